@@ -54,14 +54,14 @@
 #include "ui/taskgraph.h"
 #include "vtl/tlist.h"
 
-#define SCHED_HEIGHT ((double) 0.5)
-#define FLOOR_HEIGHT ((double) 0)
-
 #define ABSTRACT_TASK_TIME_ZERO vtl::Time(false, 0, 0, 6)
 
 AbstractTask::AbstractTask() :
-	pid(0), accTime(), accPct(0), cursorTime(), cursorPct(0), isNew(true),
-	offset(0), scale(0), graph(nullptr), events(nullptr)
+	pid(0), schedTimev(timeArena), schedEventIdx(indexArena),
+	wakeTimev(timeArena), wakeDelay(timeArena), preemptedTimev(timeArena),
+	runningTimev(timeArena), accTime(), accPct(0), cursorTime(),
+	cursorPct(0), isNew(true), offset(0), scale(0), graph(nullptr),
+	events(nullptr)
 {}
 
 AbstractTask::~AbstractTask()
@@ -70,17 +70,6 @@ AbstractTask::~AbstractTask()
 		delete graph;
 }
 
-bool AbstractTask::doScale()
-{
-	int i;
-	int s = schedData.size();
-	double schedScale = scale * SCHED_HEIGHT;
-	scaledSchedData.resize(s);
-	for (i = 0; i < s; i++)
-		scaledSchedData[i] = schedData.read(i) * schedScale + offset;
-	return false; /* No error */
-}
-
 bool AbstractTask::doStats()
 {
 	int startidx, endidx;
@@ -257,35 +246,6 @@ bool AbstractTask::doStatsTimeLimited()
 	return false;
 }
 
-bool AbstractTask::doScaleRunning()
-{
-	int s = runningTimev.size();
-	double scaledHeight = FLOOR_HEIGHT * scale + offset;
-
-	scaledRunningData.resize(s);
-	scaledRunningData.fill(scaledHeight, s);
-	return false; /* No error */
-}
-
-bool AbstractTask::doScalePreempted()
-{
-	int s = preemptedTimev.size();
-	scaledPreemptedData.resize(s);
-	double scaledHeight = FLOOR_HEIGHT * scale + offset;
-	scaledPreemptedData.fill(scaledHeight, s);
-	return false; /* No error */
-}
-
-bool AbstractTask::doScaleWakeup()
-{
-	int s = wakeDelay.size();
-	/* Create the dummy vector needed for horizontal display */
-	double scaledHeight = WAKEUP_HEIGHT * scale + offset;
-	wakeZero.fill(0, s);
-	wakeHeight.fill(scaledHeight, s);
-	return false; /* No error */
-}
-
 void AbstractTask::setCursorTime(enum TShark::CursorIdx cursor,
 				 const vtl::Time &time)
 {
@@ -312,6 +272,16 @@ void AbstractTask::setEndTime(const vtl::Time &time)
 	endTime = time;
 }
 
+/*
+ * Sets the arenas of the tasks that are created after this, the first for the
+ * time series and the second for the event indices.
+ */
+void AbstractTask::setArenas(Arena *times, Arena *indices)
+{
+	timeArena = times;
+	indexArena = indices;
+}
+
 int AbstractTask::_binarySearch(const vtl::Time &time, int lowerIdx,
 			       int higherIdx)
 {
@@ -383,3 +353,5 @@ vtl::Time AbstractTask::endTime;
 vtl::Time AbstractTask::lowerTimeLimit;
 vtl::Time AbstractTask::higherTimeLimit;
 vtl::Time AbstractTask::cursorValues[TShark::NR_CURSORS];
+Arena *AbstractTask::timeArena = nullptr;
+Arena *AbstractTask::indexArena = nullptr;
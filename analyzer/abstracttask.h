@@ -52,7 +52,8 @@
 #ifndef ABSTRACTTASK_H
 #define ABSTRACTTASK_H
 
-#include <QVector>
+#include "mm/arenavector.h"
+#include "mm/indexvector.h"
 #include "vtl/bitvector.h"
 
 #include "vtl/time.h"
@@ -65,6 +66,10 @@ class TraceAnalyzer;
 #define SCHED_BIT 0x1
 #define FLOOR_BIT 0x0
 
+/* Heights of the scheduling graph, before the offset and scale are applied */
+#define SCHED_HEIGHT ((double) 0.5)
+#define FLOOR_HEIGHT ((double) 0)
+
 namespace vtl {
 	template<class T> class TList;
 }
@@ -80,18 +85,14 @@ public:
 	/* is really tid as all other pids here */
 	int pid;
 
-	QVector<double> schedTimev;
-	QVector<int>    schedEventIdx;
-	vtl::BitVector  schedData;
-	QVector<double> scaledSchedData;
-	QVector<double> wakeTimev;
-	QVector<double> wakeDelay;
-	QVector<double> wakeHeight;
-	QVector<double> wakeZero;
-	QVector<double> preemptedTimev;
-	QVector<double> runningTimev;
-	QVector<double> scaledPreemptedData;
-	QVector<double> scaledRunningData;
+	/* These are kept in the arenas given to setArenas() */
+	ArenaVector<double> schedTimev;
+	IndexVector         schedEventIdx;
+	vtl::BitVector      schedData;
+	ArenaVector<double> wakeTimev;
+	ArenaVector<double> wakeDelay;
+	ArenaVector<double> preemptedTimev;
+	ArenaVector<double> runningTimev;
 
 	vtl::Time accTime;             /* Total time consumption        */
 	unsigned  accPct;              /* Percentage of the above       */
@@ -101,21 +102,21 @@ public:
 	/* Only used during extraction */
 	bool isNew;
 
-	/* These are for scaling purposes */
+	/*
+	 * The graphs map a value v to v * scale + offset when they draw the
+	 * data, there are no scaled copies of the data
+	 */
 	double offset;
 	double scale;
 
-	bool doScale();
 	bool doStats();
 	bool doStatsTimeLimited();
-	bool doScaleWakeup();
-	bool doScaleRunning();
-	bool doScalePreempted();
 
 	static void setCursorTime(enum TShark::CursorIdx cursor,
 				  const vtl::Time &time);
 	static void setStartTime(const vtl::Time &time);
 	static void setEndTime(const vtl::Time &time);
+	static void setArenas(Arena *times, Arena *indices);
 
 	TaskGraph *graph;
 
@@ -131,6 +132,8 @@ protected:
 	static vtl::Time startTime;
 	static vtl::Time endTime;
 	static vtl::Time cursorValues[];
+	static Arena *timeArena;
+	static Arena *indexArena;
 	vtl::TList<TraceEvent> *events;
 };
 
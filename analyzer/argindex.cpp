@@ -0,0 +1,344 @@
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2018  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+
+#include "analyzer/argindex.h"
+#include "threads/threadpool.h"
+
+/* The lists of a chunk keep the offsets of the events from its start */
+typedef QHash<const TString*, QVector<quint32> > ChunkRefs;
+typedef QPair<int, const QVector<quint32> *> ChunkList;
+
+static __always_inline void addRef(ChunkRefs &refs, const TString *str,
+				   quint32 index)
+{
+	if (str == nullptr || str->len <= 0)
+		return;
+	QVector<quint32> &list = refs[str];
+	/* An event may contain the same string more than once */
+	if (list.isEmpty() || list.last() != index)
+		list.append(index);
+}
+
+/* The value of a key=value argument, or an empty array */
+static __always_inline QByteArray valueOf(const QByteArray &str)
+{
+	int eq = str.indexOf('=');
+
+	if (eq < 0 || eq == str.size() - 1)
+		return QByteArray();
+	return str.mid(eq + 1);
+}
+
+ArgIndex::ArgIndex():
+	nrEvents(0), built(false)
+{}
+
+void ArgIndex::clear()
+{
+	strings.clear();
+	postings.clear();
+	ngrams.clear();
+	nrEvents = 0;
+	built = false;
+}
+
+/*
+ * The pool threads collect the events of each string pointer in their chunks.
+ * The pointers are then mapped to the sorted distinct strings, after which the
+ * lists of each string are concatenated in parallel.
+ */
+void ArgIndex::build(const vtl::TList<TraceEvent> *events)
+{
+	vtl::index_t s = events->size();
+	int nrChunks = (s + ARGINDEX_CHUNK - 1) / ARGINDEX_CHUNK;
+	QVector<ChunkRefs> chunkRefs(nrChunks);
+	ChunkRefs *refs = chunkRefs.data();
+	QHash<const TString*, QPair<int, int> > ptrIds;
+	QHash<QByteArray, int> tmpIds;
+	QVector<QByteArray> tmpStrings;
+	QVector<int> order;
+	QVector<int> finalId;
+	QVector<QVector<ChunkList> > sources;
+	ChunkRefs::const_iterator iter;
+	QByteArray str, value;
+	QPair<int, int> ids;
+	int c, i;
+
+	clear();
+
+	ThreadPool::instance()->parallelFor(0, nrChunks, 1,
+					    [events, s, refs](int b, int e) {
+		vtl::index_t first;
+		int c, i, a, n;
+		for (c = b; c < e; c++) {
+			first = (vtl::index_t) c * ARGINDEX_CHUNK;
+			n = TSMIN(s - first, ARGINDEX_CHUNK);
+			for (i = 0; i < n; i++) {
+				const TraceEvent &event = events->at(first + i);
+				addRef(refs[c], event.taskName, i);
+				for (a = 0; a < event.argc; a++)
+					addRef(refs[c], event.argv[a], i);
+			}
+		}
+	});
+
+	/* Give each distinct string a temporary id */
+	for (c = 0; c < nrChunks; c++) {
+		for (iter = refs[c].constBegin(); iter != refs[c].constEnd();
+		     iter++) {
+			if (ptrIds.contains(iter.key()))
+				continue;
+			str = QByteArray(iter.key()->ptr, iter.key()->len);
+			value = valueOf(str);
+			ids.first = tmpIds.value(str, tmpStrings.size());
+			if (ids.first == tmpStrings.size()) {
+				tmpIds.insert(str, ids.first);
+				tmpStrings.append(str);
+			}
+			ids.second = -1;
+			if (!value.isEmpty()) {
+				ids.second = tmpIds.value(value,
+							  tmpStrings.size());
+				if (ids.second == tmpStrings.size()) {
+					tmpIds.insert(value, ids.second);
+					tmpStrings.append(value);
+				}
+			}
+			ptrIds.insert(iter.key(), ids);
+		}
+	}
+	tmpIds.clear();
+
+	/* Sort the strings and map the temporary ids to the sorted ones */
+	order.resize(tmpStrings.size());
+	for (i = 0; i < order.size(); i++)
+		order[i] = i;
+	std::sort(order.begin(), order.end(),
+		  [&tmpStrings](int a, int b) {
+			  return tmpStrings[a] < tmpStrings[b];
+		  });
+	finalId.resize(order.size());
+	strings.resize(order.size());
+	for (i = 0; i < order.size(); i++) {
+		finalId[order[i]] = i;
+		strings[i] = tmpStrings[order[i]];
+	}
+	tmpStrings.clear();
+
+	/* The chunks are visited in order, so the sources are in order */
+	sources.resize(strings.size());
+	for (c = 0; c < nrChunks; c++) {
+		for (iter = refs[c].constBegin(); iter != refs[c].constEnd();
+		     iter++) {
+			ids = ptrIds.value(iter.key());
+			sources[finalId[ids.first]].append(
+				ChunkList(c, &iter.value()));
+			if (ids.second >= 0)
+				sources[finalId[ids.second]].append(
+					ChunkList(c, &iter.value()));
+		}
+	}
+
+	postings.resize(strings.size());
+	vtl::IndexList *dst = postings.data();
+	const QVector<ChunkList> *src = sources.constData();
+	ThreadPool::instance()->parallelFor(0, strings.size(), 256,
+					    [dst, src](int b, int e) {
+		vtl::index_t first, n;
+		int id, j, k;
+		for (id = b; id < e; id++) {
+			const QVector<ChunkList> &lists = src[id];
+			n = 0;
+			for (j = 0; j < lists.size(); j++)
+				n += lists[j].second->size();
+			dst[id].reserve(n);
+			for (j = 0; j < lists.size(); j++) {
+				const QVector<quint32> &list =
+					*lists[j].second;
+				first = (vtl::index_t) lists[j].first *
+					ARGINDEX_CHUNK;
+				for (k = 0; k < list.size(); k++)
+					dst[id].append(first + list[k]);
+			}
+			/*
+			 * Pointers with the same string, or a string and a
+			 * value, may refer to the same events in a chunk
+			 */
+			if (lists.size() > 1)
+				dst[id].sortUnique();
+		}
+	});
+
+	buildNgrams();
+	nrEvents = s;
+	built = true;
+}
+
+void ArgIndex::buildNgrams()
+{
+	const char *s;
+	quint32 g;
+	int id, j;
+
+	for (id = 0; id < strings.size(); id++) {
+		s = strings[id].constData();
+		for (j = 0; j + ARGINDEX_NGRAM <= strings[id].size(); j++) {
+			g = ngram(s + j);
+			QVector<int> &list = ngrams[g];
+			if (list.isEmpty() || list.last() != id)
+				list.append(id);
+		}
+	}
+}
+
+void ArgIndex::findStrings(const QByteArray &query, match_t match,
+			   QVector<int> &ids) const
+{
+	QVector<QByteArray>::const_iterator iter;
+	QHash<quint32, QVector<int> >::const_iterator giter;
+	const QVector<int> *rarest = nullptr;
+	int i;
+
+	if (query.isEmpty())
+		return;
+
+	iter = std::lower_bound(strings.constBegin(), strings.constEnd(),
+				query);
+	switch (match) {
+	case MATCH_EXACT:
+		if (iter != strings.constEnd() && *iter == query)
+			ids.append(iter - strings.constBegin());
+		break;
+	case MATCH_PREFIX:
+		for (; iter != strings.constEnd() && iter->startsWith(query);
+		     iter++)
+			ids.append(iter - strings.constBegin());
+		break;
+	case MATCH_SUBSTRING:
+		if (query.size() < ARGINDEX_NGRAM) {
+			for (i = 0; i < strings.size(); i++) {
+				if (strings[i].contains(query))
+					ids.append(i);
+			}
+			break;
+		}
+		for (i = 0; i + ARGINDEX_NGRAM <= query.size(); i++) {
+			giter = ngrams.constFind(ngram(query.constData() + i));
+			if (giter == ngrams.constEnd())
+				return;
+			if (rarest == nullptr ||
+			    giter.value().size() < rarest->size())
+				rarest = &giter.value();
+		}
+		for (i = 0; i < rarest->size(); i++) {
+			if (strings[rarest->at(i)].contains(query))
+				ids.append(rarest->at(i));
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+/*
+ * Sets the bits of the events that contain a string that matches the query.
+ * Returns the number of matching events.
+ */
+vtl::index_t ArgIndex::search(const QByteArray &query, match_t match,
+			      vtl::RankBitmap &result) const
+{
+	QVector<int> ids;
+	vtl::index_t j;
+	int i;
+
+	result.resize(nrEvents);
+	findStrings(query, match, ids);
+	for (i = 0; i < ids.size(); i++) {
+		const vtl::IndexList &list = postings[ids[i]];
+		for (j = 0; j < list.size(); j++)
+			result.set(list.at(j));
+	}
+	result.buildRank();
+	return result.count();
+}
+
+/*
+ * An estimate, since the overhead of the containers of Qt and of the heap is
+ * not known exactly.
+ */
+vtl::MemUsage ArgIndex::memUsage() const
+{
+	QHash<quint32, QVector<int> >::const_iterator iter;
+	vtl::MemUsage list;
+	quint64 reserved, used;
+	int i;
+
+	reserved = (quint64) strings.capacity() * sizeof(QByteArray) +
+		(quint64) postings.capacity() * sizeof(vtl::IndexList);
+	used = (quint64) strings.size() * sizeof(QByteArray) +
+		(quint64) postings.size() * sizeof(vtl::IndexList);
+	for (i = 0; i < strings.size(); i++) {
+		reserved += strings[i].capacity() + 1;
+		used += strings[i].size() + 1;
+		list = postings[i].memUsage();
+		reserved += list.reserved;
+		used += list.used;
+	}
+	for (iter = ngrams.constBegin(); iter != ngrams.constEnd(); iter++) {
+		reserved += sizeof(quint32) + sizeof(QVector<int>) +
+			(quint64) iter.value().capacity() * sizeof(int);
+		used += sizeof(quint32) + sizeof(QVector<int>) +
+			(quint64) iter.value().size() * sizeof(int);
+	}
+	return vtl::MemUsage(reserved, used);
+}
@@ -0,0 +1,127 @@
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2018  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ARGINDEX_H
+#define ARGINDEX_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QPair>
+#include <QVector>
+#include <QtGlobal>
+
+#include "misc/traceshark.h"
+#include "parser/traceevent.h"
+#include "vtl/index.h"
+#include "vtl/indexlist.h"
+#include "vtl/memusage.h"
+#include "vtl/rankbitmap.h"
+#include "vtl/tlist.h"
+
+/* The number of events that a pool thread indexes in one go */
+#define ARGINDEX_CHUNK (65536)
+/* The length of the substrings in the n-gram index */
+#define ARGINDEX_NGRAM (3)
+
+/*
+ * An inverted index from the strings of the events, i.e. the arguments and the
+ * task names, to the sorted indices of the events that contain them. For an
+ * argument of the form key=value, the value is also indexed as a string of its
+ * own, so that e.g. 1234 finds both prev_pid=1234 and next_pid=1234.
+ *
+ * The parser interns most arguments in the argPool of the grammar, but not
+ * all, since rarely reused strings are allocated separately. The strings are
+ * therefore identified by their contents and not by their TString pointers.
+ *
+ * The distinct strings are kept sorted, so that an exact or prefix search is a
+ * binary search. A substring search uses an index from each n-gram to the
+ * strings that contain it, so that only the strings that contain the rarest
+ * n-gram of the query need to be compared.
+ */
+class ArgIndex {
+public:
+	typedef enum {
+		MATCH_EXACT = 0,
+		MATCH_PREFIX,
+		MATCH_SUBSTRING,
+		NR_MATCHES
+	} match_t;
+	ArgIndex();
+	void build(const vtl::TList<TraceEvent> *events);
+	void clear();
+	__always_inline bool isBuilt() const;
+	vtl::index_t search(const QByteArray &query, match_t match,
+			    vtl::RankBitmap &result) const;
+	vtl::MemUsage memUsage() const;
+private:
+	void findStrings(const QByteArray &query, match_t match,
+			 QVector<int> &ids) const;
+	void buildNgrams();
+	static __always_inline quint32 ngram(const char *s);
+	QVector<QByteArray> strings;
+	QVector<vtl::IndexList> postings;
+	QHash<quint32, QVector<int> > ngrams;
+	vtl::index_t nrEvents;
+	bool built;
+};
+
+__always_inline bool ArgIndex::isBuilt() const
+{
+	return built;
+}
+
+__always_inline quint32 ArgIndex::ngram(const char *s)
+{
+	return ((quint32) (uchar) s[0] << 16) | ((quint32) (uchar) s[1] << 8) |
+		(quint32) (uchar) s[2];
+}
+
+#endif /* ARGINDEX_H */
@@ -52,6 +52,7 @@
 #ifndef CPU_H
 #define CPU_H
 
+#include "vtl/index.h"
 #include "vtl/time.h"
 
 class CPU {
@@ -63,7 +64,7 @@ public:
 
 	/* Time when pidOnCPU was scheduled */
 	vtl::Time lastSched;
-	int lastSchedIdx;
+	vtl::index_t lastSchedIdx;
 
 	vtl::Time lastEnterIdle;
 	vtl::Time lastExitIdle;
@@ -0,0 +1,150 @@
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2018  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CPUARRAY_H
+#define CPUARRAY_H
+
+#include <QVector>
+#include <cstdlib>
+#include <new>
+
+#include "misc/traceshark.h"
+#include "vtl/compiler.h"
+#include "vtl/error.h"
+
+/* The objects of different CPUs never share a cache line of this size */
+#define CPUARRAY_CACHE_LINE (64)
+
+/*
+ * An array with an object for each CPU, which grows when a higher CPU number
+ * is seen in the trace. The objects are padded to whole cache lines, so that
+ * the pool threads can work on different CPUs without false sharing. When the
+ * array grows, the new objects are put in a new contiguous block, which is at
+ * least as large as all the previous ones together, so that the objects never
+ * move and there are only a few blocks.
+ */
+template<class T>
+class CPUArray {
+public:
+	CPUArray();
+	~CPUArray();
+	__always_inline T &operator[](unsigned int cpu) const;
+	__always_inline unsigned int size() const;
+	void grow(unsigned int n);
+	void clear();
+private:
+	class alignas(CPUARRAY_CACHE_LINE) Slot {
+	public:
+		T value;
+	};
+	QVector<Slot*> items;
+	QVector<void*> blocks;
+};
+
+template<class T>
+CPUArray<T>::CPUArray()
+{}
+
+template<class T>
+CPUArray<T>::~CPUArray()
+{
+	clear();
+}
+
+template<class T>
+__always_inline T &CPUArray<T>::operator[](unsigned int cpu) const
+{
+	return items.constData()[cpu]->value;
+}
+
+template<class T>
+__always_inline unsigned int CPUArray<T>::size() const
+{
+	return items.size();
+}
+
+/* Makes sure that there are objects for at least the CPUs below n */
+template<class T>
+void CPUArray<T>::grow(unsigned int n)
+{
+	unsigned int s = items.size();
+	unsigned int nr, i;
+	void *block;
+	Slot *slot;
+	int r;
+
+	if (n <= s)
+		return;
+	nr = TSMAX(n - s, s);
+	r = posix_memalign(&block, CPUARRAY_CACHE_LINE, nr * sizeof(Slot));
+	if (r != 0)
+		vtl::err(BSD_EX_OSERR, r, "posix_memalign() failed at %s:%d",
+			 __FILE__, __LINE__);
+	blocks.append(block);
+	slot = (Slot*) block;
+	for (i = 0; i < nr; i++)
+		items.append(new (slot + i) Slot);
+}
+
+template<class T>
+void CPUArray<T>::clear()
+{
+	int i;
+
+	for (i = 0; i < items.size(); i++)
+		items[i]->~Slot();
+	for (i = 0; i < blocks.size(); i++)
+		free(blocks[i]);
+	items.clear();
+	blocks.clear();
+}
+
+#endif /* CPUARRAY_H */
@@ -53,15 +53,21 @@
 #define CPUFREQ_H
 
 #include <QVector>
+#include "analyzer/lodpyramid.h"
 
 class CpuFreq {
 public:
 	QVector<double> timev;
 	QVector<double> data;
-	QVector<double> scaledData;
 	double offset;
 	double scale;
-	bool doScale();
+	LodPyramid<LodBucket> lod;
+	__always_inline void buildLod();
 };
 
+__always_inline void CpuFreq::buildLod()
+{
+	lod.build(timev, data);
+}
+
 #endif /* CPUFREQ_H*/
@@ -50,21 +50,13 @@
  */
 
 #include "analyzer/cputask.h"
-#include "analyzer/traceanalyzer.h"
 
 CPUTask::CPUTask() :
 	AbstractTask()
 {}
 
-bool CPUTask::doScaleWakeup() {
-	int s = wakeDelay.size();
-	int i;
-	/* Compute a scaled delay vector needed for vertical display */
-	verticalDelay.resize(s);
-	double maxsize = WAKEUP_SIZE * scale;
-	double factor = maxsize / WAKEUP_MAX;
-	for (i = 0; i < s; i++)
-		verticalDelay[i] = TSMIN(factor * wakeDelay[i], maxsize);
-
-	return AbstractTask::doScaleWakeup();
+bool CPUTask::buildLod()
+{
+	lod.build(schedTimev, schedData, FLOOR_HEIGHT, SCHED_HEIGHT);
+	return false; /* No error */
 }
@@ -54,12 +54,13 @@
 
 #include <QVector>
 #include "analyzer/abstracttask.h"
+#include "analyzer/lodpyramid.h"
 
 class CPUTask: public AbstractTask {
 public:
 	CPUTask();
-	QVector<double> verticalDelay;
-	bool doScaleWakeup();
+	LodPyramid<LodBucket> lod;
+	bool buildLod();
 };
 
 #endif /* CPUTASK_H */
@@ -0,0 +1,98 @@
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2018  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "analyzer/cputasktable.h"
+
+CPUTaskTable::CPUTaskTable():
+	mask(0), shift(32), nrTasks(0)
+{}
+
+/* Inserts an index that is not present */
+void CPUTaskTable::insert(int index, CPUTask *task)
+{
+	Slot *t;
+	unsigned int i;
+
+	if ((nrTasks + 1) * 2 > table.size())
+		grow();
+	t = table.data();
+	for (i = slotOf(index); t[i].index >= 0; i = (i + 1) & mask)
+		;
+	t[i].index = index;
+	t[i].task = task;
+	nrTasks++;
+}
+
+void CPUTaskTable::grow()
+{
+	QVector<Slot> old;
+	int s = table.isEmpty() ? CPUTASKTABLE_MIN_SIZE : table.size() * 2;
+	int i;
+
+	old.swap(table);
+	table.resize(s);
+	mask = s - 1;
+	for (shift = 32; s > 1; s >>= 1)
+		shift--;
+	nrTasks = 0;
+	for (i = 0; i < old.size(); i++) {
+		if (old[i].index >= 0)
+			insert(old[i].index, old[i].task);
+	}
+}
+
+void CPUTaskTable::clear()
+{
+	QVector<Slot>().swap(table);
+	mask = 0;
+	shift = 32;
+	nrTasks = 0;
+}
@@ -0,0 +1,140 @@
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2018  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CPUTASKTABLE_H
+#define CPUTASKTABLE_H
+
+#include <QVector>
+
+#include "vtl/compiler.h"
+#include "vtl/memusage.h"
+
+class CPUTask;
+
+/* The number of slots when the first task is inserted, a power of two */
+#define CPUTASKTABLE_MIN_SIZE (16)
+
+/*
+ * Maps the dense index of a pid, see PidIndex, to the CPUTask of the pid on
+ * one CPU. A CPU usually runs only a small part of the tasks of a trace, so
+ * instead of an array with an element for every task, this is a hash table
+ * with open addressing and linear probing that is kept at most half full.
+ * The slot of an index is given by Fibonacci hashing, i.e. by the top bits of
+ * the index times the golden ratio.
+ */
+class CPUTaskTable {
+public:
+	CPUTaskTable();
+	__always_inline CPUTask *find(int index) const;
+	void insert(int index, CPUTask *task);
+	__always_inline int size() const;
+	__always_inline int capacity() const;
+	__always_inline CPUTask *taskAt(int slot) const;
+	void clear();
+	__always_inline vtl::MemUsage memUsage() const;
+private:
+	class Slot {
+	public:
+		Slot(): index(-1), task(nullptr) {}
+		int index;
+		CPUTask *task;
+	};
+	__always_inline unsigned int slotOf(int index) const;
+	void grow();
+	QVector<Slot> table;
+	unsigned int mask;
+	int shift;
+	int nrTasks;
+};
+
+__always_inline unsigned int CPUTaskTable::slotOf(int index) const
+{
+	return ((unsigned int) index * 2654435769U) >> shift;
+}
+
+/* Returns the CPUTask of the index, or nullptr if it has not been inserted */
+__always_inline CPUTask *CPUTaskTable::find(int index) const
+{
+	const Slot *t = table.constData();
+	unsigned int i;
+
+	if (unlikely(nrTasks == 0))
+		return nullptr;
+	for (i = slotOf(index); t[i].index >= 0; i = (i + 1) & mask) {
+		if (t[i].index == index)
+			return t[i].task;
+	}
+	return nullptr;
+}
+
+__always_inline int CPUTaskTable::size() const
+{
+	return nrTasks;
+}
+
+__always_inline int CPUTaskTable::capacity() const
+{
+	return table.size();
+}
+
+__always_inline vtl::MemUsage CPUTaskTable::memUsage() const
+{
+	return vtl::MemUsage((quint64) table.capacity() * sizeof(Slot),
+			     (quint64) nrTasks * sizeof(Slot));
+}
+
+/* Returns the CPUTask in a slot, or nullptr if the slot is empty */
+__always_inline CPUTask *CPUTaskTable::taskAt(int slot) const
+{
+	return table[slot].task;
+}
+
+#endif /* CPUTASKTABLE_H */
@@ -0,0 +1,165 @@
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2018  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <QVector>
+#include <climits>
+
+#include "analyzer/eventfinder.h"
+#include "misc/traceshark.h"
+#include "threads/threadpool.h"
+
+EventFinder::EventFinder(const vtl::TList<TraceEvent> *e):
+	events(e)
+{}
+
+/*
+ * Returns the index of the first event in [from, to) that matches pred, or the
+ * last one if forward is false. The scan is abandoned if a chunk that is
+ * closer to the start of the search, i.e. one with a lower number than chunk,
+ * has found a match. The number of the closest chunk with a match is kept in
+ * nearest, or INT_MAX if there is none.
+ */
+vtl::index_t EventFinder::findInRange(const EventPredicate &pred,
+				      vtl::index_t from, vtl::index_t to,
+				      bool forward, int chunk,
+				      QAtomicInt *nearest) const
+{
+	vtl::index_t i, n;
+	int cur;
+
+	for (n = 0; n < to - from; n++) {
+		if (n % FIND_POLL == 0 && nearest->loadAcquire() < chunk)
+			return -1;
+		i = forward ? from + n : to - 1 - n;
+		if (pred.matches(events->at(i)))
+			goto found;
+	}
+	return -1;
+found:
+	cur = nearest->loadAcquire();
+	while (chunk < cur && !nearest->testAndSetOrdered(cur, chunk))
+		cur = nearest->loadAcquire();
+	return i;
+}
+
+/*
+ * Returns the index of the closest event that matches pred, starting with the
+ * event at start and scanning in the direction given by forward, or -1 if there
+ * is none. Beyond the first FIND_FIRST events, the scan is done in waves of
+ * chunks, one per thread, where the chunks grow with the distance from the
+ * start. A wave ends early as soon as the chunks that are closer than a found
+ * match have been scanned, so that a match is found quickly no matter how far
+ * away it is.
+ */
+vtl::index_t EventFinder::find(vtl::index_t start, const EventPredicate &pred,
+			       bool forward) const
+{
+	ThreadPool *pool = ThreadPool::instance();
+	int nrChunks = pool->nrWorkers() + 1;
+	QVector<vtl::index_t> results(nrChunks);
+	vtl::index_t *res = results.data();
+	QAtomicInt nearest(INT_MAX);
+	vtl::index_t s, end, k;
+	int size, ck;
+
+	s = events->size();
+	if (start < 0 || start >= s)
+		return -1;
+
+	if (forward) {
+		end = TSMIN(start + FIND_FIRST, s);
+		k = findInRange(pred, start, end, true, 0, &nearest);
+		start = end;
+		end = s;
+	} else {
+		end = start + 1;
+		start = TSMAX(end - FIND_FIRST, 0);
+		k = findInRange(pred, start, end, false, 0, &nearest);
+		end = start;
+		start = 0;
+	}
+
+	/* The range [start, end) is left to scan */
+	size = FIND_FIRST;
+	while (k < 0 && start < end) {
+		size = TSMIN(size * 2, FIND_MAX_CHUNK);
+		nearest.storeRelease(INT_MAX);
+		pool->parallelFor(0, nrChunks, 1, [this, &pred, forward, start,
+						     end, size, res,
+						     &nearest](int b, int e) {
+			vtl::index_t from, to;
+			int c;
+			for (c = b; c < e; c++) {
+				res[c] = -1;
+				if (c >= (end - start + size - 1) / size)
+					continue;
+				if (forward) {
+					from = start + (vtl::index_t) c * size;
+					to = TSMIN(from + size, end);
+				} else {
+					to = end - (vtl::index_t) c * size;
+					from = TSMAX(to - size, start);
+				}
+				res[c] = findInRange(pred, from, to, forward,
+						     c, &nearest);
+			}
+		});
+		ck = nearest.loadAcquire();
+		k = ck == INT_MAX ? -1 : res[ck];
+		if (forward)
+			start = TSMIN(start + (vtl::index_t) nrChunks * size,
+				      end);
+		else
+			end = TSMAX(end - (vtl::index_t) nrChunks * size,
+				    start);
+	}
+	return k;
+}
@@ -0,0 +1,124 @@
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2018  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef EVENTPREDICATE_H
+#define EVENTPREDICATE_H
+
+#include <QByteArray>
+#include <cstring>
+
+#include "misc/traceshark.h"
+#include "misc/tstring.h"
+#include "parser/traceevent.h"
+
+/* The value of a field of EventPredicate that matches any event */
+#define EVENTPREDICATE_ANY (-1)
+
+/*
+ * The conditions that an event must fulfill in order to be found by
+ * TraceAnalyzer::findEvent(). All fields that are not EVENTPREDICATE_ANY, or
+ * empty in the case of arg, must match.
+ */
+class EventPredicate {
+public:
+	EventPredicate(): type(EVENTPREDICATE_ANY), pid(EVENTPREDICATE_ANY),
+		cpu(EVENTPREDICATE_ANY) {}
+	__always_inline bool matches(const TraceEvent &event) const;
+	/* An event_t, or EVENTPREDICATE_ANY */
+	int type;
+	/* The pid of the task that emitted the event */
+	int pid;
+	int cpu;
+	/* A substring of one of the arguments */
+	QByteArray arg;
+private:
+	static __always_inline bool contains(const TString *str,
+					     const QByteArray &sub);
+};
+
+__always_inline bool EventPredicate::contains(const TString *str,
+					      const QByteArray &sub)
+{
+	const char *s = sub.constData();
+	const char *p = str->ptr;
+	const char *last = str->ptr + str->len - sub.size();
+
+	while (p <= last) {
+		p = (const char *) memchr(p, s[0], last - p + 1);
+		if (p == nullptr)
+			return false;
+		if (memcmp(p, s, sub.size()) == 0)
+			return true;
+		p++;
+	}
+	return false;
+}
+
+__always_inline bool EventPredicate::matches(const TraceEvent &event) const
+{
+	int i;
+
+	if (type != EVENTPREDICATE_ANY && (int) event.type != type)
+		return false;
+	if (pid != EVENTPREDICATE_ANY && event.pid != pid)
+		return false;
+	if (cpu != EVENTPREDICATE_ANY && (int) event.cpu != cpu)
+		return false;
+	if (arg.isEmpty())
+		return true;
+	for (i = 0; i < event.argc; i++) {
+		if (contains(event.argv[i], arg))
+			return true;
+	}
+	return false;
+}
+
+#endif /* EVENTPREDICATE_H */
@@ -0,0 +1,681 @@
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2018  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <QMap>
+#include <cctype>
+#include <cstring>
+
+#include "analyzer/filterexpr.h"
+#include "mm/stringtree.h"
+#include "parser/genericparams.h"
+#include "parser/paramhelpers.h"
+
+/*
+ * A set of single values whose range is wider than this is compiled into a
+ * series of comparisons, since the bitmap of the set would be too large.
+ */
+#define FILTEREXPR_MAX_SET_SPAN (1 << 24)
+
+const FilterExpr::FieldInfo FilterExpr::fieldInfo[NR_FIELDS] = {
+	{ "cpu",        KIND_INT },
+	{ "common_pid", KIND_INT },
+	{ "event",      KIND_EVENT },
+	{ "prev_pid",   KIND_INT },
+	{ "prev_prio",  KIND_INT },
+	{ "prev_state", KIND_STATE },
+	{ "next_pid",   KIND_INT },
+	{ "next_prio",  KIND_INT },
+	{ "pid",        KIND_INT },
+	{ "prio",       KIND_INT },
+	{ "target_cpu", KIND_INT },
+	{ "orig_cpu",   KIND_INT },
+	{ "dest_cpu",   KIND_INT },
+	{ "cpu_id",     KIND_INT },
+	{ "state",      KIND_INT },
+	{ "irq",        KIND_INT },
+	{ "parent_pid", KIND_INT },
+	{ "child_pid",  KIND_INT },
+};
+
+FilterExpr::FilterExpr():
+	fieldMask(0), pos(0), tokPos(0), tok(TOK_END), tokValue(0), depth(0),
+	maxDepth(0), nesting(0)
+{}
+
+void FilterExpr::clear()
+{
+	exprText.clear();
+	program.clear();
+	sets.clear();
+	fieldMask = 0;
+}
+
+const QString &FilterExpr::getText() const
+{
+	return exprText;
+}
+
+bool FilterExpr::compile(const QString &text, QString *error)
+{
+	clear();
+	src = text.toLatin1();
+	pos = 0;
+	depth = 0;
+	maxDepth = 0;
+	nesting = 0;
+	errorMsg.clear();
+
+	if (!next() || !parseOr())
+		goto error;
+	if (tok != TOK_END) {
+		fail("Unexpected input");
+		goto error;
+	}
+	if (maxDepth > FILTEREXPR_MAX_DEPTH) {
+		fail("The expression is too complex");
+		goto error;
+	}
+	exprText = text;
+	src.clear();
+	return true;
+error:
+	if (error != nullptr)
+		*error = errorMsg;
+	clear();
+	src.clear();
+	return false;
+}
+
+bool FilterExpr::fail(const QString &msg)
+{
+	/* Only the first error is reported */
+	if (errorMsg.isEmpty())
+		errorMsg = QString("%1 at position %2").arg(msg).arg(tokPos + 1);
+	return false;
+}
+
+static __always_inline bool isIdentStart(char c)
+{
+	return isalpha((unsigned char) c) || c == '_';
+}
+
+static __always_inline bool isIdentChar(char c)
+{
+	return isalnum((unsigned char) c) || c == '_';
+}
+
+/* Reads the next token, returns false if there is no valid token */
+bool FilterExpr::next()
+{
+	const char *s = src.constData();
+	int len = src.size();
+	int start, base, digit;
+	bool neg = false;
+	char c;
+
+	while (pos < len && isspace((unsigned char) s[pos]))
+		pos++;
+	tokPos = pos;
+	if (pos >= len) {
+		tok = TOK_END;
+		return true;
+	}
+
+	c = s[pos];
+	if (isIdentStart(c)) {
+		start = pos;
+		while (pos < len) {
+			c = s[pos];
+			/* Task states may contain '+' and '|', e.g. R+ or D|K */
+			if (isIdentChar(c) || c == '+')
+				pos++;
+			else if (c == '|' && pos + 1 < len &&
+				 isIdentStart(s[pos + 1]))
+				pos++;
+			else
+				break;
+		}
+		tok = TOK_IDENT;
+		tokText = src.mid(start, pos - start);
+		return true;
+	}
+
+	if (isdigit((unsigned char) c) ||
+	    (c == '-' && pos + 1 < len && isdigit((unsigned char) s[pos + 1]))) {
+		if (c == '-') {
+			neg = true;
+			pos++;
+		}
+		base = 10;
+		if (s[pos] == '0' && pos + 2 < len &&
+		    (s[pos + 1] == 'x' || s[pos + 1] == 'X') &&
+		    isxdigit((unsigned char) s[pos + 2])) {
+			base = 16;
+			pos += 2;
+		}
+		tokValue = 0;
+		while (pos < len && isxdigit((unsigned char) s[pos])) {
+			c = s[pos];
+			if (isdigit((unsigned char) c))
+				digit = c - '0';
+			else if (base == 16)
+				digit = tolower((unsigned char) c) - 'a' + 10;
+			else
+				break;
+			tokValue = tokValue * base + digit;
+			if (tokValue > (qint64) INT_MAX + 1)
+				return fail("The integer is too large");
+			pos++;
+		}
+		if (neg)
+			tokValue = -tokValue;
+		if (tokValue > INT_MAX)
+			return fail("The integer is too large");
+		tok = TOK_INT;
+		return true;
+	}
+
+	pos++;
+	switch (c) {
+	case '&':
+		tok = pos < len && s[pos] == '&' ? TOK_AND : TOK_ERROR;
+		break;
+	case '|':
+		tok = pos < len && s[pos] == '|' ? TOK_OR : TOK_ERROR;
+		break;
+	case '=':
+		tok = pos < len && s[pos] == '=' ? TOK_EQ : TOK_ERROR;
+		break;
+	case '.':
+		tok = pos < len && s[pos] == '.' ? TOK_DOTDOT : TOK_ERROR;
+		break;
+	case '!':
+		tok = pos < len && s[pos] == '=' ? TOK_NE : TOK_NOT;
+		break;
+	case '<':
+		tok = pos < len && s[pos] == '=' ? TOK_LE : TOK_LT;
+		break;
+	case '>':
+		tok = pos < len && s[pos] == '=' ? TOK_GE : TOK_GT;
+		break;
+	case '(':
+		tok = TOK_LPAREN;
+		return true;
+	case ')':
+		tok = TOK_RPAREN;
+		return true;
+	case '{':
+		tok = TOK_LBRACE;
+		return true;
+	case '}':
+		tok = TOK_RBRACE;
+		return true;
+	case ',':
+		tok = TOK_COMMA;
+		return true;
+	default:
+		tok = TOK_ERROR;
+		break;
+	}
+
+	if (tok == TOK_ERROR)
+		return fail(QString("Unexpected character '%1'").arg(c));
+	/* The two character tokens */
+	if (tok != TOK_NOT && tok != TOK_LT && tok != TOK_GT)
+		pos++;
+	return true;
+}
+
+bool FilterExpr::expect(token_t t, const char *what)
+{
+	if (tok != t)
+		return fail(QString("Expected %1").arg(what));
+	return next();
+}
+
+void FilterExpr::append(op_t op, field_t field, int value, int high)
+{
+	Insn insn;
+
+	insn.op = op;
+	insn.field = field;
+	insn.value = value;
+	insn.high = high;
+	program.append(insn);
+
+	switch (op) {
+	case OP_AND:
+	case OP_OR:
+		depth--;
+		break;
+	case OP_NOT:
+		break;
+	default:
+		depth++;
+		maxDepth = TSMAX(maxDepth, depth);
+		break;
+	}
+}
+
+bool FilterExpr::parseOr()
+{
+	if (!parseAnd())
+		return false;
+	while (tok == TOK_OR) {
+		if (!next() || !parseAnd())
+			return false;
+		append(OP_OR);
+	}
+	return true;
+}
+
+bool FilterExpr::parseAnd()
+{
+	if (!parseUnary())
+		return false;
+	while (tok == TOK_AND) {
+		if (!next() || !parseUnary())
+			return false;
+		append(OP_AND);
+	}
+	return true;
+}
+
+bool FilterExpr::parseUnary()
+{
+	bool rval;
+
+	if (++nesting > FILTEREXPR_MAX_DEPTH)
+		return fail("The expression is nested too deeply");
+
+	switch (tok) {
+	case TOK_NOT:
+		rval = next() && parseUnary();
+		if (rval)
+			append(OP_NOT);
+		break;
+	case TOK_LPAREN:
+		rval = next() && parseOr() && expect(TOK_RPAREN, "')'");
+		break;
+	default:
+		rval = parseComparison();
+		break;
+	}
+
+	nesting--;
+	return rval;
+}
+
+bool FilterExpr::parseComparison()
+{
+	field_t field;
+	kind_t kind;
+	op_t op;
+	int value;
+
+	if (tok != TOK_IDENT)
+		return fail("Expected a field name");
+	if (!lookupField(tokText, field))
+		return fail(QString("Unknown field \"%1\"")
+			    .arg(QString::fromLatin1(tokText)));
+	kind = fieldInfo[field].kind;
+	fieldMask |= (quint32) 0x1 << field;
+	if (!next())
+		return false;
+
+	switch (tok) {
+	case TOK_EQ:
+		op = OP_EQ;
+		break;
+	case TOK_NE:
+		op = OP_NE;
+		break;
+	case TOK_LT:
+		op = OP_LT;
+		break;
+	case TOK_LE:
+		op = OP_LE;
+		break;
+	case TOK_GT:
+		op = OP_GT;
+		break;
+	case TOK_GE:
+		op = OP_GE;
+		break;
+	case TOK_IDENT:
+		if (tokText == "in")
+			return next() && parseSet(field, kind);
+		/* Fall through */
+	default:
+		return fail("Expected a comparison operator or \"in\"");
+	}
+
+	/* Event types and task states have no order */
+	if (kind != KIND_INT && op != OP_EQ && op != OP_NE)
+		return fail(QString("The field \"%1\" can only be compared with "
+				    "==, != or in").arg(fieldInfo[field].name));
+	if (!next() || !parseValue(kind, value))
+		return false;
+	append(op, field, value);
+	return true;
+}
+
+bool FilterExpr::parseSet(field_t field, kind_t kind)
+{
+	QMap<int, int> singles;
+	QMap<int, int>::const_iterator iter;
+	int nrTerms = 0;
+	int value, high;
+
+	if (!expect(TOK_LBRACE, "'{'"))
+		return false;
+	for (;;) {
+		if (!parseValue(kind, value))
+			return false;
+		if (tok == TOK_DOTDOT) {
+			if (kind != KIND_INT)
+				return fail("Ranges are only allowed for integer "
+					    "fields");
+			if (!next() || !parseValue(kind, high))
+				return false;
+			if (high < value)
+				return fail("The range is empty");
+			append(OP_RANGE, field, value, high);
+			if (nrTerms++ > 0)
+				append(OP_OR);
+		} else {
+			singles.insert(value, value);
+		}
+		if (tok != TOK_COMMA)
+			break;
+		if (!next())
+			return false;
+	}
+	if (!expect(TOK_RBRACE, "',' or '}'"))
+		return false;
+
+	if (singles.isEmpty())
+		return true;
+	if ((qint64) singles.lastKey() - singles.firstKey() <
+	    FILTEREXPR_MAX_SET_SPAN) {
+		sets.append(FilterSet());
+		sets.last().build(singles);
+		append(OP_IN, field, 0, sets.size() - 1);
+		if (nrTerms++ > 0)
+			append(OP_OR);
+		return true;
+	}
+	for (iter = singles.constBegin(); iter != singles.constEnd(); iter++) {
+		append(OP_EQ, field, iter.key());
+		if (nrTerms++ > 0)
+			append(OP_OR);
+	}
+	return true;
+}
+
+bool FilterExpr::parseValue(kind_t kind, int &value)
+{
+	TString ts;
+	taskstate_t state;
+
+	switch (kind) {
+	case KIND_INT:
+		if (tok != TOK_INT)
+			return fail("Expected an integer");
+		value = (int) tokValue;
+		break;
+	case KIND_EVENT:
+		if (tok != TOK_IDENT)
+			return fail("Expected an event name");
+		if (!lookupEvent(tokText, value))
+			return fail(QString("Unknown event \"%1\"")
+				    .arg(QString::fromLatin1(tokText)));
+		break;
+	case KIND_STATE:
+		if (tok != TOK_IDENT)
+			return fail("Expected a task state");
+		ts.ptr = tokText.data();
+		ts.len = tokText.size();
+		state = __sched_state_from_tstring(&ts);
+		if (state == TASK_STATE_PARSER_ERROR)
+			return fail(QString("Invalid task state \"%1\"")
+				    .arg(QString::fromLatin1(tokText)));
+		value = (int) state;
+		break;
+	default:
+		return fail("Internal error");
+	}
+	return next();
+}
+
+bool FilterExpr::lookupField(const QByteArray &name, field_t &field) const
+{
+	int i;
+
+	for (i = 0; i < NR_FIELDS; i++) {
+		if (name == fieldInfo[i].name) {
+			field = (field_t) i;
+			return true;
+		}
+	}
+	return false;
+}
+
+bool FilterExpr::lookupEvent(const QByteArray &name, int &value) const
+{
+	const TString *str;
+	int nr, i;
+
+	if (TraceEvent::getStringTree() == nullptr)
+		return false;
+	nr = TraceEvent::getNrEvents();
+	for (i = 0; i < nr; i++) {
+		str = TraceEvent::getEventName((event_t) i);
+		if (str == nullptr || str->len != name.size())
+			continue;
+		if (strncmp(str->ptr, name.constData(), str->len) == 0) {
+			value = i;
+			return true;
+		}
+	}
+	return false;
+}
+
+static __always_inline int decodeSwitch(FilterExpr::field_t field,
+					tracetype_t ttype,
+					const TraceEvent &event)
+{
+	sched_switch_handle handle;
+
+	if (!sched_switch_parse(ttype, event, handle))
+		return FILTEREXPR_UNDEFINED;
+
+	switch (field) {
+	case FilterExpr::FIELD_PREV_PID:
+		return sched_switch_handle_oldpid(ttype, event, handle);
+	case FilterExpr::FIELD_PREV_PRIO:
+		return sched_switch_handle_oldprio(ttype, event, handle);
+	case FilterExpr::FIELD_PREV_STATE:
+		return sched_switch_handle_state(ttype, event, handle);
+	case FilterExpr::FIELD_NEXT_PID:
+		return sched_switch_handle_newpid(ttype, event, handle);
+	case FilterExpr::FIELD_NEXT_PRIO:
+		return sched_switch_handle_newprio(ttype, event, handle);
+	default:
+		return FILTEREXPR_UNDEFINED;
+	}
+}
+
+/*
+ * Returns the value of the field for the event, or FILTEREXPR_UNDEFINED if
+ * the event does not have it. Note that the parse errors of the param
+ * functions also yield INT_MAX, i.e. FILTEREXPR_UNDEFINED.
+ */
+static __always_inline int decodeEvent(FilterExpr::field_t field,
+				       tracetype_t ttype,
+				       const TraceEvent &event)
+{
+	switch (field) {
+	case FilterExpr::FIELD_PREV_PID:
+	case FilterExpr::FIELD_PREV_PRIO:
+	case FilterExpr::FIELD_PREV_STATE:
+	case FilterExpr::FIELD_NEXT_PID:
+	case FilterExpr::FIELD_NEXT_PRIO:
+		if (event.type != SCHED_SWITCH)
+			break;
+		return decodeSwitch(field, ttype, event);
+	case FilterExpr::FIELD_PID:
+		if (event.type == SCHED_WAKEUP ||
+		    event.type == SCHED_WAKEUP_NEW) {
+			if (sched_wakeup_args_ok(ttype, event))
+				return sched_wakeup_pid(ttype, event);
+		} else if (event.type == SCHED_WAKING) {
+			if (sched_waking_args_ok(ttype, event))
+				return sched_waking_pid(ttype, event);
+		} else if (event.type == SCHED_MIGRATE_TASK) {
+			if (sched_migrate_args_ok(ttype, event))
+				return sched_migrate_pid(ttype, event);
+		} else if (event.type == SCHED_PROCESS_EXIT) {
+			if (sched_process_exit_args_ok(ttype, event))
+				return sched_process_exit_pid(ttype, event);
+		}
+		break;
+	case FilterExpr::FIELD_PRIO:
+		if (event.type == SCHED_WAKEUP ||
+		    event.type == SCHED_WAKEUP_NEW) {
+			if (sched_wakeup_args_ok(ttype, event))
+				return sched_wakeup_prio(ttype, event);
+		} else if (event.type == SCHED_WAKING) {
+			if (sched_waking_args_ok(ttype, event))
+				return sched_waking_prio(ttype, event);
+		} else if (event.type == SCHED_MIGRATE_TASK) {
+			if (sched_migrate_args_ok(ttype, event))
+				return sched_migrate_prio(ttype, event);
+		}
+		break;
+	case FilterExpr::FIELD_TARGET_CPU:
+		if (event.type == SCHED_WAKEUP ||
+		    event.type == SCHED_WAKEUP_NEW) {
+			if (sched_wakeup_args_ok(ttype, event))
+				return sched_wakeup_cpu(ttype, event);
+		} else if (event.type == SCHED_WAKING) {
+			if (sched_waking_args_ok(ttype, event))
+				return sched_waking_cpu(ttype, event);
+		}
+		break;
+	case FilterExpr::FIELD_ORIG_CPU:
+		if (event.type == SCHED_MIGRATE_TASK &&
+		    sched_migrate_args_ok(ttype, event))
+			return sched_migrate_origCPU(ttype, event);
+		break;
+	case FilterExpr::FIELD_DEST_CPU:
+		if (event.type == SCHED_MIGRATE_TASK &&
+		    sched_migrate_args_ok(ttype, event))
+			return sched_migrate_destCPU(ttype, event);
+		break;
+	case FilterExpr::FIELD_CPU_ID:
+		if (event.type == CPU_FREQUENCY) {
+			if (cpufreq_args_ok(ttype, event))
+				return cpufreq_cpu(ttype, event);
+		} else if (event.type == CPU_IDLE) {
+			if (cpuidle_args_ok(ttype, event))
+				return cpuidle_cpu(ttype, event);
+		}
+		break;
+	case FilterExpr::FIELD_STATE:
+		if (event.type == CPU_FREQUENCY) {
+			if (cpufreq_args_ok(ttype, event))
+				return cpufreq_freq(ttype, event);
+		} else if (event.type == CPU_IDLE) {
+			if (cpuidle_args_ok(ttype, event))
+				return cpuidle_state(ttype, event);
+		}
+		break;
+	case FilterExpr::FIELD_IRQ:
+		if (event.type == IRQ_HANDLER_ENTRY) {
+			if (irq_handler_entry_args_ok(ttype, event))
+				return irq_handler_entry_irq(ttype, event);
+		} else if (event.type == IRQ_HANDLER_EXIT) {
+			if (irq_handler_exit_args_ok(ttype, event))
+				return irq_handler_exit_irq(ttype, event);
+		}
+		break;
+	case FilterExpr::FIELD_PARENT_PID:
+		if (event.type == SCHED_PROCESS_FORK &&
+		    sched_process_fork_args_ok(ttype, event))
+			return sched_process_fork_parent_pid(ttype, event);
+		break;
+	case FilterExpr::FIELD_CHILD_PID:
+		if (event.type == SCHED_PROCESS_FORK &&
+		    sched_process_fork_args_ok(ttype, event))
+			return sched_process_fork_childpid(ttype, event);
+		break;
+	default:
+		break;
+	}
+	return FILTEREXPR_UNDEFINED;
+}
+
+/*
+ * Decodes the field of the events in [first, last) into the column, which
+ * must have been resized to hold all events. Different ranges of the same
+ * column can be decoded by different threads.
+ */
+void FilterExpr::decodeField(field_t field, tracetype_t ttype,
+			     const vtl::TList<TraceEvent> *events,
+			     vtl::TList<int> *column, vtl::index_t first,
+			     vtl::index_t last)
+{
+	vtl::index_t i;
+
+	for (i = first; i < last; i++)
+		(*column)[i] = decodeEvent(field, ttype, events->at(i));
+}
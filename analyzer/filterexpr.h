@@ -0,0 +1,398 @@
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2018  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef FILTEREXPR_H
+#define FILTEREXPR_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+#include <QtGlobal>
+#include <climits>
+
+#include "analyzer/filterset.h"
+#include "misc/traceshark.h"
+#include "parser/traceevent.h"
+#include "vtl/tlist.h"
+
+/* The value of a decoded field for the events that do not have the field */
+#define FILTEREXPR_UNDEFINED (INT_MAX)
+/* The maximum depth of the evaluation stack of a compiled expression */
+#define FILTEREXPR_MAX_DEPTH (32)
+/* The number of events that are evaluated in one go, one per bit of a word */
+#define FILTEREXPR_BLOCK (64)
+
+/*
+ * A filter expression, such as:
+ *
+ *	cpu in {0..7} && event == sched_switch && prev_state == D &&
+ *	next_prio < 100
+ *
+ * A comparison is a field name, an operator and a value, or a field name
+ * followed by "in" and a set of values and ranges. Comparisons can be combined
+ * with &&, || and !, and grouped with parentheses. The fields are named as in
+ * the kernel tracepoints, with common_pid for the pid of the task that emitted
+ * the event.
+ *
+ * A comparison is unknown for an event that does not have the field, and as
+ * in SQL, !unknown is unknown, false && unknown is false and true || unknown
+ * is true. An event only matches if the expression is true, so neither
+ * prev_state == D nor !(prev_state == D) matches a sched_wakeup event.
+ *
+ * The expression is parsed and type checked once, and compiled into a postfix
+ * program. The program is evaluated for a block of up to 64 events at a time,
+ * so that each instruction yields a bit mask, which keeps the interpretation
+ * overhead small. The tracepoint fields are not parsed from the arguments of
+ * the events during evaluation but read from columns of decoded values, see
+ * decodeField().
+ */
+class FilterExpr {
+public:
+	typedef enum {
+		/* These are read directly from the TraceEvent */
+		FIELD_CPU = 0,
+		FIELD_COMMON_PID,
+		FIELD_EVENT,
+		/* These need to be decoded from the arguments */
+		FIELD_PREV_PID,
+		FIELD_PREV_PRIO,
+		FIELD_PREV_STATE,
+		FIELD_NEXT_PID,
+		FIELD_NEXT_PRIO,
+		FIELD_PID,
+		FIELD_PRIO,
+		FIELD_TARGET_CPU,
+		FIELD_ORIG_CPU,
+		FIELD_DEST_CPU,
+		FIELD_CPU_ID,
+		FIELD_STATE,
+		FIELD_IRQ,
+		FIELD_PARENT_PID,
+		FIELD_CHILD_PID,
+		NR_FIELDS
+	} field_t;
+	FilterExpr();
+	bool compile(const QString &text, QString *error);
+	void clear();
+	__always_inline bool isEmpty() const;
+	__always_inline bool usesField(field_t field) const;
+	const QString &getText() const;
+	__always_inline quint64 eval(const vtl::TList<TraceEvent> *events,
+				     const vtl::TList<int> *const *columns,
+				     vtl::index_t first, int n) const;
+	static __always_inline bool fieldIsDecoded(field_t field);
+	static void decodeField(field_t field, tracetype_t ttype,
+				const vtl::TList<TraceEvent> *events,
+				vtl::TList<int> *column, vtl::index_t first,
+				vtl::index_t last);
+private:
+	typedef enum {
+		OP_EQ = 0,
+		OP_NE,
+		OP_LT,
+		OP_LE,
+		OP_GT,
+		OP_GE,
+		OP_IN,
+		OP_RANGE,
+		OP_AND,
+		OP_OR,
+		OP_NOT
+	} op_t;
+	typedef enum {
+		KIND_INT = 0,
+		KIND_EVENT,
+		KIND_STATE
+	} kind_t;
+	typedef enum {
+		TOK_END = 0,
+		TOK_IDENT,
+		TOK_INT,
+		TOK_AND,
+		TOK_OR,
+		TOK_NOT,
+		TOK_LPAREN,
+		TOK_RPAREN,
+		TOK_LBRACE,
+		TOK_RBRACE,
+		TOK_COMMA,
+		TOK_DOTDOT,
+		TOK_EQ,
+		TOK_NE,
+		TOK_LT,
+		TOK_LE,
+		TOK_GT,
+		TOK_GE,
+		TOK_ERROR
+	} token_t;
+	class Insn {
+	public:
+		op_t op;
+		field_t field;
+		int value;
+		int high;  /* The upper limit of OP_RANGE, the set of OP_IN */
+	};
+	class FieldInfo {
+	public:
+		const char *name;
+		kind_t kind;
+	};
+	bool next();
+	bool expect(token_t tok, const char *what);
+	bool fail(const QString &msg);
+	bool parseOr();
+	bool parseAnd();
+	bool parseUnary();
+	bool parseComparison();
+	bool parseSet(field_t field, kind_t kind);
+	bool parseValue(kind_t kind, int &value);
+	bool lookupField(const QByteArray &name, field_t &field) const;
+	bool lookupEvent(const QByteArray &name, int &value) const;
+	void append(op_t op, field_t field = FIELD_CPU, int value = 0,
+		    int high = 0);
+	__always_inline void load(const vtl::TList<TraceEvent> *events,
+				  const vtl::TList<int> *const *columns,
+				  field_t field, vtl::index_t first, int n,
+				  int *vals, quint64 &defined) const;
+	__always_inline quint64 compare(const Insn &insn, const int *vals,
+					int n) const;
+	static __always_inline quint64 blockMask(int n);
+	QString exprText;
+	QVector<Insn> program;
+	QVector<FilterSet> sets;
+	quint32 fieldMask;
+	/* The state of the parser, only used by compile() */
+	QByteArray src;
+	int pos;
+	int tokPos;
+	token_t tok;
+	QByteArray tokText;
+	qint64 tokValue;
+	int depth;
+	int maxDepth;
+	int nesting;
+	QString errorMsg;
+	static const FieldInfo fieldInfo[NR_FIELDS];
+};
+
+__always_inline bool FilterExpr::isEmpty() const
+{
+	return program.isEmpty();
+}
+
+__always_inline bool FilterExpr::usesField(field_t field) const
+{
+	return (fieldMask & ((quint32) 0x1 << field)) != 0;
+}
+
+__always_inline bool FilterExpr::fieldIsDecoded(field_t field)
+{
+	return field > FIELD_EVENT;
+}
+
+__always_inline quint64 FilterExpr::blockMask(int n)
+{
+	return n >= FILTEREXPR_BLOCK ? ~(quint64) 0 :
+		((quint64) 0x1 << n) - 1;
+}
+
+__always_inline void FilterExpr::load(const vtl::TList<TraceEvent> *events,
+				      const vtl::TList<int> *const *columns,
+				      field_t field, vtl::index_t first, int n,
+				      int *vals, quint64 &defined) const
+{
+	const int *col;
+	int i;
+
+	switch (field) {
+	case FIELD_CPU:
+		for (i = 0; i < n; i++)
+			vals[i] = (int) events->at(first + i).cpu;
+		defined = blockMask(n);
+		break;
+	case FIELD_COMMON_PID:
+		for (i = 0; i < n; i++)
+			vals[i] = events->at(first + i).pid;
+		defined = blockMask(n);
+		break;
+	case FIELD_EVENT:
+		for (i = 0; i < n; i++)
+			vals[i] = (int) events->at(first + i).type;
+		defined = blockMask(n);
+		break;
+	default:
+		/* A block never crosses a map of the TList */
+		col = &columns[field]->at(first);
+		defined = 0;
+		for (i = 0; i < n; i++) {
+			vals[i] = col[i];
+			if (col[i] != FILTEREXPR_UNDEFINED)
+				defined |= (quint64) 0x1 << i;
+		}
+		break;
+	}
+}
+
+__always_inline quint64 FilterExpr::compare(const Insn &insn,
+					    const int *vals, int n) const
+{
+	const FilterSet *set;
+	quint64 m = 0;
+	int v = insn.value;
+	int i;
+
+	switch (insn.op) {
+	case OP_EQ:
+		for (i = 0; i < n; i++)
+			m |= (quint64) (vals[i] == v) << i;
+		break;
+	case OP_NE:
+		for (i = 0; i < n; i++)
+			m |= (quint64) (vals[i] != v) << i;
+		break;
+	case OP_LT:
+		for (i = 0; i < n; i++)
+			m |= (quint64) (vals[i] < v) << i;
+		break;
+	case OP_LE:
+		for (i = 0; i < n; i++)
+			m |= (quint64) (vals[i] <= v) << i;
+		break;
+	case OP_GT:
+		for (i = 0; i < n; i++)
+			m |= (quint64) (vals[i] > v) << i;
+		break;
+	case OP_GE:
+		for (i = 0; i < n; i++)
+			m |= (quint64) (vals[i] >= v) << i;
+		break;
+	case OP_RANGE:
+		for (i = 0; i < n; i++)
+			m |= (quint64) (vals[i] >= v && vals[i] <= insn.high)
+				<< i;
+		break;
+	case OP_IN:
+		set = &sets[insn.high];
+		for (i = 0; i < n; i++)
+			m |= (quint64) set->contains(vals[i]) << i;
+		break;
+	default:
+		break;
+	}
+	return m;
+}
+
+/*
+ * Returns a mask with bit i set if the event first + i matches, for i < n.
+ * The columns array holds the decoded column of each field that the
+ * expression uses, see fieldIsDecoded().
+ *
+ * Each entry of the stack is a pair of masks. The events whose bits are set in
+ * known have a true or false value, which is given by the bit in truth. The
+ * bits of truth are always clear for the unknown events.
+ */
+__always_inline quint64 FilterExpr::eval(const vtl::TList<TraceEvent> *events,
+					 const vtl::TList<int> *const *columns,
+					 vtl::index_t first, int n) const
+{
+	quint64 truth[FILTEREXPR_MAX_DEPTH];
+	quint64 known[FILTEREXPR_MAX_DEPTH];
+	int vals[FILTEREXPR_BLOCK];
+	quint64 defined = 0;
+	quint64 full = blockMask(n);
+	quint64 t0, t1, k0, k1;
+	int loaded = -1;
+	int sp = 0;
+	int i;
+
+	for (i = 0; i < program.size(); i++) {
+		const Insn &insn = program[i];
+		switch (insn.op) {
+		case OP_AND:
+			sp--;
+			t0 = truth[sp - 1];
+			k0 = known[sp - 1];
+			t1 = truth[sp];
+			k1 = known[sp];
+			/* A known false operand makes the result false */
+			truth[sp - 1] = t0 & t1;
+			known[sp - 1] = (k0 & k1) | (k0 & ~t0) | (k1 & ~t1);
+			break;
+		case OP_OR:
+			sp--;
+			t0 = truth[sp - 1];
+			k0 = known[sp - 1];
+			t1 = truth[sp];
+			k1 = known[sp];
+			/* A true operand makes the result true */
+			truth[sp - 1] = t0 | t1;
+			known[sp - 1] = (k0 & k1) | t0 | t1;
+			break;
+		case OP_NOT:
+			truth[sp - 1] = ~truth[sp - 1] & known[sp - 1];
+			break;
+		default:
+			/* Consecutive comparisons often test the same field */
+			if (insn.field != loaded) {
+				load(events, columns, insn.field, first, n,
+				     vals, defined);
+				loaded = insn.field;
+			}
+			truth[sp] = compare(insn, vals, n) & defined;
+			known[sp] = defined;
+			sp++;
+			break;
+		}
+	}
+	return sp > 0 ? truth[0] & full : full;
+}
+
+#endif /* FILTEREXPR_H */
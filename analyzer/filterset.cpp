@@ -1,6 +1,6 @@
 /*
  * Traceshark - a visualizer for visualizing ftrace and perf traces
- * Copyright (C) 2014, 2015, 2016  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ * Copyright (C) 2018  Viktor Rosendahl <viktor.rosendahl@gmail.com>
  *
  * This file is dual licensed: you can use it either under the terms of
  * the GPL, or the BSD license, at your option.
@@ -49,14 +49,22 @@
  *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
-#include "analyzer/cpufreq.h"
+#include "analyzer/filterset.h"
 
-bool CpuFreq::doScale()
+FilterSet::FilterSet():
+	low(0), nrBits(0)
+{}
+
+void FilterSet::clear()
+{
+	low = 0;
+	nrBits = 0;
+	words.clear();
+}
+
+void FilterSet::setRange(int first, int last)
 {
-	int i;
-	int s = data.size();
-	scaledData.resize(s);
-	for (i = 0; i < s; i++)
-		scaledData[i] = data[i] * scale + offset;
-	return false; /* No error */	
+	low = first;
+	nrBits = (unsigned int) ((qint64) last - first + 1);
+	words.fill(0, (nrBits + 63) / 64);
 }
@@ -0,0 +1,118 @@
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2018  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef FILTERSET_H
+#define FILTERSET_H
+
+#include <QMap>
+#include <QVector>
+#include <QtGlobal>
+#include "misc/traceshark.h"
+
+/*
+ * A set of integers, such as pids or event types, stored as a bitmap that
+ * covers the range from the smallest to the largest member. This is what the
+ * filters test the events against, since a test is a couple of instructions
+ * instead of a search in a QMap.
+ */
+class FilterSet {
+public:
+	FilterSet();
+	void clear();
+	template<typename K, typename V>
+		void build(const QMap<K, V> &map);
+	__always_inline bool contains(int value) const;
+	__always_inline bool isEmpty() const;
+private:
+	void setRange(int first, int last);
+	__always_inline void insert(int value);
+	int low;
+	unsigned int nrBits;
+	QVector<quint64> words;
+};
+
+__always_inline bool FilterSet::contains(int value) const
+{
+	quint64 offset = (quint64) ((qint64) value - low);
+
+	if (offset >= nrBits)
+		return false;
+	return (words[offset >> 6] >> (offset & 63)) & 0x1;
+}
+
+__always_inline bool FilterSet::isEmpty() const
+{
+	return nrBits == 0;
+}
+
+__always_inline void FilterSet::insert(int value)
+{
+	quint64 offset = (quint64) ((qint64) value - low);
+
+	words[offset >> 6] |= (quint64) 0x1 << (offset & 63);
+}
+
+/* The set will contain the keys of the map */
+template<typename K, typename V>
+void FilterSet::build(const QMap<K, V> &map)
+{
+	typename QMap<K, V>::const_iterator iter;
+
+	clear();
+	if (map.isEmpty())
+		return;
+	/* A QMap is sorted, so the range is given by the first and last key */
+	setRange((int) map.firstKey(), (int) map.lastKey());
+	for (iter = map.constBegin(); iter != map.constEnd(); iter++)
+		insert((int) iter.key());
+}
+
+#endif /* FILTERSET_H */
@@ -0,0 +1,305 @@
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2018  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LODPYRAMID_H
+#define LODPYRAMID_H
+
+#include <cmath>
+#include <QVector>
+#include "misc/traceshark.h"
+#include "vtl/memusage.h"
+
+template<class T> class ArenaVector;
+
+namespace vtl {
+	class BitVector;
+}
+
+/* Series with fewer samples than this are always drawn from the raw data */
+#define LOD_MIN_SAMPLES (4096)
+/* The average number of samples in a bucket at the finest level */
+#define LOD_SAMPLES_PER_BUCKET (4)
+#define LOD_MAX_LEVELS (48)
+
+/*
+ * A bucket summarizes the samples of a series whose times fall into the
+ * interval [start + index * width, start + (index + 1) * width), where width
+ * is the bucket width of the level. Empty buckets are not stored.
+ */
+class LodBucket {
+public:
+	LodBucket() {}
+	LodBucket(float value):
+		key(0), index(0), min(value), max(value), last(value) {}
+	__always_inline void merge(const LodBucket &later);
+	double key;   /* Time of the first sample in the bucket */
+	int index;
+	float min;
+	float max;    /* For scheduling data, any scheduling in the bucket */
+	float last;   /* The value that continues into the following bucket */
+};
+
+__always_inline void LodBucket::merge(const LodBucket &later)
+{
+	min = TSMIN(min, later.min);
+	max = TSMAX(max, later.max);
+	last = later.last;
+}
+
+/*
+ * A multi resolution summary of a series. Level k has buckets that are 2^k
+ * times as wide as the buckets of level 0, so that a graph can pick the level
+ * whose buckets are about one pixel wide and draw a number of points that
+ * depends on the width of the plot rather than on the number of samples.
+ *
+ * The Bucket class needs the key and index members and a merge() function
+ * that adds a later bucket to it. Merging is used both for adding the samples
+ * to level 0 and for building each coarser level from the previous one.
+ */
+template<class Bucket>
+class LodPyramid {
+public:
+	LodPyramid();
+	template<typename BucketFn>
+		void build(const double *keys, int n, int minSamples,
+			   double samplesPerBucket, BucketFn bucketAt);
+	void build(const QVector<double> &keys, const QVector<double> &values);
+	void build(const ArenaVector<double> &keys, const vtl::BitVector &bits,
+		   double zero, double one);
+	void clear();
+	__always_inline bool isEmpty() const;
+	__always_inline int nrLevels() const;
+	__always_inline double bucketWidth(int level) const;
+	__always_inline const QVector<Bucket> &level(int level) const;
+	int findLevel(double keys, double pixels) const;
+	int findBucket(int level, double key) const;
+	vtl::MemUsage memUsage() const;
+private:
+	double start;
+	double quantum;
+	QVector<QVector<Bucket> > levels;
+};
+
+/* These are only defined for LodBucket, in lodpyramid.cpp */
+template<>
+void LodPyramid<LodBucket>::build(const QVector<double> &keys,
+				  const QVector<double> &values);
+template<>
+void LodPyramid<LodBucket>::build(const ArenaVector<double> &keys,
+				  const vtl::BitVector &bits,
+				  double zero, double one);
+
+template<class Bucket>
+LodPyramid<Bucket>::LodPyramid():
+	start(0), quantum(0)
+{}
+
+template<class Bucket>
+__always_inline bool LodPyramid<Bucket>::isEmpty() const
+{
+	return levels.isEmpty();
+}
+
+template<class Bucket>
+__always_inline int LodPyramid<Bucket>::nrLevels() const
+{
+	return levels.size();
+}
+
+template<class Bucket>
+__always_inline double LodPyramid<Bucket>::bucketWidth(int level) const
+{
+	return ldexp(quantum, level);
+}
+
+template<class Bucket>
+__always_inline const QVector<Bucket> &LodPyramid<Bucket>::level(int level)
+	const
+{
+	return levels[level];
+}
+
+/*
+ * The bucketAt function returns a bucket that holds only the sample i, the
+ * key and index of which are filled in here. Nothing is built for fewer than
+ * minSamples samples.
+ */
+template<class Bucket>
+template<typename BucketFn>
+void LodPyramid<Bucket>::build(const double *keys, int n, int minSamples,
+			       double samplesPerBucket, BucketFn bucketAt)
+{
+	int i, k, s, idx, prev;
+	double duration;
+
+	clear();
+	if (n < minSamples)
+		return;
+
+	start = keys[0];
+	duration = keys[n - 1] - start;
+	if (!(duration > 0))
+		return;
+	quantum = duration * samplesPerBucket / n;
+
+	levels.resize(1);
+	QVector<Bucket> *cur = &levels[0];
+	cur->reserve((int) (n / samplesPerBucket) + 1);
+
+	prev = -1;
+	for (i = 0; i < n; i++) {
+		idx = (int) ((keys[i] - start) / quantum);
+		Bucket b = bucketAt(i);
+		if (idx != prev) {
+			b.key = keys[i];
+			b.index = idx;
+			cur->append(b);
+			prev = idx;
+			continue;
+		}
+		cur->last().merge(b);
+	}
+	cur->squeeze();
+
+	/* Each coarser level merges pairs of buckets of the previous level */
+	for (k = 1; k < LOD_MAX_LEVELS && levels[k - 1].size() > 2; k++) {
+		levels.resize(k + 1);
+		const QVector<Bucket> &fine = levels[k - 1];
+		QVector<Bucket> &coarse = levels[k];
+		s = fine.size();
+		coarse.reserve(s / 2 + 1);
+		prev = -1;
+		for (i = 0; i < s; i++) {
+			const Bucket &f = fine[i];
+			idx = f.index >> 1;
+			if (idx != prev) {
+				Bucket b = f;
+				b.index = idx;
+				coarse.append(b);
+				prev = idx;
+				continue;
+			}
+			coarse.last().merge(f);
+		}
+		coarse.squeeze();
+	}
+}
+
+template<class Bucket>
+void LodPyramid<Bucket>::clear()
+{
+	levels.clear();
+	start = 0;
+	quantum = 0;
+}
+
+template<class Bucket>
+vtl::MemUsage LodPyramid<Bucket>::memUsage() const
+{
+	quint64 reserved, used;
+	int i;
+
+	reserved = (quint64) levels.capacity() * sizeof(QVector<Bucket>);
+	used = (quint64) levels.size() * sizeof(QVector<Bucket>);
+	for (i = 0; i < levels.size(); i++) {
+		reserved += (quint64) levels[i].capacity() * sizeof(Bucket);
+		used += (quint64) levels[i].size() * sizeof(Bucket);
+	}
+	return vtl::MemUsage(reserved, used);
+}
+
+/*
+ * Returns the coarsest level whose buckets are not wider than a pixel, when
+ * an interval that is keys wide is drawn on pixels pixels, or -1 if even the
+ * finest level is too coarse, in which case the raw data should be used.
+ */
+template<class Bucket>
+int LodPyramid<Bucket>::findLevel(double keys, double pixels) const
+{
+	double keysPerPixel;
+	int k;
+
+	if (levels.isEmpty() || !(pixels > 0))
+		return -1;
+	keysPerPixel = keys / pixels;
+	if (!(keysPerPixel > 0))
+		return -1;
+	k = (int) floor(log2(keysPerPixel / quantum));
+	if (k < 0)
+		return -1;
+	return TSMIN(k, levels.size() - 1);
+}
+
+/*
+ * Returns the index of the last bucket at the level whose key is not greater
+ * than key, or 0 if there is no such bucket
+ */
+template<class Bucket>
+int LodPyramid<Bucket>::findBucket(int level, double key) const
+{
+	const QVector<Bucket> &b = levels[level];
+	int lo = 0;
+	int hi = b.size() - 1;
+	int mid;
+
+	if (hi < 0 || b[0].key > key)
+		return 0;
+	while (lo < hi) {
+		mid = (lo + hi + 1) / 2;
+		if (b[mid].key <= key)
+			lo = mid;
+		else
+			hi = mid - 1;
+	}
+	return lo;
+}
+
+#endif /* LODPYRAMID_H */
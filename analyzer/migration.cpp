@@ -0,0 +1,152 @@
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2018  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+
+#include "analyzer/migration.h"
+
+MigrationList::MigrationList():
+	offset(0), unit(0)
+{}
+
+void MigrationList::clear()
+{
+	timev.clear();
+	pidv.clear();
+	oldcpuv.clear();
+	newcpuv.clear();
+	lod.clear();
+}
+
+vtl::MemUsage MigrationList::memUsage() const
+{
+	quint64 reserved, used;
+	vtl::MemUsage usage;
+
+	reserved = (quint64) timev.capacity() * sizeof(double) +
+		(quint64) (pidv.capacity() + oldcpuv.capacity() +
+			   newcpuv.capacity()) * sizeof(int);
+	used = (quint64) timev.size() * sizeof(double) +
+		(quint64) (pidv.size() + oldcpuv.size() + newcpuv.size()) *
+		sizeof(int);
+	usage = vtl::MemUsage(reserved, used);
+	usage += lod.memUsage();
+	return usage;
+}
+
+/*
+ * The events of a trace are in time order, so this is normally only a check.
+ * A trace that has been merged from several buffers could still have some
+ * reordering, though.
+ */
+void MigrationList::sortByTime()
+{
+	const double *t = timev.constData();
+	int n = timev.size();
+	QVector<int> perm(n);
+	QVector<double> stime(n);
+	QVector<int> spid(n);
+	QVector<int> sold(n);
+	QVector<int> snew(n);
+	int i, p;
+
+	if (std::is_sorted(t, t + n))
+		return;
+
+	for (i = 0; i < n; i++)
+		perm[i] = i;
+	std::stable_sort(perm.begin(), perm.end(), [t](int a, int b) {
+			return t[a] < t[b];
+		});
+
+	for (i = 0; i < n; i++) {
+		p = perm[i];
+		stime[i] = timev[p];
+		spid[i] = pidv[p];
+		sold[i] = oldcpuv[p];
+		snew[i] = newcpuv[p];
+	}
+	timev.swap(stime);
+	pidv.swap(spid);
+	oldcpuv.swap(sold);
+	newcpuv.swap(snew);
+}
+
+/* On average, there is one migration per bucket at the finest level */
+void MigrationList::buildLod()
+{
+	lod.build(timev.constData(), timev.size(), MIGRATION_LOD_MIN, 1,
+		  [this](int i) {
+			int lo = lane(oldcpuv[i]);
+			int hi = lane(newcpuv[i]);
+			return lo <= hi ? MigrationBucket(lo, hi) :
+				MigrationBucket(hi, lo);
+		});
+}
+
+/* This is called from a worker thread when the trace has been processed */
+void MigrationList::build()
+{
+	timev.squeeze();
+	pidv.squeeze();
+	oldcpuv.squeeze();
+	newcpuv.squeeze();
+	sortByTime();
+	buildLod();
+}
+
+/* Returns the index of the first migration that is not before time */
+int MigrationList::lowerBound(double time) const
+{
+	const double *t = timev.constData();
+
+	return std::lower_bound(t, t + timev.size(), time) - t;
+}
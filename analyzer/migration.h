@@ -52,14 +52,87 @@
 #ifndef MIGRATION_H
 #define MIGRATION_H
 
-#include "vtl/time.h"
+#include <QVector>
+#include "analyzer/lodpyramid.h"
+#include "misc/traceshark.h"
+#include "vtl/memusage.h"
 
-class Migration {
+/* With fewer migrations than this, the arrows are always drawn one by one */
+#define MIGRATION_LOD_MIN (4096)
+
+/*
+ * A bucket counts the migrations whose times fall into the interval
+ * [start + index * width, start + (index + 1) * width), where width is the
+ * bucket width of the level. A lane is 0 for fork and exit and cpu + 1 for a
+ * CPU. Empty buckets are not stored.
+ */
+class MigrationBucket {
+public:
+	MigrationBucket() {}
+	MigrationBucket(int lo, int hi):
+		key(0), index(0), count(1), lowLane(lo), highLane(hi) {}
+	__always_inline void merge(const MigrationBucket &later);
+	double key;   /* Time of the first migration in the bucket */
+	int index;
+	int count;
+	int lowLane;
+	int highLane;
+};
+
+__always_inline void MigrationBucket::merge(const MigrationBucket &later)
+{
+	count += later.count;
+	lowLane = TSMIN(lowLane, later.lowLane);
+	highLane = TSMAX(highLane, later.highLane);
+}
+
+/*
+ * All migrations, forks and exits of a trace, stored as flat arrays in time
+ * order. The lod counts the migrations in buckets, so that a dense part of
+ * the trace can be drawn as bands whose number depends on the width of the
+ * plot rather than on the number of migrations.
+ */
+class MigrationList {
 public:
-	int pid;
-	int oldcpu;
-	int newcpu;
-	vtl::Time time;
+	MigrationList();
+	__always_inline void append(int pid, int oldcpu, int newcpu,
+				    double time);
+	void build();
+	void clear();
+	__always_inline int size() const;
+	__always_inline int lane(int cpu) const;
+	int lowerBound(double time) const;
+	vtl::MemUsage memUsage() const;
+	QVector<double> timev;
+	QVector<int> pidv;
+	QVector<int> oldcpuv;   /* -1 for a fork */
+	QVector<int> newcpuv;   /* -1 for an exit */
+	/* The value of a lane is offset + lane * unit */
+	double offset;
+	double unit;
+	LodPyramid<MigrationBucket> lod;
+private:
+	void sortByTime();
+	void buildLod();
 };
 
-#endif /* MIGRATION */
+__always_inline void MigrationList::append(int pid, int oldcpu, int newcpu,
+					   double time)
+{
+	pidv.append(pid);
+	oldcpuv.append(oldcpu);
+	newcpuv.append(newcpu);
+	timev.append(time);
+}
+
+__always_inline int MigrationList::size() const
+{
+	return timev.size();
+}
+
+__always_inline int MigrationList::lane(int cpu) const
+{
+	return cpu + 1;
+}
+
+#endif /* MIGRATION_H */
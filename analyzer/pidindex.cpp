@@ -0,0 +1,97 @@
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2018  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "analyzer/pidindex.h"
+#include "misc/traceshark.h"
+
+PidIndex::PidIndex():
+	nrPids(0)
+{}
+
+/* Inserts a pid that is not present and returns its new index */
+int PidIndex::insert(int pid)
+{
+	int index = nrPids;
+	int s;
+
+	if ((unsigned int) pid >= PIDINDEX_MAX_DIRECT) {
+		other.insert(pid, index);
+		nrPids++;
+		return index;
+	}
+
+	if (pid >= direct.size()) {
+		s = TSMAX(direct.size() * 2, PIDINDEX_MIN_DIRECT);
+		s = TSMAX(s, pid + 1);
+		s = TSMIN(s, PIDINDEX_MAX_DIRECT);
+		/* The new elements are zero, i.e. not present */
+		direct.resize(s);
+	}
+	direct[pid] = index + 1;
+	nrPids++;
+	return index;
+}
+
+void PidIndex::clear()
+{
+	direct.clear();
+	other.clear();
+	nrPids = 0;
+}
+
+/* The nodes of the hash are counted without their overhead */
+vtl::MemUsage PidIndex::memUsage() const
+{
+	quint64 hash = (quint64) other.size() * 2 * sizeof(int);
+
+	return vtl::MemUsage((quint64) direct.capacity() * sizeof(int) + hash,
+			     (quint64) direct.size() * sizeof(int) + hash);
+}
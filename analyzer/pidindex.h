@@ -0,0 +1,102 @@
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2018  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PIDINDEX_H
+#define PIDINDEX_H
+
+#include <QHash>
+#include <QVector>
+
+#include "vtl/compiler.h"
+#include "vtl/memusage.h"
+
+/* Pids below this are looked up in an array, PID_MAX_LIMIT of Linux */
+#define PIDINDEX_MAX_DIRECT (4194304)
+/* The size of the array when the first pid is inserted */
+#define PIDINDEX_MIN_DIRECT (32768)
+
+/*
+ * Gives each pid a dense index, in the order that the pids are inserted, so
+ * that the data of the pids can be kept in arrays. Since pids are bounded, the
+ * index of a pid is found in an array with the pid as index. The array holds
+ * the index plus one, so that the zeroes of a grown array mean that the pid is
+ * not present. Negative pids, which some kernels have, are kept in a hash.
+ */
+class PidIndex {
+public:
+	PidIndex();
+	__always_inline int find(int pid) const;
+	int insert(int pid);
+	__always_inline int size() const;
+	void clear();
+	vtl::MemUsage memUsage() const;
+private:
+	QVector<int> direct;
+	QHash<int, int> other;
+	int nrPids;
+};
+
+/* Returns the index of pid, or -1 if it has not been inserted */
+__always_inline int PidIndex::find(int pid) const
+{
+	if (likely((unsigned int) pid < (unsigned int) direct.size()))
+		return direct.constData()[pid] - 1;
+	if ((unsigned int) pid < PIDINDEX_MAX_DIRECT)
+		return -1;
+	return other.value(pid, -1);
+}
+
+__always_inline int PidIndex::size() const
+{
+	return nrPids;
+}
+
+#endif /* PIDINDEX_H */
@@ -0,0 +1,146 @@
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2018  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+
+#include "analyzer/cputask.h"
+#include "analyzer/spanindex.h"
+
+SpanIndex::SpanIndex()
+{}
+
+/*
+ * The tasks are all the CPUTasks of one CPU. The task index of a span refers
+ * to this array.
+ */
+void SpanIndex::build(CPUTask *const *tasks, int nr)
+{
+	int t, i, n, count = 0;
+
+	spans.resize(0);
+	for (t = 0; t < nr; t++)
+		count += tasks[t]->schedData.size() / 2 + 1;
+	spans.reserve(count);
+
+	for (t = 0; t < nr; t++) {
+		const CPUTask *task = tasks[t];
+		n = TSMIN(task->schedTimev.size(),
+			  (int) task->schedData.size());
+		n = TSMIN(n, task->schedEventIdx.size());
+		for (i = 0; i < n - 1; i++) {
+			if (!task->schedData.readbool(i))
+				continue;
+			SchedSpan span;
+			span.start = task->schedTimev[i];
+			span.end = task->schedTimev[i + 1];
+			span.task = t;
+			span.eventIdx = task->schedEventIdx[i];
+			spans.append(span);
+		}
+	}
+
+	std::sort(spans.begin(), spans.end(),
+		  [](const SchedSpan &a, const SchedSpan &b) {
+			  return a.start < b.start;
+		  });
+	spans.squeeze();
+}
+
+void SpanIndex::clear()
+{
+	spans.clear();
+}
+
+/* Returns the index of the span that contains time, or -1 */
+int SpanIndex::findSpan(double time) const
+{
+	const SchedSpan *first = spans.constData();
+	const SchedSpan *last = first + spans.size();
+	const SchedSpan *s;
+
+	s = std::upper_bound(first, last, time,
+			     [](double t, const SchedSpan &span) {
+				     return t < span.start;
+			     });
+	if (s == first)
+		return -1;
+	s--;
+	if (time > s->end)
+		return -1;
+	return s - first;
+}
+
+/*
+ * Returns the index of the span that contains time or, if there is none, the
+ * closest span that is at most maxDistance away from it. Returns -1 if there
+ * is no such span.
+ */
+int SpanIndex::findNearest(double time, double maxDistance) const
+{
+	const SchedSpan *first = spans.constData();
+	const SchedSpan *last = first + spans.size();
+	const SchedSpan *s;
+	double before, after;
+
+	s = std::upper_bound(first, last, time,
+			     [](double t, const SchedSpan &span) {
+				     return t < span.start;
+			     });
+	before = s == first ? maxDistance + 1 : time - (s - 1)->end;
+	if (s != first && before <= 0)
+		return s - 1 - first;
+	after = s == last ? maxDistance + 1 : s->start - time;
+	if (before <= after && before <= maxDistance)
+		return s - 1 - first;
+	if (after < before && after <= maxDistance)
+		return s - first;
+	return -1;
+}
@@ -0,0 +1,112 @@
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2018  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef SPANINDEX_H
+#define SPANINDEX_H
+
+#include <QVector>
+#include "misc/traceshark.h"
+#include "vtl/index.h"
+#include "vtl/memusage.h"
+
+class CPUTask;
+
+/* An interval of time during which a task was running on a CPU */
+class SchedSpan {
+public:
+	double start;
+	double end;
+	int task;              /* Index of the CPUTask on the CPU */
+	vtl::index_t eventIdx; /* Index of the event that started the span */
+};
+
+/*
+ * The spans of all tasks of one CPU, sorted by start time. Since only one
+ * task at a time can run on a CPU, the spans do not overlap and the span at a
+ * given time can be found with a binary search.
+ */
+class SpanIndex {
+public:
+	SpanIndex();
+	void build(CPUTask *const *tasks, int nr);
+	void clear();
+	__always_inline bool isEmpty() const;
+	__always_inline int size() const;
+	__always_inline const SchedSpan &at(int index) const;
+	int findSpan(double time) const;
+	int findNearest(double time, double maxDistance) const;
+	__always_inline vtl::MemUsage memUsage() const;
+private:
+	QVector<SchedSpan> spans;
+};
+
+__always_inline bool SpanIndex::isEmpty() const
+{
+	return spans.isEmpty();
+}
+
+__always_inline int SpanIndex::size() const
+{
+	return spans.size();
+}
+
+__always_inline const SchedSpan &SpanIndex::at(int index) const
+{
+	return spans[index];
+}
+
+__always_inline vtl::MemUsage SpanIndex::memUsage() const
+{
+	return vtl::MemUsage((quint64) spans.capacity() * sizeof(SchedSpan),
+			     (quint64) spans.size() * sizeof(SchedSpan));
+}
+
+#endif /* SPANINDEX_H */
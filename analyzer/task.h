@@ -71,7 +71,6 @@ class TaskHandle {
 public:
 	TaskHandle():task(nullptr) {};
 	Task *task;
-	__always_inline Task &getTask();
 };
 
 class TaskName {
@@ -120,12 +119,6 @@ __always_inline void Task::checkName(const char *name, bool forkname)
 	}
 }
 
-__always_inline Task &TaskHandle::getTask()
-{
-	if (task == nullptr)
-		task = new Task;
-	return *task;
-}
 /*
  * If the name is not the newest name and is "forkname", then we will will
  * surrount it with {}. If the name is not the newest and not a forkname,
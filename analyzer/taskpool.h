@@ -0,0 +1,160 @@
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2018  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TASKPOOL_H
+#define TASKPOOL_H
+
+#include <QVector>
+#include <cstdlib>
+#include <new>
+
+#include "vtl/compiler.h"
+#include "vtl/error.h"
+#include "vtl/memusage.h"
+
+/* The number of objects in a chunk of a TaskPool is 1 << TASKPOOL_SHIFT */
+#define TASKPOOL_SHIFT (8)
+#define TASKPOOL_CHUNK (1 << TASKPOOL_SHIFT)
+#define TASKPOOL_MASK (TASKPOOL_CHUNK - 1)
+
+/*
+ * Keeps objects in chunks of contiguous storage, in the order that they were
+ * added, so that an object is found from its index with two loads. The
+ * objects are never moved, so pointers to them stay valid until clear()
+ * destroys all of them.
+ */
+template<class T>
+class TaskPool {
+public:
+	TaskPool();
+	~TaskPool();
+	__always_inline T *add();
+	__always_inline T &operator[](int index) const;
+	__always_inline int size() const;
+	void clear();
+	vtl::MemUsage memUsage() const;
+private:
+	void addChunk();
+	QVector<T*> chunks;
+	int nrElements;
+};
+
+template<class T>
+TaskPool<T>::TaskPool():
+	nrElements(0)
+{}
+
+template<class T>
+TaskPool<T>::~TaskPool()
+{
+	clear();
+}
+
+template<class T>
+void TaskPool<T>::addChunk()
+{
+	T *chunk = (T*) malloc(sizeof(T) * TASKPOOL_CHUNK);
+
+	if (chunk == nullptr)
+		vtl::err(BSD_EX_OSERR, errno, "malloc() failed at %s:%d",
+			 __FILE__, __LINE__);
+	chunks.append(chunk);
+}
+
+/* Constructs a new object, whose index is size() - 1 after this */
+template<class T>
+__always_inline T *TaskPool<T>::add()
+{
+	T *ptr;
+
+	if (unlikely((nrElements >> TASKPOOL_SHIFT) == chunks.size()))
+		addChunk();
+	ptr = chunks.constData()[nrElements >> TASKPOOL_SHIFT] +
+		(nrElements & TASKPOOL_MASK);
+	nrElements++;
+	return new (ptr) T;
+}
+
+template<class T>
+__always_inline T &TaskPool<T>::operator[](int index) const
+{
+	return chunks.constData()[index >> TASKPOOL_SHIFT]
+		[index & TASKPOOL_MASK];
+}
+
+template<class T>
+__always_inline int TaskPool<T>::size() const
+{
+	return nrElements;
+}
+
+template<class T>
+void TaskPool<T>::clear()
+{
+	int i;
+
+	for (i = 0; i < nrElements; i++)
+		(*this)[i].~T();
+	for (i = 0; i < chunks.size(); i++)
+		free(chunks[i]);
+	chunks.clear();
+	nrElements = 0;
+}
+
+/* This does not include what the objects themselves have allocated */
+template<class T>
+vtl::MemUsage TaskPool<T>::memUsage() const
+{
+	return vtl::MemUsage((quint64) chunks.size() * TASKPOOL_CHUNK *
+			     sizeof(T), (quint64) nrElements * sizeof(T));
+}
+
+#endif /* TASKPOOL_H */
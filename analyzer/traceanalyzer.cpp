@@ -49,6 +49,7 @@
  *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <algorithm>
 #include <climits>
 #include <cstdlib>
 
@@ -65,19 +66,20 @@ extern "C" {
 #include <QString>
 
 #include "vtl/error.h"
+#include "vtl/mapping.h"
 #include "vtl/tlist.h"
 
 #include "analyzer/cpufreq.h"
 #include "analyzer/cpuidle.h"
+#include "analyzer/eventfinder.h"
 #include "parser/genericparams.h"
 #include "analyzer/traceanalyzer.h"
 #include "parser/traceparser.h"
 #include "misc/errors.h"
 #include "misc/setting.h"
 #include "misc/traceshark.h"
-#include "threads/workthread.h"
+#include "threads/threadpool.h"
 #include "threads/workitem.h"
-#include "threads/workqueue.h"
 
 __always_inline static int clib_open(const char *pathname, int flags,
 				     mode_t mode)
@@ -91,17 +93,19 @@ __always_inline static int clib_close(int fd)
 }
 
 TraceAnalyzer::TraceAnalyzer()
-	: events(nullptr), cpuTaskMaps(nullptr), cpuFreq(nullptr),
-	  cpuIdle(nullptr), black(0, 0, 0), white(255, 255, 255),
+	: events(nullptr), black(0, 0, 0), white(255, 255, 255),
 	  migrationOffset(0), migrationScale(0), maxCPU(0), nrCPUs(0),
 	  endTime(false, 0, 0, 6), startTime(false, 0, 0, 6), endTimeDbl(0),
 	  startTimeDbl(0), endTimeIdx(0), maxFreq(0), minFreq(0),
-	  maxIdleState(0), minIdleState(0), timePrecision(0), CPUs(nullptr),
-	  customPlot(nullptr), pidFilterInclusive(false),
-	  OR_pidFilterInclusive(false)
+	  maxIdleState(0), minIdleState(0), timePrecision(0),
+	  customPlot(nullptr), pidEventsBuilt(false),
+	  pidFilterInclusive(false), OR_pidFilterInclusive(false),
+	  argIndexItem(this, &TraceAnalyzer::buildArgIndex),
+	  argIndexStarted(false)
 {
 	taskNamePool = new StringPool(16384, 256);
 	parser = new TraceParser();
+	AbstractTask::setArenas(&timeArena, &indexArena);
 	filterState.disableAll();
 	OR_filterState.disableAll();
 }
@@ -123,24 +127,35 @@ int TraceAnalyzer::open(const QString &fileName)
 
 void TraceAnalyzer::prepareDataStructures()
 {
-	cpuTaskMaps = new vtl::AVLTree<int, CPUTask,
-				       vtl::AVLBALANCE_USEPOINTERS>
-		[NR_CPUS_ALLOWED];
-	cpuFreq = new CpuFreq[NR_CPUS_ALLOWED];
-	cpuIdle = new CpuIdle[NR_CPUS_ALLOWED];
-	CPUs = new CPU[NR_CPUS_ALLOWED];
 	schedOffset.resize(0);
-	schedOffset.resize(NR_CPUS_ALLOWED);
 	schedScale.resize(0);
-	schedScale.resize(NR_CPUS_ALLOWED);
 	cpuIdleOffset.resize(0);
-	cpuIdleOffset.resize(NR_CPUS_ALLOWED);
 	cpuIdleScale.resize(0);
-	cpuIdleScale.resize(NR_CPUS_ALLOWED);
 	cpuFreqOffset.resize(0);
-	cpuFreqOffset.resize(NR_CPUS_ALLOWED);
 	cpuFreqScale.resize(0);
-	cpuFreqScale.resize(NR_CPUS_ALLOWED);
+	/* CPU 0 is always there, the others are added by updateMaxCPU() */
+	growCPUs(1);
+}
+
+/*
+ * Makes room for the CPUs below n. The objects of the existing CPUs do not
+ * move, since pointers to them are kept elsewhere, e.g. in the timelines.
+ */
+void TraceAnalyzer::growCPUs(unsigned int n)
+{
+	cpuTaskMaps.grow(n);
+	cpuTaskTables.grow(n);
+	cpuFreq.grow(n);
+	cpuIdle.grow(n);
+	cpuSpans.grow(n);
+	CPUs.grow(n);
+	n = CPUs.size();
+	schedOffset.resize(n);
+	schedScale.resize(n);
+	cpuIdleOffset.resize(n);
+	cpuIdleScale.resize(n);
+	cpuFreqOffset.resize(n);
+	cpuFreqScale.resize(n);
 }
 
 bool TraceAnalyzer::isOpen() const
@@ -150,34 +165,37 @@ bool TraceAnalyzer::isOpen() const
 
 void TraceAnalyzer::close()
 {
-	if (cpuTaskMaps != nullptr) {
-		delete[] cpuTaskMaps;
-		cpuTaskMaps = nullptr;
-	}
-	if (cpuFreq != nullptr) {
-		delete[] cpuFreq;
-		cpuFreq = nullptr;
-	}
-	if (cpuIdle != nullptr) {
-		delete[] cpuIdle;
-		cpuIdle = nullptr;
-	}
-	if (CPUs != nullptr) {
-		delete[] CPUs;
-		CPUs = nullptr;
-	}
+	int i;
 
-	DEFINE_TASKMAP_ITERATOR(iter) = taskMap.begin();
-	while (iter != taskMap.end()) {
-		Task *task = iter.value().task;
-		delete task;
-		iter++;
-	}
+	/* The index is built from the events, so it must be finished first */
+	argIndexGroup.wait();
+	argIndex.clear();
+	argIndexStarted = false;
+	searchMatches.clear();
+
+	cpuTaskMaps.clear();
+	cpuFreq.clear();
+	cpuIdle.clear();
+	cpuSpans.clear();
+	CPUs.clear();
 
 	taskMap.clear();
+	cpuTaskTables.clear();
+	pidIndex.clear();
+	taskPool.clear();
+	cpuTaskPool.clear();
+	/* The tasks are gone, so nothing refers to their series anymore */
+	timeArena.reset();
+	indexArena.reset();
+	schedTasks.clear();
+	schedTaskStart.clear();
 	disableAllFilters();
+	pidEventSlot.clear();
+	pidEventLists.clear();
+	pidEventsBuilt = false;
+	for (i = 0; i < FilterExpr::NR_FIELDS; i++)
+		filterColumns[i].clear();
 	migrations.clear();
-	migrationArrows.clear();
 	colorMap.clear();
 	parser->close();
 	taskNamePool->clear();
@@ -208,6 +226,7 @@ void TraceAnalyzer::processTrace()
 	 */
 	threadProcess();
 	colorizeTasks();
+	trimMemory();
 }
 
 void TraceAnalyzer::threadProcess()
@@ -224,8 +243,151 @@ void TraceAnalyzer::threadProcess()
 	default:
 		break;
 	}
+	buildCPUTaskMaps();
 	processSchedAddTail();
 	processFreqAddTail();
+	buildSchedTaskList();
+
+	/* The migrations are independent of the rest, so overlap them */
+	WorkGroup group;
+	WorkItem<TraceAnalyzer> migrationItem(this,
+					      &TraceAnalyzer::buildMigrations);
+	group.run(&migrationItem);
+	buildLod();
+	buildSpanIndex();
+	group.wait();
+}
+
+/*
+ * Gives back the memory that was reserved while the trace was processed but
+ * that is not used, i.e. the unused tails of the pools and lists, and the
+ * capacity of the vectors that were filled by appending.
+ */
+void TraceAnalyzer::trimMemory()
+{
+	unsigned int cpu;
+
+	parser->trim();
+	timeArena.trim();
+	indexArena.trim();
+	taskNamePool->trim();
+	for (cpu = 0; cpu < getNrCPUs(); cpu++) {
+		cpuFreq[cpu].timev.squeeze();
+		cpuFreq[cpu].data.squeeze();
+		cpuIdle[cpu].timev.squeeze();
+		cpuIdle[cpu].data.squeeze();
+	}
+	migrations.timev.squeeze();
+	migrations.pidv.squeeze();
+	migrations.oldcpuv.squeeze();
+	migrations.newcpuv.squeeze();
+	schedTasks.squeeze();
+	schedTaskStart.squeeze();
+}
+
+bool TraceAnalyzer::buildArgIndex()
+{
+	argIndex.build(events);
+	return false;
+}
+
+/*
+ * Starts to build the index of the strings of the events in the thread pool,
+ * unless it has already been started. The index is as large as a good part of
+ * the trace, so this is not done when a trace is loaded but when the user
+ * starts to search.
+ */
+void TraceAnalyzer::startArgIndex()
+{
+	if (argIndexStarted || !isOpen())
+		return;
+	argIndexStarted = true;
+	argIndexGroup.run(&argIndexItem);
+}
+
+/*
+ * Searches for the events that contain a string that matches text, see
+ * ArgIndex. The matching events are set in searchMatches and their number is
+ * returned. If the index is not ready, then this waits for it.
+ */
+vtl::index_t TraceAnalyzer::searchArgs(const QString &text,
+				       ArgIndex::match_t match)
+{
+	if (!isOpen()) {
+		searchMatches.clear();
+		return 0;
+	}
+	startArgIndex();
+	argIndexGroup.wait();
+	return argIndex.search(text.toUtf8(), match, searchMatches);
+}
+
+/* The memory of the elements of a vector, not of what they point to */
+template<class T>
+static __always_inline vtl::MemUsage vectorUsage(const QVector<T> &v)
+{
+	return vtl::MemUsage((quint64) v.capacity() * sizeof(T),
+			     (quint64) v.size() * sizeof(T));
+}
+
+/*
+ * Adds the memory of the trace to report. The argument index is only included
+ * if it is not being built, since this doesn't wait for it. The nodes of the
+ * AVL trees are counted without the overhead of the heap.
+ */
+void TraceAnalyzer::memReport(MemReport &report) const
+{
+	vtl::MemUsage tasks = taskPool.memUsage();
+	vtl::MemUsage filters = filteredEvents.memUsage();
+	vtl::MemUsage columns, pidLists, lod, spans, cpuData;
+	quint64 nodes = 0;
+	quint64 cache;
+	unsigned int cpu;
+	int i;
+
+	parser->memReport(report);
+	tasks += cpuTaskPool.memUsage();
+	tasks += pidIndex.memUsage();
+	for (cpu = 0; cpu < getNrCPUs(); cpu++) {
+		tasks += cpuTaskTables[cpu].memUsage();
+		nodes += cpuTaskMaps[cpu].size();
+		spans += cpuSpans[cpu].memUsage();
+		lod += cpuFreq[cpu].lod.memUsage();
+		lod += cpuIdle[cpu].lod.memUsage();
+		cpuData += vectorUsage(cpuFreq[cpu].timev);
+		cpuData += vectorUsage(cpuFreq[cpu].data);
+		cpuData += vectorUsage(cpuIdle[cpu].timev);
+		cpuData += vectorUsage(cpuIdle[cpu].data);
+	}
+	nodes *= sizeof(vtl::AVLNode<int, CPUTask*>);
+	nodes += (quint64) taskMap.size() *
+		sizeof(vtl::AVLNode<int, TaskHandle>);
+	tasks += vtl::MemUsage(nodes, nodes);
+	tasks += vectorUsage(schedTasks);
+	report.add(QString("Tasks"), tasks);
+	report.add(QString("Task time series"), timeArena.memUsage());
+	report.add(QString("Task event indices"), indexArena.memUsage());
+	report.add(QString("Task names"), taskNamePool->memUsage());
+	for (i = 0; i < schedTasks.size(); i++)
+		lod += schedTasks[i]->lod.memUsage();
+	report.add(QString("Level of detail summaries"), lod);
+	report.add(QString("CPU frequency and idle"), cpuData);
+	report.add(QString("CPU spans"), spans);
+	report.add(QString("Migrations"), migrations.memUsage());
+	filters += searchMatches.memUsage();
+	report.add(QString("Filters and search"), filters);
+	for (i = 0; i < FilterExpr::NR_FIELDS; i++)
+		columns += filterColumns[i].memUsage();
+	report.add(QString("Filter columns"), columns);
+	for (i = 0; i < pidEventLists.size(); i++)
+		pidLists += pidEventLists[i].memUsage();
+	pidLists += vectorUsage(pidEventLists);
+	report.add(QString("Event lists of the pids"), pidLists);
+	if (argIndexGroup.isIdle() && argIndex.isBuilt())
+		report.add(QString("Argument index"), argIndex.memUsage());
+	/* Mappings that were given back by pools and lists, see close() */
+	cache = vtl::get_map_cache_size();
+	report.add(QString("Recycled mappings"), vtl::MemUsage(cache, 0));
 }
 
 void TraceAnalyzer::processSchedAddTail()
@@ -235,7 +397,7 @@ void TraceAnalyzer::processSchedAddTail()
 	for (cpu = 0; cpu < getNrCPUs(); cpu++) {
 		DEFINE_CPUTASKMAP_ITERATOR(iter) = cpuTaskMaps[cpu].begin();
 		while (iter != cpuTaskMaps[cpu].end()) {
-			CPUTask &task = iter.value();
+			CPUTask &task = *iter.value();
 			unsigned int d;
 			double lastTime;
 			int lastIndex = task.schedTimev.size() - 1;
@@ -295,7 +457,7 @@ void TraceAnalyzer::processFreqAddTail()
 
 unsigned int TraceAnalyzer::guessTimePrecision()
 {
-	int s = events->size();
+	vtl::index_t s = events->size();
 	int r, p;
 
 	r = 0;
@@ -317,6 +479,50 @@ unsigned int TraceAnalyzer::guessTimePrecision()
 	return r;
 }
 
+/*
+ * Adds a Task for a pid that does not have one and returns its dense index.
+ * The Task is also added to taskMap, which keeps the tasks ordered by pid.
+ */
+int TraceAnalyzer::addTask(int pid)
+{
+	int index = pidIndex.insert(pid);
+	Task *task = taskPool.add();
+
+	Q_ASSERT(index == taskPool.size() - 1);
+	taskMap[pid].task = task;
+	return index;
+}
+
+CPUTask *TraceAnalyzer::addCPUTask(int index, int pid, unsigned int cpu)
+{
+	CPUTask *task = cpuTaskPool.add();
+
+	cpuTaskTables[cpu].insert(index, task);
+	return task;
+}
+
+/*
+ * The models, the dialogs and the passes over the CPUs need the CPUTasks of
+ * each CPU in pid order, so the tables that were used while the trace was
+ * processed are moved into cpuTaskMaps, after which they are freed.
+ */
+void TraceAnalyzer::buildCPUTaskMaps()
+{
+	unsigned int cpu;
+	CPUTask *task;
+	int i;
+
+	for (cpu = 0; cpu < getNrCPUs(); cpu++) {
+		CPUTaskTable &table = cpuTaskTables[cpu];
+		for (i = 0; i < table.capacity(); i++) {
+			task = table.taskAt(i);
+			if (task != nullptr)
+				cpuTaskMaps[cpu][task->pid] = task;
+		}
+		table.clear();
+	}
+}
+
 /*
  * This function is supposed to be called seldom, thus it's ok to not have it
  * as optimized as the other functions, e.g. in terms of inlining
@@ -325,16 +531,17 @@ void TraceAnalyzer::handleWrongTaskOnCPU(const TraceEvent &/*event*/,
 					 unsigned int cpu,
 					 CPU *eventCPU, int oldpid,
 					 const vtl::Time &oldtime,
-					 int idx)
+					 vtl::index_t idx)
 {
 	int epid = eventCPU->pidOnCPU;
 	vtl::Time prevtime, faketime;
 	double fakeDbl;
 	CPUTask *cpuTask;
 	Task *task;
+	int index;
 
 	if (epid > 0) {
-		cpuTask = &cpuTaskMaps[cpu][epid];
+		cpuTask = getCPUTask(taskIndex(epid), epid, cpu);
 		Q_ASSERT(!cpuTask->isNew);
 		Q_ASSERT(!cpuTask->schedTimev.isEmpty());
 		prevtime = eventCPU->lastSched;
@@ -353,7 +560,8 @@ void TraceAnalyzer::handleWrongTaskOnCPU(const TraceEvent &/*event*/,
 	}
 
 	if (oldpid > 0) {
-		cpuTask = &cpuTaskMaps[cpu][oldpid];
+		index = taskIndex(oldpid);
+		cpuTask = getCPUTask(index, oldpid, cpu);
 		if (cpuTask->isNew) {
 			cpuTask->pid = oldpid;
 		}
@@ -364,7 +572,7 @@ void TraceAnalyzer::handleWrongTaskOnCPU(const TraceEvent &/*event*/,
 		cpuTask->schedData.append(SCHED_BIT);
 		cpuTask->schedEventIdx.append(idx);
 
-		task = &taskMap[oldpid].getTask();
+		task = &taskPool[index];
 		if (task->isNew) {
 			task->pid = oldpid;
 		}
@@ -400,7 +608,7 @@ void TraceAnalyzer::colorizeTasks()
 	for (cpu = 0; cpu <= getMaxCPU(); cpu++) {
 		DEFINE_CPUTASKMAP_ITERATOR(iter) = cpuTaskMaps[cpu].begin();
 		while (iter != cpuTaskMaps[cpu].end()) {
-			CPUTask &task = iter.value();
+			CPUTask &task = *iter.value();
 			iter++;
 			if (colorMap.contains(task.pid))
 				continue;
@@ -467,10 +675,11 @@ retry:
 }
 
 
-int TraceAnalyzer::binarySearch(const vtl::Time &time, int start, int end)
-	const
+vtl::index_t TraceAnalyzer::binarySearch(const vtl::Time &time,
+					 vtl::index_t start,
+					 vtl::index_t end) const
 {
-	int pivot = (end + start) / 2;
+	vtl::index_t pivot = (end + start) / 2;
 	if (pivot == start)
 		return pivot;
 	if (time < events->at(pivot).time)
@@ -479,24 +688,12 @@ int TraceAnalyzer::binarySearch(const vtl::Time &time, int start, int end)
 		return binarySearch(time, pivot, end);
 }
 
-int TraceAnalyzer::binarySearchFiltered(const vtl::Time &time, int start,
-					int end) const
-{
-	int pivot = (end + start) / 2;
-	if (pivot == start)
-		return pivot;
-	if (time < filteredEvents.at(pivot)->time)
-		return binarySearchFiltered(time, start, pivot);
-	else
-		return binarySearchFiltered(time, pivot, end);
-}
-
-int TraceAnalyzer::findIndexBefore(const vtl::Time &time) const
+vtl::index_t TraceAnalyzer::findIndexBefore(const vtl::Time &time) const
 {
 	if (events->size() < 1)
 		return -1;
 
-	int end = events->size() - 1;
+	vtl::index_t end = events->size() - 1;
 
 	/* Basic sanity checks */
 	if (time > events->at(end).time)
@@ -504,19 +701,19 @@ int TraceAnalyzer::findIndexBefore(const vtl::Time &time) const
 	if (time < events->at(0).time)
 		return 0;
 
-	int c = binarySearch(time, 0, end);
+	vtl::index_t c = binarySearch(time, 0, end);
 
 	while (c > 0 && events->at(c).time >= time)
 		c--;
 	return c;
 }
 
-int TraceAnalyzer::findIndexAfter(const vtl::Time &time) const
+vtl::index_t TraceAnalyzer::findIndexAfter(const vtl::Time &time) const
 {
 	if (events->size() < 1)
 		return -1;
 
-	int end = events->size() - 1;
+	vtl::index_t end = events->size() - 1;
 
 	/* Basic sanity checks */
 	if (time > events->at(end).time)
@@ -524,39 +721,20 @@ int TraceAnalyzer::findIndexAfter(const vtl::Time &time) const
 	if (time < events->at(0).time)
 		return 0;
 
-	int c = binarySearch(time, 0, end);
+	vtl::index_t c = binarySearch(time, 0, end);
 
 	while (c < end && events->at(c).time <= time)
 		c++;
 	return c;
 }
 
-int TraceAnalyzer::findFilteredIndexBefore(const vtl::Time &time) const
-{
-	if (filteredEvents.size() < 1)
-		return -1;
-
-	int end = filteredEvents.size() - 1;
-
-	/* Basic sanity checks */
-	if (time > filteredEvents.at(end)->time)
-		return end;
-	if (time < filteredEvents.at(0)->time)
-		return 0;
-
-	int c = binarySearchFiltered(time, 0, end);
-
-	while (c > 0 && filteredEvents.at(c)->time >= time)
-		c--;
-	return c;
-}
-
 const TraceEvent *TraceAnalyzer::findPreviousSchedEvent(const vtl::Time &time,
 							int pid,
-							int *index) const
+							vtl::index_t *index)
+	const
 {
-	int start = findIndexBefore(time);
-	int i;
+	vtl::index_t start = findIndexBefore(time);
+	vtl::index_t i;
 
 	if (start < 0)
 		return nullptr;
@@ -575,11 +753,12 @@ const TraceEvent *TraceAnalyzer::findPreviousSchedEvent(const vtl::Time &time,
 
 const TraceEvent *TraceAnalyzer::findNextSchedSleepEvent(const vtl::Time &time,
 							 int pid,
-							 int *index) const
+							 vtl::index_t *index)
+	const
 {
-	int start = findIndexAfter(time);
-	int i;
-	int s = events->size();
+	vtl::index_t start = findIndexAfter(time);
+	vtl::index_t i;
+	vtl::index_t s = events->size();
 
 	if (start < 0)
 		return nullptr;
@@ -598,39 +777,83 @@ const TraceEvent *TraceAnalyzer::findNextSchedSleepEvent(const vtl::Time &time,
 	return nullptr;
 }
 
-const TraceEvent *TraceAnalyzer::findFilteredEvent(int index,
-						   int *filterIndex) const
+/*
+ * Returns the index of the closest event after time, or before time if forward
+ * is false, that matches pred. See EventFinder::find().
+ */
+vtl::index_t TraceAnalyzer::findEvent(const vtl::Time &time,
+				      const EventPredicate &pred,
+				      bool forward) const
 {
-	const TraceEvent *eptr = &events->at(index);
-	vtl::Time time = eptr->time;
-	int s = filteredEvents.size();
-	int i;
-	int start = findFilteredIndexBefore(time);
+	vtl::index_t start;
 
-	if (start < 0)
-		return nullptr;
+	if (!isOpen() || events->size() < 1)
+		return -1;
 
-	for (i = start; i < s; i++) {
-		const TraceEvent *cptr = filteredEvents[i];
-		if (cptr == eptr) {
-			*filterIndex = i;
-			return cptr;
-		}
-		if (cptr->time > time)
-			break;
+	if (forward) {
+		start = findIndexAfter(time);
+		if (events->at(start).time <= time)
+			return -1;
+	} else {
+		start = findIndexBefore(time);
+		if (events->at(start).time >= time)
+			return -1;
 	}
-	return nullptr;
+	return EventFinder(events).find(start, pred, forward);
+}
+
+/*
+ * Finds the first event after time that matches pred. The index of the event
+ * is stored in index, unless it is a nullptr.
+ */
+const TraceEvent *TraceAnalyzer::findNextEvent(const vtl::Time &time,
+					       const EventPredicate &pred,
+					       vtl::index_t *index) const
+{
+	vtl::index_t i = findEvent(time, pred, true);
+
+	if (i < 0)
+		return nullptr;
+	if (index != nullptr)
+		*index = i;
+	return &events->at(i);
 }
 
-const TraceEvent *TraceAnalyzer::findPreviousWakEvent(int startidx,
+/* As findNextEvent() but finds the last event before time */
+const TraceEvent *TraceAnalyzer::findPreviousEvent(const vtl::Time &time,
+						   const EventPredicate &pred,
+						   vtl::index_t *index) const
+{
+	vtl::index_t i = findEvent(time, pred, false);
+
+	if (i < 0)
+		return nullptr;
+	if (index != nullptr)
+		*index = i;
+	return &events->at(i);
+}
+
+const TraceEvent *TraceAnalyzer::findFilteredEvent(vtl::index_t index,
+						   vtl::index_t *filterIndex)
+	const
+{
+	if (index < 0 || index >= filteredEvents.size() ||
+	    !filteredEvents.test(index))
+		return nullptr;
+	*filterIndex = filteredEvents.rank(index);
+	return &events->at(index);
+}
+
+const TraceEvent *TraceAnalyzer::findPreviousWakEvent(vtl::index_t startidx,
 						      int pid,
 						      event_t wanted,
-						      int *index) const
+						      vtl::index_t *index)
+	const
 {
-	int i;
+	vtl::index_t i;
 	int epid = 0;
 
-	if (startidx < 0 || startidx >= (int) events->size())
+	if (startidx < 0 || startidx >= events->size())
 		return nullptr;
 
 	if (wanted != SCHED_WAKEUP && wanted != SCHED_WAKEUP_NEW &&
@@ -657,17 +880,17 @@ const TraceEvent *TraceAnalyzer::findPreviousWakEvent(int startidx,
 }
 
 const TraceEvent *TraceAnalyzer::findWakingEvent(const TraceEvent *wakeup,
-						 int *index) const
+						 vtl::index_t *index) const
 {
-	int i;
-	int startidx = findIndexBefore(wakeup->time);
+	vtl::index_t i;
+	vtl::index_t startidx = findIndexBefore(wakeup->time);
 	int wpid = generic_sched_wakeup_pid(*wakeup);
 	int pid;
 
 	if (wpid == INT_MAX)
 		return nullptr;
 
-	if (startidx < 0 || startidx >= (int) events->size())
+	if (startidx < 0 || startidx >= events->size())
 		return nullptr;
 
 	for (i = startidx; i >= 0; i--) {
@@ -735,160 +958,171 @@ void TraceAnalyzer::setQCustomPlot(QCustomPlot *plot)
 	customPlot = plot;
 }
 
-void TraceAnalyzer::addCpuFreqWork(unsigned int cpu,
-				   QList<AbstractWorkItem*> &list)
-{
-	double scale = cpuFreqScale.value(cpu);
-	double offset = cpuFreqOffset.value(cpu);
-	CpuFreq *freq = cpuFreq + cpu;
-	freq->scale = scale;
-	freq->offset = offset;
-	WorkItem<CpuFreq> *freqItem = new WorkItem<CpuFreq>
-		(freq, &CpuFreq::doScale);
-	list.append(freqItem);
-}
-
-void TraceAnalyzer::addCpuIdleWork(unsigned int cpu,
-				   QList<AbstractWorkItem*> &list)
-{
-	double scale = cpuIdleScale.value(cpu);
-	double offset = cpuIdleOffset.value(cpu);
-	CpuIdle *idle = cpuIdle + cpu;
-	idle->scale = scale;
-	idle->offset = offset;
-	WorkItem<CpuIdle> *idleItem = new WorkItem<CpuIdle>
-		(idle, &CpuIdle::doScale);
-	list.append(idleItem);
-}
-
-void TraceAnalyzer::addCpuSchedWork(unsigned int cpu,
-				    QList<AbstractWorkItem*> &list)
-{
-	double scale = schedScale.value(cpu);
-	double offset = schedOffset.value(cpu);
-	DEFINE_CPUTASKMAP_ITERATOR(iter) = cpuTaskMaps[cpu].begin();
-	while (iter != cpuTaskMaps[cpu].end()) {
-		CPUTask &task = iter.value();
-		task.scale = scale;
-		task.offset = offset;
-		WorkItem<CPUTask> *taskItem = new WorkItem<CPUTask>
-			(&task, &CPUTask::doScale);
-		list.append(taskItem);
-		taskItem = new WorkItem<CPUTask>(&task,
-						 &CPUTask::doScaleWakeup);
-		list.append(taskItem);
-		taskItem = new WorkItem<CPUTask>(&task,
-						 &CPUTask::doScaleRunning);
-		list.append(taskItem);
-		taskItem = new WorkItem<CPUTask>(&task,
-						 &CPUTask::doScalePreempted);
-		list.append(taskItem);
-		iter++;
+/*
+ * Collects pointers to all CPUTasks into one array, so that the scaling does
+ * not need to walk the AVL trees. The tasks of CPU n are found at the indices
+ * [schedTaskStart[n], schedTaskStart[n + 1]).
+ */
+void TraceAnalyzer::buildSchedTaskList()
+{
+	unsigned int cpu;
+
+	schedTasks.resize(0);
+	schedTaskStart.resize(0);
+	for (cpu = 0; cpu < getNrCPUs(); cpu++) {
+		schedTaskStart.append(schedTasks.size());
+		DEFINE_CPUTASKMAP_ITERATOR(iter) = cpuTaskMaps[cpu].begin();
+		while (iter != cpuTaskMaps[cpu].end()) {
+			schedTasks.append(iter.value());
+			iter++;
+		}
 	}
+	schedTaskStart.append(schedTasks.size());
 }
 
 /*
- * This function must be called from the application mainthread because it
- * creates objects that are children customPlot, which is created by the
- * mainthread
+ * The work items are numbered so that the CPUTasks come first, followed by
+ * the CpuFreq and then the CpuIdle of each CPU
  */
-void TraceAnalyzer::scaleMigration()
+void TraceAnalyzer::buildLodRange(int begin, int end)
 {
-	MigrationArrow *a;
-	QList<Migration>::iterator iter;
-	double unit = migrationScale / getNrCPUs();
-	for (iter = migrations.begin(); iter != migrations.end(); iter++) {
-		Migration &m = *iter;
-		double s = migrationOffset + (m.oldcpu + 1) * unit;
-		double e = migrationOffset + (m.newcpu + 1) * unit;
-		QColor color = getTaskColor(m.pid);
-		a = new MigrationArrow(s, e, m.time.toDouble(), color,
-				       customPlot);
-		migrationArrows.append(a);
+	int ntasks = schedTasks.size();
+	int ncpus = getNrCPUs();
+	int i;
+
+	for (i = begin; i < end; i++) {
+		if (i < ntasks)
+			schedTasks[i]->buildLod();
+		else if (i < ntasks + ncpus)
+			cpuFreq[i - ntasks].buildLod();
+		else
+			cpuIdle[i - ntasks - ncpus].buildLod();
 	}
 }
 
-void TraceAnalyzer::doScale()
+void TraceAnalyzer::buildLod()
+{
+	int nr = schedTasks.size() + 2 * getNrCPUs();
+
+	ThreadPool::instance()->parallelFor(0, nr, LOD_GRAIN,
+					    [this](int b, int e) {
+		buildLodRange(b, e);
+	});
+}
+
+/*
+ * The span index of a CPU is built from the tasks of the CPU in the order of
+ * schedTasks, so a task index of a span is an index into the tasks of the CPU
+ */
+void TraceAnalyzer::buildSpanIndex()
+{
+	ThreadPool::instance()->parallelFor(0, getNrCPUs(), 1,
+					    [this](int b, int e) {
+		int cpu;
+		for (cpu = b; cpu < e; cpu++) {
+			int first = schedTaskStart[cpu];
+			int nr = schedTaskStart[cpu + 1] - first;
+			cpuSpans[cpu].build(schedTasks.constData() + first, nr);
+		}
+	});
+}
+
+void TraceAnalyzer::scaleSchedTasks(int begin, int end)
 {
-	QList<AbstractWorkItem*> workList;
+	const int *first = schedTaskStart.constData();
+	const int *last = first + schedTaskStart.size();
 	unsigned int cpu;
-	int i, s;
-	bool useWorkList =
-		Setting::isEnabled(Setting::SHOW_CPUFREQ_GRAPHS) ||
-		Setting::isEnabled(Setting::SHOW_CPUIDLE_GRAPHS) ||
-		Setting::isEnabled(Setting::SHOW_SCHED_GRAPHS);
-
-	if (useWorkList) {
-		for (cpu = 0; cpu <= getMaxCPU(); cpu++) {
-			/* CpuFreq items */
-			if (Setting::isEnabled(Setting::SHOW_CPUFREQ_GRAPHS))
-				addCpuFreqWork(cpu, workList);
-			/* CpuIdle items */
-			if (Setting::isEnabled(Setting::SHOW_CPUIDLE_GRAPHS))
-				addCpuIdleWork(cpu, workList);
-			/* Task items */
-			if (Setting::isEnabled(Setting::SHOW_SCHED_GRAPHS))
-				addCpuSchedWork(cpu, workList);
+	double scale, offset;
+	int i, next;
+
+	if (begin >= end)
+		return;
+
+	/* Find the CPU of the first task, i.e. the last CPU starting <= begin */
+	cpu = std::upper_bound(first, last, begin) - first - 1;
+	next = schedTaskStart[cpu + 1];
+	scale = schedScale[cpu];
+	offset = schedOffset[cpu];
+
+	for (i = begin; i < end; i++) {
+		while (i >= next) {
+			cpu++;
+			next = schedTaskStart[cpu + 1];
+			scale = schedScale[cpu];
+			offset = schedOffset[cpu];
 		}
-		s = workList.size();
-		for (i = 0; i < s; i++)
-			scalingQueue.addWorkItem(workList[i]);
-		scalingQueue.start();
+		CPUTask *task = schedTasks[i];
+		task->scale = scale;
+		task->offset = offset;
 	}
+}
 
-	/* Migration scaling is done from the mainthread */
-	if (Setting::isEnabled(Setting::SHOW_MIGRATION_GRAPHS))
-		scaleMigration();
+bool TraceAnalyzer::buildMigrations()
+{
+	migrations.build();
+	return false; /* No error */
+}
 
-	if (useWorkList) {
-		scalingQueue.wait();
-		for (i = 0; i < s; i++)
-			delete workList[i];
-	}
+void TraceAnalyzer::scaleMigration()
+{
+	migrations.offset = migrationOffset;
+	migrations.unit = migrationScale / getNrCPUs();
 }
 
-void TraceAnalyzer::doStats()
+/*
+ * The graphs apply the offset and scale when they are drawn, so here we only
+ * need to update the transforms, which is cheap enough to do from the
+ * mainthread
+ */
+void TraceAnalyzer::doScale()
 {
-	QList<AbstractWorkItem*> workList;
-	int i, s;
+	unsigned int cpu;
 
-	DEFINE_TASKMAP_ITERATOR(iter);
-	for(iter = taskMap.begin(); iter != taskMap.end(); iter++) {
-		Task *task = iter.value().task;
-		WorkItem<Task> *taskItem = new WorkItem<Task>
-			(task, &Task::doStats);
-		workList.append(taskItem);
-		statsQueue.addWorkItem(taskItem);
+	for (cpu = 0; cpu <= getMaxCPU(); cpu++) {
+		cpuFreq[cpu].scale = cpuFreqScale.value(cpu);
+		cpuFreq[cpu].offset = cpuFreqOffset.value(cpu);
+		cpuIdle[cpu].scale = cpuIdleScale.value(cpu);
+		cpuIdle[cpu].offset = cpuIdleOffset.value(cpu);
 	}
 
-	statsQueue.start();
-	statsQueue.wait();
+	if (Setting::isEnabled(Setting::SHOW_SCHED_GRAPHS))
+		scaleSchedTasks(0, schedTasks.size());
 
-	s = workList.size();
-	for (i = 0; i < s; i++)
-		delete workList[i];
+	if (Setting::isEnabled(Setting::SHOW_MIGRATION_GRAPHS))
+		scaleMigration();
 }
 
-void TraceAnalyzer::doLimitedStats()
+void TraceAnalyzer::getTasks(QVector<Task*> &tasks)
 {
-	QList<AbstractWorkItem*> workList;
-	int i, s;
-
+	tasks.resize(0);
+	tasks.reserve(taskMap.size());
 	DEFINE_TASKMAP_ITERATOR(iter);
-	for(iter = taskMap.begin(); iter != taskMap.end(); iter++) {
-		Task *task = iter.value().task;
-		WorkItem<Task> *taskItem = new WorkItem<Task>
-			(task, &Task::doStatsTimeLimited);
-		workList.append(taskItem);
-		statsLimitedQueue.addWorkItem(taskItem);
-	}
+	for(iter = taskMap.begin(); iter != taskMap.end(); iter++)
+		tasks.append(iter.value().task);
+}
 
-	statsLimitedQueue.start();
-	statsLimitedQueue.wait();
+void TraceAnalyzer::doStats()
+{
+	QVector<Task*> tasks;
+
+	getTasks(tasks);
+	ThreadPool::instance()->parallelFor(0, tasks.size(), STATS_GRAIN,
+					    [&tasks](int b, int e) {
+		for (int i = b; i < e; i++)
+			tasks[i]->doStats();
+	});
+}
 
-	s = workList.size();
-	for (i = 0; i < s; i++)
-		delete workList[i];
+void TraceAnalyzer::doLimitedStats()
+{
+	QVector<Task*> tasks;
+
+	getTasks(tasks);
+	ThreadPool::instance()->parallelFor(0, tasks.size(), STATS_GRAIN,
+					    [&tasks](int b, int e) {
+		for (int i = b; i < e; i++)
+			tasks[i]->doStatsTimeLimited();
+	});
 }
 
 void TraceAnalyzer::processFtrace()
@@ -901,64 +1135,301 @@ void TraceAnalyzer::processPerf()
 	__processGeneric(TRACE_TYPE_PERF);
 }
 
-void TraceAnalyzer::processAllFilters()
+void TraceAnalyzer::compileFilters()
 {
-	int i;
-	int s = events->size();
-	const TraceEvent *eptr;
+	filterPidSet.build(filterPidMap);
+	OR_filterPidSet.build(OR_filterPidMap);
+	filterEventSet.build(filterEventMap);
+	OR_filterEventSet.build(OR_filterEventMap);
+	decodeFilterFields();
+}
 
-	filteredEvents.clear();
+/*
+ * Decodes the fields that the filter expressions use from the arguments of the
+ * events, in parallel. A column is kept until the trace is closed, so that
+ * a new expression with the same fields does not need to parse the arguments
+ * again.
+ */
+void TraceAnalyzer::decodeFilterFields()
+{
+	vtl::index_t s = events->size();
+	int nrChunks = (s + FILTER_CHUNK - 1) / FILTER_CHUNK;
+	tracetype_t ttype = getTraceType();
+	bool andArg = filterState.isEnabled(FilterState::FILTER_ARG);
+	bool orArg = OR_filterState.isEnabled(FilterState::FILTER_ARG);
+	FilterExpr::field_t field;
+	vtl::TList<int> *column;
+	int f;
+
+	for (f = 0; f < FilterExpr::NR_FIELDS; f++) {
+		field = (FilterExpr::field_t) f;
+		if (FilterExpr::fieldIsDecoded(field) &&
+		    filterColumns[f].size() == 0 &&
+		    ((andArg && filterExpr.usesField(field)) ||
+		     (orArg && OR_filterExpr.usesField(field)))) {
+			filterColumns[f].resize(s);
+			column = &filterColumns[f];
+			ThreadPool::instance()->parallelFor(
+				0, nrChunks, 1,
+				[this, field, ttype, column, s](int b, int e) {
+					FilterExpr::decodeField(
+						field, ttype, events, column,
+						(vtl::index_t) b * FILTER_CHUNK,
+						TSMIN((vtl::index_t) e *
+						      FILTER_CHUNK, s));
+				});
+		}
+		filterColumnData[f] = filterColumns[f].size() == 0 ?
+			nullptr : &filterColumns[f];
+	}
+}
 
-	for (i = 0; i < s; i++) {
-		const TraceEvent &event = events->at(i);
-		eptr = &event;
-		/* OR filters */
-		if (OR_filterState.isEnabled(FilterState::FILTER_PID) &&
-		    !__processPidFilter(event, OR_filterPidMap,
-					OR_pidFilterInclusive)) {
-			filteredEvents.append(eptr);
-			continue;
+/*
+ * Sets the bits of the events of the chunk that pass the filters. The filter
+ * expressions are evaluated for a block of 64 events at a time, which gives a
+ * word of filteredEvents.
+ */
+void TraceAnalyzer::filterChunk(int chunk)
+{
+	vtl::RankBitmap::word_t *matches = filteredEvents.data();
+	vtl::index_t first = (vtl::index_t) chunk * FILTER_CHUNK;
+	vtl::index_t last = TSMIN(first + FILTER_CHUNK, events->size());
+	bool andArg = filterState.isEnabled(FilterState::FILTER_ARG);
+	bool orArg = OR_filterState.isEnabled(FilterState::FILTER_ARG);
+	vtl::RankBitmap::word_t orWord, andWord;
+	vtl::index_t b;
+	int i, n;
+
+	for (b = first; b < last; b += FILTEREXPR_BLOCK) {
+		n = TSMIN(FILTEREXPR_BLOCK, last - b);
+		orWord = 0;
+		andWord = 0;
+		for (i = 0; i < n; i++) {
+			const TraceEvent &event = events->at(b + i);
+			if (__filterEventOR(event))
+				orWord |= (vtl::RankBitmap::word_t) 0x1 << i;
+			else if (__filterEventAND(event))
+				andWord |= (vtl::RankBitmap::word_t) 0x1 << i;
 		}
-		if (OR_filterState.isEnabled(FilterState::FILTER_EVENT)) {
-			DEFINE_FILTER_EVENTMAP_ITERATOR(iter);
-			iter = OR_filterEventMap.find(event.type);
-			if (iter != OR_filterEventMap.end()) {
-				filteredEvents.append(eptr);
-				continue;
+		if (orArg)
+			orWord |= OR_filterExpr.eval(events, filterColumnData,
+						     b, n);
+		if (andArg && andWord != 0)
+			andWord &= filterExpr.eval(events, filterColumnData,
+						   b, n);
+		matches[b >> 6] = orWord | andWord;
+	}
+}
+
+/*
+ * The events are filtered in chunks by the pool threads, each of which sets
+ * the bits of the matching events of its chunk in filteredEvents. A chunk is
+ * a whole number of words, so no word is written by two threads.
+ */
+void TraceAnalyzer::processAllFilters()
+{
+	int nrChunks = (events->size() + FILTER_CHUNK - 1) / FILTER_CHUNK;
+
+	compileFilters();
+	if (mergePidFilter())
+		return;
+
+	filteredEvents.resize(events->size());
+	ThreadPool::instance()->parallelFor(0, nrChunks, 1,
+					    [this](int b, int e) {
+		int c;
+		for (c = b; c < e; c++)
+			filterChunk(c);
+	});
+	filteredEvents.buildRank();
+}
+
+/*
+ * Each chunk of events is scanned by a pool thread, which collects the events
+ * of each pid in the chunk. The lists of a pid are then concatenated in chunk
+ * order, so that they are sorted.
+ */
+void TraceAnalyzer::buildPidEvents()
+{
+	vtl::index_t s = events->size();
+	int nrChunks = (s + FILTER_CHUNK - 1) / FILTER_CHUNK;
+	QVector<QHash<int, QVector<quint32> > > chunkLists(nrChunks);
+	QHash<int, QVector<quint32> > *lists = chunkLists.data();
+	QVector<int> slotPids;
+	int c;
+
+	/* The lists of a chunk keep the offsets of the events from its start */
+	ThreadPool::instance()->parallelFor(0, nrChunks, 1,
+					    [this, s, lists](int b, int e) {
+		vtl::index_t first;
+		int c, i, n, pid;
+		for (c = b; c < e; c++) {
+			QHash<int, QVector<quint32> > &h = lists[c];
+			first = (vtl::index_t) c * FILTER_CHUNK;
+			n = TSMIN(s - first, FILTER_CHUNK);
+			for (i = 0; i < n; i++) {
+				const TraceEvent &event = events->at(first + i);
+				h[event.pid].append(i);
+				if (__targetPid(event, pid) &&
+				    pid != event.pid)
+					h[pid].append(i);
 			}
 		}
-		if (OR_filterState.isEnabled(FilterState::FILTER_TIME)) {
-			if (event.time >= OR_filterTimeLow &&
-			    event.time <= OR_filterTimeHigh) {
-				filteredEvents.append(eptr);
+	});
+
+	pidEventSlot.clear();
+	for (c = 0; c < nrChunks; c++) {
+		QHash<int, QVector<quint32> >::const_iterator iter;
+		for (iter = lists[c].constBegin();
+		     iter != lists[c].constEnd(); iter++) {
+			if (pidEventSlot.contains(iter.key()))
 				continue;
+			pidEventSlot.insert(iter.key(), slotPids.size());
+			slotPids.append(iter.key());
+		}
+	}
+
+	pidEventLists.clear();
+	pidEventLists.resize(slotPids.size());
+	vtl::IndexList *dst = pidEventLists.data();
+	const int *pids = slotPids.constData();
+	ThreadPool::instance()->parallelFor(0, slotPids.size(), STATS_GRAIN,
+					    [nrChunks, lists, dst, pids]
+					    (int b, int e) {
+		vtl::index_t first, n;
+		int slot, c, i;
+		for (slot = b; slot < e; slot++) {
+			QHash<int, QVector<quint32> >::const_iterator iter;
+			n = 0;
+			for (c = 0; c < nrChunks; c++) {
+				iter = lists[c].constFind(pids[slot]);
+				if (iter != lists[c].constEnd())
+					n += iter.value().size();
+			}
+			dst[slot].reserve(n);
+			for (c = 0; c < nrChunks; c++) {
+				iter = lists[c].constFind(pids[slot]);
+				if (iter == lists[c].constEnd())
+					continue;
+				first = (vtl::index_t) c * FILTER_CHUNK;
+				const QVector<quint32> &list = iter.value();
+				for (i = 0; i < list.size(); i++)
+					dst[slot].append(first + list[i]);
 			}
 		}
-		/* AND filters */
-		if (filterState.isEnabled(FilterState::FILTER_PID) &&
-		    __processPidFilter(event, filterPidMap,
-				       pidFilterInclusive)) {
+	});
+	pidEventsBuilt = true;
+}
+
+const vtl::IndexList *TraceAnalyzer::pidEvents(int pid) const
+{
+	QHash<int, int>::const_iterator iter = pidEventSlot.constFind(pid);
+
+	if (iter == pidEventSlot.constEnd())
+		return nullptr;
+	return &pidEventLists[iter.value()];
+}
+
+/*
+ * The per pid lists can only be used when the pid filter is the only filter,
+ * since they say nothing about the other filters
+ */
+bool TraceAnalyzer::pidFilterIsIncremental() const
+{
+	int f;
+
+	if (OR_filterState.isEnabled())
+		return false;
+	for (f = 0; f < FilterState::NR_FILTERS; f++) {
+		if (f == FilterState::FILTER_PID)
 			continue;
+		if (filterState.isEnabled((FilterState::filter_t) f))
+			return false;
+	}
+	return filterState.isEnabled(FilterState::FILTER_PID);
+}
+
+/*
+ * When filtering only on a few pids, setting the bits of their events is much
+ * cheaper than testing all events. Returns false if this is not possible or
+ * not worthwhile, in which case all events need to be tested.
+ */
+bool TraceAnalyzer::mergePidFilter()
+{
+	QVector<const vtl::IndexList *> lists;
+	DEFINE_FILTER_PIDMAP_ITERATOR(iter);
+	const vtl::IndexList *list;
+	vtl::index_t total = 0;
+	vtl::index_t idx, j;
+	int i;
+
+	if (!pidFilterIsIncremental())
+		return false;
+	if (!pidEventsBuilt)
+		buildPidEvents();
+
+	for (iter = filterPidMap.begin(); iter != filterPidMap.end(); iter++) {
+		list = pidEvents(iter.key());
+		if (list == nullptr)
+			continue;
+		total += list->size();
+		lists.append(list);
+	}
+	if (total > events->size() / 2)
+		return false;
+
+	filteredEvents.resize(events->size());
+	for (i = 0; i < lists.size(); i++) {
+		for (j = 0; j < lists[i]->size(); j++) {
+			idx = lists[i]->at(j);
+			/*
+			 * Without inclusive filtering, the events that target
+			 * a pid only match if they belong to a filtered pid
+			 */
+			if (pidFilterInclusive ||
+			    filterPidSet.contains(events->at(idx).pid))
+				filteredEvents.set(idx);
 		}
-		if (filterState.isEnabled(FilterState::FILTER_EVENT)) {
-			DEFINE_FILTER_EVENTMAP_ITERATOR(iter);
-			iter = filterEventMap.find(event.type);
-			if (iter == filterEventMap.end())
-				continue;
-		}
-		if (filterState.isEnabled(FilterState::FILTER_TIME)) {
-			if (event.time < filterTimeLow ||
-			    event.time > filterTimeHigh)
-				continue;
-		}
-		if (filterState.isEnabled(FilterState::FILTER_CPU)) {
-			/* Add CPU nr filtering here */
-		}
-		if (filterState.isEnabled(FilterState::FILTER_ARG)) {
-			/* Add argument filtering here */
-		}
-		filteredEvents.append(eptr);
 	}
+	filteredEvents.buildRank();
+	return true;
+}
+
+/* The pid must already be in filterPidSet */
+void TraceAnalyzer::mergePidIntoFilter(int pid)
+{
+	const vtl::IndexList *list = pidEvents(pid);
+	vtl::index_t idx, i;
+
+	if (list == nullptr)
+		return;
+	for (i = 0; i < list->size(); i++) {
+		idx = list->at(i);
+		if (pidFilterInclusive || events->at(idx).pid == pid)
+			filteredEvents.set(idx);
+	}
+	filteredEvents.buildRank();
+}
+
+/*
+ * The pid must already be removed from filterPidSet. An event in the list of
+ * the pid may still match because of another pid, e.g. a wakeup by another
+ * filtered task, so those events are tested again.
+ */
+void TraceAnalyzer::subtractPidFromFilter(int pid)
+{
+	const vtl::IndexList *list = pidEvents(pid);
+	vtl::index_t idx, i;
+
+	if (list == nullptr)
+		return;
+	for (i = 0; i < list->size(); i++) {
+		idx = list->at(i);
+		if (filteredEvents.test(idx) &&
+		    !__filterEvent(events->at(idx)))
+			filteredEvents.reset(idx);
+	}
+	filteredEvents.buildRank();
 }
 
 void TraceAnalyzer::createPidFilter(QMap<int, int> &map,
@@ -1038,6 +1509,36 @@ void TraceAnalyzer::createTimeFilter(const vtl::Time &low,
 		processAllFilters();
 }
 
+/*
+ * The expression is described in filterexpr.h. If it cannot be compiled, the
+ * filters are left unchanged, error is set and false is returned.
+ */
+bool TraceAnalyzer::createArgFilter(const QString &expr, bool orlogic,
+				    QString *error)
+{
+	FilterExpr compiled;
+
+	if (expr.trimmed().isEmpty()) {
+		if (filterState.isEnabled(FilterState::FILTER_ARG))
+			disableFilter(FilterState::FILTER_ARG);
+		return true;
+	}
+	if (!compiled.compile(expr, error))
+		return false;
+
+	if (orlogic) {
+		OR_filterExpr = compiled;
+		OR_filterState.enable(FilterState::FILTER_ARG);
+	} else {
+		filterExpr = compiled;
+		filterState.enable(FilterState::FILTER_ARG);
+	}
+	/* No need to process filters if we only have OR-filters */
+	if (filterState.isEnabled())
+		processAllFilters();
+	return true;
+}
+
 void TraceAnalyzer::disableFilter(FilterState::filter_t filter)
 {
 	filterState.disable(filter);
@@ -1056,18 +1557,22 @@ void TraceAnalyzer::disableFilter(FilterState::filter_t filter)
 	case FilterState::FILTER_CPU:
 		break;
 	case FilterState::FILTER_ARG:
+		filterExpr.clear();
+		OR_filterExpr.clear();
 		break;
 	default:
 		break;
 	}
-	if (filterState.isEnabled())
+	if (filterState.isEnabled()) {
 		processAllFilters();
-	else
+	} else {
 		filteredEvents.clear();
+	}
 }
 
 void TraceAnalyzer::addPidToFilter(int pid) {
 	DEFINE_FILTER_PIDMAP_ITERATOR(iter);
+	bool incremental;
 
 	iter = filterPidMap.find(pid);
 	if (iter != filterPidMap.end()) {
@@ -1084,7 +1589,14 @@ epilogue:
 		return;
 	}
 
+	/* If only the pid filter is active, the events of the pid are merged */
+	incremental = pidFilterIsIncremental() && pidEventsBuilt;
 	filterState.enable(FilterState::FILTER_PID);
+	if (incremental) {
+		filterPidSet.build(filterPidMap);
+		mergePidIntoFilter(pid);
+		return;
+	}
 	processAllFilters();
 }
 
@@ -1104,6 +1616,11 @@ void TraceAnalyzer::removePidFromFilter(int pid) {
 		disableFilter(FilterState::FILTER_PID);
 		return;
 	}
+	if (pidFilterIsIncremental() && pidEventsBuilt) {
+		filterPidSet.build(filterPidMap);
+		subtractPidFromFilter(pid);
+		return;
+	}
 	processAllFilters();
 }
 
@@ -1118,6 +1635,9 @@ void TraceAnalyzer::disableAllFilters()
 	filterEventMap.clear();
 	OR_filterEventMap.clear();
 
+	filterExpr.clear();
+	OR_filterExpr.clear();
+
 	filteredEvents.clear();
 }
 
@@ -1185,8 +1705,7 @@ bool TraceAnalyzer::exportTraceFile(const char *fileName, int *ts_errno,
 	char *wbuf, *wb;
 	int fd, w;
 	int written, written_io, space, nrspaces, write_rval;
-	int nr_elements = filteredEvents.size();
-	int idx;
+	vtl::index_t idx;
 	int i;
 	const TraceEvent *eptr;
 	bool rval = true;
@@ -1230,7 +1749,7 @@ bool TraceAnalyzer::exportTraceFile(const char *fileName, int *ts_errno,
 		goto error_munmap;
 	}
 
-	idx = 0;
+	idx = filteredEvents.findNext(0);
 
 	if (export_type == EXPORT_TYPE_CPU_CYCLES) {
 		cpuevent_type = determineCPUEvent(ok);
@@ -1248,9 +1767,9 @@ bool TraceAnalyzer::exportTraceFile(const char *fileName, int *ts_errno,
 		space = WRITE_BUFFER_SIZE;
 		wb = wbuf;
 
-		while (idx < nr_elements && written < WRITE_BUFFER_LIMIT) {
-			eptr = filteredEvents[idx];
-			idx++;
+		while (idx >= 0 && written < WRITE_BUFFER_LIMIT) {
+			eptr = &events->at(idx);
+			idx = filteredEvents.findNext(idx + 1);
 			if (export_type == EXPORT_TYPE_CPU_CYCLES &&
 			    eptr->type != cpuevent_type)
 				continue;
@@ -1333,7 +1852,7 @@ bool TraceAnalyzer::exportTraceFile(const char *fileName, int *ts_errno,
 				}
 			} while(written_io < written);
 		}
-		if (idx >= nr_elements)
+		if (idx < 0)
 			break;
 	} while(true);
 
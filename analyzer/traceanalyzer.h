@@ -56,31 +56,44 @@
 #include <QStringList>
 #include <QVector>
 #include <QList>
+#include <QHash>
 #include <QMap>
 #include <QtGlobal>
 #include <limits>
 
 #include "vtl/avltree.h"
+#include "vtl/index.h"
+#include "vtl/indexlist.h"
+#include "vtl/rankbitmap.h"
 #include "vtl/tlist.h"
 
 #include "analyzer/cpu.h"
+#include "analyzer/cpuarray.h"
 #include "analyzer/cpufreq.h"
 #include "analyzer/cpuidle.h"
+#include "analyzer/filterexpr.h"
+#include "analyzer/filterset.h"
 #include "analyzer/filterstate.h"
 #include "parser/genericparams.h"
+#include "mm/arena.h"
+#include "mm/memreport.h"
 #include "mm/mempool.h"
 #include "analyzer/abstracttask.h"
+#include "analyzer/argindex.h"
 #include "analyzer/cputask.h"
+#include "analyzer/cputasktable.h"
+#include "analyzer/eventpredicate.h"
 #include "analyzer/tcolor.h"
 #include "parser/traceevent.h"
 #include "analyzer/migration.h"
-#include "ui/migrationarrow.h"
+#include "analyzer/pidindex.h"
+#include "analyzer/spanindex.h"
 #include "analyzer/task.h"
+#include "analyzer/taskpool.h"
 #include "parser/traceparser.h"
 #include "misc/traceshark.h"
+#include "threads/threadpool.h"
 #include "threads/workitem.h"
-#include "threads/workthread.h"
-#include "threads/workqueue.h"
 #include "vtl/time.h"
 
 #define FAKE_DELTA (vtl::Time(false, 0, 50))
@@ -95,6 +108,16 @@
  */
 #define WAKEUP_MAX ((double) 0.020)
 
+/* The number of tasks that a pool thread computes statistics for in one go */
+#define STATS_GRAIN (64)
+/* The number of graphs that a pool thread builds LOD pyramids for in one go */
+#define LOD_GRAIN (16)
+/*
+ * The number of events that a pool thread filters in one go. This must be a
+ * multiple of 64, so that no two chunks share a word of filteredEvents.
+ */
+#define FILTER_CHUNK (65536)
+
 class TraceFile;
 class QCustomPlot;
 
@@ -113,17 +136,24 @@ public:
 	void processTrace();
 	const TraceEvent *findPreviousSchedEvent(const vtl::Time &time,
 						 int pid,
-						 int *index) const;
+						 vtl::index_t *index) const;
 	const TraceEvent *findNextSchedSleepEvent(const vtl::Time &time,
 						  int pid,
-						  int *index) const;
-	const TraceEvent *findPreviousWakEvent(int startidx,
+						  vtl::index_t *index) const;
+	const TraceEvent *findPreviousWakEvent(vtl::index_t startidx,
 					       int pid,
 					       event_t wanted,
-					       int *index) const;
+					       vtl::index_t *index) const;
 	const TraceEvent *findWakingEvent(const TraceEvent *wakeup,
-					  int *index) const;
-	const TraceEvent *findFilteredEvent(int index, int *filterIndex) const;
+					  vtl::index_t *index) const;
+	const TraceEvent *findFilteredEvent(vtl::index_t index,
+					    vtl::index_t *filterIndex) const;
+	const TraceEvent *findNextEvent(const vtl::Time &time,
+					const EventPredicate &pred,
+					vtl::index_t *index) const;
+	const TraceEvent *findPreviousEvent(const vtl::Time &time,
+					    const EventPredicate &pred,
+					    vtl::index_t *index) const;
 	__always_inline unsigned int getMaxCPU() const;
 	__always_inline unsigned int getNrCPUs() const;
 	__always_inline vtl::Time getStartTime() const;
@@ -153,6 +183,8 @@ public:
 	void createEventFilter(QMap<event_t, event_t> &map, bool orlogic);
 	void createTimeFilter(const vtl::Time &low,
 			      const vtl::Time &high, bool orlogic);
+	bool createArgFilter(const QString &expr, bool orlogic,
+			     QString *error);
 	void disableFilter(FilterState::filter_t filter);
 	void addPidToFilter(int pid);
 	void removePidFromFilter(int pid);
@@ -161,28 +193,36 @@ public:
 	bool filterActive(FilterState::filter_t filter) const;
 	bool exportTraceFile(const char *fileName, int *ts_errno,
 			     exporttype_t export_type);
+	void startArgIndex();
+	vtl::index_t searchArgs(const QString &text, ArgIndex::match_t match);
+	void memReport(MemReport &report) const;
 	vtl::TList<TraceEvent> *events;
-	vtl::TList <const TraceEvent*> filteredEvents;
-	vtl::AVLTree<int, CPUTask, vtl::AVLBALANCE_USEPOINTERS>
-		*cpuTaskMaps;
+	/* The events that pass the filters, as a bitmap over their indices */
+	vtl::RankBitmap filteredEvents;
+	/* The events that matched the last searchArgs() */
+	vtl::RankBitmap searchMatches;
+	/* These are ordered by pid, the tasks are kept in the TaskPools */
+	CPUArray<vtl::AVLTree<int, CPUTask*> > cpuTaskMaps;
 	vtl::AVLTree<int, TaskHandle> taskMap;
-	CpuFreq *cpuFreq;
-	CpuIdle *cpuIdle;
-	QList<Migration> migrations;
-	QList<MigrationArrow*> migrationArrows;
+	CPUArray<CpuFreq> cpuFreq;
+	CPUArray<CpuIdle> cpuIdle;
+	CPUArray<SpanIndex> cpuSpans;
+	MigrationList migrations;
 private:
 	TraceParser *parser;
 	void prepareDataStructures();
+	void growCPUs(unsigned int n);
 	void resetProperties();
 	void threadProcess();
-	int binarySearch(const vtl::Time &time, int start, int end) const;
-	int binarySearchFiltered(const vtl::Time &time, int start, int end)
-		const;
+	void trimMemory();
+	vtl::index_t binarySearch(const vtl::Time &time, vtl::index_t start,
+				  vtl::index_t end) const;
 	void colorizeTasks();
 	event_t determineCPUEvent(bool &ok);
-	int findIndexBefore(const vtl::Time &time) const;
-	int findIndexAfter(const vtl::Time &time) const;
-	int findFilteredIndexBefore(const vtl::Time &time) const;
+	vtl::index_t findIndexBefore(const vtl::Time &time) const;
+	vtl::index_t findIndexAfter(const vtl::Time &time) const;
+	vtl::index_t findEvent(const vtl::Time &time,
+			       const EventPredicate &pred, bool forward) const;
 	__always_inline int
 		generic_sched_switch_newpid(const TraceEvent &event) const;
 	__always_inline int
@@ -200,38 +240,47 @@ private:
 	__always_inline vtl::Time estimateWakeUp(const Task *task,
 						 const vtl::Time &newTime,
 						 bool &valid) const;
+	__always_inline int taskIndex(int pid);
+	__always_inline Task *getTask(int pid);
+	__always_inline CPUTask *getCPUTask(int index, int pid,
+					    unsigned int cpu);
+	int addTask(int pid);
+	CPUTask *addCPUTask(int index, int pid, unsigned int cpu);
 	void handleWrongTaskOnCPU(const TraceEvent &event, unsigned int cpu,
 				  CPU *eventCPU, int oldpid,
 				  const vtl::Time &oldtime,
-				  int idx);
+				  vtl::index_t idx);
 	__always_inline void __processSwitchEvent(tracetype_t ttype,
 						  const TraceEvent &event,
-						  int idx);
+						  vtl::index_t idx);
 	__always_inline void __processWakeupEvent(tracetype_t ttype,
 						  const TraceEvent &event,
-						  int idx);
+						  vtl::index_t idx);
 	__always_inline void __processCPUfreqEvent(tracetype_t ttype,
 						   const TraceEvent &event,
-						   int idx);
+						   vtl::index_t idx);
 	__always_inline void __processCPUidleEvent(tracetype_t ttype,
 						   const TraceEvent &event,
-						   int idx);
+						   vtl::index_t idx);
 	__always_inline void __processMigrateEvent(tracetype_t ttype,
 						   const TraceEvent &event,
-						   int idx);
+						   vtl::index_t idx);
 	__always_inline void __processForkEvent(tracetype_t ttype,
 						const TraceEvent &event,
-						int idx);
+						vtl::index_t idx);
 	__always_inline void __processExitEvent(tracetype_t ttype,
 						const TraceEvent &event,
-						int idx);
-	void addCpuFreqWork(unsigned int cpu,
-			    QList<AbstractWorkItem*> &list);
-	void addCpuIdleWork(unsigned int cpu,
-			    QList<AbstractWorkItem*> &list);
-	void addCpuSchedWork(unsigned int cpu,
-			     QList<AbstractWorkItem*> &list);
+						vtl::index_t idx);
+	void buildCPUTaskMaps();
+	void buildSchedTaskList();
+	void buildLod();
+	void buildSpanIndex();
+	bool buildMigrations();
+	bool buildArgIndex();
+	void buildLodRange(int begin, int end);
+	void scaleSchedTasks(int begin, int end);
 	void scaleMigration();
+	void getTasks(QVector<Task*> &tasks);
 	void processSchedAddTail();
 	void processFreqAddTail();
 	unsigned int guessTimePrecision();
@@ -244,14 +293,26 @@ private:
 	void processFtrace();
 	void processPerf();
 	void processAllFilters();
+	void compileFilters();
+	void decodeFilterFields();
+	void filterChunk(int chunk);
+	void buildPidEvents();
+	const vtl::IndexList *pidEvents(int pid) const;
+	bool pidFilterIsIncremental() const;
+	bool mergePidFilter();
+	void mergePidIntoFilter(int pid);
+	void subtractPidFromFilter(int pid);
+	__always_inline bool __filterEvent(const TraceEvent &event);
+	__always_inline bool __filterEventOR(const TraceEvent &event);
+	__always_inline bool __filterEventAND(const TraceEvent &event);
+	__always_inline bool __targetPid(const TraceEvent &event, int &pid);
 	__always_inline
 		bool __processPidFilter(const TraceEvent &event,
-					QMap<int, int> &map,
+					const FilterSet &set,
 					bool inclusive);
-	WorkQueue processingQueue;
-	WorkQueue scalingQueue;
-	WorkQueue statsQueue;
-	WorkQueue statsLimitedQueue;
+	/* All CPUTasks, grouped by CPU, see buildSchedTaskList() */
+	QVector<CPUTask*> schedTasks;
+	QVector<int> schedTaskStart;
 	vtl::AVLTree <int, TColor> colorMap;
 	TColor black;
 	TColor white;
@@ -269,13 +330,13 @@ private:
 	vtl::Time startTime;
 	double endTimeDbl;
 	double startTimeDbl;
-	int endTimeIdx;
+	vtl::index_t endTimeIdx;
 	unsigned int maxFreq;
 	unsigned int minFreq;
 	int maxIdleState;
 	int minIdleState;
 	unsigned int timePrecision;
-	CPU *CPUs;
+	CPUArray<CPU> CPUs;
 	StringPool *taskNamePool;
 	QCustomPlot *customPlot;
 	FilterState filterState;
@@ -284,12 +345,51 @@ private:
 	QMap<int, int> OR_filterPidMap;
 	QMap<event_t, event_t> filterEventMap;
 	QMap<event_t, event_t> OR_filterEventMap;
+	/* The maps above, compiled for processAllFilters() */
+	FilterSet filterPidSet;
+	FilterSet OR_filterPidSet;
+	FilterSet filterEventSet;
+	FilterSet OR_filterEventSet;
+	FilterExpr filterExpr;
+	FilterExpr OR_filterExpr;
+	/*
+	 * The decoded values of the fields that the filter expressions have
+	 * used, see decodeFilterFields(). A column is empty until it is needed.
+	 */
+	vtl::TList<int> filterColumns[FilterExpr::NR_FIELDS];
+	const vtl::TList<int> *filterColumnData[FilterExpr::NR_FIELDS];
+	/*
+	 * For each pid, the indices of its events and of the events that
+	 * target it, as in __targetPid(). These are built when they are first
+	 * needed.
+	 */
+	QHash<int, int> pidEventSlot;
+	QVector<vtl::IndexList> pidEventLists;
+	bool pidEventsBuilt;
 	bool pidFilterInclusive;
 	bool OR_pidFilterInclusive;
 	vtl::Time filterTimeLow;
 	vtl::Time filterTimeHigh;
 	vtl::Time OR_filterTimeLow;
 	vtl::Time OR_filterTimeHigh;
+	/* Built in the background, see startArgIndex() */
+	ArgIndex argIndex;
+	WorkItem<TraceAnalyzer> argIndexItem;
+	WorkGroup argIndexGroup;
+	bool argIndexStarted;
+	/*
+	 * The tasks of a pid are found through its dense index in pidIndex,
+	 * which is also its index in taskPool. While the trace is processed,
+	 * the CPUTasks are found through the dense index in cpuTaskTables,
+	 * after which they are moved to cpuTaskMaps, see buildCPUTaskMaps().
+	 */
+	PidIndex pidIndex;
+	TaskPool<Task> taskPool;
+	TaskPool<CPUTask> cpuTaskPool;
+	CPUArray<CPUTaskTable> cpuTaskTables;
+	/* The time series and event indices of the tasks, see AbstractTask */
+	Arena timeArena;
+	Arena indexArena;
 	static const char spaceStr[];
 	static const int spaceStrLen;
 	static const char *const cpuevents[];
@@ -442,10 +542,7 @@ __always_inline QColor TraceAnalyzer::getTaskColor(int pid) const
 __always_inline CPUTask *TraceAnalyzer::findCPUTask(int pid,
 						    unsigned int cpu)
 {
-	if (cpuTaskMaps[cpu].contains(pid))
-		return &cpuTaskMaps[cpu][pid];
-	else
-		return nullptr;
+	return cpuTaskMaps[cpu].value(pid, nullptr);
 }
 
 __always_inline tracetype_t TraceAnalyzer::getTraceType() const
@@ -455,19 +552,44 @@ __always_inline tracetype_t TraceAnalyzer::getTraceType() const
 
 __always_inline Task *TraceAnalyzer::findTask(int pid)
 {
-	DEFINE_TASKMAP_ITERATOR(iter) = taskMap.find(pid);
-	if (iter == taskMap.end())
+	int index = pidIndex.find(pid);
+
+	if (index < 0)
 		return nullptr;
-	else
-		return iter.value().task;
+	return &taskPool[index];
+}
+
+/* Returns the dense index of pid, a new Task is added if needed */
+__always_inline int TraceAnalyzer::taskIndex(int pid)
+{
+	int index = pidIndex.find(pid);
+
+	if (unlikely(index < 0))
+		index = addTask(pid);
+	return index;
+}
+
+__always_inline Task *TraceAnalyzer::getTask(int pid)
+{
+	return &taskPool[taskIndex(pid)];
+}
+
+/* index must be the dense index of pid, as returned by taskIndex() */
+__always_inline CPUTask *TraceAnalyzer::getCPUTask(int index, int pid,
+						   unsigned int cpu)
+{
+	CPUTask *task = cpuTaskTables[cpu].find(index);
+
+	if (likely(task != nullptr))
+		return task;
+	return addCPUTask(index, pid, cpu);
 }
 
 __always_inline
 void TraceAnalyzer::__processMigrateEvent(tracetype_t ttype,
 					  const TraceEvent &event,
-					  int /* idx */)
+					  vtl::index_t /* idx */)
 {
-	Migration m;
 	unsigned int oldcpu;
 	unsigned int newcpu;
 
@@ -483,34 +605,28 @@ void TraceAnalyzer::__processMigrateEvent(tracetype_t ttype,
 	updateMaxCPU(oldcpu);
 	updateMaxCPU(newcpu);
 
-	m.pid = sched_migrate_pid(ttype, event);
-	m.oldcpu = oldcpu;
-	m.newcpu = newcpu;
-	m.time = event.time;
-	migrations.append(m);
+	migrations.append(sched_migrate_pid(ttype, event), oldcpu, newcpu,
+			  event.time.toDouble());
 }
 
 __always_inline void TraceAnalyzer::__processForkEvent(tracetype_t ttype,
 						       const TraceEvent &event,
-						       int idx)
+						       vtl::index_t idx)
 {
-	Migration m;
 	const char *childname;
+	int pid;
 
 	if (!sched_process_fork_args_ok(ttype, event))
 		return;
 
-	m.pid = sched_process_fork_childpid(ttype, event);
-	m.oldcpu = -1;
-	m.newcpu = event.cpu;
-	m.time = event.time;
-	migrations.append(m);
+	pid = sched_process_fork_childpid(ttype, event);
+	migrations.append(pid, -1, event.cpu, event.time.toDouble());
 
-	Task *task = &taskMap[m.pid].getTask();
+	Task *task = getTask(pid);
 	if (task->isNew) {
 		/* This should be very likely for a task that just forked !*/
 		task->isNew = false;
-		task->pid = m.pid;
+		task->pid = pid;
 		task->events = events;
 		task->schedTimev.append(event.time.toDouble());
 		task->schedData.append(FLOOR_BIT);
@@ -523,22 +639,19 @@ __always_inline void TraceAnalyzer::__processForkEvent(tracetype_t ttype,
 
 __always_inline void TraceAnalyzer::__processExitEvent(tracetype_t ttype,
 						       const TraceEvent &event,
-						       int /* idx */)
+						       vtl::index_t /* idx */)
 {
-	Migration m;
+	int pid;
 
 	if (!sched_process_exit_args_ok(ttype, event))
 		return;
 
-	m.pid = sched_process_exit_pid(ttype, event);
-	m.oldcpu = event.cpu;
-	m.newcpu = -1;
-	m.time = event.time;
-	migrations.append(m);
+	pid = sched_process_exit_pid(ttype, event);
+	migrations.append(pid, event.cpu, -1, event.time.toDouble());
 
-	Task *task = &taskMap[m.pid].getTask();
+	Task *task = getTask(pid);
 	if (task->isNew) {
-		task->pid = m.pid;
+		task->pid = pid;
 		task->events = events;
 	}
 	task->exitStatus = STATUS_EXITCALLED;
@@ -547,7 +660,7 @@ __always_inline void TraceAnalyzer::__processExitEvent(tracetype_t ttype,
 __always_inline
 void TraceAnalyzer::__processSwitchEvent(tracetype_t ttype,
 					 const TraceEvent &event,
-					 int idx)
+					 vtl::index_t idx)
 {
 	sched_switch_handle_t handle;
 	unsigned int cpu = event.cpu;
@@ -556,6 +669,7 @@ void TraceAnalyzer::__processSwitchEvent(tracetype_t ttype,
 	double oldtimeDbl, newtimeDbl;
 	int oldpid;
 	int newpid;
+	int index;
 	CPUTask *cpuTask;
 	Task *task;
 	vtl::Time delay;
@@ -585,7 +699,7 @@ void TraceAnalyzer::__processSwitchEvent(tracetype_t ttype,
 	 * switched out after exit has been called.
 	 */
 	if (event.pid != 0) {
-		task = &taskMap[event.pid].getTask();
+		task = getTask(event.pid);
 		task->checkName(event.taskName->ptr);
 		if (task->isNew) {
 			task->pid = event.pid;
@@ -611,8 +725,9 @@ void TraceAnalyzer::__processSwitchEvent(tracetype_t ttype,
 	oldtimeDbl = oldtime.toDouble();
 
 	/* Handle the outgoing task */
-	cpuTask = &cpuTaskMaps[cpu][oldpid];
-	task = &taskMap[oldpid].getTask();
+	index = taskIndex(oldpid);
+	cpuTask = getCPUTask(index, oldpid, cpu);
+	task = &taskPool[index];
 	state = sched_switch_handle_state(ttype, event, handle);
 
 	/* First handle the global task */
@@ -694,7 +809,8 @@ skip:
 	newtimeDbl = newtime.toDouble();
 
 	/* Handle the incoming task */
-	task = &taskMap[newpid].getTask();
+	index = taskIndex(newpid);
+	task = &taskPool[index];
 	if (task->isNew) {
 		task->pid = newpid;
 		task->isNew = false;
@@ -726,7 +842,7 @@ skip:
 	task->schedData.append(SCHED_BIT);
 	task->schedEventIdx.append(idx);
 
-	cpuTask = &cpuTaskMaps[cpu][newpid];
+	cpuTask = getCPUTask(index, newpid, cpu);
 	if (cpuTask->isNew) {
 		/* true means task is newly constructed above */
 		cpuTask->pid = newpid;
@@ -758,7 +874,7 @@ out:
 __always_inline
 void TraceAnalyzer::__processWakeupEvent(tracetype_t ttype,
 					 const TraceEvent &event,
-					 int /* idx */)
+					 vtl::index_t /* idx */)
 {
 	int pid;
 	Task *task;
@@ -776,7 +892,7 @@ void TraceAnalyzer::__processWakeupEvent(tracetype_t ttype,
 	pid = sched_wakeup_pid(ttype, event);
 
 	/* Handle the woken up task */
-	task = &taskMap[pid].getTask();
+	task = getTask(pid);
 	task->lastWakeUP = time;
 	if (task->isNew) {
 		task->pid = pid;
@@ -794,7 +910,7 @@ void TraceAnalyzer::__processWakeupEvent(tracetype_t ttype,
 __always_inline
 void TraceAnalyzer::__processCPUfreqEvent(tracetype_t ttype,
 					  const TraceEvent &event,
-					  int /* idx */)
+					  vtl::index_t /* idx */)
 {
 	unsigned int cpu;
 	unsigned int freq;
@@ -826,7 +942,7 @@ void TraceAnalyzer::__processCPUfreqEvent(tracetype_t ttype,
 __always_inline
 void TraceAnalyzer::__processCPUidleEvent(tracetype_t ttype,
 					  const TraceEvent &event,
-					  int /* idx */)
+					  vtl::index_t /* idx */)
 {
 	unsigned int cpu;
 	double time;
@@ -852,8 +968,11 @@ void TraceAnalyzer::__processCPUidleEvent(tracetype_t ttype,
 
 __always_inline void TraceAnalyzer::updateMaxCPU(unsigned int cpu)
 {
-	if (cpu > maxCPU)
+	if (unlikely(cpu > maxCPU)) {
 		maxCPU = cpu;
+		if (cpu >= CPUs.size())
+			growCPUs(cpu + 1);
+	}
 }
 
 __always_inline void TraceAnalyzer::updateMaxFreq(unsigned int freq)
@@ -882,10 +1001,10 @@ __always_inline void TraceAnalyzer::updateMinIdleState(int state)
 
 __always_inline void TraceAnalyzer::__processGeneric(tracetype_t ttype)
 {
-	int i;
+	vtl::index_t i;
 	bool eof = false;
-	int indexReady = 0;
-	int prevIndex = 0;
+	vtl::index_t indexReady = 0;
+	vtl::index_t prevIndex = 0;
 
 	while (!eof && indexReady <= 0)
 		parser->waitForNextBatch(eof, indexReady);
@@ -943,47 +1062,100 @@ __always_inline void TraceAnalyzer::__processGeneric(tracetype_t ttype)
 	timePrecision = guessTimePrecision();
 }
 
+/*
+ * Finds the pid that a wakeup, fork or switch event targets, which is the pid
+ * that an inclusive pid filter also matches
+ */
+__always_inline bool TraceAnalyzer::__targetPid(const TraceEvent &event,
+						int &pid)
+{
+	tracetype_t ttype = getTraceType();
+	sched_switch_handle sw_handle;
+
+	switch (event.type) {
+	case SCHED_WAKEUP:
+	case SCHED_WAKEUP_NEW:
+		if (!sched_wakeup_args_ok(ttype, event))
+			return false;
+		pid = sched_wakeup_pid(ttype, event);
+		return true;
+	case SCHED_PROCESS_FORK:
+		if (!sched_process_fork_args_ok(ttype, event))
+			return false;
+		pid = sched_process_fork_childpid(ttype, event);
+		return true;
+	case SCHED_SWITCH:
+		if (!sched_switch_parse(ttype, event, sw_handle))
+			return false;
+		pid = sched_switch_handle_newpid(ttype, event, sw_handle);
+		return pid != 0;
+	default:
+		return false;
+	}
+}
+
 __always_inline
 bool TraceAnalyzer::__processPidFilter(const TraceEvent &event,
-				       QMap<int, int> &map,
+				       const FilterSet &set,
 				       bool inclusive)
 {
-	sched_switch_handle sw_handle;
-	DEFINE_FILTER_PIDMAP_ITERATOR(iter);
-	iter = map.find(event.pid);
-	if (iter == map.end()) {
-		tracetype_t ttype = getTraceType();
-		int pid = INT_MAX;
-		if (!inclusive)
-			return true;
-		switch (event.type) {
-		case SCHED_WAKEUP:
-		case SCHED_WAKEUP_NEW:
-			if (!sched_wakeup_args_ok(ttype, event))
-				return true;
-			pid = sched_wakeup_pid(ttype, event);
-			break;
-		case SCHED_PROCESS_FORK:
-			if (!sched_process_fork_args_ok(ttype, event))
-				return true;
-			pid = sched_process_fork_childpid(ttype, event);
-			break;
-		case SCHED_SWITCH:
-			if (!sched_switch_parse(ttype, event, sw_handle))
-				return true;
-			pid = sched_switch_handle_newpid(ttype, event,
-							 sw_handle);
-			if (pid == 0)
-				return true;
-			break;
-		default:
-			return true;
-		}
-		iter = filterPidMap.find(pid);
-		if (iter == filterPidMap.end())
-			return true;
-	}
+	int pid;
+
+	if (set.contains(event.pid))
+		return false;
+	if (!inclusive || !__targetPid(event, pid))
+		return true;
+	return !set.contains(pid);
+}
+
+/*
+ * Returns true if the event matches one of the OR filters. The argument
+ * filter is not included, since it is evaluated for blocks of events, see
+ * filterChunk()
+ */
+__always_inline bool TraceAnalyzer::__filterEventOR(const TraceEvent &event)
+{
+	if (OR_filterState.isEnabled(FilterState::FILTER_PID) &&
+	    !__processPidFilter(event, OR_filterPidSet,
+				OR_pidFilterInclusive))
+		return true;
+	if (OR_filterState.isEnabled(FilterState::FILTER_EVENT) &&
+	    OR_filterEventSet.contains(event.type))
+		return true;
+	if (OR_filterState.isEnabled(FilterState::FILTER_TIME) &&
+	    event.time >= OR_filterTimeLow && event.time <= OR_filterTimeHigh)
+		return true;
 	return false;
 }
 
+/*
+ * Returns true if the event passes the AND filters, except for the argument
+ * filter
+ */
+__always_inline bool TraceAnalyzer::__filterEventAND(const TraceEvent &event)
+{
+	if (filterState.isEnabled(FilterState::FILTER_PID) &&
+	    __processPidFilter(event, filterPidSet, pidFilterInclusive))
+		return false;
+	if (filterState.isEnabled(FilterState::FILTER_EVENT) &&
+	    !filterEventSet.contains(event.type))
+		return false;
+	if (filterState.isEnabled(FilterState::FILTER_TIME) &&
+	    (event.time < filterTimeLow || event.time > filterTimeHigh))
+		return false;
+	if (filterState.isEnabled(FilterState::FILTER_CPU)) {
+		/* Add CPU nr filtering here */
+	}
+	return true;
+}
+
+/*
+ * Returns true if the event passes the filters. This must not be used when the
+ * argument filter is enabled.
+ */
+__always_inline bool TraceAnalyzer::__filterEvent(const TraceEvent &event)
+{
+	return __filterEventOR(event) || __filterEventAND(event);
+}
+
 #endif /* TRACEANALYZER_H */
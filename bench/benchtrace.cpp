@@ -0,0 +1,275 @@
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2018  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <QFile>
+#include <QtGlobal>
+#include <cstdio>
+
+#include "bench/benchtrace.h"
+
+/* The number of tasks and CPUs of the synthetic trace */
+#define BENCH_NR_TASKS (400)
+#define BENCH_NR_CPUS (8)
+
+class BenchTask {
+public:
+	QByteArray comm;
+	int pid;
+	int prio;
+};
+
+static __always_inline quint32 nextRandom(quint32 &seed)
+{
+	seed = seed * 1103515245 + 12345;
+	return seed >> 8;
+}
+
+BenchTrace::BenchTrace(int nrLines, format_t format):
+	synthetic(true)
+{
+	QByteArray path = qgetenv(format == FORMAT_PERF ? BENCHTRACE_PERF_ENV :
+				  BENCHTRACE_ENV);
+
+	if (!path.isEmpty() && readFile(path, nrLines))
+		synthetic = false;
+	else
+		generate(nrLines, format);
+	finish();
+}
+
+bool BenchTrace::readFile(const QByteArray &path, int nrLines)
+{
+	QFile file(QString::fromLocal8Bit(path));
+	QByteArray text;
+
+	if (!file.open(QIODevice::ReadOnly)) {
+		qWarning("Cannot open %s, using a synthetic trace",
+			 path.constData());
+		return false;
+	}
+	while (lines.size() < nrLines && !file.atEnd()) {
+		text = file.readLine().trimmed();
+		if (text.isEmpty() || text.startsWith('#'))
+			continue;
+		addLine(text.constData());
+	}
+	return lines.size() > 0;
+}
+
+/*
+ * The tasks are picked so that those with a low index are much more common,
+ * like in a real trace, where a few tasks dominate.
+ */
+void BenchTrace::generate(int nrLines, format_t format)
+{
+	static const char *names[] = { "chrome", "Xorg", "gnome-shell",
+				       "kworker/%d:%d", "ksoftirqd/%d",
+				       "rcu_sched", "java", "make", "cc1plus",
+				       "pulseaudio", "migration/%d" };
+	const int nrNames = sizeof(names) / sizeof(names[0]);
+	QVector<BenchTask> tasks(BENCH_NR_TASKS);
+	int current[BENCH_NR_CPUS];
+	char text[768];
+	char head[128];
+	char args[512];
+	char comm[64];
+	const char *event;
+	const char *subsys;
+	quint32 seed = 1;
+	double time = 1000.0;
+	BenchTask *prev, *next;
+	int i, cpu, r;
+
+	for (i = 0; i < BENCH_NR_TASKS; i++) {
+		snprintf(comm, sizeof(comm), names[i % nrNames],
+			 i % BENCH_NR_CPUS, i / nrNames);
+		tasks[i].comm = QByteArray(comm);
+		tasks[i].pid = 1000 + i * 7;
+		tasks[i].prio = i % 17 == 0 ? 98 : 120;
+	}
+	for (cpu = 0; cpu < BENCH_NR_CPUS; cpu++)
+		current[cpu] = cpu;
+
+	for (i = 0; i < nrLines; i++) {
+		cpu = nextRandom(seed) % BENCH_NR_CPUS;
+		r = nextRandom(seed) % BENCH_NR_TASKS;
+		r = r * (nextRandom(seed) % BENCH_NR_TASKS) / BENCH_NR_TASKS;
+		prev = &tasks[current[cpu]];
+		next = &tasks[r];
+		time += (nextRandom(seed) % 100) / 1000000.0;
+		subsys = "sched";
+		switch (nextRandom(seed) % 20) {
+		case 0:
+		case 1:
+		case 2:
+		case 3:
+		case 4:
+		case 5:
+		case 6:
+		case 7:
+			event = "sched_switch";
+			snprintf(args, sizeof(args), "prev_comm=%s prev_pid=%d "
+				 "prev_prio=%d prev_state=%s ==> next_comm=%s "
+				 "next_pid=%d next_prio=%d",
+				 prev->comm.constData(), prev->pid, prev->prio,
+				 r % 3 == 0 ? "R" : (r % 3 == 1 ? "S" : "D"),
+				 next->comm.constData(), next->pid, next->prio);
+			current[cpu] = r;
+			break;
+		case 8:
+		case 9:
+		case 10:
+		case 11:
+		case 12:
+		case 13:
+		case 14:
+			event = r % 2 == 0 ? "sched_wakeup" : "sched_waking";
+			snprintf(args, sizeof(args), "comm=%s pid=%d prio=%d "
+				 "target_cpu=%03d",
+				 next->comm.constData(), next->pid, next->prio,
+				 (cpu + r) % BENCH_NR_CPUS);
+			break;
+		case 15:
+		case 16:
+			subsys = "power";
+			event = "cpu_idle";
+			snprintf(args, sizeof(args), "state=%d cpu_id=%d",
+				 r % 2 == 0 ? -1 : r % 4, cpu);
+			break;
+		case 17:
+			subsys = "power";
+			event = "cpu_frequency";
+			snprintf(args, sizeof(args), "state=%d cpu_id=%d",
+				 800000 + (r % 12) * 100000, cpu);
+			break;
+		default:
+			/* Every event has its own runtime and vruntime */
+			event = "sched_stat_runtime";
+			snprintf(args, sizeof(args), "comm=%s pid=%d "
+				 "runtime=%u [ns] vruntime=%llu [ns]",
+				 prev->comm.constData(), prev->pid,
+				 nextRandom(seed) % 4000000,
+				 1000000000ULL + (unsigned long long) i * 977);
+			break;
+		}
+		if (format == FORMAT_PERF) {
+			snprintf(head, sizeof(head), "%s %d [%03d] %.6f:",
+				 prev->comm.constData(), prev->pid, cpu, time);
+			snprintf(text, sizeof(text), "%s %s:%s: %s", head,
+				 subsys, event, args);
+		} else {
+			snprintf(head, sizeof(head), "%s-%d [%03d] %.6f:",
+				 prev->comm.constData(), prev->pid, cpu, time);
+			snprintf(text, sizeof(text), "%s %s: %s", head, event,
+				 args);
+		}
+		addLine(text);
+	}
+}
+
+/*
+ * Splits the line at the spaces. The arguments start after the second token
+ * after the CPU that ends with a colon, i.e. after the time and the event, in
+ * both formats.
+ */
+void BenchTrace::addLine(const char *text)
+{
+	TraceLine line;
+	TString token;
+	const char *c = text;
+	const char *begin;
+	bool afterCPU = false;
+	int colons = 0;
+	int arg = -1;
+
+	line.strings = nullptr;
+	line.nStrings = 0;
+	line.begin = nullptr;
+	starts.append(tokens.size());
+	while (*c != '\0') {
+		while (*c == ' ' || *c == '\t')
+			c++;
+		if (*c == '\0')
+			break;
+		begin = c;
+		while (*c != '\0' && *c != ' ' && *c != '\t')
+			c++;
+		token.ptr = nullptr;
+		token.len = c - begin;
+		if (*begin == '[')
+			afterCPU = true;
+		else if (afterCPU && arg < 0 && c[-1] == ':' && ++colons == 2)
+			arg = line.nStrings + 1;
+		offsets.append(chars.size());
+		chars.append(begin, token.len);
+		chars.append('\0');
+		tokens.append(token);
+		line.nStrings++;
+	}
+	lines.append(line);
+	args.append(arg < 0 ? (int) line.nStrings : arg);
+}
+
+/* The pointers can only be set when chars and tokens have stopped growing */
+void BenchTrace::finish()
+{
+	int i;
+
+	for (i = 0; i < tokens.size(); i++)
+		tokens[i].ptr = chars.data() + offsets[i];
+	for (i = 0; i < lines.size(); i++) {
+		lines[i].strings = tokens.data() + starts[i];
+		if (lines[i].nStrings > 0)
+			lines[i].begin = lines[i].strings[0].ptr;
+	}
+	offsets.clear();
+	starts.clear();
+}
@@ -0,0 +1,126 @@
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2018  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef BENCHTRACE_H
+#define BENCHTRACE_H
+
+#include <QByteArray>
+#include <QVector>
+
+#include "misc/tstring.h"
+#include "parser/traceline.h"
+#include "vtl/compiler.h"
+
+/*
+ * The environment variables that name an ftrace and a perf trace file, whose
+ * lines are used instead of the synthetic trace
+ */
+#define BENCHTRACE_ENV "TRACESHARK_BENCH_TRACE"
+#define BENCHTRACE_PERF_ENV "TRACESHARK_BENCH_PERF_TRACE"
+
+/*
+ * The lines of an ftrace or perf trace for the benchmarks, split into null
+ * terminated tokens as TraceFile does. If the environment variable of the
+ * format is set, up to nrLines lines are read from the file that it names, so
+ * that a benchmark can be run with the events and arguments of a real trace.
+ * Otherwise a synthetic trace is generated. It has a mix of scheduling,
+ * frequency and idle events, with a few hundred tasks, some of them much busier
+ * than the others, and an event whose arguments are different in every line.
+ */
+class BenchTrace {
+public:
+	typedef enum {
+		FORMAT_FTRACE = 0,
+		FORMAT_PERF
+	} format_t;
+	BenchTrace(int nrLines, format_t format = FORMAT_FTRACE);
+	__always_inline int nrLines() const;
+	__always_inline TraceLine &line(int i);
+	__always_inline int firstArg(int i) const;
+	__always_inline bool isSynthetic() const;
+private:
+	bool readFile(const QByteArray &path, int nrLines);
+	void generate(int nrLines, format_t format);
+	void addLine(const char *text);
+	void finish();
+	QByteArray chars;
+	QVector<TString> tokens;
+	QVector<TraceLine> lines;
+	/* The offset of each token in chars, until finish() */
+	QVector<int> offsets;
+	/* The index of the first token of each line, until finish() */
+	QVector<int> starts;
+	/* The index of the first argument of each line in its tokens */
+	QVector<int> args;
+	bool synthetic;
+};
+
+__always_inline int BenchTrace::nrLines() const
+{
+	return lines.size();
+}
+
+__always_inline TraceLine &BenchTrace::line(int i)
+{
+	return lines[i];
+}
+
+__always_inline int BenchTrace::firstArg(int i) const
+{
+	return args[i];
+}
+
+__always_inline bool BenchTrace::isSynthetic() const
+{
+	return synthetic;
+}
+
+#endif /* BENCHTRACE_H */
@@ -0,0 +1,155 @@
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2018  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <QtTest>
+
+#include "bench/benchtrace.h"
+#include "misc/traceshark.h"
+#include "parser/ftrace/ftracegrammar.h"
+#include "parser/perf/perfgrammar.h"
+#include "parser/traceevent.h"
+
+/* The number of lines of each trace */
+#define NR_BENCH_LINES (500000)
+
+/*
+ * Parses the lines of an ftrace and a perf trace with the grammars, which is
+ * the part of the parsing that is done once per line. The cost per line is the
+ * time of an iteration divided by the number of lines, which is printed at the
+ * start. Run it with the environment variables of BenchTrace set, in order to
+ * use the lines of real traces.
+ */
+class BenchParseLine : public QObject
+{
+	Q_OBJECT
+private slots:
+	void initTestCase();
+	void cleanupTestCase();
+	void ftrace();
+	void perf();
+private:
+	template<class Grammar>
+		int parseAll(Grammar *grammar, BenchTrace *trace);
+	BenchTrace *ftraceTrace;
+	BenchTrace *perfTrace;
+	const TString *argv[EVENT_MAX_NR_ARGS];
+	TraceEvent event;
+};
+
+/* Returns the number of lines that the grammar does not accept */
+template<class Grammar>
+int BenchParseLine::parseAll(Grammar *grammar, BenchTrace *trace)
+{
+	int nrErrors = 0;
+	int i;
+
+	for (i = 0; i < trace->nrLines(); i++) {
+		event.argc = 0;
+		event.argv = argv;
+		if (!grammar->parseLine(trace->line(i), event))
+			nrErrors++;
+	}
+	return nrErrors;
+}
+
+void BenchParseLine::initTestCase()
+{
+	ftraceTrace = new BenchTrace(NR_BENCH_LINES,
+				     BenchTrace::FORMAT_FTRACE);
+	perfTrace = new BenchTrace(NR_BENCH_LINES, BenchTrace::FORMAT_PERF);
+	qDebug("%s ftrace trace: %d lines",
+	       ftraceTrace->isSynthetic() ? "Synthetic" : "Real",
+	       ftraceTrace->nrLines());
+	qDebug("%s perf trace: %d lines",
+	       perfTrace->isSynthetic() ? "Synthetic" : "Real",
+	       perfTrace->nrLines());
+}
+
+void BenchParseLine::cleanupTestCase()
+{
+	delete ftraceTrace;
+	delete perfTrace;
+}
+
+/*
+ * The first pass fills the pools and the event tree, so that the measured
+ * passes are like the bulk of a long trace, where most names and arguments
+ * have been seen before.
+ */
+void BenchParseLine::ftrace()
+{
+	FtraceGrammar grammar;
+	int nrErrors;
+
+	nrErrors = parseAll(&grammar, ftraceTrace);
+	if (ftraceTrace->isSynthetic())
+		QCOMPARE(nrErrors, 0);
+	QBENCHMARK {
+		QCOMPARE(parseAll(&grammar, ftraceTrace), nrErrors);
+	}
+}
+
+void BenchParseLine::perf()
+{
+	PerfGrammar grammar;
+	int nrErrors;
+
+	nrErrors = parseAll(&grammar, perfTrace);
+	if (perfTrace->isSynthetic())
+		QCOMPARE(nrErrors, 0);
+	QBENCHMARK {
+		QCOMPARE(parseAll(&grammar, perfTrace), nrErrors);
+	}
+}
+
+QTEST_APPLESS_MAIN(BenchParseLine)
+
+#include "bench_parseline.moc"
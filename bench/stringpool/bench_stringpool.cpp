@@ -0,0 +1,207 @@
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2018  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <QByteArray>
+#include <QSet>
+#include <QVector>
+#include <QtTest>
+
+#include "bench/benchtrace.h"
+#include "bench/stringpool/avlstringpool.h"
+#include "misc/traceshark.h"
+#include "misc/tstring.h"
+#include "mm/stringpool.h"
+
+/* The number of lines of the trace, whose arguments are interned */
+#define NR_BENCH_LINES (500000)
+/* The cutoff and the sizes that the grammars use for their argPool */
+#define ARGPOOL_CUTOFF (16)
+#define ARGPOOL_PAGES (2048)
+#define ARGPOOL_HSIZE (1024 * 1024)
+
+typedef enum {
+	POOL_AVL = 0,
+	POOL_OPEN
+} pool_t;
+
+/*
+ * Interns the arguments of a trace like the grammars do, with the current
+ * StringPool and with the one that had a hash table of AVL trees. Run it with
+ * the environment variable BENCHTRACE_ENV set to an ftrace file, in order to
+ * use the arguments of a real trace. The cost per argument is the time of an
+ * iteration divided by the number of arguments, which is printed at the start.
+ */
+class BenchStringPool : public QObject
+{
+	Q_OBJECT
+private slots:
+	void initTestCase();
+	void cleanupTestCase();
+	void interning();
+	void allocString_data();
+	void allocString();
+private:
+	template<class Pool>
+		const TString *alloc(Pool *pool, const TString *str,
+				     uint32_t cutoff);
+	template<class Pool>
+		void internAll(Pool *pool, uint32_t cutoff);
+	template<class Pool>
+		int countDistinct(Pool *pool);
+	BenchTrace *trace;
+	QVector<const TString*> args;
+	int nrDistinct;
+};
+
+template<>
+const TString *BenchStringPool::alloc(AVLStringPool *pool,
+				      const TString *str, uint32_t cutoff)
+{
+	return pool->allocString(str, TShark::StrHash32(str), cutoff);
+}
+
+template<>
+const TString *BenchStringPool::alloc(StringPool *pool, const TString *str,
+				      uint32_t cutoff)
+{
+	return pool->allocString(str, TShark::StrHash(str), cutoff);
+}
+
+template<class Pool>
+void BenchStringPool::internAll(Pool *pool, uint32_t cutoff)
+{
+	int i;
+
+	for (i = 0; i < args.size(); i++)
+		alloc(pool, args[i], cutoff);
+}
+
+/* Returns the number of distinct strings that the pool returns for args */
+template<class Pool>
+int BenchStringPool::countDistinct(Pool *pool)
+{
+	QSet<const TString*> distinct;
+	int i;
+
+	for (i = 0; i < args.size(); i++)
+		distinct.insert(alloc(pool, args[i], 0));
+	return distinct.size();
+}
+
+void BenchStringPool::initTestCase()
+{
+	QSet<QByteArray> distinct;
+	const TraceLine *line;
+	unsigned int j;
+	int i;
+
+	trace = new BenchTrace(NR_BENCH_LINES);
+	for (i = 0; i < trace->nrLines(); i++) {
+		line = &trace->line(i);
+		for (j = trace->firstArg(i); j < line->nStrings; j++) {
+			args.append(&line->strings[j]);
+			distinct.insert(QByteArray(line->strings[j].ptr,
+						   line->strings[j].len));
+		}
+	}
+	nrDistinct = distinct.size();
+	qDebug("%s trace: %d lines, %d arguments, %d distinct",
+	       trace->isSynthetic() ? "Synthetic" : "Real", trace->nrLines(),
+	       args.size(), nrDistinct);
+}
+
+void BenchStringPool::cleanupTestCase()
+{
+	delete trace;
+}
+
+/* Both pools must return one string for each distinct argument */
+void BenchStringPool::interning()
+{
+	AVLStringPool avl(ARGPOOL_PAGES, ARGPOOL_HSIZE);
+	StringPool open(ARGPOOL_PAGES, ARGPOOL_HSIZE);
+
+	QCOMPARE(countDistinct(&avl), nrDistinct);
+	QCOMPARE(countDistinct(&open), nrDistinct);
+}
+
+void BenchStringPool::allocString_data()
+{
+	QTest::addColumn<int>("pool");
+
+	QTest::newRow("avl") << (int) POOL_AVL;
+	QTest::newRow("open addressing") << (int) POOL_OPEN;
+}
+
+/*
+ * A pool is created for each iteration, like the grammars clear their pools
+ * for each trace, so that the table has to grow as in a real parse.
+ */
+void BenchStringPool::allocString()
+{
+	QFETCH(int, pool);
+
+	if (pool == POOL_AVL) {
+		QBENCHMARK {
+			AVLStringPool avl(ARGPOOL_PAGES, ARGPOOL_HSIZE);
+			internAll(&avl, ARGPOOL_CUTOFF);
+		}
+	} else {
+		QBENCHMARK {
+			StringPool open(ARGPOOL_PAGES, ARGPOOL_HSIZE);
+			internAll(&open, ARGPOOL_CUTOFF);
+		}
+	}
+}
+
+QTEST_APPLESS_MAIN(BenchStringPool)
+
+#include "bench_stringpool.moc"
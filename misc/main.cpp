@@ -53,11 +53,15 @@
 #include <QApplication>
 #include <QString>
 #include <QtCore>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
 #include "misc/errors.h"
 #include "misc/resources.h"
 #include "ui/mainwindow.h"
 #include "ui/tracesharkstyle.h"
 #include "vtl/error.h"
+#include "vtl/mapping.h"
 
 #define QT4_WARNING \
 "WARNING!!! WARNING!!! WARNING!!!\n" \
@@ -69,10 +73,44 @@
 "WARNING!!! WARNING!!! WARNING!!! WARNING!!! WARNING!!! WARNING!!!\n" \
 "WARNING!!! WARNING!!! WARNING!!! WARNING!!! WARNING!!! WARNING!!!"
 
+#define HUGEPAGES_OPTION "--hugepages="
+#define MEMREPORT_OPTION "--mem-report"
+#define MAPCACHE_OPTION "--map-cache="
+#define SCRATCHDIR_OPTION "--scratch-dir="
+
 static char *prgname;
+static bool printMemReport = false;
 
-static void parseOption(const char */*opt*/)
-{}
+static void parseOption(const char *opt)
+{
+	vtl::hugepages_t mode;
+	size_t len = strlen(HUGEPAGES_OPTION);
+	size_t clen = strlen(MAPCACHE_OPTION);
+	size_t slen = strlen(SCRATCHDIR_OPTION);
+	unsigned long mib;
+	char *end;
+
+	if (strncmp(opt, HUGEPAGES_OPTION, len) == 0) {
+		if (!vtl::parse_hugepages(opt + len, &mode))
+			vtl::errx(BSD_EX_USAGE,
+				  "Usage: %s --hugepages=none|thp|hugetlb",
+				  prgname);
+		vtl::set_hugepages(mode);
+	} else if (strcmp(opt, MEMREPORT_OPTION) == 0) {
+		printMemReport = true;
+	} else if (strncmp(opt, MAPCACHE_OPTION, clen) == 0) {
+		errno = 0;
+		mib = strtoul(opt + clen, &end, 10);
+		if (errno != 0 || end == opt + clen || *end != '\0')
+			vtl::errx(BSD_EX_USAGE, "Usage: %s --map-cache=<MiB>",
+				  prgname);
+		vtl::set_map_cache((size_t) mib * 1024 * 1024);
+	} else if (strncmp(opt, SCRATCHDIR_OPTION, slen) == 0) {
+		if (!vtl::set_scratch_dir(opt + slen))
+			vtl::errx(BSD_EX_USAGE,
+				  "%s is not a writable directory", opt + slen);
+	}
+}
 
 static void parseArguments(QString *fileName, int argc, char* argv[])
 {
@@ -96,7 +134,6 @@ static void parseArguments(QString *fileName, int argc, char* argv[])
 int main(int argc, char* argv[])
 {
 	QApplication app(argc, argv);
-	MainWindow mainWindow;
 	QPixmap pm(QLatin1String(RESSRC_PNG_SHARK));
 	QIcon icon;
 	QString appname = QLatin1String("Traceshark");
@@ -106,7 +143,10 @@ int main(int argc, char* argv[])
 
 	vtl::set_strerror(ts_strerror);
 
+	/* The huge page mode must be set before anything is mapped */
 	parseArguments(&fileName, argc, argv);
+	MainWindow mainWindow;
+	mainWindow.setPrintMemReport(printMemReport);
 /* Set graphicssystem to opengl if we have old enough Qt */
 #if QT_VERSION < QT_VERSION_CHECK(5, 0, 0)
 	QApplication::setGraphicsSystem("opengl");
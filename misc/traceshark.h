@@ -59,6 +59,7 @@
 #include <QtCore>
 #include <cstdint>
 #include <cstdio>
+#include <cstring>
 #include "misc/tstring.h"
 #include "vtl/compiler.h"
 
@@ -87,8 +88,7 @@ typedef enum {
 #define lastfunc(myint) ((double) myint)
 
 #define DEFINE_CPUTASKMAP_ITERATOR(name) \
-	vtl::AVLTree<int, CPUTask, \
-		vtl::AVLBALANCE_USEPOINTERS>::iterator name
+	vtl::AVLTree<int, CPUTask*>::iterator name
 
 #define DEFINE_TASKMAP_ITERATOR(name) \
 	vtl::AVLTree<int, TaskHandle>::iterator name
@@ -202,6 +202,34 @@ namespace TShark {
 		uvalue.word8[0] = str->ptr[s - 1];
 		return uvalue.word32;
 	}
+
+	/*
+	 * StrHash32() only looks at four characters, which is enough to spread
+	 * the event names but not the arguments, many of which only differ in
+	 * the middle. This hash mixes in all characters, eight at a time.
+	 */
+	__always_inline uint32_t StrHash(const TString *str)
+	{
+		const char *p = str->ptr;
+		int n = str->len;
+		uint64_t h = 0x9e3779b97f4a7c15ULL ^ (uint64_t) n;
+		uint64_t w;
+
+		for (; n >= 8; n -= 8, p += 8) {
+			memcpy(&w, p, 8);
+			h = (h ^ w) * 0xff51afd7ed558ccdULL;
+			h ^= h >> 32;
+		}
+		if (n > 0) {
+			w = 0;
+			memcpy(&w, p, n);
+			h = (h ^ w) * 0xff51afd7ed558ccdULL;
+		}
+		h ^= h >> 33;
+		h *= 0xc4ceb9fe1a85ec53ULL;
+		h ^= h >> 29;
+		return (uint32_t) h;
+	}
 }
 
 #endif /* TRACESHARK_H */
@@ -0,0 +1,143 @@
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2018  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cerrno>
+#include <cstdlib>
+
+#include "mm/arena.h"
+#include "vtl/error.h"
+
+/* The header of a large block, which keeps the data aligned */
+#define ARENA_HEADER (ARENA_ALIGN)
+
+Arena::Arena(unsigned int nr_pages):
+	largeBytes(0)
+{
+	pool = new MemPool(nr_pages, 1);
+}
+
+Arena::~Arena()
+{
+	reset();
+	delete pool;
+}
+
+void *Arena::allocLarge(size_t bytes)
+{
+	char *raw = (char*) malloc(bytes + ARENA_HEADER);
+
+	if (raw == nullptr)
+		vtl::err(BSD_EX_OSERR, errno, "malloc() failed at %s:%d",
+			 __FILE__, __LINE__);
+	*((size_t*) raw) = (size_t) largeBlocks.size();
+	largeBlocks.append(raw);
+	largeBytes += bytes;
+	return raw + ARENA_HEADER;
+}
+
+/*
+ * Returns a block of newBytes with the first oldBytes copied from block. A
+ * block from the pool is left in place until the arena is reset, while a large
+ * block is resized in place, if possible.
+ */
+void *Arena::grow(void *block, size_t oldBytes, size_t newBytes)
+{
+	char *raw, *newRaw;
+	size_t idx;
+	void *ptr;
+
+	if (block == nullptr)
+		return alloc(newBytes);
+
+	oldBytes = roundUp(oldBytes);
+	newBytes = roundUp(newBytes);
+	if (oldBytes > ARENA_MAX_POOLED) {
+		raw = (char*) block - ARENA_HEADER;
+		idx = *((size_t*) raw);
+		newRaw = (char*) realloc(raw, newBytes + ARENA_HEADER);
+		if (newRaw == nullptr)
+			vtl::err(BSD_EX_OSERR, errno,
+				 "realloc() failed at %s:%d", __FILE__,
+				 __LINE__);
+		largeBlocks[idx] = newRaw;
+		largeBytes += newBytes - oldBytes;
+		return newRaw + ARENA_HEADER;
+	}
+
+	ptr = alloc(newBytes);
+	memcpy(ptr, block, oldBytes);
+	return ptr;
+}
+
+void Arena::reset()
+{
+	int i;
+
+	for (i = 0; i < largeBlocks.size(); i++)
+		free(largeBlocks[i]);
+	largeBlocks.clear();
+	largeBytes = 0;
+	pool->reset();
+}
+
+/* The large blocks are malloc()ed, so they are not trimmed */
+void Arena::trim()
+{
+	pool->trim();
+}
+
+vtl::MemUsage Arena::memUsage() const
+{
+	vtl::MemUsage usage = pool->memUsage();
+
+	usage += vtl::MemUsage(largeBytes, largeBytes);
+	return usage;
+}
@@ -0,0 +1,109 @@
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2018  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <QVector>
+#include <cstddef>
+#include <cstring>
+
+#include "mm/mempool.h"
+#include "vtl/compiler.h"
+
+/* Blocks that are larger than this are allocated from the heap */
+#define ARENA_MAX_POOLED (65536)
+/* The alignment of the blocks, enough for doubles and pointers */
+#define ARENA_ALIGN (16)
+
+/*
+ * An arena of blocks that are not freed one by one, but all at once with
+ * reset(). Small blocks are carved out of a MemPool, so that allocating them
+ * is only a matter of bumping a pointer. The large blocks are allocated from
+ * the heap, with a header that holds their index in largeBlocks, so that they
+ * can be resized with realloc() and freed by reset().
+ */
+class Arena {
+public:
+	Arena(unsigned int nr_pages = 256 * 10);
+	~Arena();
+	__always_inline void *alloc(size_t bytes);
+	void *grow(void *block, size_t oldBytes, size_t newBytes);
+	void reset();
+	void trim();
+	vtl::MemUsage memUsage() const;
+private:
+	static __always_inline size_t roundUp(size_t bytes);
+	void *allocLarge(size_t bytes);
+	MemPool *pool;
+	QVector<void*> largeBlocks;
+	quint64 largeBytes;
+};
+
+__always_inline size_t Arena::roundUp(size_t bytes)
+{
+	return (bytes + ARENA_ALIGN - 1) & ~((size_t) ARENA_ALIGN - 1);
+}
+
+__always_inline void *Arena::alloc(size_t bytes)
+{
+	void *ptr;
+
+	bytes = roundUp(bytes);
+	if (bytes > ARENA_MAX_POOLED)
+		return allocLarge(bytes);
+	ptr = pool->allocBytes(bytes);
+	if (ptr == nullptr)
+		return allocLarge(bytes);
+	return ptr;
+}
+
+#endif /* ARENA_H */
@@ -0,0 +1,183 @@
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2018  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ARENAVECTOR_H
+#define ARENAVECTOR_H
+
+#include "mm/arena.h"
+#include "vtl/compiler.h"
+
+/* The capacity of the first block of an ArenaVector */
+#define ARENAVECTOR_MIN (16)
+
+/*
+ * A vector that is appended to, whose elements are kept in a contiguous block
+ * of an Arena. When the block is full, a block of twice the size is taken from
+ * the arena, so that appending is cheap and there is no heap block per vector.
+ * The old blocks are given back when the arena is reset, after which the
+ * vectors that used it must not be accessed anymore.
+ *
+ * The vector does not own its elements, so it can be copied like a pointer,
+ * but then only one of the copies may be appended to. T must be a type that
+ * can be copied with memcpy().
+ */
+template<class T>
+class ArenaVector {
+public:
+	ArenaVector(Arena *a = nullptr);
+	__always_inline void setArena(Arena *a);
+	__always_inline void append(const T &value);
+	__always_inline void reserve(int n);
+	__always_inline int size() const;
+	__always_inline bool isEmpty() const;
+	__always_inline const T *constData() const;
+	__always_inline const T &first() const;
+	__always_inline const T &last() const;
+	__always_inline const T &at(int i) const;
+	__always_inline const T &operator[](int i) const;
+	__always_inline T &operator[](int i);
+private:
+	void grow(int n);
+	T *ptr;
+	int len;
+	int cap;
+	Arena *arena;
+};
+
+template<class T>
+ArenaVector<T>::ArenaVector(Arena *a):
+	ptr(nullptr), len(0), cap(0), arena(a)
+{}
+
+template<class T>
+__always_inline void ArenaVector<T>::setArena(Arena *a)
+{
+	arena = a;
+}
+
+template<class T>
+void ArenaVector<T>::grow(int n)
+{
+	int newCap = cap > 0 ? 2 * cap : ARENAVECTOR_MIN;
+
+	if (newCap < n)
+		newCap = n;
+	ptr = (T*) arena->grow(ptr, sizeof(T) * (size_t) cap,
+			       sizeof(T) * (size_t) newCap);
+	cap = newCap;
+}
+
+template<class T>
+__always_inline void ArenaVector<T>::append(const T &value)
+{
+	if (unlikely(len == cap))
+		grow(len + 1);
+	ptr[len] = value;
+	len++;
+}
+
+/* Makes room for n elements, so that a known size can be appended in place */
+template<class T>
+__always_inline void ArenaVector<T>::reserve(int n)
+{
+	if (n > cap)
+		grow(n);
+}
+
+template<class T>
+__always_inline int ArenaVector<T>::size() const
+{
+	return len;
+}
+
+template<class T>
+__always_inline bool ArenaVector<T>::isEmpty() const
+{
+	return len == 0;
+}
+
+template<class T>
+__always_inline const T *ArenaVector<T>::constData() const
+{
+	return ptr;
+}
+
+template<class T>
+__always_inline const T &ArenaVector<T>::first() const
+{
+	return ptr[0];
+}
+
+template<class T>
+__always_inline const T &ArenaVector<T>::last() const
+{
+	return ptr[len - 1];
+}
+
+template<class T>
+__always_inline const T &ArenaVector<T>::at(int i) const
+{
+	return ptr[i];
+}
+
+template<class T>
+__always_inline const T &ArenaVector<T>::operator[](int i) const
+{
+	return ptr[i];
+}
+
+template<class T>
+__always_inline T &ArenaVector<T>::operator[](int i)
+{
+	return ptr[i];
+}
+
+#endif /* ARENAVECTOR_H */
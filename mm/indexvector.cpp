@@ -1,6 +1,6 @@
 /*
  * Traceshark - a visualizer for visualizing ftrace and perf traces
- * Copyright (C) 2015, 2017  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ * Copyright (C) 2018  Viktor Rosendahl <viktor.rosendahl@gmail.com>
  *
  * This file is dual licensed: you can use it either under the terms of
  * the GPL, or the BSD license, at your option.
@@ -49,20 +49,19 @@
  *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
-#ifndef MIGRATIONARROW_H
-#define MIGRATIONARROW_H
+#include "mm/indexvector.h"
 
-#include <QColor>
-#include "qcustomplot/qcustomplot.h"
+IndexVector::IndexVector(Arena *a):
+	offsets(a), wideIndices(a), base(-1), wide(false)
+{}
 
-class MigrationArrow : public QCPItemLine
+/* Copies the indices to the 64-bit vector, which is used from now on */
+void IndexVector::widen()
 {
-	Q_OBJECT
-public:
-	MigrationArrow(double start, double end, double time,
-		       const QColor &color, QCustomPlot *parent);
-private:
-	QCPLineEnding head;
-};
+	int i;
 
-#endif /* MIGRATIONARROW_H */
+	wideIndices.reserve(offsets.size() + 1);
+	for (i = 0; i < offsets.size(); i++)
+		wideIndices.append(at(i));
+	wide = true;
+}
@@ -0,0 +1,134 @@
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2018  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef INDEXVECTOR_H
+#define INDEXVECTOR_H
+
+#include <cstdint>
+#include <QtGlobal>
+
+#include "mm/arenavector.h"
+#include "vtl/compiler.h"
+#include "vtl/index.h"
+
+/*
+ * An ArenaVector of event indices that keeps them as 32-bit offsets from the
+ * first index that is not zero, so that the indices of a task take half the
+ * space of 64-bit ones. Zero is kept as it is, since it is the index that the
+ * tasks use for the start of the trace. If an index falls outside of the range
+ * of the offsets, the indices are copied to a vector of 64-bit ones, which is
+ * then used instead.
+ */
+class IndexVector {
+public:
+	IndexVector(Arena *a = nullptr);
+	__always_inline void append(vtl::index_t index);
+	__always_inline int size() const;
+	__always_inline bool isEmpty() const;
+	__always_inline vtl::index_t at(int i) const;
+	__always_inline vtl::index_t operator[](int i) const;
+private:
+	void widen();
+	ArenaVector<quint32> offsets;
+	ArenaVector<vtl::index_t> wideIndices;
+	vtl::index_t base;
+	bool wide;
+};
+
+__always_inline void IndexVector::append(vtl::index_t index)
+{
+	vtl::index_t offset;
+
+	if (unlikely(wide)) {
+		wideIndices.append(index);
+		return;
+	}
+	if (index == 0) {
+		offsets.append(0);
+		return;
+	}
+	if (unlikely(base < 0))
+		base = index;
+	offset = index - base + 1;
+	if (unlikely(offset <= 0 || offset > UINT32_MAX)) {
+		widen();
+		wideIndices.append(index);
+		return;
+	}
+	offsets.append((quint32) offset);
+}
+
+__always_inline int IndexVector::size() const
+{
+	return wide ? wideIndices.size() : offsets.size();
+}
+
+__always_inline bool IndexVector::isEmpty() const
+{
+	return size() == 0;
+}
+
+__always_inline vtl::index_t IndexVector::at(int i) const
+{
+	quint32 offset;
+
+	if (unlikely(wide))
+		return wideIndices[i];
+	offset = offsets[i];
+	return offset == 0 ? 0 : base + offset - 1;
+}
+
+__always_inline vtl::index_t IndexVector::operator[](int i) const
+{
+	return at(i);
+}
+
+#endif /* INDEXVECTOR_H */
@@ -59,42 +59,74 @@ extern "C" {
 #include <unistd.h>
 }
 
-MemPool::MemPool(unsigned int nr_pages, unsigned int objsize)
+/*
+ * If onScratch is true, the maps are backed by files in the directory of
+ * vtl::set_scratch_dir(), see vtl::map_scratch()
+ */
+MemPool::MemPool(unsigned int nr_pages, unsigned int objsize, bool onScratch):
+	scratch(onScratch)
 {
 	poolSize = nr_pages * sysconf(_SC_PAGESIZE);
 	objSize = objsize;
+	exhaustUsed = 0ULL;
 	next = nullptr;
 	memory = nullptr;
-	newMap();
+	newMap(false);
 }
 
 MemPool::~MemPool()
 {
 	int i;
 	int len = exhaustList.size();
-	for (i = 0; i < len; i++) {
-		if (munmap(exhaustList[i], poolSize) != 0)
-			munmap_err();
-	}
-	if (memory != nullptr && munmap(memory, poolSize) != 0)
-		munmap_err();
+	for (i = 0; i < len; i++)
+		unmapMap(exhaustList[i]);
+	if (memory != nullptr)
+		unmapMap(memory);
+}
+
+void MemPool::unmapMap(void *map)
+{
+	if (scratch)
+		vtl::unmap_scratch(map, poolSize);
+	else
+		vtl::unmap_reusable(map, poolSize);
 }
 
 void MemPool::addMemory()
 {
 	exhaustList.append(memory);
-	newMap();
+	exhaustUsed += used;
+	/* The pool has filled one map already, so it will fill this one too */
+	newMap(true);
 }
 
 void MemPool::reset()
 {
 	int i;
 	int len = exhaustList.size();
-	for (i = 0; i < len; i++) {
-		if (munmap(exhaustList[i], poolSize) != 0)
-			munmap_err();
-	}
+	for (i = 0; i < len; i++)
+		unmapMap(exhaustList[i]);
 	exhaustList.clear();
+	exhaustUsed = 0ULL;
 	used = 0ULL;
 	next = memory;
 }
+
+/*
+ * Gives back the unused pages of the current map. The maps that have been
+ * exhausted have at most an object worth of unused memory.
+ */
+void MemPool::trim()
+{
+	/* The pages of a file can be dropped by the kernel without this */
+	if (scratch)
+		return;
+	vtl::trim_anonymous(memory, poolSize, used);
+}
+
+vtl::MemUsage MemPool::memUsage() const
+{
+	quint64 nrMaps = exhaustList.size() + (memory != nullptr ? 1 : 0);
+
+	return vtl::MemUsage(nrMaps * poolSize, exhaustUsed + used);
+}
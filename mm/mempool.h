@@ -60,12 +60,14 @@ extern "C" {
 
 #include "vtl/compiler.h"
 #include "vtl/error.h"
+#include "vtl/mapping.h"
+#include "vtl/memusage.h"
 
 class MemPool
 {
 public:
 	MemPool(unsigned int nr_pages = 256 * 10,
-		unsigned int objsize = 64);
+		unsigned int objsize = 64, bool onScratch = false);
 	~MemPool();
 	__always_inline void* allocObj();
 	__always_inline void* allocN(unsigned int n);
@@ -78,14 +80,21 @@ public:
 	__always_inline bool commitBytes(unsigned int nrbytes);
 	__always_inline bool commitChars(unsigned int nrbytes);
 	void reset();
+	void trim();
+	vtl::MemUsage memUsage() const;
 private:
 	quint8 *memory;
 	quint8 *next;
 	unsigned long long poolSize;
 	unsigned long long used;
+	/* The bytes that were used of the maps in exhaustList */
+	unsigned long long exhaustUsed;
 	unsigned int objSize;
 	QList <void*> exhaustList;
-	__always_inline void newMap();
+	/* The maps are backed by files in the scratch directory */
+	bool scratch;
+	__always_inline void newMap(bool populate);
+	void unmapMap(void *map);
 	void addMemory();
 };
 
@@ -173,18 +182,16 @@ __always_inline bool MemPool::commitChars(unsigned int chars)
 	return commitBytes(sizeof(char) * chars);
 }
 
-__always_inline void MemPool::newMap()
+__always_inline void MemPool::newMap(bool populate)
 {
 	quint8 *ptr;
-	ptr = (quint8*) mmap(nullptr, (size_t) poolSize, PROT_READ|PROT_WRITE,
-			     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
-	if (likely(ptr != MAP_FAILED)) {
-		memory = ptr;
-		next = ptr;
-		used = 0ULL;
-		return;
-	}
-	mmap_err();
+	if (scratch)
+		ptr = (quint8*) vtl::map_scratch((size_t) poolSize);
+	else
+		ptr = (quint8*) vtl::map_reusable((size_t) poolSize, populate);
+	memory = ptr;
+	next = ptr;
+	used = 0ULL;
 }
 
 #endif /* MEMPOOL_H */
@@ -1,6 +1,6 @@
 /*
  * Traceshark - a visualizer for visualizing ftrace and perf traces
- * Copyright (C) 2015, 2016  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ * Copyright (C) 2018  Viktor Rosendahl <viktor.rosendahl@gmail.com>
  *
  * This file is dual licensed: you can use it either under the terms of
  * the GPL, or the BSD license, at your option.
@@ -49,78 +49,59 @@
  *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
-#include "threads/workqueue.h"
-#include <QThread>
+#include "mm/memreport.h"
 
-#define DEFAULT_NR_CPUS (6) /* Isn't this what most people are running now? */
-
-WorkQueue::WorkQueue():
-	error(false), nrStarted(0)
+void MemReport::add(const QString &name, const vtl::MemUsage &usage)
 {
-	int cpus, i;
-	cpus = QThread::idealThreadCount();
-	nrThreads = cpus > 0 ? cpus:DEFAULT_NR_CPUS;
-	threads = new WorkThread<WorkQueue>[nrThreads]();
-	for (i = 0; i < nrThreads; i++)
-		threads[i].setObjFn(this, &WorkQueue::ThreadRun);
+	names.append(name);
+	usages.append(usage);
 }
 
-WorkQueue::~WorkQueue()
+void MemReport::clear()
 {
-	delete[] threads;
+	names.clear();
+	usages.clear();
 }
 
-void WorkQueue::addWorkItem(AbstractWorkItem *item)
+vtl::MemUsage MemReport::total() const
 {
-	queue.append(item);
-}
+	vtl::MemUsage sum;
+	int i;
 
-void WorkQueue::addDefaultWorkItem(AbstractWorkItem *item)
-{
-	defaultQueue.append(item);
+	for (i = 0; i < usages.size(); i++)
+		sum += usages[i];
+	return sum;
 }
 
-void WorkQueue::setWorkItemsDefault()
+QString MemReport::formatBytes(quint64 bytes)
 {
-	queue = defaultQueue;
+	if (bytes >= 1024ULL * 1024 * 1024)
+		return QString::number((double) bytes / (1024.0 * 1024 * 1024),
+				       'f', 2) + QString(" GiB");
+	if (bytes >= 1024ULL * 1024)
+		return QString::number((double) bytes / (1024.0 * 1024), 'f',
+				       1) + QString(" MiB");
+	if (bytes >= 1024ULL)
+		return QString::number((double) bytes / 1024.0, 'f', 1) +
+			QString(" KiB");
+	return QString::number(bytes) + QString(" B");
 }
 
-void WorkQueue::start()
+/* A table with a line for each subsystem and a total at the end */
+QString MemReport::toText() const
 {
+	QString text;
+	vtl::MemUsage sum = total();
 	int i;
-	int qs = queue.size();
-
-	error = false;
-	nrStarted = TSMIN(qs, nrThreads);
-	for (i = 0; i < nrStarted; i++)
-		threads[i].start();
-}
-
-bool WorkQueue::wait()
-{
-	int i;
-	for (i = 0; i < nrStarted; i++)
-		threads[i].wait();
-	return error;
-}
-
-void WorkQueue::ThreadRun() {
-	AbstractWorkItem *current;
-	bool empty;
 
-	do {
-		bool rval = false;
-		queueMutex.lock();
-		empty = queue.isEmpty();
-		if (!empty)
-			current = queue.takeFirst();
-		queueMutex.unlock();
-		if (!empty)
-			rval = current->__runWork();
-		if (rval) {
-			errorMutex.lock();
-			error |= rval;
-			errorMutex.unlock();
-		}
-	} while(!empty);
+	text += QString("%1 %2 %3\n").arg(QString("Subsystem"), -32)
+		.arg(QString("Reserved"), 12).arg(QString("Used"), 12);
+	for (i = 0; i < names.size(); i++)
+		text += QString("%1 %2 %3\n").arg(names[i], -32)
+			.arg(formatBytes(usages[i].reserved), 12)
+			.arg(formatBytes(usages[i].used), 12);
+	text += QString("%1 %2 %3\n").arg(QString("Total"), -32)
+		.arg(formatBytes(sum.reserved), 12)
+		.arg(formatBytes(sum.used), 12);
+	return text;
 }
@@ -55,29 +55,36 @@
 #define MAX(A, B) ((A) >= (B) ? A:B)
 #define MIN(A, B) ((A) < (B) ? A:B)
 
+/* The table is grown when more than 7/8 of the slots are used */
+#define SP_MAX_LOAD(size) ((size) / 8 * 7)
 
-StringPool::StringPool(unsigned int nr_pages, unsigned int hSizeP)
+/*
+ * If onScratch is true, the strings are kept in pools that are backed by files
+ * in the scratch directory, see MemPool. The hash table is always in RAM.
+ */
+StringPool::StringPool(unsigned int nr_pages, unsigned int hSizeP,
+		       bool onScratch)
 {
-	unsigned int entryPages, strPages;
-
 	if (hSizeP == 0)
 		hSize = 1;
 	else
 		hSize = hSizeP;
 
-	entryPages = 2 * hSize *
-		sizeof(vtl::AVLNode<TString, __DummySP>) / 4096;
-	entryPages = MAX(1, entryPages);
-	strPages = 2* hSize * sizeof(TString) / 4096;
-	strPages = MAX(16, strPages);
+	/*
+	 * The table starts at a quarter of hSize, rounded up to a power of two,
+	 * and grows as needed.
+	 */
+	initialSize = 16;
+	while (initialSize < hSize / 4)
+		initialSize *= 2;
+	mask = initialSize - 1;
+	nrUsed = 0;
 
-	coldCharPool = new MemPool(nr_pages, 1);
-	strPool = new MemPool(nr_pages, sizeof(TString));
+	coldCharPool = new MemPool(nr_pages, 1, onScratch);
+	strPool = new MemPool(nr_pages, sizeof(TString), onScratch);
+	charPool = new MemPool(nr_pages, sizeof(char), onScratch);
 
-	avlPools.charPool = new MemPool(nr_pages, sizeof(char));
-	avlPools.nodePool = new MemPool(entryPages, sizeof(vtl::AVLNode<TString,
-							   __DummySP>));
-	hashTable = new StringPoolEntry*[hSize];
+	table = new StringPoolSlot[initialSize];
 	countAllocs = new unsigned int[hSize];
 	countReuse = new unsigned int[hSize];
 	clearTable();
@@ -85,43 +92,124 @@ StringPool::StringPool(unsigned int nr_pages, unsigned int hSizeP)
 
 StringPool::~StringPool()
 {
-	unsigned int i, s;
 	delete coldCharPool;
 	delete strPool;
-	delete avlPools.charPool;
-	delete avlPools.nodePool;
-	delete[] hashTable;
+	delete charPool;
+	delete[] table;
 	delete[] countAllocs;
 	delete[] countReuse;
-	s = deleteList.size();
-	for (i = 0; i < s; i++) {
-		delete deleteList[i];
-	}
 }
 
 void StringPool::clearTable()
 {
-	bzero(hashTable, hSize * sizeof(StringPoolEntry*));
+	bzero(table, (mask + 1) * sizeof(StringPoolSlot));
 	bzero(countAllocs, hSize * sizeof(unsigned int));
 	bzero(countReuse, hSize * sizeof(unsigned int));
+	nrUsed = 0;
 }
 
 void StringPool::clear()
 {
-	unsigned int s, i;
+	/* Give back the memory of a table that has grown for a large trace */
+	if (mask + 1 != initialSize) {
+		delete[] table;
+		table = new StringPoolSlot[initialSize];
+		mask = initialSize - 1;
+	}
 	clearTable();
 	coldCharPool->reset();
 	strPool->reset();
-	avlPools.nodePool->reset();
-	avlPools.charPool->reset();
-	s = deleteList.size();
-	for (i = 0; i < s; i++) {
-		delete deleteList[i];
-	}
-	deleteList.clear();
+	charPool->reset();
 }
 
 void StringPool::reset()
 {
 	clear();
 }
+
+void StringPool::trim()
+{
+	coldCharPool->trim();
+	strPool->trim();
+	charPool->trim();
+}
+
+vtl::MemUsage StringPool::memUsage() const
+{
+	vtl::MemUsage usage = coldCharPool->memUsage();
+	quint64 counts = (quint64) 2 * hSize * sizeof(unsigned int);
+
+	usage += strPool->memUsage();
+	usage += charPool->memUsage();
+	usage += vtl::MemUsage((quint64) (mask + 1) * sizeof(StringPoolSlot),
+			       (quint64) nrUsed * sizeof(StringPoolSlot));
+	usage += vtl::MemUsage(counts, counts);
+	return usage;
+}
+
+/*
+ * Puts the slot in the table. The slot is moved forward, past the slots that
+ * are as far or further from their home slots, and then swapped with the
+ * first one that is closer, which in turn is moved forward, and so on until a
+ * free slot is found.
+ */
+void StringPool::placeSlot(StringPoolSlot &slot)
+{
+	StringPoolSlot tmp;
+	uint32_t idx = slot.hval & mask;
+
+	slot.dist = 1;
+	while (table[idx].dist != 0) {
+		if (table[idx].dist < slot.dist) {
+			tmp = table[idx];
+			table[idx] = slot;
+			slot = tmp;
+		}
+		slot.dist++;
+		idx = (idx + 1) & mask;
+	}
+	table[idx] = slot;
+}
+
+void StringPool::grow()
+{
+	StringPoolSlot *old = table;
+	uint32_t oldSize = mask + 1;
+	uint32_t i;
+
+	table = new StringPoolSlot[oldSize * 2];
+	mask = oldSize * 2 - 1;
+	bzero(table, (mask + 1) * sizeof(StringPoolSlot));
+	for (i = 0; i < oldSize; i++) {
+		if (old[i].dist != 0)
+			placeSlot(old[i]);
+	}
+	delete[] old;
+}
+
+const TString *StringPool::insertString(const TString *str, uint32_t hval)
+{
+	StringPoolSlot slot;
+	TString *newstr;
+
+	newstr = (TString*) strPool->allocObj();
+	if (newstr == nullptr)
+		return nullptr;
+	newstr->len = str->len;
+	newstr->ptr = (char*) charPool->allocChars(str->len + 1);
+	if (newstr->ptr == nullptr)
+		return nullptr;
+	strcpy(newstr->ptr, str->ptr);
+
+	if (nrUsed + 1 > SP_MAX_LOAD(mask + 1))
+		grow();
+
+	slot.hval = hval;
+	slot.len = slotLen(str->len);
+	bzero(slot.prefix, SP_INLINE_SIZE);
+	memcpy(slot.prefix, newstr->ptr, MIN(str->len, SP_INLINE_SIZE));
+	slot.str = newstr;
+	placeSlot(slot);
+	nrUsed++;
+	return newstr;
+}
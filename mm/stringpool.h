@@ -57,151 +57,133 @@
 #include "mm/mempool.h"
 #include "misc/traceshark.h"
 #include "misc/tstring.h"
-#include "vtl/avltree.h"
 #include "vtl/tlist.h"
 
-class __DummySP {};
+/* The number of leading characters of a string that are kept in its slot */
+#define SP_INLINE_SIZE (16)
+/* The length that is stored in a slot for strings that are longer */
+#define SP_LEN_MAX (UINT16_MAX)
 
-class PoolBundleSP {
-public:
-	MemPool *charPool;
-	MemPool *nodePool;
-};
-
-#define __STRINGPOOL_ITERATOR(name) \
-vtl::AVLTree<TString, __DummySP, vtl::AVLBALANCE_USEPOINTERS, \
-AVLAllocatorSP<TString, __DummySP>, AVLCompareSP<TString>>::iterator
-
-template <class T>
-class AVLCompareSP {
-public:
-	__always_inline static int compare(const T &a, const T &b) {
-		return strcmp(a.ptr, b.ptr);
-	}
-};
-
-template <class T, class U>
-class AVLAllocatorSP {
-public:
-	AVLAllocatorSP(void *data) {
-		PoolBundleSP *pb = (PoolBundleSP*) data;
-		pools = *pb;
-	}
-	__always_inline vtl::AVLNode<T, U> *alloc(const T &key) {
-		vtl::AVLNode<T, U> *node = (vtl::AVLNode<T, U> *)
-			pools.nodePool->allocObj();
-		node->key.len = key.len;
-		node->key.ptr = (char*) pools.charPool->allocChars(key.len + 1);
-		strcpy(node->key.ptr, key.ptr);
-		return node;
-	}
-	__always_inline int clear() {
-		/*
-		 * Do nothing because the pools are owned by StringPool. This
-		 * is only called from StringPool, via AVLTree, when the object
-		 * is cleared.
-		 */
-		return 0;
-	}
-private:
-	PoolBundleSP pools;
-};
-
-#define AVLTREE_SIZE ((int)sizeof(vtl::AVLTree<TString, __DummySP,	 \
-vtl::AVLBALANCE_USEPOINTERS, AVLAllocatorSP<TString, __DummySP>, \
-			     AVLCompareSP<TString>>))
-#define TSTRING_PTR_SIZE ((int)sizeof(TString*))
-#define TYPICAL_CACHE_LINE_SIZE (64)
-
-#define SP_CACHE_SIZE (TYPICAL_CACHE_LINE_SIZE - TSTRING_PTR_SIZE - \
-		       AVLTREE_SIZE)
-
-class StringPoolEntry {
-	friend class StringPool;
+/*
+ * A slot of the hash table of StringPool. The full hash value, the length and
+ * the first characters of the string are kept in the slot, so that a probe
+ * seldom needs to follow the pointer to the string. The slot is 32 bytes,
+ * so that two of them fit in a cache line.
+ */
+class StringPoolSlot {
 public:
-StringPoolEntry(void *data): cachePtr(nullptr), avlTree(data) {
-		bzero(cache, SP_CACHE_SIZE);
-	}
-protected:
-	char cache[SP_CACHE_SIZE];
-	TString *cachePtr;
-	vtl::AVLTree<TString, __DummySP, vtl::AVLBALANCE_USEPOINTERS,
-		AVLAllocatorSP<TString, __DummySP>, AVLCompareSP<TString>>
-		avlTree;
+	uint32_t hval;
+	/* The distance from the home slot plus one, or zero if free */
+	uint16_t dist;
+	uint16_t len;
+	char prefix[SP_INLINE_SIZE];
+	TString *str;
 };
 
+/*
+ * A string interner, which returns the same TString for all strings that are
+ * equal. The strings are kept in an open addressing hash table with Robin
+ * Hood probing, i.e. a string that is inserted takes the slot of any string
+ * that is closer to its home slot than the inserted string would be. This
+ * keeps the probe sequences short and lets a lookup stop as soon as it finds
+ * a slot that is closer to its home than the probe is.
+ *
+ * The hval given to allocString() must be TShark::StrHash() of the string.
+ * If cutoff is non-zero, the strings are also grouped by TShark::StrHash32()
+ * modulo hSize. Once more than cutoff strings of a group have been interned,
+ * and they have been reused less often than that, the strings of the group
+ * are allocated separately instead. StrHash32() only looks at the first and
+ * the last characters, so a group tends to consist of similar strings, such
+ * as the values of an argument that is different in every event. This keeps
+ * the table from growing with strings that will never be reused.
+ */
 class StringPool
 {
 public:
-	StringPool(unsigned int nr_pages = 256 * 10, unsigned int hSizeP = 256);
+	StringPool(unsigned int nr_pages = 256 * 10, unsigned int hSizeP = 256,
+		   bool onScratch = false);
 	~StringPool();
 	__always_inline const TString *allocString(const TString *str,
 						   uint32_t hval,
 						   uint32_t cutoff);
 	void clear();
 	void reset();
+	void trim();
+	vtl::MemUsage memUsage() const;
 private:
 	__always_inline const TString *allocUniqueString(const TString *str);
+	__always_inline bool equals(const StringPoolSlot *slot,
+				    const TString *str) const;
+	static __always_inline uint16_t slotLen(int len);
+	const TString *insertString(const TString *str, uint32_t hval);
+	void placeSlot(StringPoolSlot &slot);
+	void grow();
 	MemPool *coldCharPool;
 	MemPool *strPool;
-	PoolBundleSP avlPools;
-	StringPoolEntry **hashTable;
+	MemPool *charPool;
+	StringPoolSlot *table;
+	uint32_t mask;
+	uint32_t nrUsed;
+	uint32_t initialSize;
 	unsigned int *countAllocs;
 	unsigned int *countReuse;
 	unsigned int hSize;
 	void clearTable();
-	vtl::TList<StringPoolEntry*> deleteList;
 };
 
+__always_inline uint16_t StringPool::slotLen(int len)
+{
+	return len < SP_LEN_MAX ? (uint16_t) len : SP_LEN_MAX;
+}
+
+__always_inline bool StringPool::equals(const StringPoolSlot *slot,
+					const TString *str) const
+{
+	int n = str->len;
+
+	if (slot->len != slotLen(n))
+		return false;
+	if (memcmp(slot->prefix, str->ptr, TSMIN(n, SP_INLINE_SIZE)) != 0)
+		return false;
+	if (n <= SP_INLINE_SIZE)
+		return true;
+	return slot->str->len == n &&
+		memcmp(slot->str->ptr + SP_INLINE_SIZE,
+		       str->ptr + SP_INLINE_SIZE, n - SP_INLINE_SIZE) == 0;
+}
+
 __always_inline const TString *StringPool::allocString(const TString *str,
 						       uint32_t hval,
 						       uint32_t cutoff)
 {
-	StringPoolEntry *entry;
-	bool isNew;
-
-	hval = hval % hSize;
-
-	if (cutoff != 0 && countAllocs[hval] > cutoff &&
-	    countAllocs[hval] > countReuse[hval]) {
-		const TString *newstr = allocUniqueString(str);
-		return newstr;
+	const StringPoolSlot *slot;
+	uint32_t idx = hval & mask;
+	uint32_t dist;
+	uint32_t c = 0;
+
+	if (cutoff != 0) {
+		c = TShark::StrHash32(str) % hSize;
+		if (countAllocs[c] > cutoff && countAllocs[c] > countReuse[c]) {
+			const TString *newstr = allocUniqueString(str);
+			return newstr;
+		}
 	}
 
-	if (hashTable[hval] != nullptr) {
-		entry = hashTable[hval];
-		if (entry->cachePtr != nullptr &&
-		    strcmp(entry->cache, str->ptr) == 0) {
-			if (cutoff != 0)
-				countReuse[hval]++;
-			return entry->cachePtr;
-		}
-		__STRINGPOOL_ITERATOR(iter) iter =
-			entry->avlTree.findInsert(*str, isNew);
-		TString &refStr = iter.key();
-		if (isNew) {
+	for (dist = 1;; dist++) {
+		slot = &table[idx];
+		if (slot->dist < dist)
+			break;
+		if (slot->hval == hval && equals(slot, str)) {
 			if (cutoff != 0)
-				countAllocs[hval]++;
-		} else {
-			if (refStr.len < SP_CACHE_SIZE) {
-				strcpy(entry->cache, refStr.ptr);
-				entry->cachePtr = &refStr;
-			}
-			if (cutoff != 0)
-				countReuse[hval]++;
+				countReuse[c]++;
+			return slot->str;
 		}
-		return &refStr;
-	} else {
-		entry = new StringPoolEntry(&avlPools);
-		hashTable[hval] = entry;
-		deleteList.append(entry);
-		__STRINGPOOL_ITERATOR(iter) iter =
-			entry->avlTree.findInsert(*str, isNew);
-		if (cutoff != 0)
-			countAllocs[hval]++;
-		TString &refStr = iter.key();
-		return &refStr;
+		idx = (idx + 1) & mask;
 	}
+
+	if (cutoff != 0)
+		countAllocs[c]++;
+	return insertString(str, hval);
 }
 
 __always_inline const TString *StringPool::allocUniqueString(const TString *str)
@@ -219,7 +201,4 @@ __always_inline const TString *StringPool::allocUniqueString(const TString *str)
 	return newstr;
 }
 
-
-
-
 #endif /* STRINGPOOL_H */
@@ -79,6 +79,9 @@ StringTree::StringTree(unsigned int nr_pages, unsigned int hSizeP,
 	stringTable = new TString*[table_size];
 	tableSize = table_size;
 
+	hotTable = new StringTreeHot[ST_HOT_SIZE];
+	hotMask = ST_HOT_SIZE - 1;
+
 	clearTable();
 }
 
@@ -89,6 +92,7 @@ StringTree::~StringTree()
 	delete avlPools.nodePool;
 	delete[] hashTable;
 	delete[] stringTable;
+	delete[] hotTable;
 	s = deleteList.size();
 	for (i = 0; i < s; i++) {
 		delete deleteList[i];
@@ -99,9 +103,57 @@ void StringTree::clearTable()
 {
 	bzero(hashTable, hSize * sizeof(StringTreeEntry*));
 	bzero(stringTable, tableSize * sizeof(TString*));
+	bzero(hotTable, (hotMask + 1) * sizeof(StringTreeHot));
+	hotUsed = 0;
 	maxEvent = (event_t) -1;
 }
 
+void StringTree::hotInsert(const TString *str, event_t value)
+{
+	StringTreeHot *slot;
+	StringTreeKey key;
+	unsigned int idx;
+
+	if (str->len < 1)
+		return;
+
+	/* Keep the table at most half full, so that the probes are short */
+	if (2 * (hotUsed + 1) > hotMask + 1)
+		hotGrow();
+
+	hotKey(str->ptr, str->len, key);
+	idx = hotHash(key, str->len) & hotMask;
+	while (hotTable[idx].len != 0)
+		idx = (idx + 1) & hotMask;
+
+	slot = &hotTable[idx];
+	slot->key = key;
+	slot->len = str->len;
+	slot->value = value;
+	slot->str = str;
+	hotUsed++;
+}
+
+void StringTree::hotGrow()
+{
+	StringTreeHot *old = hotTable;
+	unsigned int oldSize = hotMask + 1;
+	unsigned int i, idx;
+
+	hotTable = new StringTreeHot[2 * oldSize];
+	hotMask = 2 * oldSize - 1;
+	bzero(hotTable, (hotMask + 1) * sizeof(StringTreeHot));
+	for (i = 0; i < oldSize; i++) {
+		if (old[i].len == 0)
+			continue;
+		idx = hotHash(old[i].key, old[i].len) & hotMask;
+		while (hotTable[idx].len != 0)
+			idx = (idx + 1) & hotMask;
+		hotTable[idx] = old[i];
+	}
+	delete[] old;
+}
+
 void StringTree::clear()
 {
 	unsigned int s, i;
@@ -119,3 +171,27 @@ void StringTree::reset()
 {
 	clear();
 }
+
+void StringTree::trim()
+{
+	avlPools.charPool->trim();
+	avlPools.nodePool->trim();
+	deleteList.trim();
+}
+
+vtl::MemUsage StringTree::memUsage() const
+{
+	vtl::MemUsage usage = avlPools.charPool->memUsage();
+	quint64 tables = (quint64) hSize * sizeof(StringTreeEntry*) +
+		(quint64) tableSize * sizeof(TString*);
+	quint64 entries = (quint64) deleteList.size() *
+		sizeof(StringTreeEntry);
+
+	usage += avlPools.nodePool->memUsage();
+	usage += deleteList.memUsage();
+	usage += vtl::MemUsage(tables, tables);
+	usage += vtl::MemUsage(entries, entries);
+	usage += vtl::MemUsage((quint64) (hotMask + 1) * sizeof(StringTreeHot),
+			       (quint64) hotUsed * sizeof(StringTreeHot));
+	return usage;
+}
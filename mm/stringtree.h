@@ -115,6 +115,31 @@ vtl::AVLBALANCE_USEPOINTERS, AVLAllocatorST<TString, event_t>, \
 #define ST_CACHE_SIZE (ST_TYPICAL_CACHE_LINE_SIZE - ST_TSTRING_PTR_SIZE - \
 		       ST_AVLTREE_SIZE)
 
+/* The number of leading characters of a name that a hot slot keeps inline */
+#define ST_HOT_INLINE (16)
+/* The initial number of slots of the hot table, a power of two */
+#define ST_HOT_SIZE (256)
+
+/*
+ * The first ST_HOT_INLINE characters of a name as two words, see
+ * StringTree::hotKey(). Together with the length, they identify a name that
+ * is not longer than ST_HOT_INLINE.
+ */
+class StringTreeKey {
+public:
+	uint64_t a;
+	uint64_t b;
+};
+
+/* A slot of the hot table of StringTree. A free slot has a len of zero. */
+class StringTreeHot {
+public:
+	StringTreeKey key;
+	int len;
+	event_t value;
+	const TString *str;
+};
+
 class StringTreeEntry {
 	friend class StringTree;
 public:
@@ -135,9 +160,12 @@ public:
 	__always_inline event_t searchAllocString(const TString *str,
 						  uint32_t hval,
 						  event_t newval);
+	__always_inline event_t findHot(const char *ptr, int len) const;
 	__always_inline event_t getMaxEvent() const;
 	void clear();
 	void reset();
+	void trim();
+	vtl::MemUsage memUsage() const;
 private:
 	PoolBundleST avlPools;
 	StringTreeEntry **hashTable;
@@ -145,6 +173,15 @@ private:
 	unsigned int tableSize;
 	event_t maxEvent;
 	TString **stringTable;
+	StringTreeHot *hotTable;
+	unsigned int hotMask;
+	unsigned int hotUsed;
+	static __always_inline void hotKey(const char *ptr, int len,
+					   StringTreeKey &key);
+	static __always_inline unsigned int hotHash(const StringTreeKey &key,
+						    int len);
+	void hotInsert(const TString *str, event_t value);
+	void hotGrow();
 	void clearTable();
 	vtl::TList<StringTreeEntry*> deleteList;
 };
@@ -156,12 +193,85 @@ __always_inline const TString *StringTree::stringLookup(event_t value) const
 	return stringTable[value];
 }
 
+/*
+ * Loads the first ST_HOT_INLINE characters of a name, with a few loads that
+ * overlap if the name is shorter, so that no byte beyond the name is read and
+ * no loop is needed.
+ */
+__always_inline void StringTree::hotKey(const char *ptr, int len,
+					StringTreeKey &key)
+{
+	uint32_t lo, hi;
+
+	if (len >= 8) {
+		memcpy(&key.a, ptr, 8);
+		if (len >= 16)
+			memcpy(&key.b, ptr + 8, 8);
+		else
+			memcpy(&key.b, ptr + len - 8, 8);
+	} else if (len >= 4) {
+		memcpy(&lo, ptr, 4);
+		memcpy(&hi, ptr + len - 4, 4);
+		key.a = ((uint64_t) hi << 32) | lo;
+		key.b = 0;
+	} else {
+		key.a = (uint64_t) (uint8_t) ptr[0] |
+			((uint64_t) (uint8_t) ptr[len / 2] << 8) |
+			((uint64_t) (uint8_t) ptr[len - 1] << 16);
+		key.b = 0;
+	}
+}
+
+__always_inline unsigned int StringTree::hotHash(const StringTreeKey &key,
+						 int len)
+{
+	uint64_t w = (key.a ^ (key.b >> 7) ^ (uint64_t) len) *
+		0x9e3779b97f4a7c15ULL;
+
+	return (unsigned int) (w >> 32);
+}
+
+/*
+ * Looks up a name in the hot table, which has a slot for every name in the
+ * tree, so that the common case of a known event name needs neither a copy
+ * of the name, to terminate it, nor a walk of an AVL tree. The name does not
+ * need to be null terminated. Returns EVENT_ERROR if the name is not found.
+ */
+__always_inline event_t StringTree::findHot(const char *ptr, int len) const
+{
+	const StringTreeHot *slot;
+	StringTreeKey key;
+	unsigned int idx;
+
+	if (len < 1)
+		return EVENT_ERROR;
+
+	hotKey(ptr, len, key);
+	for (idx = hotHash(key, len) & hotMask;; idx = (idx + 1) & hotMask) {
+		slot = &hotTable[idx];
+		if (slot->len == 0)
+			return EVENT_ERROR;
+		if (slot->len != len || slot->key.a != key.a ||
+		    slot->key.b != key.b)
+			continue;
+		if (len <= ST_HOT_INLINE ||
+		    memcmp(slot->str->ptr + ST_HOT_INLINE, ptr + ST_HOT_INLINE,
+			   len - ST_HOT_INLINE) == 0)
+			return slot->value;
+	}
+}
+
 __always_inline event_t StringTree::searchAllocString(const TString *str,
 						      uint32_t hval,
 						      event_t newval)
 {
 	StringTreeEntry *entry;
 	bool isNew;
+	event_t hot;
+
+	hot = findHot(str->ptr, str->len);
+	if (hot != EVENT_ERROR)
+		return hot;
 
 	hval = hval % hSize;
 
@@ -174,6 +284,7 @@ __always_inline event_t StringTree::searchAllocString(const TString *str,
 			e = newval;
 			stringTable[newval] = &iter.key();
 			maxEvent = newval;
+			hotInsert(&iter.key(), newval);
 			return newval;
 		} else {
 			return iter.value();
@@ -188,6 +299,7 @@ __always_inline event_t StringTree::searchAllocString(const TString *str,
 		e = newval;
 		stringTable[newval] = &iter.key();
 		maxEvent = newval;
+		hotInsert(&iter.key(), newval);
 		return newval;
 	}
 }
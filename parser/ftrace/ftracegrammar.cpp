@@ -56,10 +56,11 @@ extern "C" {
 #include "parser/ftrace/ftracegrammar.h"
 #include "parser/traceevent.h"
 
-FtraceGrammar::FtraceGrammar() :
+/* If onScratch is true, the arguments are kept in scratch files */
+FtraceGrammar::FtraceGrammar(bool onScratch) :
 	unknownTypeCounter(EVENT_UNKNOWN), tmp_argc(0)
 {
-	argPool = new StringPool(2048, 1024 * 1024);
+	argPool = new StringPool(2048, 1024 * 1024, onScratch);
 	namePool =  new StringPool(1024, 65536);
 	eventTree = new StringTree(8, 256, 4096);
 	bzero(tmp_argv, sizeof(tmp_argv));
@@ -82,6 +83,20 @@ void FtraceGrammar::clear()
 	unknownTypeCounter = EVENT_UNKNOWN;
 }
 
+void FtraceGrammar::memReport(MemReport &report) const
+{
+	report.add(QString("Event names"), eventTree->memUsage());
+	report.add(QString("Arguments"), argPool->memUsage());
+	report.add(QString("Event task names"), namePool->memUsage());
+}
+
+void FtraceGrammar::trim()
+{
+	eventTree->trim();
+	argPool->trim();
+	namePool->trim();
+}
+
 void FtraceGrammar::setupEventTree()
 {
 	int t;
@@ -53,6 +53,7 @@
 #define FTRACEGRAMMAR_H
 
 #include "misc/traceshark.h"
+#include "mm/memreport.h"
 #include "mm/stringpool.h"
 #include "mm/stringtree.h"
 #include "parser/paramhelpers.h"
@@ -70,9 +71,11 @@
 class FtraceGrammar
 {
 public:
-	FtraceGrammar();
+	FtraceGrammar(bool onScratch = false);
 	~FtraceGrammar();
 	void clear();
+	void memReport(MemReport &report) const;
+	void trim();
 	__always_inline bool parseLine(const TraceLine &line,
 				       TraceEvent &event);
 	StringTree *eventTree;
@@ -241,11 +244,11 @@ __always_inline bool FtraceGrammar::TimeMatch(const TString *str,
 			}
 			if (!namestr.merge(&finistr, maxlen))
 				return false;
-			hash = TShark::StrHash32(&namestr);
+			hash = TShark::StrHash(&namestr);
 			newname = namePool->allocString(&namestr, hash, 0);
 		} else {
 			/* This is the common case, no spaces in the name. */
-			hash = TShark::StrHash32(&finistr);
+			hash = TShark::StrHash(&finistr);
 			newname = namePool->allocString(&finistr, hash, 0);
 		}
 
@@ -261,12 +264,23 @@ __always_inline bool FtraceGrammar::EventMatch(const TString *str,
 {
 	char buf[512];
 	TString estr;
+	const int maxlen = sizeof(buf) / sizeof(char) - 1;
+	char *lastChr;
+	event_t type;
+
+	/* The common case, an event name that has been seen before */
+	if (str->len > 1 && str->ptr[str->len - 1] == ':') {
+		type = eventTree->findHot(str->ptr, str->len - 1);
+		if (type != EVENT_ERROR) {
+			event.type = type;
+			return true;
+		}
+	}
+
 	estr.len = 0;
 	estr.ptr = buf;
-	const int maxlen = sizeof(buf) / sizeof(char) - 1;
 	estr.set(str, maxlen);
-	char *lastChr = estr.ptr + estr.len - 1;
-	event_t type;
+	lastChr = estr.ptr + estr.len - 1;
 
 	if (estr.len < 1)
 		return false;
@@ -298,7 +312,7 @@ __always_inline bool FtraceGrammar::ArgMatch(const TString *str,
 {
 	const TString *newstr;
 	if (event.argc < EVENT_MAX_NR_ARGS) {
-		newstr = argPool->allocString(str, TShark::StrHash32(str), 16);
+		newstr = argPool->allocString(str, TShark::StrHash(str), 16);
 		if (newstr == nullptr)
 			return false;
 		event.argv[event.argc] = newstr;
@@ -172,7 +172,7 @@ __ftrace_sched_switch_handle_newname_strdup(const TraceEvent &event,
 	len++;
 
 	ts.len = len;
-	retstr = pool->allocString(&ts, TShark::StrHash32(&ts), 0);
+	retstr = pool->allocString(&ts, TShark::StrHash(&ts), 0);
 	if (retstr == nullptr)
 		return NullStr;
 
@@ -245,7 +245,7 @@ __ftrace_sched_switch_handle_oldname_strdup(const TraceEvent &event,
 	len++;
 
 	ts.len = len;
-	retstr = pool->allocString(&ts, TShark::StrHash32(&ts), 0);
+	retstr = pool->allocString(&ts, TShark::StrHash(&ts), 0);
 	if (retstr == nullptr)
 		return NullStr;
 
@@ -375,7 +375,7 @@ static __always_inline const char
 	len++;
 
 	ts.len = len;
-	retstr = pool->allocString(&ts, TShark::StrHash32(&ts), 0);
+	retstr = pool->allocString(&ts, TShark::StrHash(&ts), 0);
 	if (retstr == nullptr)
 		return NullStr;
 
@@ -463,7 +463,7 @@ finalize:
 	len++;
 
 	ts.len = len;
-	retstr = pool->allocString(&ts, TShark::StrHash32(&ts), 0);
+	retstr = pool->allocString(&ts, TShark::StrHash(&ts), 0);
 	if (retstr == nullptr)
 		return NullStr;
 
@@ -541,7 +541,7 @@ __ftrace_sched_waking_name_strdup(const TraceEvent &event, StringPool *pool)
 		return NullStr;
 
 	ts.len = len;
-	retstr = pool->allocString(&ts, TShark::StrHash32(&ts), 0);
+	retstr = pool->allocString(&ts, TShark::StrHash(&ts), 0);
 	if (retstr == nullptr)
 		return NullStr;
 	return retstr->ptr;
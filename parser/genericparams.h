@@ -131,6 +131,10 @@ DECLARE_GENERIC_TRACEFN_HANDLE(sched_switch_handle_state,   \
 			       const sched_switch_handle&)
 DECLARE_GENERIC_TRACEFN_HANDLE(sched_switch_handle_oldpid, int,	\
 			       const sched_switch_handle&)
+DECLARE_GENERIC_TRACEFN_HANDLE(sched_switch_handle_oldprio, unsigned int, \
+			       const sched_switch_handle&)
+DECLARE_GENERIC_TRACEFN_HANDLE(sched_switch_handle_newprio, unsigned int, \
+			       const sched_switch_handle&)
 DECLARE_GENERIC_TRACEFN_POOL_HANDLE(sched_switch_handle_oldname_strdup, \
 				    const char *,			\
 				    const sched_switch_handle&)
@@ -0,0 +1,258 @@
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2018  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+extern "C" {
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+}
+
+#include "mm/stringpool.h"
+#include "parser/memestimate.h"
+#include "parser/traceevent.h"
+#include "misc/tstring.h"
+
+MemEstimate::MemEstimate():
+	fileSize(0), sampledBytes(0), nrEventLines(0), nrArgs(0),
+	nrArgBytes(0), nrSwitches(0), nrEvents(0), eventBytes(0), argvBytes(0),
+	stringBytes(0), taskBytes(0)
+{}
+
+/*
+ * Samples the file and computes the estimate. Returns 0 on success and an
+ * errno value otherwise.
+ */
+int MemEstimate::estimate(const QString &fileName)
+{
+	char *buf;
+	struct stat sbuf;
+	quint64 step, offset;
+	ssize_t n;
+	int fd, i, nr;
+	int ts_errno = 0;
+
+	fd = open(fileName.toLocal8Bit().data(), O_RDONLY);
+	if (fd < 0)
+		return errno;
+	if (fstat(fd, &sbuf) != 0) {
+		ts_errno = errno;
+		close(fd);
+		return ts_errno;
+	}
+	fileSize = sbuf.st_size;
+
+	buf = new char[MEMESTIMATE_SAMPLE_SIZE];
+	nr = MEMESTIMATE_NR_SAMPLES;
+	if (fileSize <= (quint64) MEMESTIMATE_NR_SAMPLES *
+	    MEMESTIMATE_SAMPLE_SIZE)
+		nr = (fileSize + MEMESTIMATE_SAMPLE_SIZE - 1) /
+			MEMESTIMATE_SAMPLE_SIZE;
+	step = nr > 1 ? (fileSize - MEMESTIMATE_SAMPLE_SIZE) / (nr - 1) : 0;
+	for (i = 0; i < nr; i++) {
+		offset = i * step;
+		n = pread(fd, buf, MEMESTIMATE_SAMPLE_SIZE, offset);
+		if (n < 0) {
+			ts_errno = errno;
+			break;
+		}
+		sample(buf, n, offset == 0);
+	}
+	delete[] buf;
+	close(fd);
+	if (ts_errno == 0)
+		compute();
+	return ts_errno;
+}
+
+/*
+ * Only the complete lines of a chunk are sampled, so a chunk that doesn't
+ * begin at the start of the file begins after its first newline.
+ */
+void MemEstimate::sample(const char *buf, int len, bool first)
+{
+	const char *end = buf + len;
+	const char *begin = buf;
+	const char *nl;
+
+	if (!first) {
+		begin = (const char*) memchr(buf, '\n', len);
+		if (begin == nullptr)
+			return;
+		begin++;
+	}
+
+	while (begin < end) {
+		nl = (const char*) memchr(begin, '\n', end - begin);
+		if (nl == nullptr)
+			break;
+		sampleLine(begin, nl);
+		sampledBytes += nl - begin + 1;
+		begin = nl + 1;
+	}
+}
+
+/*
+ * ftrace prints the event name as sched_switch: and perf as
+ * sched:sched_switch:, so the name is matched by its suffix.
+ */
+static __always_inline bool isSwitch(const char *word, int wlen)
+{
+	const char name[] = "sched_switch:";
+	const int len = sizeof(name) - 1;
+
+	if (wlen < len || strncmp(word + wlen - len, name, len))
+		return false;
+	return wlen == len || word[wlen - len - 1] == ':';
+}
+
+/*
+ * An event line has the timestamp and the event name as its first words that
+ * end with a colon, the arguments follow after them. Other lines, such as the
+ * comments of ftrace and the backtraces of perf, only add to the bytes.
+ */
+void MemEstimate::sampleLine(const char *begin, const char *end)
+{
+	const char *word;
+	const char *p = begin;
+	int colons = 0;
+	int wlen;
+
+	if (p < end && *p == '#')
+		return;
+
+	while (p < end) {
+		while (p < end && (*p == ' ' || *p == '\t'))
+			p++;
+		word = p;
+		while (p < end && *p != ' ' && *p != '\t')
+			p++;
+		wlen = p - word;
+		if (wlen == 0)
+			break;
+		if (colons < 2) {
+			if (word[wlen - 1] != ':')
+				continue;
+			colons++;
+			if (colons == 2) {
+				nrEventLines++;
+				if (isSwitch(word, wlen))
+					nrSwitches++;
+			}
+			continue;
+		}
+		nrArgs++;
+		nrArgBytes += wlen;
+		distinctArgs.insert(QByteArray(word, wlen));
+	}
+}
+
+void MemEstimate::compute()
+{
+	double scale, argsPerEvent, distinct, argLen;
+
+	if (sampledBytes == 0 || nrEventLines == 0)
+		return;
+
+	scale = (double) fileSize / sampledBytes;
+	nrEvents = nrEventLines * scale;
+	argsPerEvent = (double) nrArgs / nrEventLines;
+	distinct = nrArgs > 0 ? (double) distinctArgs.size() / nrArgs : 0;
+	argLen = nrArgs > 0 ? (double) nrArgBytes / nrArgs : 0;
+
+	eventBytes = nrEvents * sizeof(TraceEvent);
+	argvBytes = nrEvents * argsPerEvent * sizeof(TString*);
+	/*
+	 * The distinct ratio of a sample is a lower bound for the number of
+	 * strings, since values such as timestamps and addresses tend to be
+	 * unique over the whole trace.
+	 */
+	stringBytes = nrEvents * argsPerEvent * distinct *
+		(sizeof(TString) + sizeof(StringPoolSlot) + argLen + 1);
+	taskBytes = nrSwitches * scale * MEMESTIMATE_SWITCH_BYTES;
+}
+
+void MemEstimate::memReport(MemReport &report) const
+{
+	report.add(QString("Events (estimate)"),
+		   vtl::MemUsage(eventBytes, eventBytes));
+	report.add(QString("Argument pointers (estimate)"),
+		   vtl::MemUsage(argvBytes, argvBytes));
+	report.add(QString("Arguments (estimate)"),
+		   vtl::MemUsage(stringBytes, stringBytes));
+	report.add(QString("Task time series (estimate)"),
+		   vtl::MemUsage(taskBytes, taskBytes));
+}
+
+/* Returns the MemAvailable of /proc/meminfo in bytes, or 0 if it's unknown */
+quint64 MemEstimate::memAvailable()
+{
+	unsigned long long kb;
+	char line[256];
+	quint64 avail = 0;
+	FILE *file;
+
+	file = fopen("/proc/meminfo", "r");
+	if (file == nullptr)
+		return 0;
+	while (fgets(line, sizeof(line), file) != nullptr) {
+		if (sscanf(line, "MemAvailable: %llu kB", &kb) == 1) {
+			avail = (quint64) kb * 1024;
+			break;
+		}
+	}
+	fclose(file);
+	return avail;
+}
@@ -0,0 +1,127 @@
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2018  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef MEMESTIMATE_H
+#define MEMESTIMATE_H
+
+#include <QByteArray>
+#include <QSet>
+#include <QString>
+#include <QtGlobal>
+
+#include "mm/memreport.h"
+#include "vtl/compiler.h"
+
+/* The number of chunks of the file that are sampled */
+#define MEMESTIMATE_NR_SAMPLES (16)
+/* The size of each sampled chunk */
+#define MEMESTIMATE_SAMPLE_SIZE (65536)
+/*
+ * The bytes of task time series and event indices that a sched_switch event
+ * adds, for the task that is switched out and the one that is switched in.
+ */
+#define MEMESTIMATE_SWITCH_BYTES (64)
+
+/*
+ * Estimates how much memory a trace will need once it has been loaded, by
+ * sampling chunks that are spread evenly over the file. The estimate is based
+ * on the average length of the lines, the number of arguments of each event,
+ * how many of the arguments are distinct and how many of the events are
+ * sched_switch events. The file itself is not counted, since it is mapped
+ * read-only and its pages can be dropped from the page cache.
+ */
+class MemEstimate {
+public:
+	MemEstimate();
+	int estimate(const QString &fileName);
+	void memReport(MemReport &report) const;
+	__always_inline quint64 total() const;
+	__always_inline quint64 inCoreTotal() const;
+	__always_inline quint64 getNrEvents() const;
+	static quint64 memAvailable();
+private:
+	void sample(const char *buf, int len, bool first);
+	void sampleLine(const char *begin, const char *end);
+	void compute();
+	quint64 fileSize;
+	quint64 sampledBytes;
+	quint64 nrEventLines;
+	quint64 nrArgs;
+	quint64 nrArgBytes;
+	quint64 nrSwitches;
+	QSet<QByteArray> distinctArgs;
+	quint64 nrEvents;
+	quint64 eventBytes;
+	quint64 argvBytes;
+	quint64 stringBytes;
+	quint64 taskBytes;
+};
+
+__always_inline quint64 MemEstimate::total() const
+{
+	return eventBytes + argvBytes + stringBytes + taskBytes;
+}
+
+/*
+ * The part of the total that is kept in RAM also when the events are kept in
+ * files in the scratch directory
+ */
+__always_inline quint64 MemEstimate::inCoreTotal() const
+{
+	return taskBytes;
+}
+
+__always_inline quint64 MemEstimate::getNrEvents() const
+{
+	return nrEvents;
+}
+
+#endif /* MEMESTIMATE_H */
@@ -52,10 +52,11 @@
 #include "parser/perf/perfgrammar.h"
 #include "parser/traceevent.h"
 
-PerfGrammar::PerfGrammar() :
+/* If onScratch is true, the arguments are kept in scratch files */
+PerfGrammar::PerfGrammar(bool onScratch) :
 	unknownTypeCounter(EVENT_UNKNOWN)
 {
-	argPool = new StringPool(2048, 1024 * 1024);
+	argPool = new StringPool(2048, 1024 * 1024, onScratch);
 	namePool =  new StringPool(1024, 65536);
 	eventTree = new StringTree(8, 256, 4096);
 	setupEventTree();
@@ -77,6 +78,20 @@ void PerfGrammar::clear()
 	unknownTypeCounter = EVENT_UNKNOWN;
 }
 
+void PerfGrammar::memReport(MemReport &report) const
+{
+	report.add(QString("Event names"), eventTree->memUsage());
+	report.add(QString("Arguments"), argPool->memUsage());
+	report.add(QString("Event task names"), namePool->memUsage());
+}
+
+void PerfGrammar::trim()
+{
+	eventTree->trim();
+	argPool->trim();
+	namePool->trim();
+}
+
 void PerfGrammar::setupEventTree()
 {
 	int t;
@@ -53,6 +53,7 @@
 #define PERFGRAMMAR_H
 
 #include "misc/traceshark.h"
+#include "mm/memreport.h"
 #include "mm/stringpool.h"
 #include "mm/stringtree.h"
 #include "parser/traceevent.h"
@@ -69,9 +70,11 @@
 class PerfGrammar
 {
 public:
-	PerfGrammar();
+	PerfGrammar(bool onScratch = false);
 	~PerfGrammar();
 	void clear();
+	void memReport(MemReport &report) const;
+	void trim();
 	__always_inline bool parseLine(TraceLine &line, TraceEvent &event);
 	StringTree *eventTree;
 private:
@@ -258,10 +261,10 @@ __always_inline bool PerfGrammar::TimeMatch(TString *str, TraceEvent &event)
 					return false;
 			}
 
-			hash = TShark::StrHash32(&namestr);
+			hash = TShark::StrHash(&namestr);
 			newname = namePool->allocString(&namestr, hash, 0);
 		} else {
-			hash = TShark::StrHash32(event.argv[0]);
+			hash = TShark::StrHash(event.argv[0]);
 			newname = namePool->allocString(event.argv[0], hash,
 							0);
 		}
@@ -275,34 +278,43 @@ __always_inline bool PerfGrammar::TimeMatch(TString *str, TraceEvent &event)
 
 __always_inline bool PerfGrammar::EventMatch(TString *str, TraceEvent &event)
 {
+	char buf[512];
+	TString estr;
+	const int maxlen = sizeof(buf) / sizeof(char) - 1;
 	char *lastChr = str->ptr + str->len - 1;
 	char *c;
 	TString tmpstr;
 	event_t type;
 
-	if (str->len < 1)
+	if (str->len < 1 || *lastChr != ':')
 		return false;
 
-	if (*lastChr == ':') {
-		*lastChr = '\0';
-		str->len--;
-	} else
-		return false;
-
-	for (c = str->ptr; c < lastChr; c++)
-		if (*c == ':')
-			break;
-
-	if (c < lastChr) {
+	/* Skip the subsystem, e.g. the sched: of sched:sched_switch: */
+	c = (char*) memchr(str->ptr, ':', str->len - 1);
+	if (c != nullptr) {
 		tmpstr.ptr = c + 1;
 		tmpstr.len = lastChr - tmpstr.ptr;
 	} else {
 		tmpstr.ptr = str->ptr;
-		tmpstr.len = str->len;
+		tmpstr.len = str->len - 1;
 	}
+	if (tmpstr.len < 1)
+		return false;
+
+	/* The common case, an event name that has been seen before */
+	type = eventTree->findHot(tmpstr.ptr, tmpstr.len);
+	if (type != EVENT_ERROR) {
+		event.type = type;
+		return true;
+	}
+
+	/* The AVL trees need a null terminated name, so it is copied */
+	estr.len = 0;
+	estr.ptr = buf;
+	if (!estr.set(&tmpstr, maxlen))
+		return false;
 
-	type = eventTree->searchAllocString(&tmpstr,
-					    TShark::StrHash32(&tmpstr),
+	type = eventTree->searchAllocString(&estr, TShark::StrHash32(&estr),
 					    (event_t) unknownTypeCounter);
 	if (type == EVENT_ERROR)
 		return false;
@@ -322,7 +334,7 @@ __always_inline bool PerfGrammar::ArgMatch(TString *str, TraceEvent &event)
 {
 	const TString *newstr;
 	if (event.argc < EVENT_MAX_NR_ARGS) {
-		newstr = argPool->allocString(str, TShark::StrHash32(str), 16);
+		newstr = argPool->allocString(str, TShark::StrHash(str), 16);
 		if (newstr == nullptr)
 			return false;
 		event.argv[event.argc] = newstr;
@@ -309,7 +309,7 @@ __perf_sched_switch_handle_newname_strdup(const TraceEvent &event,
 	}
 
 	ts.len = len;
-	retstr = pool->allocString(&ts, TShark::StrHash32(&ts), 0);
+	retstr = pool->allocString(&ts, TShark::StrHash(&ts), 0);
 	if (retstr == nullptr)
 		return NullStr;
 
@@ -379,7 +379,7 @@ __perf_sched_switch_handle_oldname_strdup(const TraceEvent &event,
 			return NullStr;
 	}
 	ts.len = len;
-	retstr = pool->allocString(&ts, TShark::StrHash32(&ts), 0);
+	retstr = pool->allocString(&ts, TShark::StrHash(&ts), 0);
 	if (retstr == nullptr)
 		return NullStr;
 
@@ -525,7 +525,7 @@ __perf_sched_wakeup_name_strdup(const TraceEvent &event, StringPool *pool)
 	}
 
 	ts.len = len;
-	retstr = pool->allocString(&ts, TShark::StrHash32(&ts), 0);
+	retstr = pool->allocString(&ts, TShark::StrHash(&ts), 0);
 	if (retstr == nullptr)
 		return NullStr;
 
@@ -599,7 +599,7 @@ __perf_sched_process_fork_childname_strdup(const TraceEvent &event,
 		return NullStr;
 
 	ts.len = len;
-	retstr = pool->allocString(&ts, TShark::StrHash32(&ts), 0);
+	retstr = pool->allocString(&ts, TShark::StrHash(&ts), 0);
 	if (retstr == nullptr)
 		return NullStr;
 
@@ -65,19 +65,27 @@
 #include "misc/traceshark.h"
 #include "threads/indexwatcher.h"
 #include "threads/threadbuffer.h"
+#include "vtl/mapping.h"
 
 #define CLEAR_VARIABLE(VAR) memset(&VAR, 0, sizeof(VAR))
 #define TRACE_TYPE_CONFIDENCE_FACTOR (100)
 
+/*
+ * If a scratch directory has been set, the events and their arguments are
+ * kept in files there, so that a trace can be larger than the RAM. The data of
+ * the analyzer, such as the tasks, is still kept in RAM.
+ */
 TraceParser::TraceParser()
 	: traceType(TRACE_TYPE_NONE), events(nullptr)
 {
+	bool scratch = vtl::get_scratch_dir() != nullptr;
+
 	traceFile = nullptr;
-	ptrPool = new MemPool(16384, sizeof(TString*));
-	postEventPool = new MemPool(16384, sizeof(TString));
+	ptrPool = new MemPool(16384, sizeof(TString*), scratch);
+	postEventPool = new MemPool(16384, sizeof(TString), scratch);
 
-	ftraceGrammar = new FtraceGrammar();
-	perfGrammar = new PerfGrammar();
+	ftraceGrammar = new FtraceGrammar(scratch);
+	perfGrammar = new PerfGrammar(scratch);
 
 	tbuffers = new ThreadBuffer<TraceLine>*[NR_TBUFFERS];
 	parserThread = new WorkThread<TraceParser>
@@ -86,8 +94,8 @@ TraceParser::TraceParser()
 		(QString("readerThread"), this, &TraceParser::threadReader);
 	eventsWatcher = new IndexWatcher(10000);
 	traceTypeWatcher = new IndexWatcher;
-	ftraceEvents = new vtl::TList<TraceEvent>();
-	perfEvents = new vtl::TList<TraceEvent>();
+	ftraceEvents = new vtl::TList<TraceEvent>(scratch);
+	perfEvents = new vtl::TList<TraceEvent>(scratch);
 
 	CLEAR_VARIABLE(fakeEvent);
 	CLEAR_VARIABLE(fakePostEventInfo);
@@ -158,6 +166,34 @@ void TraceParser::close()
 	traceType = TRACE_TYPE_NONE;
 }
 
+/*
+ * Gives back the unused tails of the pools and lists. This must only be called
+ * after the whole trace has been parsed.
+ */
+void TraceParser::trim()
+{
+	ptrPool->trim();
+	postEventPool->trim();
+	ftraceEvents->trim();
+	perfEvents->trim();
+	ftraceGrammar->trim();
+	perfGrammar->trim();
+}
+
+void TraceParser::memReport(MemReport &report) const
+{
+	vtl::MemUsage argv = ptrPool->memUsage();
+
+	if (events != nullptr)
+		report.add(QString("Events"), events->memUsage());
+	argv += postEventPool->memUsage();
+	report.add(QString("Argument pointers"), argv);
+	if (traceType == TRACE_TYPE_PERF)
+		perfGrammar->memReport(report);
+	else
+		ftraceGrammar->memReport(report);
+}
+
 
 void TraceParser::threadReader()
 {
@@ -284,7 +320,7 @@ out:
 
 void TraceParser::waitForTraceType()
 {
-	int index;
+	vtl::index_t index;
 	bool eof = false;
 	while (!eof)
 		traceTypeWatcher->waitForNextBatch(eof, index);
@@ -57,6 +57,7 @@
 #include "parser/genericparams.h"
 #include "parser/ftrace/ftracegrammar.h"
 #include "parser/perf/perfgrammar.h"
+#include "mm/memreport.h"
 #include "mm/mempool.h"
 #include "parser/tracelinedata.h"
 #include "parser/traceline.h"
@@ -66,7 +67,6 @@
 #include "threads/threadbuffer.h"
 #include "threads/workitem.h"
 #include "threads/workthread.h"
-#include "threads/workqueue.h"
 #include "misc/tstring.h"
 
 #define NR_TBUFFERS (4)
@@ -87,6 +87,8 @@ public:
 	int open(const QString &fileName);
 	bool isOpen() const;
 	void close();
+	void memReport(MemReport &report) const;
+	void trim();
 	void threadParser();
 	void threadReader();
 	__always_inline vtl::TList<TraceEvent> *getEventsTList() const;
@@ -94,7 +96,7 @@ public:
 	const StringTree *getFtraceEventTree();
 protected:
 	tracetype_t traceType;
-	__always_inline void waitForNextBatch(bool &eof, int &index);
+	__always_inline void waitForNextBatch(bool &eof, vtl::index_t &index);
 	void waitForTraceType();
 private:
 	void determineTraceType();
@@ -132,7 +134,8 @@ private:
 	IndexWatcher *traceTypeWatcher;
 };
 
-__always_inline void TraceParser::waitForNextBatch(bool &eof, int &index)
+__always_inline void TraceParser::waitForNextBatch(bool &eof,
+						   vtl::index_t &index)
 {
 	eventsWatcher->waitForNextBatch(eof, index);
 }
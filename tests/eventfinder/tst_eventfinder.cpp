@@ -0,0 +1,252 @@
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2018  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <QVector>
+#include <QtTest>
+
+#include "analyzer/eventfinder.h"
+#include "analyzer/eventpredicate.h"
+#include "misc/traceshark.h"
+#include "parser/traceevent.h"
+#include "vtl/tlist.h"
+
+/*
+ * Enough events for several waves of chunks, also with many pool threads, and
+ * a partial chunk at the end
+ */
+#define NR_TEST_EVENTS (40 * FIND_FIRST + 17)
+/* The pid of the events that the tests search for */
+#define MATCH_PID (1)
+
+/*
+ * The events that match have MATCH_PID, the others have pid 0. Each test sets
+ * the matches that it needs and clears them when it is done. The results of
+ * EventFinder are compared with those of a linear scan.
+ */
+class TestEventFinder : public QObject
+{
+	Q_OBJECT
+private slots:
+	void initTestCase();
+	void find_data();
+	void find();
+	void chunkEdges_data();
+	void chunkEdges();
+	void manyMatches();
+private:
+	void setMatches(const QVector<int> &matches, int pid);
+	vtl::index_t scan(vtl::index_t start, bool forward) const;
+	vtl::TList<TraceEvent> events;
+	EventPredicate pred;
+};
+
+void TestEventFinder::initTestCase()
+{
+	vtl::index_t i;
+
+	for (i = 0; i < NR_TEST_EVENTS; i++) {
+		TraceEvent &event = events.increase();
+		event.taskName = nullptr;
+		event.cpu = i % 4;
+		event.pid = 0;
+		event.time = vtl::Time();
+		event.type = SCHED_SWITCH;
+		event.intArg = 0;
+		event.argv = nullptr;
+		event.argc = 0;
+		event.postEventInfo = nullptr;
+	}
+	pred.pid = MATCH_PID;
+}
+
+void TestEventFinder::setMatches(const QVector<int> &matches, int pid)
+{
+	int i;
+
+	for (i = 0; i < matches.size(); i++)
+		events[matches[i]].pid = pid;
+}
+
+vtl::index_t TestEventFinder::scan(vtl::index_t start, bool forward) const
+{
+	vtl::index_t i;
+
+	if (forward) {
+		for (i = start; i < events.size(); i++) {
+			if (events.at(i).pid == MATCH_PID)
+				return i;
+		}
+	} else {
+		for (i = start; i >= 0; i--) {
+			if (events.at(i).pid == MATCH_PID)
+				return i;
+		}
+	}
+	return -1;
+}
+
+void TestEventFinder::find_data()
+{
+	const int last = NR_TEST_EVENTS - 1;
+	const int mid = NR_TEST_EVENTS / 2;
+	const int wave = FIND_FIRST + 2 * FIND_FIRST;
+
+	QTest::addColumn<QVector<int> >("matches");
+	QTest::addColumn<int>("start");
+	QTest::addColumn<bool>("forward");
+
+	QTest::newRow("none forward") << QVector<int>() << 0 << true;
+	QTest::newRow("none backward") << QVector<int>() << last << false;
+	QTest::newRow("at start") << QVector<int>({ mid }) << mid << true;
+	QTest::newRow("at start backward") << QVector<int>({ mid }) << mid <<
+		false;
+	QTest::newRow("behind") << QVector<int>({ mid - 1 }) << mid << true;
+	QTest::newRow("behind backward") << QVector<int>({ mid + 1 }) << mid <<
+		false;
+	QTest::newRow("first event") << QVector<int>({ 0 }) << last << false;
+	QTest::newRow("last event") << QVector<int>({ last }) << 0 << true;
+	QTest::newRow("out of range") << QVector<int>({ 0 }) <<
+		NR_TEST_EVENTS << false;
+	QTest::newRow("negative start") << QVector<int>({ 0 }) << -1 << true;
+	/* The closer of two matches in neighbouring chunks must win */
+	QTest::newRow("neighbour chunks") <<
+		QVector<int>({ wave - 1, wave, last }) << 0 << true;
+	QTest::newRow("neighbour chunks backward") <<
+		QVector<int>({ 0, last - wave, last - wave + 1 }) << last <<
+		false;
+	QTest::newRow("far chunk first") <<
+		QVector<int>({ FIND_FIRST, last - 1, last }) << 0 << true;
+	QTest::newRow("far chunk first backward") <<
+		QVector<int>({ 0, 1, last - FIND_FIRST }) << last << false;
+}
+
+void TestEventFinder::find()
+{
+	QFETCH(QVector<int>, matches);
+	QFETCH(int, start);
+	QFETCH(bool, forward);
+	EventFinder finder(&events);
+	vtl::index_t expected = -1;
+
+	setMatches(matches, MATCH_PID);
+	if (start >= 0 && start < NR_TEST_EVENTS)
+		expected = scan(start, forward);
+	QCOMPARE(finder.find(start, pred, forward), expected);
+	setMatches(matches, 0);
+}
+
+/*
+ * The chunks are FIND_FIRST times a power of two, so all their edges are at a
+ * multiple of FIND_FIRST from the start, no matter how many pool threads there
+ * are. A single match is placed at, and next to, each of them.
+ */
+void TestEventFinder::chunkEdges_data()
+{
+	QTest::addColumn<int>("start");
+	QTest::addColumn<bool>("forward");
+
+	QTest::newRow("forward from first") << 0 << true;
+	QTest::newRow("forward from middle") << NR_TEST_EVENTS / 2 + 5 << true;
+	QTest::newRow("backward from last") << NR_TEST_EVENTS - 1 << false;
+	QTest::newRow("backward from middle") << NR_TEST_EVENTS / 2 + 5 <<
+		false;
+}
+
+void TestEventFinder::chunkEdges()
+{
+	QFETCH(int, start);
+	QFETCH(bool, forward);
+	EventFinder finder(&events);
+	vtl::index_t edge, m;
+	int d;
+
+	for (edge = 0; edge <= NR_TEST_EVENTS; edge += FIND_FIRST) {
+		for (d = -1; d <= 1; d++) {
+			m = forward ? start + edge + d : start - edge + d;
+			if (m < 0 || m >= NR_TEST_EVENTS)
+				continue;
+			events[m].pid = MATCH_PID;
+			QCOMPARE(finder.find(start, pred, forward),
+				 scan(start, forward));
+			events[m].pid = 0;
+		}
+	}
+}
+
+/*
+ * Sparse matches in pseudorandom positions, searched for from pseudorandom
+ * starts in both directions
+ */
+void TestEventFinder::manyMatches()
+{
+	EventFinder finder(&events);
+	QVector<int> matches;
+	quint32 seed = 1;
+	vtl::index_t start;
+	int i;
+
+	for (i = 0; i < 16; i++) {
+		seed = seed * 1103515245 + 12345;
+		matches.append(seed % NR_TEST_EVENTS);
+	}
+	setMatches(matches, MATCH_PID);
+	for (i = 0; i < 64; i++) {
+		seed = seed * 1103515245 + 12345;
+		start = seed % NR_TEST_EVENTS;
+		QCOMPARE(finder.find(start, pred, true), scan(start, true));
+		QCOMPARE(finder.find(start, pred, false), scan(start, false));
+	}
+	setMatches(matches, 0);
+}
+
+QTEST_APPLESS_MAIN(TestEventFinder)
+
+#include "tst_eventfinder.moc"
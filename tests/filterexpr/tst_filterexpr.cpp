@@ -0,0 +1,380 @@
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2018  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <QString>
+#include <QVector>
+#include <QtTest>
+#include <cstring>
+#include <functional>
+
+#include "analyzer/filterexpr.h"
+#include "misc/traceshark.h"
+#include "mm/stringtree.h"
+#include "parser/traceevent.h"
+#include "vtl/tlist.h"
+
+/* Enough events for a few blocks and a partial block at the end */
+#define NR_TEST_EVENTS (3 * FILTEREXPR_BLOCK + 17)
+
+typedef std::function<bool(vtl::index_t)> Predicate;
+Q_DECLARE_METATYPE(Predicate)
+
+/*
+ * The events cycle through sched_switch, sched_wakeup and cpu_idle and
+ * through four CPUs. Only the sched_switch events have a prev_state, which is
+ * D for every other one of them and S for the rest.
+ */
+class TestFilterExpr : public QObject
+{
+	Q_OBJECT
+private slots:
+	void initTestCase();
+	void cleanupTestCase();
+	void compileValid_data();
+	void compileValid();
+	void compileInvalid_data();
+	void compileInvalid();
+	void errorPosition();
+	void usesField();
+	void evaluate_data();
+	void evaluate();
+private:
+	bool isSwitch(vtl::index_t i) const;
+	bool isD(vtl::index_t i) const;
+	QVector<vtl::index_t> filter(const FilterExpr &expr) const;
+	QVector<vtl::index_t> scan(const Predicate &pred) const;
+	StringTree *eventTree;
+	vtl::TList<TraceEvent> events;
+	vtl::TList<int> prevState;
+	vtl::TList<int> *columns[FilterExpr::NR_FIELDS];
+};
+
+void TestFilterExpr::initTestCase()
+{
+	TString str;
+	vtl::index_t i;
+	int t;
+
+	/* This is what the grammars do, the expressions look up the events */
+	eventTree = new StringTree();
+	for (t = 0; t < NR_EVENTS; t++) {
+		str.ptr = eventstrings[t];
+		str.len = strlen(eventstrings[t]);
+		eventTree->searchAllocString(&str, TShark::StrHash32(&str),
+					     (event_t) t);
+	}
+	TraceEvent::setStringTree(eventTree);
+
+	for (i = 0; i < NR_TEST_EVENTS; i++) {
+		TraceEvent &event = events.increase();
+		event.taskName = nullptr;
+		event.cpu = i % 4;
+		event.pid = i;
+		event.time = vtl::Time();
+		event.intArg = 0;
+		event.argv = nullptr;
+		event.argc = 0;
+		event.postEventInfo = nullptr;
+		switch (i % 3) {
+		case 0:
+			event.type = SCHED_SWITCH;
+			break;
+		case 1:
+			event.type = SCHED_WAKEUP;
+			break;
+		default:
+			event.type = CPU_IDLE;
+			break;
+		}
+	}
+
+	for (t = 0; t < FilterExpr::NR_FIELDS; t++)
+		columns[t] = nullptr;
+	columns[FilterExpr::FIELD_PREV_STATE] = &prevState;
+	prevState.resize(events.size());
+	for (i = 0; i < events.size(); i++) {
+		if (!isSwitch(i))
+			prevState[i] = FILTEREXPR_UNDEFINED;
+		else
+			prevState[i] = isD(i) ? TASK_FLAG_UNINTERRUPTIBLE :
+				TASK_FLAG_INTERRUPTIBLE;
+	}
+}
+
+void TestFilterExpr::cleanupTestCase()
+{
+	TraceEvent::setStringTree(nullptr);
+	delete eventTree;
+}
+
+bool TestFilterExpr::isSwitch(vtl::index_t i) const
+{
+	return i % 3 == 0;
+}
+
+bool TestFilterExpr::isD(vtl::index_t i) const
+{
+	return isSwitch(i) && (i / 3) % 2 == 0;
+}
+
+/* Evaluates the expression block by block, as TraceAnalyzer does */
+QVector<vtl::index_t> TestFilterExpr::filter(const FilterExpr &expr) const
+{
+	QVector<vtl::index_t> result;
+	vtl::index_t first, i;
+	quint64 mask;
+	int n;
+
+	for (first = 0; first < events.size(); first += FILTEREXPR_BLOCK) {
+		n = (int) TSMIN(events.size() - first,
+				(vtl::index_t) FILTEREXPR_BLOCK);
+		mask = expr.eval(&events, columns, first, n);
+		for (i = 0; i < n; i++) {
+			if (mask & ((quint64) 0x1 << i))
+				result.append(first + i);
+		}
+	}
+	return result;
+}
+
+QVector<vtl::index_t> TestFilterExpr::scan(const Predicate &pred) const
+{
+	QVector<vtl::index_t> result;
+	vtl::index_t i;
+
+	for (i = 0; i < events.size(); i++) {
+		if (pred(i))
+			result.append(i);
+	}
+	return result;
+}
+
+void TestFilterExpr::compileValid_data()
+{
+	QTest::addColumn<QString>("text");
+
+	QTest::newRow("int") << "cpu == 1";
+	QTest::newRow("negative") << "common_pid > -1";
+	QTest::newRow("hex") << "common_pid == 0x1f";
+	QTest::newRow("operators") << "cpu != 1 && cpu < 2 || cpu <= 3 && "
+		"cpu > 0 || cpu >= 1";
+	QTest::newRow("set") << "cpu in {0..3, 5, 7..9}";
+	QTest::newRow("event") << "event == sched_switch";
+	QTest::newRow("event set") << "event in {sched_wakeup, "
+		"sched_wakeup_new}";
+	QTest::newRow("state") << "prev_state == D";
+	QTest::newRow("preempted") << "prev_state == R+";
+	QTest::newRow("state flags") << "prev_state == D|K";
+	QTest::newRow("not") << "!(cpu == 1)";
+	QTest::newRow("nested") << "!((cpu == 1 || cpu == 2) && !pid == 3)";
+	QTest::newRow("no spaces") << "cpu==1&&event==cpu_idle";
+	QTest::newRow("wide set") << "pid in {0, 100000000}";
+}
+
+void TestFilterExpr::compileValid()
+{
+	QFETCH(QString, text);
+	FilterExpr expr;
+	QString error;
+
+	QVERIFY2(expr.compile(text, &error), error.toLatin1().constData());
+	QVERIFY(!expr.isEmpty());
+	QCOMPARE(expr.getText(), text);
+}
+
+void TestFilterExpr::compileInvalid_data()
+{
+	QTest::addColumn<QString>("text");
+	QTest::addColumn<QString>("error");
+
+	QTest::newRow("empty") << "" << "Expected a field name";
+	QTest::newRow("unknown field") << "foo == 1" << "Unknown field";
+	QTest::newRow("unknown event") << "event == foo" << "Unknown event";
+	QTest::newRow("state order") << "prev_state < D" <<
+		"can only be compared";
+	QTest::newRow("event order") << "event >= sched_switch" <<
+		"can only be compared";
+	QTest::newRow("bad state") << "prev_state == Q" <<
+		"Invalid task state";
+	QTest::newRow("not an int") << "cpu == D" << "Expected an integer";
+	QTest::newRow("too large") << "cpu == 4294967296" <<
+		"The integer is too large";
+	QTest::newRow("empty range") << "cpu in {5..3}" << "The range is empty";
+	QTest::newRow("event range") << "event in {cpu_idle..sched_switch}" <<
+		"Ranges are only allowed";
+	QTest::newRow("open set") << "cpu in {1, 2" << "Expected ',' or '}'";
+	QTest::newRow("no brace") << "cpu in 1" << "Expected '{'";
+	QTest::newRow("single &") << "cpu == 1 & cpu == 2" <<
+		"Unexpected character '&'";
+	QTest::newRow("single =") << "cpu = 1" << "Unexpected character '='";
+	QTest::newRow("bad char") << "cpu == 1 # 2" <<
+		"Unexpected character '#'";
+	QTest::newRow("open paren") << "(cpu == 1" << "Expected ')'";
+	QTest::newRow("extra paren") << "cpu == 1)" << "Unexpected input";
+	QTest::newRow("no operator") << "cpu 1" <<
+		"Expected a comparison operator";
+	QTest::newRow("trailing &&") << "cpu == 1 &&" << "Expected a field name";
+	QTest::newRow("too deep") << QString("!").repeated(40) + "cpu == 1" <<
+		"nested too deeply";
+}
+
+void TestFilterExpr::compileInvalid()
+{
+	QFETCH(QString, text);
+	QFETCH(QString, error);
+	FilterExpr expr;
+	QString msg;
+
+	QVERIFY(!expr.compile(text, &msg));
+	QVERIFY2(msg.contains(error), msg.toLatin1().constData());
+	QVERIFY(expr.isEmpty());
+}
+
+void TestFilterExpr::errorPosition()
+{
+	FilterExpr expr;
+	QString msg;
+
+	QVERIFY(!expr.compile("cpu == 1 && foo == 2", &msg));
+	QCOMPARE(msg, QString("Unknown field \"foo\" at position 13"));
+}
+
+void TestFilterExpr::usesField()
+{
+	FilterExpr expr;
+
+	QVERIFY(expr.compile("cpu == 1 || prev_state == D", nullptr));
+	QVERIFY(expr.usesField(FilterExpr::FIELD_CPU));
+	QVERIFY(expr.usesField(FilterExpr::FIELD_PREV_STATE));
+	QVERIFY(!expr.usesField(FilterExpr::FIELD_NEXT_PID));
+	QVERIFY(!FilterExpr::fieldIsDecoded(FilterExpr::FIELD_EVENT));
+	QVERIFY(FilterExpr::fieldIsDecoded(FilterExpr::FIELD_PREV_STATE));
+}
+
+/*
+ * The expected events are given by a predicate that is evaluated on each
+ * event, with the events that lack prev_state spelled out.
+ */
+void TestFilterExpr::evaluate_data()
+{
+	QTest::addColumn<QString>("text");
+	QTest::addColumn<Predicate>("pred");
+
+	QTest::newRow("cpu") << "cpu == 2" <<
+		Predicate([](vtl::index_t i) { return i % 4 == 2; });
+	QTest::newRow("range") << "cpu in {1..2}" <<
+		Predicate([](vtl::index_t i) {
+				return i % 4 == 1 || i % 4 == 2;
+			});
+	QTest::newRow("pid") << "common_pid >= 0x10 && common_pid < 100" <<
+		Predicate([](vtl::index_t i) { return i >= 16 && i < 100; });
+	QTest::newRow("pid set") << "common_pid in {1, 3, 200}" <<
+		Predicate([](vtl::index_t i) {
+				return i == 1 || i == 3 || i == 200;
+			});
+	QTest::newRow("event") << "event == sched_wakeup" <<
+		Predicate([](vtl::index_t i) { return i % 3 == 1; });
+	QTest::newRow("not event") << "!(event == sched_wakeup)" <<
+		Predicate([](vtl::index_t i) { return i % 3 != 1; });
+	QTest::newRow("state") << "prev_state == D" <<
+		Predicate([this](vtl::index_t i) { return isD(i); });
+	QTest::newRow("not state") << "prev_state != D" <<
+		Predicate([this](vtl::index_t i) {
+				return isSwitch(i) && !isD(i);
+			});
+	/* An unknown comparison stays unknown when negated */
+	QTest::newRow("not undefined") << "!(prev_state == D)" <<
+		Predicate([this](vtl::index_t i) {
+				return isSwitch(i) && !isD(i);
+			});
+	QTest::newRow("double not") << "!!(prev_state == D)" <<
+		Predicate([this](vtl::index_t i) { return isD(i); });
+	QTest::newRow("true or unknown") << "!(prev_state == D) || cpu == 0" <<
+		Predicate([this](vtl::index_t i) {
+				return (isSwitch(i) && !isD(i)) || i % 4 == 0;
+			});
+	QTest::newRow("false and unknown") <<
+		"!(prev_state == D && cpu == 0)" <<
+		Predicate([this](vtl::index_t i) {
+				return (isSwitch(i) && !isD(i)) ||
+					i % 4 != 0;
+			});
+	QTest::newRow("unknown and true") <<
+		"!(prev_state == D && cpu in {0..3})" <<
+		Predicate([this](vtl::index_t i) {
+				return isSwitch(i) && !isD(i);
+			});
+	QTest::newRow("unknown or false") <<
+		"!(prev_state == D || cpu == 5)" <<
+		Predicate([this](vtl::index_t i) {
+				return isSwitch(i) && !isD(i);
+			});
+	QTest::newRow("switch and cpu") <<
+		"event == sched_switch && cpu in {0, 3} && prev_state == D" <<
+		Predicate([this](vtl::index_t i) {
+				return isD(i) && (i % 4 == 0 || i % 4 == 3);
+			});
+}
+
+void TestFilterExpr::evaluate()
+{
+	QFETCH(QString, text);
+	QFETCH(Predicate, pred);
+	FilterExpr expr;
+	QString error;
+
+	QVERIFY2(expr.compile(text, &error), error.toLatin1().constData());
+	QCOMPARE(filter(expr), scan(pred));
+}
+
+QTEST_APPLESS_MAIN(TestFilterExpr)
+
+#include "tst_filterexpr.moc"
@@ -55,27 +55,31 @@
 #include <QMutex>
 #include <QWaitCondition>
 
+#include "vtl/compiler.h"
+#include "vtl/index.h"
+
 class IndexWatcher
 {
 public:
 	IndexWatcher(int bSize = 100);
 	void setBatchSize(int bSize);
-	__always_inline void waitForNextBatch(bool &eof, int &index);
-	__always_inline void sendNextIndex(int index);
+	__always_inline void waitForNextBatch(bool &eof, vtl::index_t &index);
+	__always_inline void sendNextIndex(vtl::index_t index);
 	void sendEOF();
 	void reset();
 private:
 	int batchSize;
 	bool isEOF;
 	/* This is the highest index posted by the producer */
-	int postedIndex;
+	vtl::index_t postedIndex;
 	/* This is the higher index being received by the consumer */
-	int receivedIndex;
+	vtl::index_t receivedIndex;
 	QMutex mutex;
 	QWaitCondition batchCompleted;
 };
 
-__always_inline void IndexWatcher::waitForNextBatch(bool &eof, int &index)
+__always_inline void IndexWatcher::waitForNextBatch(bool &eof,
+						    vtl::index_t &index)
 {
 	mutex.lock();
 	while(!isEOF && postedIndex - receivedIndex < batchSize) {
@@ -87,7 +91,7 @@ __always_inline void IndexWatcher::waitForNextBatch(bool &eof, int &index)
 	mutex.unlock();
 }
 
-__always_inline void IndexWatcher::sendNextIndex(int index)
+__always_inline void IndexWatcher::sendNextIndex(vtl::index_t index)
 {
 	mutex.lock();
 	if (index <= postedIndex)
@@ -0,0 +1,266 @@
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2018  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <climits>
+#include <QString>
+#include <QThread>
+
+#include "threads/threadpool.h"
+
+#define DEFAULT_NR_CPUS (6) /* Isn't this what most people are running now? */
+
+/* The index of the pool worker that is the current thread, or -1 */
+static thread_local int workerIndex = -1;
+
+PoolWorker::PoolWorker():
+	pool(nullptr), index(0), thread(nullptr) {}
+
+PoolWorker::~PoolWorker()
+{
+	delete thread;
+}
+
+__always_inline void PoolWorker::push(const PoolItem &pitem)
+{
+	mutex.lock();
+	deque.append(pitem);
+	mutex.unlock();
+}
+
+__always_inline bool PoolWorker::pop(PoolItem &pitem)
+{
+	bool ok;
+
+	mutex.lock();
+	ok = !deque.isEmpty();
+	if (ok)
+		pitem = deque.takeLast();
+	mutex.unlock();
+	return ok;
+}
+
+__always_inline bool PoolWorker::steal(PoolItem &pitem)
+{
+	bool ok;
+
+	mutex.lock();
+	ok = !deque.isEmpty();
+	if (ok)
+		pitem = deque.takeFirst();
+	mutex.unlock();
+	return ok;
+}
+
+void PoolWorker::threadRun()
+{
+	bool stop;
+
+	workerIndex = index;
+	do {
+		if (pool->runOne(index)) {
+			stop = false;
+			continue;
+		}
+		pool->sleepMutex.lock();
+		while (pool->queued.loadAcquire() == 0 && !pool->stopping)
+			pool->workAvailable.wait(&pool->sleepMutex);
+		stop = pool->stopping && pool->queued.loadAcquire() == 0;
+		pool->sleepMutex.unlock();
+	} while (!stop);
+	workerIndex = -1;
+}
+
+ThreadPool::ThreadPool():
+	nextVictim(0), queued(0), stopping(false)
+{
+	int cpus, i;
+
+	cpus = QThread::idealThreadCount();
+	nrThreads = cpus > 0 ? cpus:DEFAULT_NR_CPUS;
+	workers = new PoolWorker[nrThreads];
+	for (i = 0; i < nrThreads; i++) {
+		PoolWorker &w = workers[i];
+		w.pool = this;
+		w.index = i;
+		w.thread = new WorkThread<PoolWorker>(QString("ThreadPool"), &w,
+						      &PoolWorker::threadRun);
+		w.thread->start();
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	int i;
+
+	sleepMutex.lock();
+	stopping = true;
+	workAvailable.wakeAll();
+	sleepMutex.unlock();
+	for (i = 0; i < nrThreads; i++)
+		workers[i].thread->wait();
+	delete[] workers;
+}
+
+ThreadPool *ThreadPool::instance()
+{
+	static ThreadPool pool;
+	return &pool;
+}
+
+int ThreadPool::currentWorker()
+{
+	return workerIndex;
+}
+
+void ThreadPool::submit(const PoolItem &pitem)
+{
+	int target = currentWorker();
+
+	/*
+	 * Work that is submitted from outside of the pool is spread round robin
+	 * over the workers. A worker that submits work keeps it in its own
+	 * deque, where the others can steal it if they are idle.
+	 */
+	if (target < 0)
+		target = (nextVictim.fetchAndAddRelaxed(1) & INT_MAX) % nrThreads;
+	workers[target].push(pitem);
+	queued.ref();
+
+	sleepMutex.lock();
+	workAvailable.wakeOne();
+	sleepMutex.unlock();
+}
+
+bool ThreadPool::findItem(int self, PoolItem &pitem)
+{
+	int start, i, victim;
+
+	if (queued.loadAcquire() == 0)
+		return false;
+
+	if (self >= 0 && workers[self].pop(pitem))
+		goto found;
+
+	start = self >= 0 ? self + 1 :
+		(nextVictim.loadAcquire() & INT_MAX) % nrThreads;
+	for (i = 0; i < nrThreads; i++) {
+		victim = (start + i) % nrThreads;
+		if (victim == self)
+			continue;
+		if (workers[victim].steal(pitem))
+			goto found;
+	}
+	return false;
+found:
+	queued.deref();
+	return true;
+}
+
+void ThreadPool::execute(const PoolItem &pitem)
+{
+	bool rval = pitem.item->__runWork();
+	pitem.group->itemDone(rval);
+}
+
+bool ThreadPool::runOne(int self)
+{
+	PoolItem pitem;
+
+	if (!findItem(self, pitem))
+		return false;
+	execute(pitem);
+	return true;
+}
+
+WorkGroup::WorkGroup(ThreadPool *p):
+	pool(p), pending(0), error(0) {}
+
+WorkGroup::~WorkGroup()
+{
+	wait();
+}
+
+void WorkGroup::run(AbstractWorkItem *item)
+{
+	pending.ref();
+	pool->submit(PoolItem(item, this));
+}
+
+bool WorkGroup::wait()
+{
+	int self = ThreadPool::currentWorker();
+
+	while (pending.loadAcquire() != 0) {
+		if (!pool->runOne(self))
+			break;
+	}
+
+	mutex.lock();
+	while (pending.loadAcquire() != 0)
+		done.wait(&mutex);
+	mutex.unlock();
+	return error.loadAcquire() != 0;
+}
+
+void WorkGroup::itemDone(bool rval)
+{
+	if (rval)
+		error.storeRelease(1);
+	/*
+	 * The decrement must be done with the mutex held, otherwise the waiter
+	 * could see zero, return and destroy the group before we have signaled
+	 * the condition.
+	 */
+	mutex.lock();
+	if (!pending.deref())
+		done.wakeAll();
+	mutex.unlock();
+}
@@ -0,0 +1,224 @@
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2018  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <QAtomicInt>
+#include <QList>
+#include <QMutex>
+#include <QWaitCondition>
+
+#include "threads/workitem.h"
+#include "threads/workthread.h"
+#include "misc/traceshark.h"
+
+class ThreadPool;
+class WorkGroup;
+
+/*
+ * A piece of work that has been submitted to the pool, together with the
+ * group that is interested in its completion
+ */
+class PoolItem {
+public:
+	PoolItem(): item(nullptr), group(nullptr) {}
+	PoolItem(AbstractWorkItem *i, WorkGroup *g): item(i), group(g) {}
+	AbstractWorkItem *item;
+	WorkGroup *group;
+};
+
+/*
+ * Each worker owns a deque. The owner pushes and pops at the back, so that
+ * it will work on the most recently submitted, cache hot items, while idle
+ * workers steal from the front, where the oldest items are.
+ */
+class PoolWorker {
+	friend class ThreadPool;
+public:
+	PoolWorker();
+	~PoolWorker();
+protected:
+	void threadRun();
+private:
+	__always_inline void push(const PoolItem &pitem);
+	__always_inline bool pop(PoolItem &pitem);
+	__always_inline bool steal(PoolItem &pitem);
+	ThreadPool *pool;
+	int index;
+	QMutex mutex;
+	QList<PoolItem> deque;
+	WorkThread<PoolWorker> *thread;
+};
+
+/*
+ * The process wide pool of worker threads. The threads are created when the
+ * pool is first used and they are kept until the program exits, so that
+ * short parallel phases, such as rescaling after a resize, do not need to pay
+ * for creating and joining threads.
+ */
+class ThreadPool {
+	friend class PoolWorker;
+	friend class WorkGroup;
+public:
+	static ThreadPool *instance();
+	__always_inline int nrWorkers() const;
+	template<typename Fn>
+		bool parallelFor(int begin, int end, int grain, Fn fn);
+protected:
+	ThreadPool();
+	~ThreadPool();
+private:
+	void submit(const PoolItem &pitem);
+	bool findItem(int self, PoolItem &pitem);
+	bool runOne(int self);
+	void execute(const PoolItem &pitem);
+	static int currentWorker();
+	PoolWorker *workers;
+	int nrThreads;
+	QAtomicInt nextVictim;
+	QAtomicInt queued;
+	QMutex sleepMutex;
+	QWaitCondition workAvailable;
+	bool stopping;
+};
+
+/*
+ * A WorkGroup is a set of work items, which are submitted to the pool and
+ * then waited for as a unit. The thread that calls wait() does not sleep
+ * while there still is queued work, instead it helps the workers. This makes
+ * it possible to wait for a group from within a work item without the risk of
+ * running out of threads.
+ */
+class WorkGroup {
+	friend class ThreadPool;
+public:
+	WorkGroup(ThreadPool *p = ThreadPool::instance());
+	~WorkGroup();
+	void run(AbstractWorkItem *item);
+	bool wait();
+	__always_inline bool isIdle() const;
+private:
+	void itemDone(bool rval);
+	ThreadPool *pool;
+	QAtomicInt pending;
+	QAtomicInt error;
+	QMutex mutex;
+	QWaitCondition done;
+};
+
+template<typename Fn>
+class RangeWorkItem : public AbstractWorkItem {
+public:
+	RangeWorkItem(): fn(nullptr), from(0), to(0) {}
+	void setRange(Fn *f, int b, int e) {
+		fn = f;
+		from = b;
+		to = e;
+	}
+protected:
+	bool run() {
+		(*fn)(from, to);
+		return false;
+	}
+private:
+	Fn *fn;
+	int from;
+	int to;
+};
+
+__always_inline int ThreadPool::nrWorkers() const
+{
+	return nrThreads;
+}
+
+/* Returns true if no item of the group is queued or running */
+__always_inline bool WorkGroup::isIdle() const
+{
+	return pending.loadAcquire() == 0;
+}
+
+/*
+ * Calls fn(b, e) for consecutive subranges [b, e) of [begin, end), each of
+ * them at most grain elements long. The subranges are processed in parallel
+ * and the function returns when all of them have been processed.
+ */
+template<typename Fn>
+bool ThreadPool::parallelFor(int begin, int end, int grain, Fn fn)
+{
+	RangeWorkItem<Fn> *items;
+	int nr, i, b, e;
+	bool rval;
+
+	if (end <= begin)
+		return false;
+	if (grain < 1)
+		grain = 1;
+
+	nr = (end - begin - 1) / grain + 1;
+	if (nr == 1) {
+		fn(begin, end);
+		return false;
+	}
+
+	WorkGroup group(this);
+	items = new RangeWorkItem<Fn>[nr];
+	for (i = 0, b = begin; i < nr; i++, b = e) {
+		e = TSMIN(end - b, grain) + b;
+		items[i].setRange(&fn, b, e);
+		group.run(items + i);
+	}
+	rval = group.wait();
+	delete[] items;
+	return rval;
+}
+
+#endif /* THREADPOOL_H */
@@ -54,14 +54,14 @@
 
 #include "misc/traceshark.h"
 
-class WorkQueue;
+class ThreadPool;
 
 /*
- * This class must be a virtual class, because it can't be a template, that 
- * would drag the WorkQueue class into the template business.
+ * This class must be a virtual class, because it can't be a template, that
+ * would drag the ThreadPool class into the template business.
  */
 class AbstractWorkItem {
-	friend class WorkQueue;
+	friend class ThreadPool;
 public:
 	virtual ~AbstractWorkItem() {}
 protected:
@@ -75,7 +75,7 @@ __always_inline bool AbstractWorkItem::__runWork() {
 
 /*
  * This class needs to be a template to be able to call functions in different
- * classes. The WorkQueue uses it through the AbstractWorkItem class interface
+ * classes. The ThreadPool uses it through the AbstractWorkItem class interface
  * in order to avoid dealing with templates.
  */
 template <class W>
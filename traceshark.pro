@@ -58,6 +58,8 @@
 HEADERS       = qcustomplot/qcustomplot.h
 
 HEADERS      +=  ui/abstracttaskmodel.h
+HEADERS      +=  ui/affinegraph.h
+HEADERS      +=  ui/cputimeline.h
 HEADERS      +=  ui/cursor.h
 HEADERS      +=  ui/cursorinfo.h
 HEADERS      +=  ui/errordialog.h
@@ -71,7 +73,8 @@ HEADERS      +=  ui/graphenabledialog.h
 HEADERS      +=  ui/infowidget.h
 HEADERS      +=  ui/licensedialog.h
 HEADERS      +=  ui/mainwindow.h
-HEADERS      +=  ui/migrationarrow.h
+HEADERS      +=  ui/memorywidget.h
+HEADERS      +=  ui/migrationgraph.h
 HEADERS      +=  ui/migrationline.h
 HEADERS      +=  ui/statslimitedmodel.h
 HEADERS      +=  ui/statsmodel.h
@@ -83,22 +86,36 @@ HEADERS      +=  ui/taskselectdialog.h
 HEADERS      +=  ui/tasktoolbar.h
 HEADERS      +=  ui/taskview.h
 HEADERS      +=  ui/tcheckbox.h
+HEADERS      +=  ui/tilecache.h
+HEADERS      +=  ui/timelinepainter.h
 HEADERS      +=  ui/traceplot.h
 HEADERS      +=  ui/tracesharkstyle.h
 HEADERS      +=  ui/yaxisticker.h
 
 HEADERS      +=  analyzer/abstracttask.h
+HEADERS      +=  analyzer/argindex.h
+HEADERS      +=  analyzer/cpuarray.h
 HEADERS      +=  analyzer/cpufreq.h
 HEADERS      +=  analyzer/cpu.h
 HEADERS      +=  analyzer/cpuidle.h
 HEADERS      +=  analyzer/cputask.h
+HEADERS      +=  analyzer/cputasktable.h
+HEADERS      +=  analyzer/eventfinder.h
+HEADERS      +=  analyzer/eventpredicate.h
+HEADERS      +=  analyzer/filterexpr.h
+HEADERS      +=  analyzer/filterset.h
 HEADERS      +=  analyzer/filterstate.h
+HEADERS      +=  analyzer/lodpyramid.h
 HEADERS      +=  analyzer/migration.h
+HEADERS      +=  analyzer/pidindex.h
+HEADERS      +=  analyzer/spanindex.h
 HEADERS      +=  analyzer/task.h
+HEADERS      +=  analyzer/taskpool.h
 HEADERS      +=  analyzer/tcolor.h
 HEADERS      +=  analyzer/traceanalyzer.h
 
 HEADERS      +=  parser/genericparams.h
+HEADERS      +=  parser/memestimate.h
 HEADERS      +=  parser/paramhelpers.h
 HEADERS      +=  parser/traceevent.h
 HEADERS      +=  parser/tracefile.h
@@ -116,12 +133,16 @@ HEADERS      +=  threads/indexwatcher.h
 HEADERS      +=  threads/loadbuffer.h
 HEADERS      +=  threads/loadthread.h
 HEADERS      +=  threads/threadbuffer.h
+HEADERS      +=  threads/threadpool.h
 HEADERS      +=  threads/tthread.h
 HEADERS      +=  threads/workitem.h
-HEADERS      +=  threads/workqueue.h
 HEADERS      +=  threads/workthread.h
 
+HEADERS      +=  mm/arena.h
+HEADERS      +=  mm/arenavector.h
+HEADERS      +=  mm/indexvector.h
 HEADERS      +=  mm/mempool.h
+HEADERS      +=  mm/memreport.h
 HEADERS      +=  mm/stringpool.h
 HEADERS      +=  mm/stringtree.h
 
@@ -138,6 +159,11 @@ HEADERS      +=  vtl/bsdexits.h
 HEADERS      +=  vtl/compiler.h
 HEADERS      +=  vtl/error.h
 HEADERS      +=  vtl/heapsort.h
+HEADERS      +=  vtl/index.h
+HEADERS      +=  vtl/indexlist.h
+HEADERS      +=  vtl/mapping.h
+HEADERS      +=  vtl/memusage.h
+HEADERS      +=  vtl/rankbitmap.h
 HEADERS      +=  vtl/tlist.h
 HEADERS      +=  vtl/time.h
 
@@ -148,6 +174,8 @@ HEADERS      +=  vtl/time.h
 SOURCES       = qcustomplot/qcustomplot.cpp
 
 SOURCES      +=  ui/abstracttaskmodel.cpp
+SOURCES      +=  ui/affinegraph.cpp
+SOURCES      +=  ui/cputimeline.cpp
 SOURCES      +=  ui/cursor.cpp
 SOURCES      +=  ui/cursorinfo.cpp
 SOURCES      +=  ui/errordialog.cpp
@@ -161,7 +189,8 @@ SOURCES      +=  ui/graphenabledialog.cpp
 SOURCES      +=  ui/infowidget.cpp
 SOURCES      +=  ui/licensedialog.cpp
 SOURCES      +=  ui/mainwindow.cpp
-SOURCES      +=  ui/migrationarrow.cpp
+SOURCES      +=  ui/memorywidget.cpp
+SOURCES      +=  ui/migrationgraph.cpp
 SOURCES      +=  ui/migrationline.cpp
 SOURCES      +=  ui/statslimitedmodel.cpp
 SOURCES      +=  ui/statsmodel.cpp
@@ -173,20 +202,30 @@ SOURCES      +=  ui/taskselectdialog.cpp
 SOURCES      +=  ui/tasktoolbar.cpp
 SOURCES      +=  ui/taskview.cpp
 SOURCES      +=  ui/tcheckbox.cpp
+SOURCES      +=  ui/tilecache.cpp
+SOURCES      +=  ui/timelinepainter.cpp
 SOURCES      +=  ui/traceplot.cpp
 SOURCES      +=  ui/tracesharkstyle.cpp
 SOURCES      +=  ui/yaxisticker.cpp
 
 
 SOURCES      +=  analyzer/abstracttask.cpp
-SOURCES      +=  analyzer/cpufreq.cpp
-SOURCES      +=  analyzer/cpuidle.cpp
+SOURCES      +=  analyzer/argindex.cpp
 SOURCES      +=  analyzer/cputask.cpp
+SOURCES      +=  analyzer/cputasktable.cpp
+SOURCES      +=  analyzer/eventfinder.cpp
+SOURCES      +=  analyzer/filterexpr.cpp
+SOURCES      +=  analyzer/filterset.cpp
 SOURCES      +=  analyzer/filterstate.cpp
+SOURCES      +=  analyzer/lodpyramid.cpp
+SOURCES      +=  analyzer/migration.cpp
+SOURCES      +=  analyzer/pidindex.cpp
+SOURCES      +=  analyzer/spanindex.cpp
 SOURCES      +=  analyzer/task.cpp
 SOURCES      +=  analyzer/tcolor.cpp
 SOURCES      +=  analyzer/traceanalyzer.cpp
 
+SOURCES      +=  parser/memestimate.cpp
 SOURCES      +=  parser/traceevent.cpp
 SOURCES      +=  parser/tracefile.cpp
 SOURCES      +=  parser/traceparser.cpp
@@ -200,10 +239,13 @@ SOURCES      +=  parser/perf/perfgrammar.cpp
 SOURCES      +=  threads/indexwatcher.cpp
 SOURCES      +=  threads/loadbuffer.cpp
 SOURCES      +=  threads/loadthread.cpp
+SOURCES      +=  threads/threadpool.cpp
 SOURCES      +=  threads/tthread.cpp
-SOURCES      +=  threads/workqueue.cpp
 
+SOURCES      +=  mm/arena.cpp
+SOURCES      +=  mm/indexvector.cpp
 SOURCES      +=  mm/mempool.cpp
+SOURCES      +=  mm/memreport.cpp
 SOURCES      +=  mm/stringpool.cpp
 SOURCES      +=  mm/stringtree.cpp
 
@@ -213,6 +255,9 @@ SOURCES      +=  misc/setting.cpp
 
 SOURCES      +=  vtl/bitvector.cpp
 SOURCES      +=  vtl/error.cpp
+SOURCES      +=  vtl/indexlist.cpp
+SOURCES      +=  vtl/mapping.cpp
+SOURCES      +=  vtl/rankbitmap.cpp
 
 ###############################################################################
 # Qt Modules
@@ -0,0 +1,306 @@
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2018  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <limits>
+
+#include "analyzer/lodpyramid.h"
+#include "mm/arenavector.h"
+#include "ui/affinegraph.h"
+#include "vtl/bitvector.h"
+
+/* The transform of a graph that has no owner is the identity */
+static const double identityOffset = 0;
+static const double identityScale = 1;
+
+AffineGraph::AffineGraph(QCPAxis *keyAxis, QCPAxis *valueAxis):
+	QCPGraph(keyAxis, valueAxis), valueOffset(&identityOffset),
+	valueScale(&identityScale), lod(nullptr)
+{}
+
+void AffineGraph::setLod(const LodPyramid<LodBucket> *pyramid)
+{
+	lod = pyramid;
+}
+
+int AffineGraph::findLodLevel() const
+{
+	QCPAxis *keyAxis = mKeyAxis.data();
+	int pixels;
+
+	if (lod == nullptr || keyAxis == nullptr)
+		return -1;
+	pixels = keyAxis->orientation() == Qt::Horizontal ?
+		keyAxis->axisRect()->width() : keyAxis->axisRect()->height();
+	return lod->findLevel(keyAxis->range().size(), pixels);
+}
+
+/*
+ * Produces the points of the visible buckets at the level. For line data
+ * each bucket gives a vertical segment from its min to max, after which the
+ * line continues at the last value of the bucket, which is what the adaptive
+ * sampling of QCPGraph would produce. For scatter data, the min and max are
+ * enough.
+ */
+void AffineGraph::getLodData(QVector<QCPGraphData> *data, int level,
+			     bool scatter) const
+{
+	const QVector<LodBucket> &buckets = lod->level(level);
+	QCPRange range = mKeyAxis->range();
+	int first = lod->findBucket(level, range.lower);
+	int s = buckets.size();
+	int i;
+
+	data->resize(0);
+	for (i = first; i < s; i++) {
+		const LodBucket &b = buckets[i];
+		data->append(QCPGraphData(b.key, b.min));
+		if (b.max != b.min)
+			data->append(QCPGraphData(b.key, b.max));
+		if (!scatter && b.last != b.max)
+			data->append(QCPGraphData(b.key, b.last));
+		/* Include the first bucket to the right, so the line ends there */
+		if (b.key > range.upper)
+			break;
+	}
+}
+
+/*
+ * The offset and scale must outlive the graph. They are read each time the
+ * graph is drawn, so the caller only needs to replot after changing them.
+ */
+void AffineGraph::setTransform(const double *offset, const double *scale)
+{
+	valueOffset = offset;
+	valueScale = scale;
+}
+
+void AffineGraph::setConstantData(const ArenaVector<double> &keys,
+				  double value)
+{
+	QVector<QCPGraphData> data(keys.size());
+	int i;
+
+	for (i = 0; i < keys.size(); i++) {
+		data[i].key = keys[i];
+		data[i].value = value;
+	}
+	mDataContainer->set(data, true);
+}
+
+void AffineGraph::setBitData(const ArenaVector<double> &keys,
+			     const vtl::BitVector &bits,
+			     double zero, double one)
+{
+	int s = TSMIN((unsigned) keys.size(), bits.size());
+	QVector<QCPGraphData> data(s);
+	int i;
+
+	for (i = 0; i < s; i++)
+		data[i].key = keys[i];
+	/*
+	 * The values are expanded straight into the points, and the container
+	 * shares the vector with us, so there is only one buffer of points.
+	 */
+	if (s > 0)
+		bits.expand(&data[0].value, s,
+			    sizeof(QCPGraphData) / sizeof(double), zero, one);
+	mDataContainer->set(data, true);
+}
+
+void AffineGraph::getOptimizedLineData(QVector<QCPGraphData> *lineData,
+				       const QCPGraphDataContainer
+				       ::const_iterator &begin,
+				       const QCPGraphDataContainer
+				       ::const_iterator &end) const
+{
+	int level = findLodLevel();
+
+	if (level >= 0)
+		getLodData(lineData, level, false);
+	else
+		QCPGraph::getOptimizedLineData(lineData, begin, end);
+	transformData(lineData);
+}
+
+void AffineGraph::getOptimizedScatterData(QVector<QCPGraphData> *scatterData,
+					  QCPGraphDataContainer
+					  ::const_iterator begin,
+					  QCPGraphDataContainer
+					  ::const_iterator end) const
+{
+	int level = findLodLevel();
+
+	if (level >= 0)
+		getLodData(scatterData, level, true);
+	else
+		QCPGraph::getOptimizedScatterData(scatterData, begin, end);
+	transformData(scatterData);
+}
+
+QPointF AffineGraph::dataPixelPosition(int index) const
+{
+	if (index < 0 || index >= mDataContainer->size())
+		return QCPGraph::dataPixelPosition(index);
+	QCPGraphDataContainer::const_iterator it =
+		mDataContainer->constBegin() + index;
+	return coordsToPixels(it->key, transform(it->value));
+}
+
+QCPRange AffineGraph::getValueRange(bool &foundRange,
+				    QCP::SignDomain inSignDomain,
+				    const QCPRange &inKeyRange) const
+{
+	QCPRange range = QCPGraph::getValueRange(foundRange, QCP::sdBoth,
+						 inKeyRange);
+	double a, b;
+
+	if (!foundRange)
+		return range;
+
+	a = transform(range.lower);
+	b = transform(range.upper);
+	range = QCPRange(TSMIN(a, b), TSMAX(a, b));
+
+	/*
+	 * The sign domain of the transformed data is not the one of the raw
+	 * data, so we can only clip the transformed range here
+	 */
+	if (inSignDomain == QCP::sdPositive && range.lower <= 0) {
+		if (range.upper <= 0)
+			foundRange = false;
+		else
+			range.lower = std::numeric_limits<double>::min();
+	} else if (inSignDomain == QCP::sdNegative && range.upper >= 0) {
+		if (range.lower >= 0)
+			foundRange = false;
+		else
+			range.upper = -std::numeric_limits<double>::min();
+	}
+	return range;
+}
+
+/*
+ * This is a version of QCPGraph::pointDistance() that uses the transformed
+ * values. The original is not virtual, so we cannot override it.
+ */
+double AffineGraph::affinePointDistance(const QPointF &pixelPoint,
+					QCPGraphDataContainer::const_iterator
+					&closestData) const
+{
+	double minDistSqr = std::numeric_limits<double>::max();
+	double posKeyMin, posKeyMax, dummy, distSqr;
+	QCPGraphDataContainer::const_iterator begin, end, it;
+	QVector<QPointF> lineData;
+	QPointF tol(mParentPlot->selectionTolerance(),
+		    mParentPlot->selectionTolerance());
+	int i, step;
+
+	closestData = mDataContainer->constEnd();
+	if (mDataContainer->isEmpty())
+		return -1.0;
+	if (mLineStyle == lsNone && mScatterStyle.isNone())
+		return -1.0;
+
+	pixelsToCoords(pixelPoint - tol, posKeyMin, dummy);
+	pixelsToCoords(pixelPoint + tol, posKeyMax, dummy);
+	if (posKeyMin > posKeyMax)
+		qSwap(posKeyMin, posKeyMax);
+
+	begin = mDataContainer->findBegin(posKeyMin, true);
+	end = mDataContainer->findEnd(posKeyMax, true);
+	for (it = begin; it != end; ++it) {
+		QPointF p = coordsToPixels(it->key, transform(it->value));
+		distSqr = QCPVector2D(p - pixelPoint).lengthSquared();
+		if (distSqr < minDistSqr) {
+			minDistSqr = distSqr;
+			closestData = it;
+		}
+	}
+
+	if (mLineStyle != lsNone) {
+		QCPVector2D p(pixelPoint);
+		/* getLines() uses our getOptimizedLineData() */
+		getLines(&lineData, QCPDataRange(0, dataCount()));
+		step = mLineStyle == lsImpulse ? 2 : 1;
+		for (i = 0; i < lineData.size() - 1; i += step) {
+			distSqr = p.distanceSquaredToLine(lineData.at(i),
+							  lineData.at(i + 1));
+			if (distSqr < minDistSqr)
+				minDistSqr = distSqr;
+		}
+	}
+
+	return qSqrt(minDistSqr);
+}
+
+double AffineGraph::selectTest(const QPointF &pos, bool onlySelectable,
+			       QVariant *details) const
+{
+	QCPGraphDataContainer::const_iterator closest;
+	double result;
+	int index;
+
+	if ((onlySelectable && mSelectable == QCP::stNone) ||
+	    mDataContainer->isEmpty())
+		return -1;
+	if (!mKeyAxis || !mValueAxis)
+		return -1;
+	if (!mKeyAxis.data()->axisRect()->rect().contains(pos.toPoint()))
+		return -1;
+
+	result = affinePointDistance(pos, closest);
+	if (details) {
+		index = closest - mDataContainer->constBegin();
+		details->setValue(QCPDataSelection(QCPDataRange(index,
+								index + 1)));
+	}
+	return result;
+}
@@ -0,0 +1,149 @@
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2018  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef AFFINEGRAPH_H
+#define AFFINEGRAPH_H
+
+#include <QVector>
+#include "qcustomplot/qcustomplot.h"
+#include "misc/traceshark.h"
+
+class LodBucket;
+template<class Bucket> class LodPyramid;
+template<class T> class ArenaVector;
+
+namespace vtl {
+	class BitVector;
+}
+
+/*
+ * A graph that holds unscaled data and that maps each value v to
+ * v * scale + offset when it is drawn, hit tested or used as the data
+ * plottable of error bars. The offset and scale are read through pointers to
+ * the ones of the object that owns the data, so when the layout changes and
+ * the owner is rescaled, the graph follows it without being touched.
+ *
+ * If the graph has a LodPyramid of the same data, then a zoomed out graph is
+ * drawn from the pyramid level whose buckets are about one pixel wide.
+ */
+class AffineGraph : public QCPGraph
+{
+	Q_OBJECT
+public:
+	AffineGraph(QCPAxis *keyAxis, QCPAxis *valueAxis);
+	void setTransform(const double *offset, const double *scale);
+	void setLod(const LodPyramid<LodBucket> *pyramid);
+	__always_inline double getOffset() const;
+	__always_inline double getScale() const;
+	void setConstantData(const ArenaVector<double> &keys, double value);
+	void setBitData(const ArenaVector<double> &keys,
+			const vtl::BitVector &bits, double zero, double one);
+	__always_inline double transform(double value) const;
+	virtual double selectTest(const QPointF &pos, bool onlySelectable,
+				  QVariant *details = 0) const
+		Q_DECL_OVERRIDE;
+	virtual QCPRange getValueRange(bool &foundRange,
+				       QCP::SignDomain inSignDomain =
+				       QCP::sdBoth,
+				       const QCPRange &inKeyRange = QCPRange())
+		const Q_DECL_OVERRIDE;
+	virtual QPointF dataPixelPosition(int index) const Q_DECL_OVERRIDE;
+protected:
+	virtual void getOptimizedLineData(QVector<QCPGraphData> *lineData,
+				const QCPGraphDataContainer::const_iterator
+					  &begin,
+				const QCPGraphDataContainer::const_iterator
+					  &end) const Q_DECL_OVERRIDE;
+	virtual void getOptimizedScatterData(QVector<QCPGraphData>
+					     *scatterData,
+					     QCPGraphDataContainer
+					     ::const_iterator begin,
+					     QCPGraphDataContainer
+					     ::const_iterator end)
+		const Q_DECL_OVERRIDE;
+	double affinePointDistance(const QPointF &pixelPoint,
+				   QCPGraphDataContainer::const_iterator
+				   &closestData) const;
+private:
+	__always_inline void transformData(QVector<QCPGraphData> *data) const;
+	int findLodLevel() const;
+	void getLodData(QVector<QCPGraphData> *data, int level,
+			bool scatter) const;
+	const double *valueOffset;
+	const double *valueScale;
+	const LodPyramid<LodBucket> *lod;
+};
+
+__always_inline double AffineGraph::getOffset() const
+{
+	return *valueOffset;
+}
+
+__always_inline double AffineGraph::getScale() const
+{
+	return *valueScale;
+}
+
+__always_inline double AffineGraph::transform(double value) const
+{
+	return value * *valueScale + *valueOffset;
+}
+
+__always_inline void AffineGraph::transformData(QVector<QCPGraphData> *data)
+	const
+{
+	QVector<QCPGraphData>::iterator iter;
+
+	for (iter = data->begin(); iter != data->end(); iter++)
+		iter->value = transform(iter->value);
+}
+
+#endif /* AFFINEGRAPH_H */
@@ -0,0 +1,455 @@
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2018  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "analyzer/cputask.h"
+#include "analyzer/spanindex.h"
+#include "analyzer/traceanalyzer.h"
+#include "ui/cputimeline.h"
+
+CPUTimeline::CPUTimeline(QCPAxis *keyAxis, QCPAxis *valueAxis):
+	QCPAbstractPlottable(keyAxis, valueAxis), spans(nullptr),
+	tileCache(nullptr), tileRow(0), wakeupFlags(TIMELINE_WAKEUP_NONE),
+	foundKeys(false)
+{
+	setSelectable(QCP::stSingleData);
+	setPen(Qt::NoPen);
+	setBrush(Qt::NoBrush);
+}
+
+int CPUTimeline::addTask(CPUTask *task, const QColor &color)
+{
+	const ArenaVector<double> &timev = task->schedTimev;
+	double maxDelay = 0;
+	int i;
+
+	for (i = 0; i < task->wakeDelay.size(); i++)
+		maxDelay = TSMAX(maxDelay, task->wakeDelay[i]);
+
+	if (!timev.isEmpty()) {
+		if (!foundKeys) {
+			keyRange = QCPRange(timev.first(), timev.last());
+			foundKeys = true;
+		} else {
+			keyRange.lower = TSMIN(keyRange.lower, timev.first());
+			keyRange.upper = TSMAX(keyRange.upper, timev.last());
+		}
+	}
+
+	tasks.append(task);
+	colors.append(color);
+	maxWakeDelay.append(maxDelay);
+	return tasks.size() - 1;
+}
+
+void CPUTimeline::setWakeupFlags(int flags)
+{
+	wakeupFlags = flags;
+}
+
+void CPUTimeline::setSpanIndex(const SpanIndex *index)
+{
+	spans = index;
+}
+
+/* The row identifies the tiles of this timeline in the cache */
+void CPUTimeline::setTileCache(TileCache *cache, int row)
+{
+	tileCache = cache;
+	tileRow = row;
+}
+
+/* The spans belong to the analyzer, so they are not included */
+vtl::MemUsage CPUTimeline::memUsage() const
+{
+	return vtl::MemUsage((quint64) tasks.capacity() * sizeof(CPUTask*) +
+			     (quint64) colors.capacity() * sizeof(QColor) +
+			     (quint64) maxWakeDelay.capacity() * sizeof(double),
+			     (quint64) tasks.size() * sizeof(CPUTask*) +
+			     (quint64) colors.size() * sizeof(QColor) +
+			     (quint64) maxWakeDelay.size() * sizeof(double));
+}
+
+/*
+ * Returns the run span whose box, from the floor to the scheduling level of
+ * the row, contains pos or is within the selection tolerance of it. The
+ * distance is zero inside of the box.
+ */
+const SchedSpan *CPUTimeline::findSpan(const QPointF &pos, double *distance)
+	const
+{
+	QCPAxis *keyAxis = mKeyAxis.data();
+	QCPAxis *valueAxis = mValueAxis.data();
+	double tol = mParentPlot->selectionTolerance();
+	double yFloor, ySched, yTop, yBottom, key, keyTol, x0, x1, dx, dy;
+	const CPUTask *task;
+	int index;
+
+	if (spans == nullptr || spans->isEmpty() || tasks.isEmpty())
+		return nullptr;
+	if (keyAxis == nullptr || valueAxis == nullptr)
+		return nullptr;
+
+	/* All tasks of a CPU have the same transform */
+	task = tasks[0];
+	yFloor = valueAxis->coordToPixel(FLOOR_HEIGHT * task->scale +
+					 task->offset);
+	ySched = valueAxis->coordToPixel(SCHED_HEIGHT * task->scale +
+					 task->offset);
+	yTop = TSMIN(yFloor, ySched);
+	yBottom = TSMAX(yFloor, ySched);
+	if (pos.y() < yTop - tol || pos.y() > yBottom + tol)
+		return nullptr;
+
+	key = keyAxis->pixelToCoord(pos.x());
+	keyTol = qAbs(keyAxis->pixelToCoord(pos.x() + tol) - key);
+	index = spans->findNearest(key, keyTol);
+	if (index < 0)
+		return nullptr;
+
+	const SchedSpan &span = spans->at(index);
+	if (distance != nullptr) {
+		x0 = keyAxis->coordToPixel(span.start);
+		x1 = keyAxis->coordToPixel(span.end);
+		dx = TSMAX(TSMAX(x0 - pos.x(), pos.x() - x1), 0.0);
+		dy = TSMAX(TSMAX(yTop - pos.y(), pos.y() - yBottom), 0.0);
+		*distance = qSqrt(dx * dx + dy * dy);
+	}
+	return &span;
+}
+
+void CPUTimeline::selectTask(int index)
+{
+	if (index < 0 || index >= tasks.size()) {
+		setSelection(QCPDataSelection());
+		return;
+	}
+	setSelection(QCPDataSelection(QCPDataRange(index, index + 1)));
+}
+
+/*
+ * Maps the keys and values of the tasks to the pixels of the plot. All tasks
+ * of a CPU have the same transform.
+ */
+void CPUTimeline::setMapping(TimelinePainter *tp) const
+{
+	QCPAxis *keyAxis = mKeyAxis.data();
+	QCPAxis *valueAxis = mValueAxis.data();
+	QCPRange range = keyAxis->range();
+	const CPUTask *task = tasks[0];
+	double x0 = keyAxis->coordToPixel(range.lower);
+	double x1 = keyAxis->coordToPixel(range.upper);
+	double y0 = valueAxis->coordToPixel(task->offset);
+	double y1 = valueAxis->coordToPixel(task->offset + task->scale);
+
+	tp->setKeyMapping(range.lower, range.upper, x0,
+			  (x1 - x0) / range.size());
+	tp->setValueMapping(y0, y0 - y1);
+	tp->setAntialiasing(antialiased(), antialiasedScatters());
+}
+
+TileSource CPUTimeline::tileSource() const
+{
+	TileSource source;
+
+	source.tasks = tasks;
+	source.colors = colors;
+	source.maxWakeDelay = maxWakeDelay;
+	source.wakeupFlags = wakeupFlags;
+	source.antialiasedLines = antialiased();
+	source.antialiasedScatters = antialiasedScatters();
+	return source;
+}
+
+/*
+ * Draws the part of a coarser tile that covers the same keys as the missing
+ * tile, if there is one in the cache. This is what is shown while zooming in,
+ * until the sharp tile is ready.
+ */
+void CPUTimeline::drawCoarserTile(QCPPainter *painter, const TileKey &key,
+				  const QRectF &target)
+{
+	TileKey coarse = key;
+	const QImage *image;
+	double factor, width;
+	int l;
+
+	for (l = 1; l <= TILE_FALLBACK_LEVELS; l++) {
+		factor = ldexp(1.0, l);
+		coarse.level = key.level + l;
+		coarse.index = (qint64) floor(key.index / factor);
+		image = tileCache->find(coarse);
+		if (image == nullptr)
+			continue;
+		width = TILE_WIDTH / factor;
+		QRectF source((key.index - coarse.index * factor) * width, 0,
+			      width, image->height());
+		painter->drawImage(target, *image, source);
+		return;
+	}
+}
+
+/*
+ * Draws the visible tiles at the level whose pixels are closest to, but not
+ * wider than, the pixels of the plot. Returns false if the tiles cannot be
+ * used, in which case the tasks need to be drawn directly.
+ */
+bool CPUTimeline::drawTiles(QCPPainter *painter)
+{
+	QCPAxis *keyAxis = mKeyAxis.data();
+	QCPAxis *valueAxis = mValueAxis.data();
+	QCPRange range = keyAxis->range();
+	const CPUTask *task = tasks[0];
+	double yTop, yFloor, span, x0, x1;
+	const QImage *image;
+	qint64 first, last;
+	int width, height;
+	TileKey key;
+
+	yTop = valueAxis->coordToPixel(FULL_HEIGHT * task->scale +
+				       task->offset);
+	yFloor = valueAxis->coordToPixel(FLOOR_HEIGHT * task->scale +
+					 task->offset);
+	height = qRound(yFloor - yTop);
+	width = keyAxis->axisRect()->width();
+	if (height <= 0 || width <= 0 || !(range.size() > 0))
+		return false;
+
+	key.row = tileRow;
+	key.height = height;
+	key.level = TileCache::findLevel(range.size() / width);
+	span = TILE_WIDTH * key.keysPerPixel();
+	first = (qint64) floor(range.lower / span);
+	last = (qint64) floor(range.upper / span);
+
+	for (key.index = first; key.index <= last; key.index++) {
+		x0 = keyAxis->coordToPixel(key.index * span);
+		x1 = keyAxis->coordToPixel((key.index + 1) * span);
+		QRectF target(x0, yTop - TILE_MARGIN, x1 - x0,
+			      height + 2 * TILE_MARGIN);
+		image = tileCache->find(key);
+		if (image != nullptr) {
+			painter->drawImage(target, *image);
+			continue;
+		}
+		tileCache->request(key, tileSource());
+		drawCoarserTile(painter, key, target);
+	}
+	return true;
+}
+
+void CPUTimeline::draw(QCPPainter *painter)
+{
+	int s = tasks.size();
+	int sel = selectedIndex();
+	bool tiled = false;
+
+	if (!mKeyAxis || !mValueAxis || s == 0)
+		return;
+
+	TimelinePainter tp(painter);
+	setMapping(&tp);
+
+	if (tileCache != nullptr)
+		tiled = drawTiles(painter);
+	if (!tiled)
+		tp.drawTasks(tasks, colors, maxWakeDelay, wakeupFlags, sel);
+
+	if (sel >= 0 && sel < s) {
+		painter->setAntialiasing(antialiased());
+		tp.drawSched(tasks[sel], mSelectionDecorator != nullptr ?
+			     mSelectionDecorator->pen() : QPen(colors[sel]));
+	}
+}
+
+void CPUTimeline::drawLegendIcon(QCPPainter *painter, const QRectF &rect)
+	const
+{
+	double y = rect.center().y();
+
+	painter->setPen(QPen(Qt::black));
+	painter->drawLine(QLineF(rect.left(), y, rect.right(), y));
+}
+
+/*
+ * Returns the pixel distance from pos to the scheduling graph of a task, or
+ * a negative value if the task has no data at the key of pos.
+ */
+double CPUTimeline::taskDistance(int index, const QPointF &pos) const
+{
+	const CPUTask *task = tasks[index];
+	const ArenaVector<double> &timev = task->schedTimev;
+	const double *t = timev.constData();
+	QCPAxis *keyAxis = mKeyAxis.data();
+	QCPAxis *valueAxis = mValueAxis.data();
+	double tol = mParentPlot->selectionTolerance();
+	double keyMin = keyAxis->pixelToCoord(pos.x() - tol);
+	double keyMax = keyAxis->pixelToCoord(pos.x() + tol);
+	double key = keyAxis->pixelToCoord(pos.x());
+	double yFloor, ySched, yTop, yBottom, dist;
+	int n, i;
+
+	if (keyMin > keyMax)
+		qSwap(keyMin, keyMax);
+	n = TSMIN(timev.size(), (int) task->schedData.size());
+	if (n == 0 || t[0] > keyMax || t[n - 1] < keyMin)
+		return -1;
+
+	yFloor = valueAxis->coordToPixel(FLOOR_HEIGHT * task->scale +
+					 task->offset);
+	ySched = valueAxis->coordToPixel(SCHED_HEIGHT * task->scale +
+					 task->offset);
+
+	/* The horizontal part of the step line at key */
+	i = std::upper_bound(t, t + n, key) - t - 1;
+	if (i >= 0)
+		dist = qAbs((task->schedData.readbool(i) ? ySched : yFloor) -
+			    pos.y());
+	else
+		dist = std::numeric_limits<double>::max();
+
+	/* A vertical part of the step line close to key */
+	i = std::lower_bound(t, t + n, keyMin) - t;
+	if (i < n && t[i] <= keyMax) {
+		yTop = TSMIN(yFloor, ySched);
+		yBottom = TSMAX(yFloor, ySched);
+		if (pos.y() >= yTop && pos.y() <= yBottom)
+			dist = TSMIN(dist, qAbs(keyAxis->coordToPixel(t[i]) -
+						pos.x()));
+	}
+	return dist;
+}
+
+double CPUTimeline::selectTest(const QPointF &pos, bool onlySelectable,
+			       QVariant *details) const
+{
+	double minDist = std::numeric_limits<double>::max();
+	double dist;
+	int best = -1;
+	int i;
+
+	if ((onlySelectable && mSelectable == QCP::stNone) || tasks.isEmpty())
+		return -1;
+	if (!mKeyAxis || !mValueAxis)
+		return -1;
+	if (!mKeyAxis.data()->axisRect()->rect().contains(pos.toPoint()))
+		return -1;
+
+	if (spans != nullptr) {
+		const SchedSpan *span = findSpan(pos, &minDist);
+		if (span == nullptr)
+			return -1;
+		best = span->task;
+		goto out;
+	}
+
+	/*
+	 * The tasks that are not running share the floor line, so a click on
+	 * the floor selects the first of them
+	 */
+	for (i = 0; i < tasks.size(); i++) {
+		dist = taskDistance(i, pos);
+		if (dist >= 0 && dist < minDist) {
+			minDist = dist;
+			best = i;
+		}
+	}
+
+	if (best < 0)
+		return -1;
+out:
+	if (details)
+		details->setValue(QCPDataSelection(QCPDataRange(best,
+								best + 1)));
+	return minDist;
+}
+
+QCPRange CPUTimeline::getKeyRange(bool &foundRange,
+				  QCP::SignDomain inSignDomain) const
+{
+	foundRange = foundKeys;
+	if (!foundKeys)
+		return QCPRange();
+	if (inSignDomain == QCP::sdPositive && keyRange.upper <= 0)
+		foundRange = false;
+	else if (inSignDomain == QCP::sdNegative && keyRange.lower >= 0)
+		foundRange = false;
+	return keyRange;
+}
+
+QCPRange CPUTimeline::getValueRange(bool &foundRange,
+				    QCP::SignDomain /* inSignDomain */,
+				    const QCPRange & /* inKeyRange */) const
+{
+	QCPRange range;
+	double a, b;
+	int i;
+
+	foundRange = false;
+	for (i = 0; i < tasks.size(); i++) {
+		const CPUTask *task = tasks[i];
+		a = FLOOR_HEIGHT * task->scale + task->offset;
+		b = (WAKEUP_HEIGHT + WAKEUP_SIZE) * task->scale + task->offset;
+		if (a > b)
+			qSwap(a, b);
+		if (!foundRange) {
+			range = QCPRange(a, b);
+			foundRange = true;
+		} else {
+			range.lower = TSMIN(range.lower, a);
+			range.upper = TSMAX(range.upper, b);
+		}
+	}
+	return range;
+}
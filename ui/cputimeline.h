@@ -0,0 +1,152 @@
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2018  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CPUTIMELINE_H
+#define CPUTIMELINE_H
+
+#include <QColor>
+#include <QPointF>
+#include <QVector>
+#include "qcustomplot/qcustomplot.h"
+#include "ui/tilecache.h"
+#include "ui/timelinepainter.h"
+#include "misc/traceshark.h"
+#include "vtl/memusage.h"
+
+class CPUTask;
+class SchedSpan;
+class SpanIndex;
+
+/*
+ * A plottable that draws all tasks of one CPU: the scheduling graphs, the
+ * wakeup markers and the preempted and runnable dots. Since there is only
+ * one of these per CPU, a replot or a hit test does not need to visit a
+ * plottable for every task and the tasks that are not in the visible key
+ * range are skipped with a binary search.
+ *
+ * The data index of a selection is the index of a task, as returned by
+ * addTask(). If the timeline has the SpanIndex of the CPU, then a hit test is
+ * a binary search for the run span under the mouse, instead of a search
+ * through the graphs of all tasks.
+ *
+ * If the timeline has a TileCache, then it draws the tasks from tiles that
+ * are rendered by the pool threads, except for the selected task, which is
+ * drawn on top of them. The key axis is assumed to be horizontal.
+ */
+class CPUTimeline : public QCPAbstractPlottable
+{
+	Q_OBJECT
+public:
+	CPUTimeline(QCPAxis *keyAxis, QCPAxis *valueAxis);
+	int addTask(CPUTask *task, const QColor &color);
+	void setWakeupFlags(int flags);
+	void setSpanIndex(const SpanIndex *index);
+	void setTileCache(TileCache *cache, int row);
+	const SchedSpan *findSpan(const QPointF &pos,
+				  double *distance = nullptr) const;
+	__always_inline int nrTasks() const;
+	__always_inline CPUTask *taskAt(int index) const;
+	__always_inline int selectedIndex() const;
+	void selectTask(int index);
+	vtl::MemUsage memUsage() const;
+	virtual double selectTest(const QPointF &pos, bool onlySelectable,
+				  QVariant *details = 0) const
+		Q_DECL_OVERRIDE;
+	virtual QCPRange getKeyRange(bool &foundRange,
+				     QCP::SignDomain inSignDomain =
+				     QCP::sdBoth) const Q_DECL_OVERRIDE;
+	virtual QCPRange getValueRange(bool &foundRange,
+				       QCP::SignDomain inSignDomain =
+				       QCP::sdBoth,
+				       const QCPRange &inKeyRange = QCPRange())
+		const Q_DECL_OVERRIDE;
+protected:
+	virtual void draw(QCPPainter *painter) Q_DECL_OVERRIDE;
+	virtual void drawLegendIcon(QCPPainter *painter, const QRectF &rect)
+		const Q_DECL_OVERRIDE;
+private:
+	void setMapping(TimelinePainter *tp) const;
+	bool drawTiles(QCPPainter *painter);
+	void drawCoarserTile(QCPPainter *painter, const TileKey &key,
+			     const QRectF &target);
+	TileSource tileSource() const;
+	double taskDistance(int index, const QPointF &pos) const;
+	QVector<CPUTask*> tasks;
+	QVector<QColor> colors;
+	QVector<double> maxWakeDelay;
+	const SpanIndex *spans;
+	TileCache *tileCache;
+	int tileRow;
+	int wakeupFlags;
+	bool foundKeys;
+	QCPRange keyRange;
+};
+
+__always_inline int CPUTimeline::nrTasks() const
+{
+	return tasks.size();
+}
+
+__always_inline CPUTask *CPUTimeline::taskAt(int index) const
+{
+	if (index < 0 || index >= tasks.size())
+		return nullptr;
+	return tasks[index];
+}
+
+__always_inline int CPUTimeline::selectedIndex() const
+{
+	if (mSelection.isEmpty())
+		return -1;
+	return mSelection.dataRange().begin();
+}
+
+#endif /* CPUTIMELINE_H */
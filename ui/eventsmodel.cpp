@@ -49,55 +49,210 @@
  *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <QMetaObject>
 #include <QVariant>
 #include <QString>
 #include "ui/eventsmodel.h"
 #include "parser/traceevent.h"
 #include "misc/traceshark.h"
+#include "vtl/rankbitmap.h"
 #include "vtl/tlist.h"
 
 
 EventsModel::EventsModel(QObject *parent):
-	QAbstractTableModel(parent), events(nullptr), eventsPtrs(nullptr)
+	QAbstractTableModel(parent), events(nullptr), filter(nullptr),
+	rowCache(EVENTS_CACHE_ROWS),
+	prefetchItem(this, &EventsModel::prefetchWork), prefetchBusy(false),
+	nextFirst(-1), nextLast(-1), pageStart(0)
 {}
 
 EventsModel::EventsModel(vtl::TList<TraceEvent> *e, QObject *parent):
-	QAbstractTableModel(parent), events(e), eventsPtrs(nullptr)
+	QAbstractTableModel(parent), events(e), filter(nullptr),
+	rowCache(EVENTS_CACHE_ROWS),
+	prefetchItem(this, &EventsModel::prefetchWork), prefetchBusy(false),
+	nextFirst(-1), nextLast(-1), pageStart(0)
 {}
 
+EventsModel::~EventsModel()
+{
+	flushCache();
+}
+
 void EventsModel::setEvents(vtl::TList<TraceEvent> *e)
 {
+	flushCache();
 	events = e;
-	eventsPtrs = nullptr;
+	filter = nullptr;
+	pageStart = 0;
 }
 
-void EventsModel::setEvents(vtl::TList<const TraceEvent*> *e)
+/* The rows will be the events whose bits are set in the filter */
+void EventsModel::setEvents(vtl::TList<TraceEvent> *e,
+			    const vtl::RankBitmap *f)
 {
-	events = nullptr;
-	eventsPtrs = e;
+	flushCache();
+	events = e;
+	filter = f;
+	pageStart = 0;
 }
 
 void EventsModel::clear()
 {
+	flushCache();
 	events = nullptr;
-	eventsPtrs = nullptr;
+	filter = nullptr;
+	pageStart = 0;
+}
+
+/*
+ * The rows are cached by their position, so the cache must be flushed whenever
+ * the list of events changes. Any prefetch must also be finished before that,
+ * since the pool thread reads the events.
+ */
+void EventsModel::flushCache()
+{
+	int i;
+
+	prefetchGroup.wait();
+	for (i = 0; i < prefetchedRows.size(); i++)
+		delete prefetchedRows[i];
+	prefetchedRows.resize(0);
+	prefetchRows.resize(0);
+	prefetchBusy = false;
+	nextFirst = -1;
+	nextLast = -1;
+	rowCache.clear();
+}
+
+void EventsModel::formatRow(const TraceEvent &event, EventRow *row)
+{
+	QString &str = row->column[5];
+	int i;
+
+	row->column[0] = event.time.toQString();
+	row->column[1] = QString(event.taskName->ptr);
+	row->column[2] = QString::number(event.pid);
+	row->column[3] = QString("[") + QString::number(event.cpu) +
+		QString("]");
+	row->column[4] = QString(event.getEventName()->ptr);
+
+	/*
+	 * If there was an integer before the event name, then we will display
+	 * that as if it had been the first argument of the event
+	 */
+	str.clear();
+	if (event.intArg != 0) {
+		str += QString::number(event.intArg);
+		if (event.argc > 0)
+			str += QString(tr(" "));
+	}
+	for (i = 0; i < event.argc; i++) {
+		str += QString(event.argv[i]->ptr);
+		if (i < event.argc - 1)
+			str += QString(tr(" "));
+	}
+}
+
+/*
+ * Returns the row of the event at pos. The returned row is valid until the
+ * next call that formats a row.
+ */
+const EventRow *EventsModel::getRow(vtl::index_t pos) const
+{
+	EventRow *r = rowCache.object(pos);
+
+	if (r != nullptr)
+		return r;
+	if (pos < 0 || pos >= getSize())
+		return nullptr;
+	r = new EventRow;
+	formatRow(*getEventAt(pos), r);
+	rowCache.insert(pos, r);
+	return r;
+}
+
+/*
+ * Formats the rows of the positions from first to last that are not in the
+ * cache, in a pool thread. If a prefetch is already running, then the range is
+ * remembered and prefetched when the running one has been collected; ranges in
+ * between are skipped, since the view has already scrolled past them.
+ */
+void EventsModel::prefetch(vtl::index_t first, vtl::index_t last)
+{
+	vtl::index_t pos;
+
+	if (prefetchBusy) {
+		nextFirst = first;
+		nextLast = last;
+		return;
+	}
+
+	first = TSMAX(first, (vtl::index_t) 0);
+	last = TSMIN(last, getSize() - 1);
+	prefetchRows.resize(0);
+	for (pos = first; pos <= last; pos++) {
+		if (!rowCache.contains(pos))
+			prefetchRows.append(pos);
+	}
+	if (prefetchRows.isEmpty())
+		return;
+
+	prefetchedRows.resize(0);
+	prefetchBusy = true;
+	prefetchGroup.run(&prefetchItem);
+}
+
+bool EventsModel::prefetchWork()
+{
+	EventRow *r;
+	int i;
+
+	for (i = 0; i < prefetchRows.size(); i++) {
+		r = new EventRow;
+		formatRow(*getEventAt(prefetchRows[i]), r);
+		prefetchedRows.append(r);
+	}
+	QMetaObject::invokeMethod(this, "collectPrefetched",
+				  Qt::QueuedConnection);
+	return false; /* No error */
+}
+
+void EventsModel::collectPrefetched()
+{
+	vtl::index_t first, last;
+	int i;
+
+	/* The cache may have been flushed after the prefetch was queued */
+	if (!prefetchBusy)
+		return;
+
+	prefetchGroup.wait();
+	for (i = 0; i < prefetchedRows.size(); i++)
+		rowCache.insert(prefetchRows[i], prefetchedRows[i]);
+	prefetchedRows.resize(0);
+	prefetchBusy = false;
+
+	if (nextFirst >= 0) {
+		first = nextFirst;
+		last = nextLast;
+		nextFirst = -1;
+		nextLast = -1;
+		prefetch(first, last);
+	}
 }
 
 int EventsModel::rowCount(const QModelIndex & /*parent*/) const
 {
-	return getSize();
+	return getPageSize();
 }
 
 int EventsModel::columnCount(const QModelIndex & /* parent */) const
 {
-	return 6; /* Number from data() and headerData() */
+	return EVENTS_NR_COLUMNS; /* Number from formatRow() and headerData() */
 }
 
 QVariant EventsModel::data(const QModelIndex &index, int role) const
 {
-	QString str;
-	int i;
-
 	if (!index.isValid())
 		return QVariant();
 	
@@ -108,45 +263,15 @@ QVariant EventsModel::data(const QModelIndex &index, int role) const
 		int column = index.column();
 		int size;
 
-		if (events == nullptr && eventsPtrs == nullptr)
+		if (events == nullptr)
 			return QVariant();
-		size = getSize();
+		size = getPageSize();
 		if ( row >= size || row < 0)
 			return QVariant();
 
-		const TraceEvent &event = *getEventAt(row);
-		switch(column) {
-		case 0:
-			return event.time.toQString();
-		case 1:
-			return QString(event.taskName->ptr);
-		case 2:
-			return QString::number(event.pid);
-		case 3:
-			return QString("[") + QString::number(event.cpu) +
-				QString("]");
-		case 4:
-			return QString(event.getEventName()->ptr);
-		case 5:
-			/*
-			 * If there was an integer before the event name, then
-			 * we will display that as if it had been the first 
-			 * argument of the event
-			 */
-			if (event.intArg != 0) {
-				str += QString::number(event.intArg);
-				if (event.argc > 0)
-					str += QString(tr(" "));
-			}
-			for (i = 0; i < event.argc; i++) {
-				str += QString(event.argv[i]->ptr);
-				if (i < event.argc - 1)
-					str += QString(tr(" "));
-			}
-			return str;
-		default:
-			break;
-		}
+		if (column < 0 || column >= EVENTS_NR_COLUMNS)
+			return QVariant();
+		return getRow(pageStart + row)->column[column];
 	}
 	return QVariant();
 }
@@ -191,6 +316,7 @@ Qt::ItemFlags EventsModel::flags(const QModelIndex &index) const
 void EventsModel::beginResetModel()
 {
 	QAbstractTableModel::beginResetModel();
+	flushCache();
 }
 
 void EventsModel::endResetModel()
@@ -198,20 +324,32 @@ void EventsModel::endResetModel()
 	QAbstractTableModel::endResetModel();
 }
 
-const TraceEvent* EventsModel::getEventAt(int index) const
+/*
+ * Makes the rows of the model the positions from start on. The cache is kept,
+ * since it is indexed by the positions.
+ */
+void EventsModel::setPage(vtl::index_t start)
+{
+	QAbstractTableModel::beginResetModel();
+	pageStart = start;
+	QAbstractTableModel::endResetModel();
+}
+
+const TraceEvent* EventsModel::getEventAt(vtl::index_t pos) const
 {
-	if (events != nullptr)
-		return &events->at(index);
-	if (eventsPtrs != nullptr)
-		return eventsPtrs->at(index);
-	return nullptr;
+	if (events == nullptr)
+		return nullptr;
+	if (filter != nullptr)
+		return &events->at(filter->select(pos));
+	return &events->at(pos);
 }
 
-int EventsModel::getSize() const
+/* The number of positions, of which the model shows one page */
+vtl::index_t EventsModel::getSize() const
 {
-	if (events != nullptr)
-		return events->size();
-	if (eventsPtrs != nullptr)
-		return eventsPtrs->size();
-	return 0;
+	if (events == nullptr)
+		return 0;
+	if (filter != nullptr)
+		return filter->count();
+	return events->size();
 }
@@ -53,20 +53,59 @@
 #define EVENTSMODEL_H
 
 #include <QAbstractTableModel>
+#include <QCache>
+#include <QString>
+#include <QVector>
+#include "misc/traceshark.h"
+#include "threads/threadpool.h"
+#include "threads/workitem.h"
+#include "vtl/compiler.h"
+#include "vtl/index.h"
 
 class TraceEvent;
 namespace vtl {
 	template<class T> class TList;
+	class RankBitmap;
 }
 
+#define EVENTS_NR_COLUMNS (6)
+/* The number of formatted rows that are kept in the cache */
+#define EVENTS_CACHE_ROWS (16384)
+/*
+ * The maximum number of rows of the model. The views of Qt have int rows and
+ * keep some data for each row of the vertical header, so a list with more
+ * events is shown one page at a time, see EventsModel::setPage().
+ */
+#define EVENTS_PAGE_ROWS (1 << 24)
+
+/* The strings of the columns of one row, as they are displayed */
+class EventRow {
+public:
+	QString column[EVENTS_NR_COLUMNS];
+};
+
+/*
+ * The model formats each row only once, into an EventRow, and keeps the most
+ * recently used rows in a cache. The rows around the viewport can be
+ * formatted in advance by a pool thread with prefetch(), so that scrolling
+ * mostly finds the rows in the cache.
+ *
+ * The events are listed by their position, which is the index of the event or,
+ * with a filter, the rank of the event among the ones that pass it. The rows
+ * of the model are the positions of the page that begins at getPageStart().
+ * getRow() and prefetch() take positions, so that they can be used for any
+ * part of the list.
+ */
 class EventsModel : public QAbstractTableModel
 {
 	Q_OBJECT
 public:
 	EventsModel(QObject *parent = 0);
 	EventsModel(vtl::TList<TraceEvent> *e, QObject *parent = 0);
+	~EventsModel();
 	void setEvents(vtl::TList<TraceEvent> *e);
-	void setEvents(vtl::TList<const TraceEvent*> *e);
+	void setEvents(vtl::TList<TraceEvent> *e,
+		       const vtl::RankBitmap *filter);
 	void clear();
 	int rowCount(const QModelIndex &parent) const;
 	int columnCount(const QModelIndex &parent) const;
@@ -78,11 +117,43 @@ public:
 	void beginResetModel();
 	void endResetModel();
 	Qt::ItemFlags flags(const QModelIndex &index) const;
+	const EventRow *getRow(vtl::index_t pos) const;
+	void prefetch(vtl::index_t first, vtl::index_t last);
+	void setPage(vtl::index_t start);
+	__always_inline vtl::index_t getPageStart() const;
+	__always_inline int getPageSize() const;
+	vtl::index_t getSize() const;
+private slots:
+	void collectPrefetched();
 private:
 	vtl::TList<TraceEvent> *events;
-	vtl::TList<const TraceEvent*> *eventsPtrs;
-	const TraceEvent* getEventAt(int index) const;
-	int getSize() const;
+	const vtl::RankBitmap *filter;
+	const TraceEvent* getEventAt(vtl::index_t pos) const;
+	static void formatRow(const TraceEvent &event, EventRow *row);
+	void flushCache();
+	bool prefetchWork();
+	mutable QCache<qint64, EventRow> rowCache;
+	/* Owned by the pool thread while the prefetch item is queued */
+	QVector<vtl::index_t> prefetchRows;
+	QVector<EventRow*> prefetchedRows;
+	WorkGroup prefetchGroup;
+	WorkItem<EventsModel> prefetchItem;
+	bool prefetchBusy;
+	vtl::index_t nextFirst;
+	vtl::index_t nextLast;
+	vtl::index_t pageStart;
 };
 
+__always_inline vtl::index_t EventsModel::getPageStart() const
+{
+	return pageStart;
+}
+
+/* The number of rows of the model */
+__always_inline int EventsModel::getPageSize() const
+{
+	return (int) TSMIN(getSize() - pageStart,
+			   (vtl::index_t) EVENTS_PAGE_ROWS);
+}
+
 #endif /* EVENTSMODEL_H */
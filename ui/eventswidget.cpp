@@ -49,8 +49,20 @@
  *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <QComboBox>
+#include <QFontMetrics>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QLineEdit>
+#include <QScrollBar>
+#include <QStyle>
 #include <QTableView>
+#include <QToolButton>
+#include <QVBoxLayout>
 #include <cmath>
+#include "analyzer/argindex.h"
+#include "vtl/rankbitmap.h"
 #include "vtl/tlist.h"
 #include "ui/eventsmodel.h"
 #include "ui/eventswidget.h"
@@ -60,12 +72,13 @@
 
 EventsWidget::EventsWidget(QWidget *parent):
 	QDockWidget(tr("Events"), parent), events(nullptr),
-	eventsPtrs(nullptr), saveScrollTime(false)
+	filter(nullptr), matches(nullptr), searchMatch(-1),
+	saveScrollTime(false)
 {
 	tableView = new TableView(this);
 	eventsModel = new EventsModel(tableView);
 	tableView->setModel(eventsModel);
-	setWidget(tableView);
+	setupLayout();
 	tableView->horizontalHeader()->setStretchLastSection(true);
 	resizeColumnsToContents();
 	tableView->show();
@@ -77,16 +90,19 @@ EventsWidget::EventsWidget(QWidget *parent):
 					      const QItemSelection &),
 		  this, handleSelectionChanged(const QItemSelection &,
 					       const QItemSelection &));
+	tsconnect(tableView->verticalScrollBar(), valueChanged(int),
+		  this, prefetchAroundViewport());
 }
 
 EventsWidget::EventsWidget(vtl::TList<TraceEvent> *e, QWidget *parent):
-	QDockWidget(parent)
+	QDockWidget(parent), filter(nullptr), matches(nullptr),
+	searchMatch(-1)
 {
 	tableView = new TableView(this);
 	eventsModel = new EventsModel(e, tableView);
 	events = e;
 	tableView->setModel(eventsModel);
-	setWidget(tableView);
+	setupLayout();
 	tableView->horizontalHeader()->setStretchLastSection(true);
 	resizeColumnsToContents();
 	tableView->show();
@@ -98,31 +114,78 @@ EventsWidget::EventsWidget(vtl::TList<TraceEvent> *e, QWidget *parent):
 					      const QItemSelection &),
 		  this, handleSelectionChanged(const QItemSelection &,
 					       const QItemSelection &));
+	tsconnect(tableView->verticalScrollBar(), valueChanged(int),
+		  this, prefetchAroundViewport());
 }
 
 EventsWidget::~EventsWidget()
 {
 }
 
+/* The search bar is placed above the table */
+void EventsWidget::setupLayout()
+{
+	QWidget *container = new QWidget(this);
+	QVBoxLayout *mainLayout = new QVBoxLayout(container);
+	QHBoxLayout *searchLayout = new QHBoxLayout();
+
+	searchLine = new QLineEdit(container);
+	searchLine->setPlaceholderText(tr("Search the names and arguments"));
+	searchMode = new QComboBox(container);
+	/* The order must match ArgIndex::match_t */
+	searchMode->addItem(tr("Exact"));
+	searchMode->addItem(tr("Prefix"));
+	searchMode->addItem(tr("Substring"));
+	searchMode->setCurrentIndex(ArgIndex::MATCH_SUBSTRING);
+	prevButton = new QToolButton(container);
+	prevButton->setArrowType(Qt::UpArrow);
+	prevButton->setToolTip(tr("Find the previous matching event"));
+	nextButton = new QToolButton(container);
+	nextButton->setArrowType(Qt::DownArrow);
+	nextButton->setToolTip(tr("Find the next matching event"));
+	searchLabel = new QLabel(container);
+
+	searchLayout->addWidget(searchLine);
+	searchLayout->addWidget(searchMode);
+	searchLayout->addWidget(prevButton);
+	searchLayout->addWidget(nextButton);
+	searchLayout->addWidget(searchLabel);
+	mainLayout->setContentsMargins(0, 0, 0, 0);
+	mainLayout->addLayout(searchLayout);
+	mainLayout->addWidget(tableView);
+	setWidget(container);
+
+	sigconnect(searchLine, textEdited(const QString &), this,
+		   searchEdited());
+	tsconnect(searchLine, returnPressed(), this, searchTriggered());
+	tsconnect(prevButton, clicked(), this, findPrevMatch());
+	tsconnect(nextButton, clicked(), this, findNextMatch());
+}
+
 void EventsWidget::setEvents(vtl::TList<TraceEvent> *e)
 {
 	eventsModel->setEvents(e);
 	events = e;
-	eventsPtrs = nullptr;
+	filter = nullptr;
 }
 
-void EventsWidget::setEvents(vtl::TList<const TraceEvent*> *e)
+void EventsWidget::setEvents(vtl::TList<TraceEvent> *e,
+			     const vtl::RankBitmap *f)
 {
-	eventsModel->setEvents(e);
-	events = nullptr;
-	eventsPtrs = e;
+	eventsModel->setEvents(e, f);
+	events = e;
+	filter = f;
 }
 
 void EventsWidget::clear()
 {
 	eventsModel->clear();
 	events = nullptr;
-	eventsPtrs = nullptr;
+	filter = nullptr;
+	matches = nullptr;
+	searchText.clear();
+	searchMatch = -1;
+	searchLabel->clear();
 }
 
 void EventsWidget::clearScrollTime()
@@ -134,39 +197,66 @@ void EventsWidget::beginResetModel()
 {
 	eventsModel->beginResetModel();
 	events = nullptr;
-	eventsPtrs = nullptr;
+	filter = nullptr;
 }
 
 void EventsWidget::endResetModel()
 {
 	eventsModel->endResetModel();
 	resizeColumnsToContents();
+	prefetchAroundViewport();
 }
 
 void EventsWidget::scrollTo(const vtl::Time &time)
 {
-	if (events != nullptr || eventsPtrs != nullptr) {
-		int n = findBestMatch(time);
-		tableView->selectRow(n);
+	if (events != nullptr) {
+		vtl::index_t n = findBestMatch(time);
+		showPosition(n);
+		tableView->selectRow(n - eventsModel->getPageStart());
 		resizeColumnsToContents();
 		scrollTime = time;
 		saveScrollTime = true;
 	}
 }
 
-void EventsWidget::scrollTo(int n)
+/* Selects the event at position n, see EventsModel */
+void EventsWidget::scrollTo(vtl::index_t n)
 {
-	if (n < 0 || (events == nullptr && eventsPtrs == nullptr))
+	if (n < 0 || events == nullptr)
 		return;
-	unsigned int index = (unsigned int) n;
-	if (index < getSize()) {
-		tableView->selectRow(index);
+	if (n < getSize()) {
+		showPosition(n);
+		tableView->selectRow(n - eventsModel->getPageStart());
 		resizeColumnsToContents();
-		scrollTime = getEventAt(index)->time;
+		scrollTime = getEventAt(n)->time;
 		saveScrollTime = true;
 	}
 }
 
+/* Moves the page of the model, if needed, so that it has a row for pos */
+void EventsWidget::showPosition(vtl::index_t pos)
+{
+	vtl::index_t start = eventsModel->getPageStart();
+
+	if (pos >= start && pos < start + eventsModel->getPageSize())
+		return;
+	start = TSMIN(pos - EVENTS_PAGE_ROWS / 2, getSize() - EVENTS_PAGE_ROWS);
+	movePage(TSMAX(start, (vtl::index_t) 0));
+}
+
+/*
+ * Resetting the model clears the selection, so the selected event is selected
+ * again if it is on the new page
+ */
+void EventsWidget::movePage(vtl::index_t start)
+{
+	vtl::index_t selected = selectedPosition();
+
+	eventsModel->setPage(start);
+	if (selected >= start && selected < start + eventsModel->getPageSize())
+		tableView->selectRow(selected - start);
+}
+
 void EventsWidget::scrollToSaved()
 {
 	if (saveScrollTime)
@@ -177,15 +267,15 @@ void EventsWidget::scrollToSaved()
 /* This function checks the value at, before and after the value found 
  * with binary search in order to determine the one with smallest difference
  */
-int EventsWidget::findBestMatch(const vtl::Time &time)
+vtl::index_t EventsWidget::findBestMatch(const vtl::Time &time)
 {
 	int n = 0;
-	int c, next, prev;
-	int end;
-	int cand[3];
+	vtl::index_t c, next, prev;
+	vtl::index_t end;
+	vtl::index_t cand[3];
 	vtl::Time diffs[3];
 	vtl::Time best;
-	int bestN;
+	vtl::index_t bestN;
 	int i;
 
 	end = getSize() - 1;
@@ -233,9 +323,10 @@ int EventsWidget::findBestMatch(const vtl::Time &time)
 	return bestN;
 }
 
-int EventsWidget::binarySearch(const vtl::Time &time, int start, int end)
+vtl::index_t EventsWidget::binarySearch(const vtl::Time &time,
+					vtl::index_t start, vtl::index_t end)
 {
-	int pivot = (end + start) / 2;
+	vtl::index_t pivot = (end + start) / 2;
 	if (pivot == start)
 		return pivot;
 	if (time < getEventAt(pivot)->time)
@@ -247,7 +338,8 @@ int EventsWidget::binarySearch(const vtl::Time &time, int start, int end)
 void EventsWidget::handleClick(const QModelIndex &index)
 {
 	if (index.column() == 0) {
-		vtl::Time time = getEventAt(index.row())->time;
+		vtl::Time time = getEventAt(eventsModel->getPageStart() +
+					    index.row())->time;
 		emit timeSelected(time);
 	}
 }
@@ -255,7 +347,8 @@ void EventsWidget::handleClick(const QModelIndex &index)
 void EventsWidget::handleDoubleClick(const QModelIndex &index)
 {
 	if (index.column() == 5) {
-		const TraceEvent &event = *getEventAt(index.row());
+		const TraceEvent &event = *getEventAt(
+			eventsModel->getPageStart() + index.row());
 		emit infoDoubleClicked(event);
 	}
 }
@@ -275,15 +368,15 @@ void EventsWidget::handleSelectionChanged(const QItemSelection &/*selected*/,
 	}
 }
 
-const TraceEvent *EventsWidget::getSelectedEvent()
+/* Returns the selected row, or -1 if not exactly one row is selected */
+int EventsWidget::selectedRow()
 {
 	int s, i, row;
 	const QModelIndexList list = tableView->modelIndexList();
-	const TraceEvent *event = nullptr;
 
 	s = list.size();
 	if (s < 1)
-		goto out;
+		return -1;
 
 	row = list[0].row();
 
@@ -291,49 +384,231 @@ const TraceEvent *EventsWidget::getSelectedEvent()
 		const QModelIndex &idx = list[i];
 		/* If more than one row is selected, don't bother */
 		if (idx.row() != row)
-			goto out;
+			return -1;
 	}
+	return row;
+}
 
-	if (events != nullptr) {
-		event = &events->at(row);
-	} else if (eventsPtrs != nullptr) {
-		event = eventsPtrs->at(row);
+/* Returns the position of the selected row, or -1 as selectedRow() */
+vtl::index_t EventsWidget::selectedPosition()
+{
+	int row = selectedRow();
+
+	if (row < 0)
+		return -1;
+	return eventsModel->getPageStart() + row;
+}
+
+const TraceEvent *EventsWidget::getSelectedEvent()
+{
+	vtl::index_t pos = selectedPosition();
+
+	if (pos < 0)
+		return nullptr;
+	return getEventAt(pos);
+}
+
+/*
+ * The result is indexed like the events, not like the rows, so that it stays
+ * valid when the filters change.
+ */
+void EventsWidget::setSearchResult(const vtl::RankBitmap *result)
+{
+	vtl::index_t n = result->count();
+
+	matches = result;
+	if (n == 1)
+		searchLabel->setText(tr("1 match"));
+	else
+		searchLabel->setText(tr("%1 matches").arg(n));
+	findMatch(true);
+}
+
+void EventsWidget::searchTriggered()
+{
+	QString text = searchLine->text();
+	int match = searchMode->currentIndex();
+
+	/* Pressing enter again moves to the next match */
+	if (matches != nullptr && text == searchText && match == searchMatch) {
+		findMatch(true);
+		return;
 	}
+	searchText = text;
+	searchMatch = match;
+	emit searchRequested(text, match);
+}
+
+void EventsWidget::findNextMatch()
+{
+	if (matches == nullptr)
+		searchTriggered();
+	else
+		findMatch(true);
+}
+
+void EventsWidget::findPrevMatch()
+{
+	if (matches == nullptr)
+		searchTriggered();
+	else
+		findMatch(false);
+}
+
+/*
+ * Moves the selection to the next or previous matching event that passes the
+ * filter, starting from the selected event. Without a selection, the search
+ * starts from the beginning or the end.
+ */
+void EventsWidget::findMatch(bool forward)
+{
+	vtl::index_t size = getSize();
+	vtl::index_t pos, idx;
+
+	if (matches == nullptr || events == nullptr || size == 0 ||
+	    matches->count() == 0)
+		return;
 
-out:
-	return event;
+	pos = selectedPosition();
+	if (pos < 0)
+		idx = forward ? -1 : matches->size();
+	else
+		idx = filter != nullptr ? filter->select(pos) : pos;
+
+	do {
+		if (forward)
+			idx = idx + 1 < matches->size() ?
+				matches->findNext(idx + 1) : -1;
+		else
+			idx = idx > 0 ? matches->findPrev(idx - 1) : -1;
+	} while (idx >= 0 && filter != nullptr && !filter->test(idx));
+
+	if (idx < 0)
+		return;
+	pos = filter != nullptr ? filter->rank(idx) : idx;
+	scrollTo(pos);
 }
 
-/* Apparently it's a bad idea to do tableView->resizeColumnsToContents() if we
- * are not visible */
+/* Apparently it's a bad idea to resize the columns if we are not visible */
 void EventsWidget::resizeColumnsToContents()
 {
 	if (QDockWidget::isVisible())
-		tableView->resizeColumnsToContents();
+		estimateColumnWidths();
 }
 
 void EventsWidget::show()
 {
 	QDockWidget::show();
-	tableView->resizeColumnsToContents();
+	estimateColumnWidths();
 }
 
-const TraceEvent* EventsWidget::getEventAt(int index) const
+void EventsWidget::visibleRows(int &first, int &last) const
 {
-	if (events != nullptr)
-		return &events->at(index);
-	if (eventsPtrs != nullptr)
-		return eventsPtrs->at(index);
-	return nullptr;
+	int height = tableView->viewport()->height();
+	int rowHeight;
+
+	first = tableView->rowAt(0);
+	last = tableView->rowAt(height - 1);
+	if (first < 0)
+		first = 0;
+	if (last < 0) {
+		rowHeight = TSMAX(tableView->verticalHeader()->
+				  defaultSectionSize(), 1);
+		last = first + height / rowHeight;
+	}
 }
 
-unsigned int EventsWidget::getSize() const
+/*
+ * QTableView::resizeColumnsToContents() formats a large number of rows just
+ * to measure them. Here, only the visible rows and a sample of rows spread
+ * over the whole list are measured. The last column is stretched, so it is
+ * not measured.
+ */
+void EventsWidget::estimateColumnWidths()
 {
-	if (events != nullptr)
-		return events->size();
-	if (eventsPtrs != nullptr)
-		return eventsPtrs->size();
-	return 0;
+	QHeaderView *header = tableView->horizontalHeader();
+	QFontMetrics fm(tableView->font());
+	int widths[EVENTS_NR_COLUMNS - 1];
+	vtl::index_t size = getSize();
+	vtl::index_t start = eventsModel->getPageStart();
+	vtl::index_t step, pos;
+	int margin, first, last, row, c;
+
+	margin = 2 * (tableView->style()->pixelMetric(
+			      QStyle::PM_FocusFrameHMargin, nullptr,
+			      tableView) + 1);
+	for (c = 0; c < EVENTS_NR_COLUMNS - 1; c++)
+		widths[c] = header->sectionSizeHint(c);
+
+	auto measure = [&](vtl::index_t n) {
+		const EventRow *r = eventsModel->getRow(n);
+		int i;
+		for (i = 0; i < EVENTS_NR_COLUMNS - 1; i++)
+			widths[i] = TSMAX(widths[i],
+					  fm.width(r->column[i]) + margin);
+	};
+
+	visibleRows(first, last);
+	last = TSMIN(last, eventsModel->getPageSize() - 1);
+	for (row = first; row <= last; row++)
+		measure(start + row);
+	step = TSMAX(size / EVENTS_WIDTH_SAMPLES, (vtl::index_t) 1);
+	for (pos = 0; pos < size; pos += step)
+		measure(pos);
+
+	for (c = 0; c < EVENTS_NR_COLUMNS - 1; c++)
+		header->resizeSection(c, widths[c]);
+}
+
+/*
+ * This is called when the view is scrolled, so it is also here that the page
+ * of the model is moved when the viewport comes close to its first or last row
+ */
+void EventsWidget::prefetchAroundViewport()
+{
+	vtl::index_t start = eventsModel->getPageStart();
+	vtl::index_t top, newStart;
+	int first, last, pageSize;
+
+	if (getSize() == 0)
+		return;
+	visibleRows(first, last);
+	pageSize = eventsModel->getPageSize();
+	if ((first < EVENTS_PAGE_MARGIN && start > 0) ||
+	    (last >= pageSize - EVENTS_PAGE_MARGIN &&
+	     start + pageSize < getSize())) {
+		top = start + first;
+		newStart = TSMIN(top - EVENTS_PAGE_ROWS / 2,
+				 getSize() - EVENTS_PAGE_ROWS);
+		newStart = TSMAX(newStart, (vtl::index_t) 0);
+		if (newStart != start) {
+			movePage(newStart);
+			tableView->scrollTo(eventsModel->index(top - newStart,
+							       0),
+					    QAbstractItemView::PositionAtTop);
+			return;
+		}
+	}
+	eventsModel->prefetch(start + first - EVENTS_PREFETCH_ROWS,
+			      start + last + EVENTS_PREFETCH_ROWS);
+}
+
+const TraceEvent* EventsWidget::getEventAt(vtl::index_t pos) const
+{
+	if (events == nullptr)
+		return nullptr;
+	if (filter != nullptr)
+		return &events->at(filter->select(pos));
+	return &events->at(pos);
+}
+
+vtl::index_t EventsWidget::getSize() const
+{
+	if (events == nullptr)
+		return 0;
+	if (filter != nullptr)
+		return filter->count();
+	return events->size();
 }
 
 vtl::Time EventsWidget::getSavedScroll()
@@ -53,14 +53,33 @@
 #define EVENTSWIDGET_H
 
 #include <QDockWidget>
+#include <QString>
 #include "misc/traceshark.h"
+#include "vtl/index.h"
 #include "vtl/time.h"
 
+/* Rows above and below the viewport that are formatted in advance */
+#define EVENTS_PREFETCH_ROWS (256)
+/* Rows that are measured, in addition to the visible ones */
+#define EVENTS_WIDTH_SAMPLES (128)
+/*
+ * When the viewport comes this close to the first or the last row of the page
+ * of the model, the page is moved so that the viewport is in its middle
+ */
+#define EVENTS_PAGE_MARGIN (1024)
+
 class TableView;
 class EventsModel;
 class TraceEvent;
+QT_BEGIN_NAMESPACE
+class QComboBox;
+class QLabel;
+class QLineEdit;
+class QToolButton;
+QT_END_NAMESPACE
 namespace vtl {
 	template<class T> class TList;
+	class RankBitmap;
 }
 
 class EventsWidget : public QDockWidget
@@ -71,39 +90,65 @@ public:
 	EventsWidget(vtl::TList<TraceEvent> *e, QWidget *parent = 0);
 	virtual ~EventsWidget();
 	void setEvents(vtl::TList<TraceEvent> *e);
-	void setEvents(vtl::TList<const TraceEvent*> *e);
+	void setEvents(vtl::TList<TraceEvent> *e,
+		       const vtl::RankBitmap *filter);
 	void clear();
 	void clearScrollTime();
 	void beginResetModel();
 	void endResetModel();
 	void resizeColumnsToContents();
 	void scrollTo(const vtl::Time &time);
-	void scrollTo(int n);
+	void scrollTo(vtl::index_t n);
 	void scrollToSaved();
 	void show();
 	vtl::Time getSavedScroll();
 	const TraceEvent *getSelectedEvent();
+	void setSearchResult(const vtl::RankBitmap *result);
 signals:
 	void timeSelected(vtl::Time time);
 	void infoDoubleClicked(const TraceEvent &event);
 	void eventSelected(const TraceEvent *event);
+	void searchEdited();
+	void searchRequested(const QString &text, int match);
 private slots:
 	void handleClick(const QModelIndex &index);
 	void handleDoubleClick(const QModelIndex &index);
 	void handleSelectionChanged(const QItemSelection &selected,
 				    const QItemSelection &deselected);
+	void prefetchAroundViewport();
+	void searchTriggered();
+	void findNextMatch();
+	void findPrevMatch();
 private:
 	TableView *tableView;
+	QLineEdit *searchLine;
+	QComboBox *searchMode;
+	QToolButton *prevButton;
+	QToolButton *nextButton;
+	QLabel *searchLabel;
 	EventsModel *eventsModel;
 	vtl::TList<TraceEvent> *events;
-	vtl::TList<const TraceEvent*> *eventsPtrs;
+	const vtl::RankBitmap *filter;
+	/* The events that match the search, indexed like the events */
+	const vtl::RankBitmap *matches;
+	QString searchText;
+	int searchMatch;
 	bool saveScrollTime;
 	vtl::Time scrollTime;
 	const TraceEvent *selectedEvent;
-	int findBestMatch(const vtl::Time &time);
-	int binarySearch(const vtl::Time &time, int start, int end);
-	const TraceEvent* getEventAt(int index) const;
-	unsigned int getSize() const;
+	void setupLayout();
+	void findMatch(bool forward);
+	int selectedRow();
+	vtl::index_t selectedPosition();
+	void showPosition(vtl::index_t pos);
+	void movePage(vtl::index_t start);
+	void estimateColumnWidths();
+	void visibleRows(int &first, int &last) const;
+	vtl::index_t findBestMatch(const vtl::Time &time);
+	vtl::index_t binarySearch(const vtl::Time &time, vtl::index_t start,
+				  vtl::index_t end);
+	const TraceEvent* getEventAt(vtl::index_t pos) const;
+	vtl::index_t getSize() const;
 };
 
 #endif /* EVENTSWIDGET_H*/
@@ -53,8 +53,13 @@
 
 #include <QApplication>
 #include <QDateTime>
+#include <QInputDialog>
+#include <QMessageBox>
 #include <QToolBar>
+#include <QToolTip>
 
+#include "ui/affinegraph.h"
+#include "ui/cputimeline.h"
 #include "ui/cursor.h"
 #include "ui/eventinfodialog.h"
 #include "ui/eventswidget.h"
@@ -63,12 +68,15 @@
 #include "ui/graphenabledialog.h"
 #include "ui/infowidget.h"
 #include "ui/licensedialog.h"
+#include "ui/memorywidget.h"
 #include "ui/mainwindow.h"
+#include "ui/migrationgraph.h"
 #include "ui/migrationline.h"
 #include "ui/taskgraph.h"
 #include "ui/taskrangeallocator.h"
 #include "ui/taskselectdialog.h"
 #include "ui/tasktoolbar.h"
+#include "ui/tilecache.h"
 #include "ui/eventselectdialog.h"
 #include "parser/traceevent.h"
 #include "ui/traceplot.h"
@@ -76,11 +84,14 @@
 #include "misc/errors.h"
 #include "misc/resources.h"
 #include "misc/traceshark.h"
-#include "threads/workqueue.h"
+#include "mm/memreport.h"
+#include "parser/memestimate.h"
 #include "threads/workitem.h"
 #include "qcustomplot/qcustomplot.h"
 #include "vtl/compiler.h"
 #include "vtl/error.h"
+#include "vtl/index.h"
+#include "vtl/mapping.h"
 
 
 #define TOOLTIP_OPEN			\
@@ -104,6 +115,9 @@
 #define TOOLTIP_TIMEFILTER		\
 "Filter on the time interval specified by the current position of the cursors"
 
+#define TOOLTIP_ARGFILTER		\
+"Filter on an expression over the CPU, the event type and the event fields"
+
 #define TOOLTIP_GRAPHENABLE		\
 "Select which types of graphs should be enabled"
 
@@ -122,6 +136,9 @@
 #define TOOLTIP_GETSTATS_TIMELIMITED	\
 "Show the dialog with statistics that are time limited by the cursors"
 
+#define TOOLTIP_SHOWMEMORY		\
+"Show how much memory each part of the trace uses"
+
 #define TOOLTIP_FIND_SLEEP		\
 "Find the next sched_switch event that puts the selected task to sleep"
 
@@ -164,8 +181,25 @@
 #define SHOW_LICENSE_TOOLTIP		\
 "Show the license of Traceshark"
 
+/*
+ * The horizontal wakeup error bars extend to the left of the wakeup point by
+ * the wakeup delay
+ */
+__always_inline static void setHorizontalWakeupErrors(QCPErrorBars *errorBars,
+						       const AbstractTask &task)
+{
+	QSharedPointer<QCPErrorBarsDataContainer> container = errorBars->data();
+	int s = task.wakeDelay.size();
+	int i;
+
+	container->resize(s);
+	for (i = 0; i < s; i++)
+		(*container)[i] = QCPErrorBarsData(task.wakeDelay[i], 0);
+}
+
 MainWindow::MainWindow():
-	tracePlot(nullptr), filterActive(false)
+	tracePlot(nullptr), printMemReport(false), migrationGraph(nullptr),
+	filterActive(false)
 {
 	analyzer = new TraceAnalyzer;
 
@@ -204,6 +238,12 @@ MainWindow::MainWindow():
 				      Qt::BottomDockWidgetArea);
 	addDockWidget(Qt::BottomDockWidgetArea, eventsWidget);
 
+	memoryWidget = new MemoryWidget(this);
+	memoryWidget->setAllowedAreas(Qt::TopDockWidgetArea |
+				      Qt::BottomDockWidgetArea);
+	addDockWidget(Qt::BottomDockWidgetArea, memoryWidget);
+	memoryWidget->hide();
+
 	cursors[TShark::RED_CURSOR] = nullptr;
 	cursors[TShark::BLUE_CURSOR] = nullptr;
 
@@ -232,6 +272,9 @@ MainWindow::MainWindow():
 
 	tsconnect(tracePlot, mouseDoubleClick(QMouseEvent*),
 		  this, plotDoubleClicked(QMouseEvent*));
+	tsconnect(tracePlot, mouseMove(QMouseEvent*),
+		  this, plotMouseMoved(QMouseEvent*));
+	tsconnect(tileCache, tilesReady(), this, tilesReady());
 	tsconnect(infoWidget, valueChanged(vtl::Time, int),
 		  this, infoValueChanged(vtl::Time, int));
 
@@ -242,6 +285,12 @@ MainWindow::MainWindow():
 		  this, showEventInfo(const TraceEvent &));
 	tsconnect(eventsWidget, eventSelected(const TraceEvent *),
 		  this, handleEventSelected(const TraceEvent *));
+	tsconnect(eventsWidget, searchRequested(const QString &, int),
+		  this, searchEvents(const QString &, int));
+	tsconnect(eventsWidget, searchEdited(), this, prepareSearch());
+
+	/* Memory widget */
+	tsconnect(memoryWidget, refreshRequested(), this, updateMemory());
 
 	/* task select dialog */
 	tsconnect(taskSelectDialog, addTaskGraph(int), this, addTaskGraph(int));
@@ -312,6 +361,7 @@ void MainWindow::createTracePlot()
 	taskRangeAllocator = new TaskRangeAllocator(schedHeight
 						    + schedSpacing);
 	taskRangeAllocator->setStart(bugWorkAroundOffset);
+	tileCache = new TileCache(this);
 
 	mainLayer = tracePlot->layer(mainLayerName);
 
@@ -376,6 +426,8 @@ void MainWindow::openFile(const QString &name)
 
 	if (analyzer->isOpen())
 		closeTrace();
+	if (!checkMemory(name))
+		return;
 	ts_errno = loadTraceFile(name);
 
 	if (ts_errno != 0) {
@@ -454,6 +506,7 @@ void MainWindow::openFile(const QString &name)
 		fflush(stdout);
 		tracePlot->legend->setVisible(true);
 		setTraceActionsEnabled(true);
+		updateMemory();
 	} else
 		setStatus(STATUS_ERROR);
 }
@@ -472,16 +525,22 @@ void MainWindow::computeLayout()
 	double inc, o, p;
 	double start, end;
 	QColor color;
+	int i;
 
 	start = analyzer->getStartTime().toDouble();
 	end = analyzer->getEndTime().toDouble();
 
-	bottom = bugWorkAroundOffset;
-	offset = bottom;
+	/* The unified task graphs, if any, are below bugWorkAroundOffset */
+	bottom = taskRangeAllocator->getBottom();
+	offset = bugWorkAroundOffset;
 	nrCPUs = analyzer->getNrCPUs();
 	ticks.resize(0);
 	tickLabels.resize(0);
 
+	for (i = 0; i < migrationLines.size(); i++)
+		tracePlot->removeItem(migrationLines[i]);
+	migrationLines.resize(0);
+
 	if (Setting::isEnabled(Setting::SHOW_MIGRATION_GRAPHS)) {
 		offset += migrateSectionOffset;
 
@@ -493,7 +552,8 @@ void MainWindow::computeLayout()
 		color = QColor(135, 206, 250); /* Light sky blue */
 		label = QString("fork/exit");
 		ticks.append(offset);
-		new MigrationLine(start, end, offset, color, tracePlot);
+		migrationLines.append(new MigrationLine(start, end, offset,
+							color, tracePlot));
 		tickLabels.append(label);
 		o = offset;
 		p = inc / nrCPUs ;
@@ -502,7 +562,9 @@ void MainWindow::computeLayout()
 			label = QString("cpu") + QString::number(cpu);
 			ticks.append(o);
 			tickLabels.append(label);
-			new MigrationLine(start, end, o, color, tracePlot);
+			migrationLines.append(new MigrationLine(start, end, o,
+								color,
+								tracePlot));
 		}
 
 		offset += inc;
@@ -557,7 +619,14 @@ void MainWindow::clearPlot()
 	cursors[TShark::RED_CURSOR] = nullptr;
 	cursors[TShark::BLUE_CURSOR] = nullptr;
 	tracePlot->clearItems();
+	/* The tiles must be gone before the tasks that they are drawn from */
+	tileCache->clear();
 	tracePlot->clearPlottables();
+	cpuTimelines.clear();
+	cpuIdleGraphs.clear();
+	cpuFreqGraphs.clear();
+	migrationLines.clear();
+	migrationGraph = nullptr;
 	tracePlot->hide();
 	TaskGraph::clearMap();
 	taskRangeAllocator->clearAll();
@@ -571,7 +640,6 @@ void MainWindow::showTrace()
 	double start, end;
 	int precision = 7;
 	double extra = 0;
-	QColor color;
 
 	start = analyzer->getStartTime().toDouble();
 	end = analyzer->getEndTime().toDouble();
@@ -581,83 +649,134 @@ void MainWindow::showTrace()
 
 	precision += (int) extra;
 
-	tracePlot->yAxis->setRange(QCPRange(bottom, top));
+	setupYAxis();
 	tracePlot->xAxis->setRange(QCPRange(start, end));
 	tracePlot->xAxis->setNumberPrecision(precision);
+
+	updateGraphs();
+
+	/* Show scheduling graphs */
+	for (cpu = 0; cpu <= analyzer->getMaxCPU(); cpu++)
+		addCPUTimeline(cpu);
+
+	tracePlot->replot();
+}
+
+/*
+ * This is used when the settings change the layout of an open trace. All
+ * graphs apply the offsets and scales of the analyzer when they are drawn, so
+ * after rescaling we only need to add or remove the graphs whose setting
+ * changed, instead of recreating all of them.
+ */
+void MainWindow::relayoutTrace()
+{
+	computeLayout();
+	rescaleTrace();
+	setupYAxis();
+	updateGraphs();
+	updateCPUTimelines();
+	tracePlot->replot();
+}
+
+void MainWindow::setupYAxis()
+{
+	tracePlot->yAxis->setRange(QCPRange(bottom, top));
 	tracePlot->yAxis->setTicks(false);
 	yaxisTicker->setTickVector(ticks);
 	yaxisTicker->setTickVectorLabels(tickLabels);
 	tracePlot->yAxis->setTicks(true);
+}
 
+/*
+ * Creates the migration, CPU frequency and CPU idle graphs that are enabled
+ * but missing and removes the ones that are disabled.
+ */
+void MainWindow::updateGraphs()
+{
+	unsigned int cpu;
+	bool showMigration =
+		Setting::isEnabled(Setting::SHOW_MIGRATION_GRAPHS);
+	bool showIdle = Setting::isEnabled(Setting::SHOW_CPUIDLE_GRAPHS);
+	bool showFreq = Setting::isEnabled(Setting::SHOW_CPUFREQ_GRAPHS);
+
+	if (showMigration && migrationGraph == nullptr) {
+		migrationGraph = new MigrationGraph(tracePlot->xAxis,
+						    tracePlot->yAxis,
+						    analyzer);
+	} else if (!showMigration && migrationGraph != nullptr) {
+		tracePlot->removePlottable(migrationGraph);
+		migrationGraph = nullptr;
+	}
 
-	if (!Setting::isEnabled(Setting::SHOW_CPUFREQ_GRAPHS) &&
-	    !Setting::isEnabled(Setting::SHOW_CPUIDLE_GRAPHS))
-		goto skipIdleFreqGraphs;
-
-	/* Show CPU frequency and idle graphs */
-	for (cpu = 0; cpu <= analyzer->getMaxCPU(); cpu++) {
-		QPen pen = QPen();
-		QPen penF = QPen();
-
-		QCPGraph *graph;
-		QString name;
-		QCPScatterStyle style;
-
-		if (Setting::isEnabled(Setting::SHOW_CPUIDLE_GRAPHS)) {
-			graph = tracePlot->addGraph(tracePlot->xAxis,
-						    tracePlot->yAxis);
-			graph->setSelectable(QCP::stNone);
-			name = QString(tr("cpuidle")) + QString::number(cpu);
-			style = QCPScatterStyle(QCPScatterStyle::ssCircle, 5);
-			pen.setColor(Qt::red);
-			style.setPen(pen);
-			graph->setScatterStyle(style);
-			pen.setColor(Qt::green);
-			graph->setPen(pen);
-			graph->setName(name);
-			graph->setAdaptiveSampling(true);
-			graph->setLineStyle(QCPGraph::lsStepLeft);
-			graph->setData(analyzer->cpuIdle[cpu].timev,
-				       analyzer->cpuIdle[cpu].scaledData);
-		}
+	if (showIdle && cpuIdleGraphs.isEmpty()) {
+		for (cpu = 0; cpu <= analyzer->getMaxCPU(); cpu++)
+			cpuIdleGraphs.append(addCPUIdleGraph(cpu));
+	} else if (!showIdle) {
+		removeGraphs(cpuIdleGraphs);
+	}
 
-		if (Setting::isEnabled(Setting::SHOW_CPUFREQ_GRAPHS)) {
-			graph = tracePlot->addGraph(tracePlot->xAxis,
-						    tracePlot->yAxis);
-			graph->setSelectable(QCP::stNone);
-			name = QString(tr("cpufreq")) + QString::number(cpu);
-			penF.setColor(Qt::blue);
-			penF.setWidth(2);
-			graph->setPen(penF);
-			graph->setName(name);
-			graph->setAdaptiveSampling(true);
-			graph->setLineStyle(QCPGraph::lsStepLeft);
-			graph->setData(analyzer->cpuFreq[cpu].timev,
-				       analyzer->cpuFreq[cpu].scaledData);
-		}
+	if (showFreq && cpuFreqGraphs.isEmpty()) {
+		for (cpu = 0; cpu <= analyzer->getMaxCPU(); cpu++)
+			cpuFreqGraphs.append(addCPUFreqGraph(cpu));
+	} else if (!showFreq) {
+		removeGraphs(cpuFreqGraphs);
 	}
+}
+
+void MainWindow::removeGraphs(QVector<AffineGraph*> &graphs)
+{
+	int i;
 
-skipIdleFreqGraphs:
+	for (i = 0; i < graphs.size(); i++)
+		tracePlot->removePlottable(graphs[i]);
+	graphs.clear();
+}
 
-	/* Show scheduling graphs */
-	for (cpu = 0; cpu <= analyzer->getMaxCPU(); cpu++) {
-		DEFINE_CPUTASKMAP_ITERATOR(iter) = analyzer->
-			cpuTaskMaps[cpu].begin();
-		while(iter != analyzer->cpuTaskMaps[cpu].end()) {
-			CPUTask &task = iter.value();
-			iter++;
-
-			addSchedGraph(task);
-			if(Setting::isEnabled(Setting::SHOW_SCHED_GRAPHS)) {
-				addHorizontalWakeupGraph(task);
-				addWakeupGraph(task);
-				addPreemptedGraph(task);
-				addStillRunningGraph(task);
-			}
-		}
-	}
+AffineGraph *MainWindow::addCPUIdleGraph(unsigned int cpu)
+{
+	AffineGraph *graph = new AffineGraph(tracePlot->xAxis,
+					     tracePlot->yAxis);
+	QString name = QString(tr("cpuidle")) + QString::number(cpu);
+	QCPScatterStyle style = QCPScatterStyle(QCPScatterStyle::ssCircle, 5);
+	QPen pen = QPen();
 
-	tracePlot->replot();
+	graph->setSelectable(QCP::stNone);
+	pen.setColor(Qt::red);
+	style.setPen(pen);
+	graph->setScatterStyle(style);
+	pen.setColor(Qt::green);
+	graph->setPen(pen);
+	graph->setName(name);
+	graph->setAdaptiveSampling(true);
+	graph->setLineStyle(QCPGraph::lsStepLeft);
+	graph->setData(analyzer->cpuIdle[cpu].timev,
+		       analyzer->cpuIdle[cpu].data, true);
+	graph->setTransform(&analyzer->cpuIdle[cpu].offset,
+			    &analyzer->cpuIdle[cpu].scale);
+	graph->setLod(&analyzer->cpuIdle[cpu].lod);
+	return graph;
+}
+
+AffineGraph *MainWindow::addCPUFreqGraph(unsigned int cpu)
+{
+	AffineGraph *graph = new AffineGraph(tracePlot->xAxis,
+					     tracePlot->yAxis);
+	QString name = QString(tr("cpufreq")) + QString::number(cpu);
+	QPen penF = QPen();
+
+	graph->setSelectable(QCP::stNone);
+	penF.setColor(Qt::blue);
+	penF.setWidth(2);
+	graph->setPen(penF);
+	graph->setName(name);
+	graph->setAdaptiveSampling(true);
+	graph->setLineStyle(QCPGraph::lsStepLeft);
+	graph->setData(analyzer->cpuFreq[cpu].timev,
+		       analyzer->cpuFreq[cpu].data, true);
+	graph->setTransform(&analyzer->cpuFreq[cpu].offset,
+			    &analyzer->cpuFreq[cpu].scale);
+	graph->setLod(&analyzer->cpuFreq[cpu].lod);
+	return graph;
 }
 
 void MainWindow::setupCursors()
@@ -725,120 +844,69 @@ void MainWindow::setupSettings()
 	Setting::setEnabled(Setting::SHOW_MIGRATION_GRAPHS, true);
 }
 
-void MainWindow::addSchedGraph(CPUTask &cpuTask)
-{
-	/* Add scheduling graph */
-	TaskGraph *graph = new TaskGraph(tracePlot);
-	QColor color = analyzer->getTaskColor(cpuTask.pid);
-	Task *task = analyzer->findTask(cpuTask.pid);
-	QPen pen = QPen();
-
-	pen.setColor(color);
-	graph->setPen(pen);
-	graph->setTask(task);
-	if (Setting::isEnabled(Setting::SHOW_SCHED_GRAPHS))
-		graph->setData(cpuTask.schedTimev, cpuTask.scaledSchedData);
-	/*
-	 * Save a pointer to the graph object in the task. The destructor of
-	 * AbstractClass will delete this when it is destroyed.
-	 */
-	cpuTask.graph = graph;
-}
-
-void MainWindow::addHorizontalWakeupGraph(CPUTask &task)
-{
-	if (!Setting::isEnabled(Setting::HORIZONTAL_WAKEUP))
-		return;
-
-	/* Add wakeup graph on top of scheduling */
-	QCPGraph *graph = tracePlot->addGraph(tracePlot->xAxis,
-					      tracePlot->yAxis);
-	QCPScatterStyle style = QCPScatterStyle(QCPScatterStyle::ssDot);
-	QColor color = analyzer->getTaskColor(task.pid);
-	QPen pen = QPen();
-	QCPErrorBars *errorBars = new QCPErrorBars(tracePlot->xAxis,
-						   tracePlot->yAxis);
-	errorBars->setAntialiased(false);
-	pen.setColor(color);
-	style.setPen(pen);
-	graph->setScatterStyle(style);
-	graph->setLineStyle(QCPGraph::lsNone);
-	graph->setAdaptiveSampling(true);
-	graph->setData(task.wakeTimev, task.wakeHeight);
-	errorBars->setData(task.wakeDelay, task.wakeZero);
-	errorBars->setErrorType(QCPErrorBars::etKeyError);
-	errorBars->setPen(pen);
-	errorBars->setWhiskerWidth(4);
-	errorBars->setDataPlottable(graph);
-	/* errorBars->setSymbolGap(0); */
-}
-
-void MainWindow::addWakeupGraph(CPUTask &task)
-{
-	if (!Setting::isEnabled(Setting::VERTICAL_WAKEUP))
-		return;
-
-	/* Add wakeup graph on top of scheduling */
-	QCPGraph *graph = tracePlot->addGraph(tracePlot->xAxis,
-					      tracePlot->yAxis);
-	QCPScatterStyle style = QCPScatterStyle(QCPScatterStyle::ssDot);
-	QColor color = analyzer->getTaskColor(task.pid);
-	QPen pen = QPen();
-	QCPErrorBars *errorBars = new QCPErrorBars(tracePlot->xAxis,
-						   tracePlot->yAxis);
-	errorBars->setAntialiased(false);
-
-	pen.setColor(color);
-	style.setPen(pen);
-	graph->setScatterStyle(style);
-	graph->setLineStyle(QCPGraph::lsNone);
-	graph->setAdaptiveSampling(true);
-	graph->setData(task.wakeTimev, task.wakeHeight);
-	errorBars->setData(task.wakeZero, task.verticalDelay);
-	errorBars->setErrorType(QCPErrorBars::etValueError);
-	errorBars->setPen(pen);
-	errorBars->setWhiskerWidth(4);
-	errorBars->setDataPlottable(graph);
+/*
+ * Adds one plottable that draws all tasks of the CPU, together with a
+ * TaskGraph for every task, which is used for selecting the task and for
+ * showing it in the legend.
+ */
+void MainWindow::addCPUTimeline(unsigned int cpu)
+{
+	CPUTimeline *timeline = new CPUTimeline(tracePlot->xAxis,
+						tracePlot->yAxis);
+	int index;
+
+	timeline->setWakeupFlags(wakeupFlags());
+	timeline->setSpanIndex(&analyzer->cpuSpans[cpu]);
+	timeline->setTileCache(tileCache, cpu);
+	timeline->setVisible(Setting::isEnabled(Setting::SHOW_SCHED_GRAPHS));
+	cpuTimelines.append(timeline);
+
+	DEFINE_CPUTASKMAP_ITERATOR(iter) = analyzer->cpuTaskMaps[cpu].begin();
+	while (iter != analyzer->cpuTaskMaps[cpu].end()) {
+		CPUTask &cpuTask = *iter.value();
+		QColor color = analyzer->getTaskColor(cpuTask.pid);
+		Task *task = analyzer->findTask(cpuTask.pid);
+		iter++;
+
+		index = timeline->addTask(&cpuTask, color);
+		TaskGraph *graph = new TaskGraph(tracePlot, timeline, index);
+		graph->setPen(QPen(color));
+		graph->setTask(task);
+		/*
+		 * Save a pointer to the graph object in the task. The
+		 * destructor of AbstractClass will delete this when it is
+		 * destroyed.
+		 */
+		cpuTask.graph = graph;
+	}
 }
 
-void MainWindow::addPreemptedGraph(CPUTask &task)
+/*
+ * The tiles include the wakeups, so they need to be rendered again if the
+ * wakeup settings have changed.
+ */
+void MainWindow::updateCPUTimelines()
 {
-	/* Add still running graph on top of the other two...*/
-	if (task.runningTimev.size() == 0)
-		return;
-	QCPGraph *graph = tracePlot->addGraph(tracePlot->xAxis,
-					      tracePlot->yAxis);
-	QString name = QString(tr("was preempted"));
-	graph->setName(name);
-	QCPScatterStyle style = QCPScatterStyle(QCPScatterStyle::ssCircle, 5);
-	QPen pen = QPen();
+	bool showSched = Setting::isEnabled(Setting::SHOW_SCHED_GRAPHS);
+	int flags = wakeupFlags();
+	int i;
 
-	pen.setColor(Qt::red);
-	style.setPen(pen);
-	graph->setScatterStyle(style);
-	graph->setLineStyle(QCPGraph::lsNone);
-	graph->setAdaptiveSampling(true);
-	graph->setData(task.preemptedTimev, task.scaledPreemptedData);
+	tileCache->clear();
+	for (i = 0; i < cpuTimelines.size(); i++) {
+		cpuTimelines[i]->setWakeupFlags(flags);
+		cpuTimelines[i]->setVisible(showSched);
+	}
 }
 
-void MainWindow::addStillRunningGraph(CPUTask &task)
+int MainWindow::wakeupFlags()
 {
-	/* Add still running graph on top of the other two...*/
-	if (task.runningTimev.size() == 0)
-		return;
-	QCPGraph *graph = tracePlot->addGraph(tracePlot->xAxis,
-					      tracePlot->yAxis);
-	QString name = QString(tr("is runnable"));
-	graph->setName(name);
-	QCPScatterStyle style = QCPScatterStyle(QCPScatterStyle::ssCircle, 5);
-	QPen pen = QPen();
+	int flags = TIMELINE_WAKEUP_NONE;
 
-	pen.setColor(Qt::blue);
-	style.setPen(pen);
-	graph->setScatterStyle(style);
-	graph->setLineStyle(QCPGraph::lsNone);
-	graph->setAdaptiveSampling(true);
-	graph->setData(task.runningTimev, task.scaledRunningData);
+	if (Setting::isEnabled(Setting::HORIZONTAL_WAKEUP))
+		flags |= TIMELINE_WAKEUP_HORIZONTAL;
+	if (Setting::isEnabled(Setting::VERTICAL_WAKEUP))
+		flags |= TIMELINE_WAKEUP_VERTICAL;
+	return flags;
 }
 
 /*
@@ -854,6 +922,7 @@ void MainWindow::setTraceActionsEnabled(bool e)
 	showTasksAction->setEnabled(e);
 	showEventsAction->setEnabled(e);
 	timeFilterAction->setEnabled(e);
+	argFilterAction->setEnabled(e);
 	showStatsAction->setEnabled(e);
 	showStatsTimeLimitedAction->setEnabled(e);
 	clearLegendAction->setEnabled(e);
@@ -912,6 +981,7 @@ void MainWindow::closeTrace()
 	setTaskActionsEnabled(false);
 	setWakeupActionsEnabled(false);
 	setStatus(STATUS_NOFILE);
+	memoryWidget->clear();
 }
 
 void MainWindow::saveScreenshot()
@@ -1143,6 +1213,64 @@ void MainWindow::plotDoubleClicked(QMouseEvent *event)
 	}
 }
 
+/*
+ * Shows the task and the event that started the run span under the mouse as
+ * a tooltip. Each CPU row is checked in constant time and the span is found
+ * with a binary search, so this is cheap enough to do on every mouse move.
+ */
+void MainWindow::plotMouseMoved(QMouseEvent *event)
+{
+	const SchedSpan *span = nullptr;
+	CPUTimeline *timeline = nullptr;
+	const CPUTask *cpuTask;
+	Task *task;
+	int cpu;
+	QString text;
+
+	/* The tooltip would only be in the way while dragging */
+	if (event->buttons() != Qt::NoButton)
+		return;
+
+	for (cpu = 0; cpu < cpuTimelines.size(); cpu++) {
+		timeline = cpuTimelines[cpu];
+		if (!timeline->visible())
+			continue;
+		span = timeline->findSpan(event->pos());
+		if (span != nullptr)
+			break;
+	}
+
+	if (span == nullptr) {
+		QToolTip::hideText();
+		return;
+	}
+
+	cpuTask = timeline->taskAt(span->task);
+	task = analyzer->findTask(cpuTask->pid);
+	if (task == nullptr) {
+		QToolTip::hideText();
+		return;
+	}
+
+	vtl::Time start = vtl::Time::fromDouble(span->start);
+	vtl::Time duration = vtl::Time::fromDouble(span->end - span->start);
+	start.setPrecision(analyzer->getTimePrecision());
+	duration.setPrecision(analyzer->getTimePrecision());
+
+	text = *task->displayName + QString(":") +
+		QString::number(task->pid) + QString("\n");
+	text += tr("cpu") + QString::number(cpu) + QString(" ") +
+		start.toQString() + QString(" +") + duration.toQString() +
+		QString("\n");
+	text += tr("event #") + QString::number(span->eventIdx);
+	QToolTip::showText(event->globalPos(), text, tracePlot);
+}
+
+void MainWindow::tilesReady()
+{
+	tracePlot->replot(QCustomPlot::rpQueuedReplot);
+}
+
 void MainWindow::infoValueChanged(vtl::Time value, int nr)
 {
 	Cursor *cursor;
@@ -1188,11 +1316,6 @@ void MainWindow::taskTriggered(int pid)
 	CPUTask *cpuTask;
 	CPUTask *maxTask;
 	int maxSize;
-	QCPGraph *qcpGraph;
-	QCPDataRange range;
-	QCPDataSelection selection;
-	int end;
-	TaskGraph *taskGraph;
 	bool enableActions = false;
 
 	tracePlot->deselectAll();
@@ -1205,17 +1328,9 @@ void MainWindow::taskTriggered(int pid)
 		goto out;
 
 	if (task->graph != nullptr) {
-		qcpGraph = task->graph->getQCPGraph();
-		if (qcpGraph == nullptr)
-			goto do_cpugraph;
-		range.setBegin(0);
-		end = task->schedTimev.size() - 1;
-		if (end < 0)
+		if (task->schedTimev.size() == 0)
 			goto do_cpugraph;
-		range.setEnd(end);
-		selection.clear();
-		selection.addDataRange(range);
-		qcpGraph->setSelection(selection);
+		task->graph->select();
 		taskToolBar->setTaskGraph(task->graph);
 		enableActions = true;
 		goto out;
@@ -1234,23 +1349,9 @@ do_cpugraph:
 		}
 	}
 
-	if (maxTask->graph != nullptr) {
-		qcpGraph = maxTask->graph->getQCPGraph();
-		if (qcpGraph == nullptr)
-			goto out;
-		range.setBegin(0);
-		end = maxTask->schedTimev.size() - 1;
-		if (end < 0)
-			goto out;
-		range.setEnd(end);
-		selection.clear();
-		selection.addDataRange(range);
-		qcpGraph->setSelection(selection);
-		taskGraph = TaskGraph::fromQCPGraph(qcpGraph);
-		/* Should not happen but check anyway */
-		if (taskGraph == nullptr)
-			goto out;
-		taskToolBar->setTaskGraph(taskGraph);
+	if (maxTask != nullptr && maxTask->graph != nullptr) {
+		maxTask->graph->select();
+		taskToolBar->setTaskGraph(maxTask->graph);
 		enableActions = true;
 	}
 
@@ -1313,6 +1414,10 @@ void MainWindow::createActions()
 	timeFilterAction->setToolTip(tr(TOOLTIP_TIMEFILTER));
 	tsconnect(timeFilterAction, triggered(), this, timeFilter());
 
+	argFilterAction = new QAction(tr("Filter on expression..."), this);
+	argFilterAction->setToolTip(tr(TOOLTIP_ARGFILTER));
+	tsconnect(argFilterAction, triggered(), this, argFilter());
+
 	graphEnableAction = new QAction(tr("Select graphs..."), this);
 	graphEnableAction->setIcon(QIcon(RESSRC_PNG_GRAPHENABLE));
 	graphEnableAction->setToolTip(tr(TOOLTIP_GRAPHENABLE));
@@ -1353,6 +1458,10 @@ void MainWindow::createActions()
 	tsconnect(showStatsTimeLimitedAction, triggered(), this,
 		  showStatsTimeLimited());
 
+	showMemoryAction = new QAction(tr("Show memory usage..."), this);
+	showMemoryAction->setToolTip(tr(TOOLTIP_SHOWMEMORY));
+	tsconnect(showMemoryAction, triggered(), this, showMemory());
+
 	exitAction = new QAction(tr("E&xit"), this);
 	exitAction->setShortcuts(QKeySequence::Quit);
 	exitAction->setToolTip(tr(TOOLTIP_EXIT));
@@ -1498,10 +1607,12 @@ void MainWindow::createMenus()
 	viewMenu->addAction(showTasksAction);
 	viewMenu->addAction(showEventsAction);
 	viewMenu->addAction(timeFilterAction);
+	viewMenu->addAction(argFilterAction);
 	viewMenu->addAction(resetFiltersAction);
 	viewMenu->addAction(graphEnableAction);
 	viewMenu->addAction(showStatsAction);
 	viewMenu->addAction(showStatsTimeLimitedAction);
+	viewMenu->addAction(showMemoryAction);
 
 	taskMenu = menuBar()->addMenu(tr("&Task"));
 	taskMenu->addAction(addToLegendAction);
@@ -1565,21 +1676,16 @@ int MainWindow::loadTraceFile(const QString &fileName)
 }
 
 void MainWindow::plottableClicked(QCPAbstractPlottable *plottable,
-				  int /* dataIndex */,
+				  int dataIndex,
 				  QMouseEvent * /* event */)
 {
-	QCPGraph *qcpGraph;
 	TaskGraph *graph;
 
-	qcpGraph = qobject_cast<QCPGraph *>(plottable);
-	if (qcpGraph == nullptr)
-		return;
-
-	graph = TaskGraph::fromQCPGraph(qcpGraph);
+	graph = TaskGraph::fromPlottable(plottable, dataIndex);
 	if (graph == nullptr)
 		return;
 
-	if (qcpGraph->selected()) {
+	if (graph->isSelected()) {
 		setTaskActionsEnabled(true);
 		taskToolBar->setTaskGraph(graph);
 	} else {
@@ -1658,7 +1764,8 @@ void MainWindow::addTaskToLegend(int pid)
 void MainWindow::setEventsWidgetEvents()
 {
 	if (analyzer->isFiltered())
-		eventsWidget->setEvents(&analyzer->filteredEvents);
+		eventsWidget->setEvents(analyzer->events,
+				       &analyzer->filteredEvents);
 	else
 		eventsWidget->setEvents(analyzer->events);
 }
@@ -1713,6 +1820,61 @@ void MainWindow::timeFilter(void)
 	updateResetFiltersEnabled();
 }
 
+void MainWindow::argFilter(void)
+{
+	vtl::Time saved = eventsWidget->getSavedScroll();
+	QString expr;
+	QString error;
+	bool ok;
+
+	expr = QInputDialog::getText(this, tr("Filter on expression"),
+				     tr("Expression, e.g. cpu in {0..3} && "
+					"event == sched_switch && "
+					"prev_state == D"),
+				     QLineEdit::Normal,
+				     argFilterText, &ok);
+	if (!ok)
+		return;
+
+	eventsWidget->beginResetModel();
+	ok = analyzer->createArgFilter(expr, false, &error);
+	setEventsWidgetEvents();
+	eventsWidget->endResetModel();
+	if (!ok) {
+		vtl::warnx("Invalid filter expression: %s",
+			   error.toLocal8Bit().constData());
+		return;
+	}
+	argFilterText = expr;
+	scrollTo(saved);
+	updateResetFiltersEnabled();
+}
+
+/*
+ * The argument index is only built when the user starts to type a search, so
+ * that a trace that is never searched does not pay for it. The search waits
+ * for the index if it is not ready by then.
+ */
+void MainWindow::prepareSearch()
+{
+	if (analyzer->isOpen())
+		analyzer->startArgIndex();
+}
+
+void MainWindow::searchEvents(const QString &text, int match)
+{
+	if (!analyzer->isOpen())
+		return;
+
+	QApplication::setOverrideCursor(Qt::WaitCursor);
+	analyzer->searchArgs(text, (ArgIndex::match_t) match);
+	QApplication::restoreOverrideCursor();
+	eventsWidget->setSearchResult(&analyzer->searchMatches);
+	/* The argument index has now been built */
+	if (memoryWidget->isVisible())
+		updateMemory();
+}
+
 void MainWindow::createPidFilter(QMap<int, int> &map,
 				 bool orlogic, bool inclusive)
 {
@@ -1839,50 +2001,10 @@ void MainWindow::exportEventsTriggered()
 
 void MainWindow::consumeSettings()
 {
-	unsigned int cpu;
-
 	if (!analyzer->isOpen())
 		return;
 
-	clearPlot();
-	taskToolBar->clear();
-
-	for (cpu = 0; cpu <= analyzer->getMaxCPU(); cpu++) {
-		DEFINE_CPUTASKMAP_ITERATOR(iter);
-		for (iter = analyzer->cpuTaskMaps[cpu].begin();
-		     iter != analyzer->cpuTaskMaps[cpu].end();
-		     iter++) {
-			CPUTask &task = iter.value();
-			delete task.graph;
-			task.graph = nullptr;
-		}
-	}
-
-	DEFINE_TASKMAP_ITERATOR(iter);
-	for (iter = analyzer->taskMap.begin();
-	     iter != analyzer->taskMap.end();
-	     iter++) {
-		Task *task = iter.value().task;
-		if (task->graph != nullptr) {
-			/*
-			 * This implies that the task had a task graph added.
-			 * We delete the TaskGraph object and set the pointers
-			 * to nullptr. The actual QCPGraph objects is already
-			 * deleted by the clearPlot() function above.
-			 */
-			delete task->graph;
-			task->graph = nullptr;
-			task->wakeUpGraph = nullptr;
-			task->runningGraph = nullptr;
-			task->preemptedGraph = nullptr;
-		}
-	}
-
-	computeLayout();
-	setupCursors();
-	rescaleTrace();
-	showTrace();
-	tracePlot->show();
+	relayoutTrace();
 }
 
 void MainWindow::addTaskGraph(int pid)
@@ -1929,17 +2051,14 @@ void MainWindow::addTaskGraph(int pid)
 
 	task->offset = taskRange->lower;
 	task->scale = schedHeight;
-	task->doScale();
-	task->doScaleWakeup();
-	task->doScaleRunning();
-	task->doScalePreempted();
 
-	taskGraph->setData(task->schedTimev, task->scaledSchedData);
+	taskGraph->setData(task->schedTimev, task->schedData);
+	taskGraph->setTransform(&task->offset, &task->scale);
 	task->graph = taskGraph;
 
 	/* Add the horizontal wakeup graph as well */
-	QCPGraph *graph = tracePlot->addGraph(tracePlot->xAxis,
-					      tracePlot->yAxis);
+	AffineGraph *graph = new AffineGraph(tracePlot->xAxis,
+					     tracePlot->yAxis);
 	QCPErrorBars *errorBars = new QCPErrorBars(tracePlot->xAxis,
 						   tracePlot->yAxis);
 	errorBars->setAntialiased(false);
@@ -1948,8 +2067,9 @@ void MainWindow::addTaskGraph(int pid)
 	graph->setScatterStyle(style);
 	graph->setLineStyle(QCPGraph::lsNone);
 	graph->setAdaptiveSampling(true);
-	graph->setData(task->wakeTimev, task->wakeHeight);
-	errorBars->setData(task->wakeDelay, task->wakeZero);
+	graph->setConstantData(task->wakeTimev, WAKEUP_HEIGHT);
+	graph->setTransform(&task->offset, &task->scale);
+	setHorizontalWakeupErrors(errorBars, *task);
 	errorBars->setErrorType(QCPErrorBars::etKeyError);
 	errorBars->setPen(pen);
 	errorBars->setWhiskerWidth(4);
@@ -1963,7 +2083,7 @@ void MainWindow::addTaskGraph(int pid)
 		task->runningGraph = nullptr;
 		goto out;
 	}
-	graph = tracePlot->addGraph(tracePlot->xAxis, tracePlot->yAxis);
+	graph = new AffineGraph(tracePlot->xAxis, tracePlot->yAxis);
 	graph->setName(name);
 
 	pen.setColor(Qt::blue);
@@ -1971,7 +2091,8 @@ void MainWindow::addTaskGraph(int pid)
 	graph->setScatterStyle(rstyle);
 	graph->setLineStyle(QCPGraph::lsNone);
 	graph->setAdaptiveSampling(true);
-	graph->setData(task->runningTimev, task->scaledRunningData);
+	graph->setConstantData(task->runningTimev, FLOOR_HEIGHT);
+	graph->setTransform(&task->offset, &task->scale);
 	task->runningGraph = graph;
 
 	/* ...and then the preempted graph */
@@ -1981,7 +2102,7 @@ void MainWindow::addTaskGraph(int pid)
 		task->preemptedGraph = nullptr;
 		goto out;
 	}
-	graph = tracePlot->addGraph(tracePlot->xAxis, tracePlot->yAxis);
+	graph = new AffineGraph(tracePlot->xAxis, tracePlot->yAxis);
 	graph->setName(name);
 
 	pen.setColor(Qt::red);
@@ -1989,7 +2110,8 @@ void MainWindow::addTaskGraph(int pid)
 	graph->setScatterStyle(rstyle);
 	graph->setLineStyle(QCPGraph::lsNone);
 	graph->setAdaptiveSampling(true);
-	graph->setData(task->preemptedTimev, task->scaledPreemptedData);
+	graph->setConstantData(task->preemptedTimev, FLOOR_HEIGHT);
+	graph->setTransform(&task->offset, &task->scale);
 	task->preemptedGraph = graph;
 
 out:
@@ -2006,14 +2128,12 @@ out:
 void MainWindow::removeTaskGraph(int pid)
 {
 	Task *task = analyzer->findTask(pid);
-	QCPGraph *qcpGraph;
 
 	if (task == nullptr)
 		return;
 
 	if (task->graph != nullptr) {
-		qcpGraph = task->graph->getQCPGraph();
-		if (qcpGraph != nullptr && qcpGraph->selected() &&
+		if (task->graph->isSelected() &&
 		    taskToolBar->getPid() == task->pid)
 			taskToolBar->removeTaskGraph();
 		task->graph->destroy();
@@ -2086,6 +2206,94 @@ void MainWindow::showStatsTimeLimited()
 		addDockWidget(Qt::RightDockWidgetArea, statsLimitedDialog);
 }
 
+void MainWindow::showMemory()
+{
+	updateMemory();
+	memoryWidget->show();
+	if (dockWidgetArea(memoryWidget) == Qt::NoDockWidgetArea)
+		addDockWidget(Qt::BottomDockWidgetArea, memoryWidget);
+}
+
+void MainWindow::memReport(MemReport &report) const
+{
+	vtl::MemUsage timelines;
+	quint64 plotBytes = 0;
+	int i;
+
+	analyzer->memReport(report);
+	for (i = 0; i < tracePlot->graphCount(); i++)
+		plotBytes += (quint64) tracePlot->graph(i)->data()->size() *
+			sizeof(QCPGraphData);
+	report.add(QString("Plot data"), vtl::MemUsage(plotBytes, plotBytes));
+	for (i = 0; i < cpuTimelines.size(); i++)
+		timelines += cpuTimelines[i]->memUsage();
+	report.add(QString("CPU timelines"), timelines);
+	report.add(QString("Tile cache"), tileCache->memUsage());
+}
+
+/* With --mem-report, the report is also printed to stdout */
+void MainWindow::updateMemory()
+{
+	MemReport report;
+
+	if (!analyzer->isOpen()) {
+		memoryWidget->clear();
+		return;
+	}
+	memReport(report);
+	memoryWidget->setReport(report);
+	if (printMemReport) {
+		printf("%s", report.toText().toLocal8Bit().data());
+		fflush(stdout);
+	}
+}
+
+void MainWindow::setPrintMemReport(bool print)
+{
+	printMemReport = print;
+}
+
+/*
+ * Estimates the memory that the trace will need and asks the user whether to
+ * continue if it's more than what is available. Returns false if the trace
+ * should not be opened.
+ */
+bool MainWindow::checkMemory(const QString &name)
+{
+	MemEstimate estimate;
+	MemReport report;
+	quint64 avail, need;
+	QString text;
+	int rval;
+
+	if (estimate.estimate(name) != 0)
+		return true;
+	if (printMemReport) {
+		estimate.memReport(report);
+		printf("Estimated memory usage of %s:\n%s",
+		       name.toLocal8Bit().data(),
+		       report.toText().toLocal8Bit().data());
+		fflush(stdout);
+	}
+	avail = MemEstimate::memAvailable();
+	need = estimate.total();
+	if (vtl::get_scratch_dir() != nullptr)
+		need = estimate.inCoreTotal();
+	if (avail == 0 || need < avail)
+		return true;
+
+	text = tr("The trace has an estimated %1 events and may need %2 of "
+		  "memory but only %3 is available. Do you want to open it "
+		  "anyway?")
+		.arg(estimate.getNrEvents())
+		.arg(MemReport::formatBytes(need))
+		.arg(MemReport::formatBytes(avail));
+	rval = QMessageBox::warning(this, tr("The trace may not fit in memory"),
+				    text, QMessageBox::Yes | QMessageBox::No,
+				    QMessageBox::No);
+	return rval == QMessageBox::Yes;
+}
+
 void MainWindow::removeQDockWidget(QDockWidget *widget)
 {
 	if (dockWidgetArea(widget) != Qt::NoDockWidgetArea)
@@ -2096,8 +2304,8 @@ void MainWindow::showWakeupOrWaking(int pid, event_t wakevent)
 {
 	int activeIdx = infoWidget->getCursorIdx();
 	int inactiveIdx;
-	int wakeUpIndex;
-	int schedIndex;
+	vtl::index_t wakeUpIndex;
+	vtl::index_t schedIndex;
 
 	if (activeIdx != TShark::RED_CURSOR &&
 	    activeIdx != TShark::BLUE_CURSOR) {
@@ -2152,7 +2360,7 @@ void MainWindow::showWakeupOrWaking(int pid, event_t wakevent)
 		 * If a filter is enabled we need to try to find the index in
 		 * analyzer->filteredEvents
 		 */
-		int filterIndex;
+		vtl::index_t filterIndex;
 		if (analyzer->findFilteredEvent(wakeUpIndex, &filterIndex)
 		    != nullptr)
 			eventsWidget->scrollTo(filterIndex);
@@ -2187,36 +2395,20 @@ void MainWindow::showWakeupOrWaking(int pid, event_t wakevent)
 		tracePlot->replot();
 		return;
 	}
-	QCPGraph *qcpGraph = cpuTask->graph->getQCPGraph();
-	if (qcpGraph == nullptr) {
-		tracePlot->replot();
-		return;
-	}
 
 	/* Finally, mark the potential wakeup task as selected */
-	int count = qcpGraph->dataCount();
-	if (count > 0)
-		count--;
-	QCPDataRange wholeRange(0,  count);
-	QCPDataSelection wholeSelection(wholeRange);
-	qcpGraph->setSelection(wholeSelection);
+	cpuTask->graph->select();
 	tracePlot->replot();
 
 	/* Finally update the TaskToolBar to reflect the change in selection */
-	TaskGraph *graph = TaskGraph::fromQCPGraph(qcpGraph);
-	if (graph == nullptr) {
-		taskToolBar->removeTaskGraph();
-		setTaskActionsEnabled(false);
-		return;
-	}
-	taskToolBar->setTaskGraph(graph);
+	taskToolBar->setTaskGraph(cpuTask->graph);
 	setTaskActionsEnabled(true);
 }
 
 void MainWindow::showWaking(const TraceEvent *wakeupevent)
 {
 	int activeIdx = infoWidget->getCursorIdx();
-	int wakingIndex;
+	vtl::index_t wakingIndex;
 
 	if (activeIdx != TShark::RED_CURSOR &&
 	    activeIdx != TShark::BLUE_CURSOR) {
@@ -2245,7 +2437,7 @@ void MainWindow::showWaking(const TraceEvent *wakeupevent)
 		 * If a filter is enabled we need to try to find the index in
 		 * analyzer->filteredEvents
 		 */
-		int filterIndex;
+		vtl::index_t filterIndex;
 		if (analyzer->findFilteredEvent(wakingIndex, &filterIndex)
 		    != nullptr)
 			eventsWidget->scrollTo(filterIndex);
@@ -2277,29 +2469,13 @@ void MainWindow::showWaking(const TraceEvent *wakeupevent)
 		tracePlot->replot();
 		return;
 	}
-	QCPGraph *qcpGraph = cpuTask->graph->getQCPGraph();
-	if (qcpGraph == nullptr) {
-		tracePlot->replot();
-		return;
-	}
 
 	/* Finally, mark the potential wakeup task as selected */
-	int count = qcpGraph->dataCount();
-	if (count > 0)
-		count--;
-	QCPDataRange wholeRange(0,  count);
-	QCPDataSelection wholeSelection(wholeRange);
-	qcpGraph->setSelection(wholeSelection);
+	cpuTask->graph->select();
 	tracePlot->replot();
 
 	/* Finally update the TaskToolBar to reflect the change in selection */
-	TaskGraph *graph = TaskGraph::fromQCPGraph(qcpGraph);
-	if (graph == nullptr) {
-		taskToolBar->removeTaskGraph();
-		setTaskActionsEnabled(false);
-		return;
-	}
-	taskToolBar->setTaskGraph(graph);
+	taskToolBar->setTaskGraph(cpuTask->graph);
 	setTaskActionsEnabled(true);
 }
 
@@ -2358,7 +2534,7 @@ void MainWindow::findSleepTriggered()
 {
 	int activeIdx = infoWidget->getCursorIdx();
 	int pid = taskToolBar->getPid();
-	int schedIndex;
+	vtl::index_t schedIndex;
 
 	if (pid == 0)
 		return;
@@ -2396,7 +2572,7 @@ void MainWindow::findSleepTriggered()
 		 * If a filter is enabled we need to try to find the index in
 		 * analyzer->filteredEvents
 		 */
-		int filterIndex;
+		vtl::index_t filterIndex;
 		if (analyzer->findFilteredEvent(schedIndex, &filterIndex)
 		    != nullptr)
 			eventsWidget->scrollTo(filterIndex);
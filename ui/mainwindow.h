@@ -75,11 +75,17 @@ QT_END_NAMESPACE
 class TraceAnalyzer;
 class EventsWidget;
 class InfoWidget;
+class MemoryWidget;
+class MemReport;
+class AffineGraph;
 class Cursor;
 class CPUTask;
+class CPUTimeline;
 class ErrorDialog;
 class GraphEnableDialog;
 class LicenseDialog;
+class MigrationGraph;
+class MigrationLine;
 class EventInfoDialog;
 class QCPAbstractPlottable;
 class QCPGraph;
@@ -91,6 +97,7 @@ class TaskToolBar;
 class TracePlot;
 class TraceEvent;
 class TaskRangeAllocator;
+class TileCache;
 class TaskSelectDialog;
 class EventSelectDialog;
 class YAxisTicker;
@@ -103,6 +110,7 @@ public:
 	MainWindow();
 	virtual ~MainWindow();
 	void openFile(const QString &name);
+	void setPrintMemReport(bool print);
 protected:
 	void closeEvent(QCloseEvent *event);
 
@@ -116,6 +124,8 @@ private slots:
 	void mouseWheel();
 	void mousePress();
 	void plotDoubleClicked(QMouseEvent *event);
+	void plotMouseMoved(QMouseEvent *event);
+	void tilesReady();
 	void infoValueChanged(vtl::Time value, int nr);
 	void moveActiveCursor(vtl::Time time);
 	void showEventInfo(const TraceEvent &event);
@@ -141,12 +151,17 @@ private slots:
 	void resetEventFilter();
 	void resetFilters();
 	void timeFilter();
+	void argFilter();
+	void prepareSearch();
+	void searchEvents(const QString &text, int match);
 	void exportEvents(TraceAnalyzer::exporttype_t export_type);
 	void exportEventsTriggered();
 	void exportCPUTriggered();
 	void consumeSettings();
 	void showStats();
 	void showStatsTimeLimited();
+	void showMemory();
+	void updateMemory();
 	void removeQDockWidget(QDockWidget *widget);
 	void taskFilter();
 
@@ -175,15 +190,19 @@ private:
 	void rescaleTrace();
 	void clearPlot();
 	void showTrace();
+	void relayoutTrace();
+	void setupYAxis();
+	void updateGraphs();
 	void setupCursors();
 	void setupSettings();
 	void updateResetFiltersEnabled();
 
-	void addSchedGraph(CPUTask &task);
-	void addHorizontalWakeupGraph(CPUTask &task);
-	void addWakeupGraph(CPUTask &task);
-	void addPreemptedGraph(CPUTask &task);
-	void addStillRunningGraph(CPUTask &task);
+	void addCPUTimeline(unsigned int cpu);
+	void updateCPUTimelines();
+	int wakeupFlags();
+	AffineGraph *addCPUIdleGraph(unsigned int cpu);
+	AffineGraph *addCPUFreqGraph(unsigned int cpu);
+	void removeGraphs(QVector<AffineGraph*> &graphs);
 
 	void setTraceActionsEnabled(bool e);
 	void setTaskActionsEnabled(bool e);
@@ -195,15 +214,20 @@ private:
 	void handleWakeUpChanged(bool selected);
 
 	void checkStatsTimeLimited();
+	bool checkMemory(const QString &name);
+	void memReport(MemReport &report) const;
 
 	TracePlot *tracePlot;
 	YAxisTicker *yaxisTicker;
 	TaskRangeAllocator *taskRangeAllocator;
+	TileCache *tileCache;
 	QCPLayer *cursorLayer;
 	QWidget *plotWidget;
 	QVBoxLayout *plotLayout;
 	EventsWidget *eventsWidget;
 	InfoWidget *infoWidget;
+	MemoryWidget *memoryWidget;
+	bool printMemReport;
 	QString traceFile;
 
 	void createActions();
@@ -235,12 +259,14 @@ private:
 	QAction *showTasksAction;
 	QAction *showEventsAction;
 	QAction *timeFilterAction;
+	QAction *argFilterAction;
 	QAction *graphEnableAction;
 	QAction *resetFiltersAction;
 	QAction *exportEventsAction;
 	QAction *exportCPUAction;
 	QAction *showStatsAction;
 	QAction *showStatsTimeLimitedAction;
+	QAction *showMemoryAction;
 	QAction *aboutAction;
 	QAction *licenseAction;
 	QAction *aboutQtAction;
@@ -287,8 +313,14 @@ private:
 	QVector<double> ticks;
 	QVector<QString> tickLabels;
 	Cursor *cursors[TShark::NR_CURSORS];
+	QVector<CPUTimeline*> cpuTimelines;
+	QVector<AffineGraph*> cpuIdleGraphs;
+	QVector<AffineGraph*> cpuFreqGraphs;
+	QVector<MigrationLine*> migrationLines;
+	MigrationGraph *migrationGraph;
 	Setting settings[Setting::NR_SETTINGS];
 	bool filterActive;
+	QString argFilterText;
 	double cursorPos[TShark::NR_CURSORS];
 };
 
@@ -0,0 +1,126 @@
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2018  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QPushButton>
+#include <QTableWidget>
+#include <QTableWidgetItem>
+#include <QVBoxLayout>
+#include <QWidget>
+
+#include "misc/traceshark.h"
+#include "mm/memreport.h"
+#include "ui/memorywidget.h"
+
+#define MEMORYWIDGET_NR_COLUMNS (3)
+
+MemoryWidget::MemoryWidget(QWidget *parent):
+	QDockWidget(tr("Memory"), parent)
+{
+	QWidget *widget = new QWidget(this);
+	QVBoxLayout *mainLayout = new QVBoxLayout(widget);
+	QHBoxLayout *buttonLayout = new QHBoxLayout();
+	QStringList labels;
+
+	setWidget(widget);
+
+	table = new QTableWidget(0, MEMORYWIDGET_NR_COLUMNS, widget);
+	labels << tr("Subsystem") << tr("Reserved") << tr("Used");
+	table->setHorizontalHeaderLabels(labels);
+	table->verticalHeader()->hide();
+	table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+	table->setSelectionMode(QAbstractItemView::NoSelection);
+	mainLayout->addWidget(table);
+	mainLayout->addLayout(buttonLayout);
+
+	QPushButton *refreshButton = new QPushButton(tr("Refresh"));
+	buttonLayout->addStretch();
+	buttonLayout->addWidget(refreshButton);
+
+	sigconnect(refreshButton, clicked(), this, refreshRequested());
+}
+
+MemoryWidget::~MemoryWidget()
+{
+}
+
+void MemoryWidget::setRow(int row, const QString &name, quint64 reserved,
+			  quint64 used)
+{
+	QTableWidgetItem *item;
+
+	table->setItem(row, 0, new QTableWidgetItem(name));
+	item = new QTableWidgetItem(MemReport::formatBytes(reserved));
+	item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+	table->setItem(row, 1, item);
+	item = new QTableWidgetItem(MemReport::formatBytes(used));
+	item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+	table->setItem(row, 2, item);
+}
+
+void MemoryWidget::setReport(const MemReport &report)
+{
+	vtl::MemUsage sum = report.total();
+	int i;
+
+	table->setRowCount(report.size() + 1);
+	for (i = 0; i < report.size(); i++)
+		setRow(i, report.name(i), report.usage(i).reserved,
+		       report.usage(i).used);
+	setRow(report.size(), tr("Total"), sum.reserved, sum.used);
+	table->resizeColumnsToContents();
+}
+
+void MemoryWidget::clear()
+{
+	table->setRowCount(0);
+}
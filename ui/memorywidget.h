@@ -1,6 +1,6 @@
 /*
  * Traceshark - a visualizer for visualizing ftrace and perf traces
- * Copyright (C) 2015, 2016  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ * Copyright (C) 2018  Viktor Rosendahl <viktor.rosendahl@gmail.com>
  *
  * This file is dual licensed: you can use it either under the terms of
  * the GPL, or the BSD license, at your option.
@@ -49,16 +49,32 @@
  *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
-#include "ui/migrationarrow.h"
+#ifndef MEMORYWIDGET_H
+#define MEMORYWIDGET_H
 
-MigrationArrow::MigrationArrow(double start, double end, double time,
-			       const QColor &color, QCustomPlot *parent):
-	QCPItemLine(parent)
+#include <QDockWidget>
+
+QT_BEGIN_NAMESPACE
+class QTableWidget;
+QT_END_NAMESPACE
+
+class MemReport;
+
+/* Shows the reserved and used memory of each subsystem, see MemReport */
+class MemoryWidget : public QDockWidget
 {
-	QPen pen;
-	QCPItemLine::start->setCoords(time, start);
-	QCPItemLine::end->setCoords(time, end);
-	pen.setColor(color);
-	setPen(pen);
-	setHead(QCPLineEnding::esFlatArrow);
-}
+	Q_OBJECT
+public:
+	MemoryWidget(QWidget *parent = 0);
+	virtual ~MemoryWidget();
+	void setReport(const MemReport &report);
+	void clear();
+signals:
+	void refreshRequested();
+private:
+	void setRow(int row, const QString &name, quint64 reserved,
+		    quint64 used);
+	QTableWidget *table;
+};
+
+#endif /* MEMORYWIDGET_H */
@@ -0,0 +1,207 @@
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2018  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cmath>
+
+#include "analyzer/traceanalyzer.h"
+#include "ui/migrationgraph.h"
+
+MigrationGraph::MigrationGraph(QCPAxis *keyAxis, QCPAxis *valueAxis,
+			       const TraceAnalyzer *a):
+	QCPAbstractPlottable(keyAxis, valueAxis), analyzer(a),
+	migrations(&a->migrations), head(QCPLineEnding::esFlatArrow),
+	bandColor(Qt::darkGray)
+{
+	setSelectable(QCP::stNone);
+	setPen(QPen());
+	setBrush(Qt::NoBrush);
+}
+
+void MigrationGraph::drawArrows(QCPPainter *painter, int first, int last)
+{
+	QCPAxis *keyAxis = mKeyAxis.data();
+	const double *t = migrations->timev.constData();
+	const int *pid = migrations->pidv.constData();
+	const int *oldcpu = migrations->oldcpuv.constData();
+	const int *newcpu = migrations->newcpuv.constData();
+	QPen pen = mPen;
+	double x;
+	int i;
+
+	painter->setBrush(Qt::SolidPattern);
+	for (i = first; i < last; i++) {
+		x = keyAxis->coordToPixel(t[i]);
+		QCPVector2D s(x, laneToPixel(migrations->lane(oldcpu[i])));
+		QCPVector2D e(x, laneToPixel(migrations->lane(newcpu[i])));
+		if (qFuzzyIsNull((s - e).lengthSquared()))
+			continue;
+		pen.setColor(analyzer->getTaskColor(pid[i]));
+		painter->setPen(pen);
+		painter->drawLine(QLineF(s.toPointF(), e.toPointF()));
+		head.draw(painter, e, e - s);
+	}
+}
+
+/*
+ * The buckets of the level are at most one pixel wide, so they are merged
+ * into pixel columns, which are shaded according to the logarithm of the
+ * number of migrations in them.
+ */
+void MigrationGraph::drawBands(QCPPainter *painter, int level,
+			       const QCPRange &range)
+{
+	QCPAxis *keyAxis = mKeyAxis.data();
+	const QVector<MigrationBucket> &buckets = migrations->lod.level(level);
+	int s = buckets.size();
+	int maxCount = 1;
+	double y0, y1, alpha;
+	QColor color;
+	int i, x;
+
+	columns.resize(0);
+	for (i = migrations->lod.findBucket(level, range.lower); i < s; i++) {
+		const MigrationBucket &b = buckets[i];
+		if (b.key > range.upper)
+			break;
+		x = (int) keyAxis->coordToPixel(b.key);
+		if (!columns.isEmpty() && columns.last().index == x) {
+			columns.last().merge(b);
+		} else {
+			columns.append(b);
+			columns.last().index = x;
+		}
+		maxCount = TSMAX(maxCount, columns.last().count);
+	}
+
+	painter->setPen(Qt::NoPen);
+	for (i = 0; i < columns.size(); i++) {
+		const MigrationBucket &c = columns[i];
+		alpha = maxCount > 1 ? log(c.count) / log(maxCount) : 1;
+		color = bandColor;
+		color.setAlphaF(0.25 + 0.75 * alpha);
+		y0 = laneToPixel(c.lowLane);
+		y1 = laneToPixel(c.highLane);
+		painter->setBrush(color);
+		painter->drawRect(QRectF(c.index, TSMIN(y0, y1), 1,
+					 TSMAX(qAbs(y1 - y0), 1.0)));
+	}
+}
+
+void MigrationGraph::draw(QCPPainter *painter)
+{
+	QCPAxis *keyAxis = mKeyAxis.data();
+	QCPRange range;
+	int first, last, width, level;
+
+	if (!mKeyAxis || !mValueAxis || migrations->size() == 0)
+		return;
+
+	range = keyAxis->range();
+	width = keyAxis->axisRect()->width();
+	first = migrations->lowerBound(range.lower);
+	last = migrations->lowerBound(range.upper);
+	if (first >= last)
+		return;
+
+	applyDefaultAntialiasingHint(painter);
+	if (last - first > width) {
+		level = migrations->lod.findLevel(range.size(), width);
+		if (level >= 0) {
+			drawBands(painter, level, range);
+			return;
+		}
+	}
+	drawArrows(painter, first, last);
+}
+
+void MigrationGraph::drawLegendIcon(QCPPainter *painter, const QRectF &rect)
+	const
+{
+	double x = rect.center().x();
+
+	painter->setPen(mPen);
+	painter->drawLine(QLineF(x, rect.bottom(), x, rect.top()));
+}
+
+double MigrationGraph::selectTest(const QPointF & /* pos */,
+				  bool /* onlySelectable */,
+				  QVariant * /* details */) const
+{
+	return -1;
+}
+
+QCPRange MigrationGraph::getKeyRange(bool &foundRange,
+				     QCP::SignDomain inSignDomain) const
+{
+	QCPRange range;
+
+	foundRange = migrations->size() > 0;
+	if (!foundRange)
+		return range;
+	range = QCPRange(migrations->timev.first(), migrations->timev.last());
+	if (inSignDomain == QCP::sdPositive && range.upper <= 0)
+		foundRange = false;
+	else if (inSignDomain == QCP::sdNegative && range.lower >= 0)
+		foundRange = false;
+	return range;
+}
+
+QCPRange MigrationGraph::getValueRange(bool &foundRange,
+				       QCP::SignDomain /* inSignDomain */,
+				       const QCPRange & /* inKeyRange */) const
+{
+	double a = migrations->offset;
+	double b = a + migrations->lane(analyzer->getMaxCPU()) *
+		migrations->unit;
+
+	foundRange = migrations->size() > 0;
+	return QCPRange(TSMIN(a, b), TSMAX(a, b));
+}
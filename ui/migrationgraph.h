@@ -0,0 +1,109 @@
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2018  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef MIGRATIONGRAPH_H
+#define MIGRATIONGRAPH_H
+
+#include <QColor>
+#include <QVector>
+#include "qcustomplot/qcustomplot.h"
+#include "analyzer/migration.h"
+#include "misc/traceshark.h"
+
+class TraceAnalyzer;
+
+/*
+ * A plottable that draws all migrations, forks and exits of a trace. Only the
+ * migrations in the visible key range are visited. When there are more of
+ * them than there are pixels, they are drawn as density bands from the
+ * levels of the MigrationList, so that the cost of a replot depends on the
+ * width of the plot rather than on the number of migrations. The key axis is
+ * assumed to be horizontal.
+ */
+class MigrationGraph : public QCPAbstractPlottable
+{
+	Q_OBJECT
+public:
+	MigrationGraph(QCPAxis *keyAxis, QCPAxis *valueAxis,
+		       const TraceAnalyzer *analyzer);
+	virtual double selectTest(const QPointF &pos, bool onlySelectable,
+				  QVariant *details = 0) const
+		Q_DECL_OVERRIDE;
+	virtual QCPRange getKeyRange(bool &foundRange,
+				     QCP::SignDomain inSignDomain =
+				     QCP::sdBoth) const Q_DECL_OVERRIDE;
+	virtual QCPRange getValueRange(bool &foundRange,
+				       QCP::SignDomain inSignDomain =
+				       QCP::sdBoth,
+				       const QCPRange &inKeyRange = QCPRange())
+		const Q_DECL_OVERRIDE;
+protected:
+	virtual void draw(QCPPainter *painter) Q_DECL_OVERRIDE;
+	virtual void drawLegendIcon(QCPPainter *painter, const QRectF &rect)
+		const Q_DECL_OVERRIDE;
+private:
+	__always_inline double laneToPixel(int lane) const;
+	void drawArrows(QCPPainter *painter, int first, int last);
+	void drawBands(QCPPainter *painter, int level, const QCPRange &range);
+	const TraceAnalyzer *analyzer;
+	const MigrationList *migrations;
+	QCPLineEnding head;
+	QColor bandColor;
+	QVector<MigrationBucket> columns;
+};
+
+__always_inline double MigrationGraph::laneToPixel(int lane) const
+{
+	return mValueAxis.data()->coordToPixel(migrations->offset +
+					       lane * migrations->unit);
+}
+
+#endif /* MIGRATIONGRAPH_H */
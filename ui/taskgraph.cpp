@@ -50,41 +50,55 @@
  */
 
 #include "qcustomplot/qcustomplot.h"
+#include "ui/affinegraph.h"
+#include "ui/cputimeline.h"
 #include "ui/taskgraph.h"
+#include "analyzer/cputask.h"
 #include "analyzer/task.h"
 
 QMap<QCPGraph *, TaskGraph *> TaskGraph::graphDir;
 
 TaskGraph::TaskGraph(QCustomPlot *parent):
-	plot(parent), task(nullptr), taskGraph(nullptr)
+	plot(parent), task(nullptr), taskGraph(nullptr), timeline(nullptr),
+	timelineIndex(-1), legendGraph(nullptr)
 {
-	graph = parent->addGraph(parent->xAxis, parent->yAxis);
+	graph = new AffineGraph(parent->xAxis, parent->yAxis);
 	graphDir[graph] = this;
 	graph->setAdaptiveSampling(true);
 	graph->setLineStyle(QCPGraph::lsStepLeft);
-	legendGraph = parent->addGraph(parent->xAxis, parent->yAxis);
-	graphDir[legendGraph] = this;
 }
 
+TaskGraph::TaskGraph(QCustomPlot *parent, CPUTimeline *cpuTimeline,
+		     int index):
+	plot(parent), task(nullptr), taskGraph(nullptr), graph(nullptr),
+	timeline(cpuTimeline), timelineIndex(index), legendGraph(nullptr)
+{}
+
 TaskGraph::~TaskGraph()
 {
 }
 
 void TaskGraph::destroy()
 {
-	plot->removeGraph(graph);
-	plot->removeGraph(legendGraph);
-	graphDir.remove(graph);
-	graphDir.remove(legendGraph);
+	if (graph != nullptr) {
+		plot->removeGraph(graph);
+		graphDir.remove(graph);
+	}
+	if (legendGraph != nullptr) {
+		plot->removeGraph(legendGraph);
+		graphDir.remove(legendGraph);
+	}
 	delete this;
 }
 
 void TaskGraph::setTask(Task *newTask)
 {
-	QString name = *newTask->displayName;
+	name = *newTask->displayName;
 	name += QString(":") + QString::number(newTask->pid);
-	graph->setName(name);
-	legendGraph->setName(name);
+	if (graph != nullptr)
+		graph->setName(name);
+	if (legendGraph != nullptr)
+		legendGraph->setName(name);
 	task = newTask;
 }	
 
@@ -95,20 +109,30 @@ Task *TaskGraph::getTask()
 
 void TaskGraph::setPen(const QPen &pen)
 {
-	graph->setPen(pen);
+	if (graph != nullptr)
+		graph->setPen(pen);
 
-	QPen legendPen(pen);
+	legendPen = pen;
 	legendPen.setWidth(5);
-	legendGraph->setPen(legendPen);
+	if (legendGraph != nullptr)
+		legendGraph->setPen(legendPen);
 }
 
 bool TaskGraph::addToLegend()
 {
+	if (legendGraph == nullptr) {
+		legendGraph = plot->addGraph(plot->xAxis, plot->yAxis);
+		graphDir[legendGraph] = this;
+		legendGraph->setName(name);
+		legendGraph->setPen(legendPen);
+	}
 	return legendGraph->addToLegend();
 }
 
 bool TaskGraph::removeFromLegend() const
 {
+	if (legendGraph == nullptr)
+		return false;
 	return legendGraph->removeFromLegend();
 }
 
@@ -122,11 +146,50 @@ void TaskGraph::setTaskGraphForLegend(TaskGraph *legendTaskGraph)
 	taskGraph = legendTaskGraph;
 }
 
-void TaskGraph::setData(const QVector<double > &keys,
-			const QVector<double> &values,
-			bool alreadySorted)
+void TaskGraph::setData(const ArenaVector<double> &keys,
+			const vtl::BitVector &bits)
+{
+	if (graph != nullptr)
+		graph->setBitData(keys, bits, FLOOR_HEIGHT, SCHED_HEIGHT);
+}
+
+void TaskGraph::setTransform(const double *offset, const double *scale)
+{
+	if (graph != nullptr)
+		graph->setTransform(offset, scale);
+}
+
+void TaskGraph::setLod(const LodPyramid<LodBucket> *lod)
+{
+	if (graph != nullptr)
+		graph->setLod(lod);
+}
+
+bool TaskGraph::isSelected() const
 {
-	graph->setData(keys, values, alreadySorted);
+	if (graph != nullptr)
+		return graph->selected();
+	return timeline->selected() &&
+		timeline->selectedIndex() == timelineIndex;
+}
+
+void TaskGraph::select()
+{
+	int end;
+
+	if (graph == nullptr) {
+		timeline->selectTask(timelineIndex);
+		return;
+	}
+	end = graph->dataCount() - 1;
+	if (end < 0)
+		return;
+	graph->setSelection(QCPDataSelection(QCPDataRange(0, end)));
+}
+
+QCustomPlot *TaskGraph::getPlot()
+{
+	return plot;
 }
 
 TaskGraph *TaskGraph::fromQCPGraph(QCPGraph *g)
@@ -137,12 +200,32 @@ TaskGraph *TaskGraph::fromQCPGraph(QCPGraph *g)
 	return i.value();
 }
 
-void TaskGraph::clearMap()
+/*
+ * The data index is only used with a CPUTimeline, where it is the index of
+ * the task.
+ */
+TaskGraph *TaskGraph::fromPlottable(QCPAbstractPlottable *plottable,
+				    int dataIndex)
 {
-	graphDir.clear();
+	CPUTimeline *cpuTimeline;
+	QCPGraph *g;
+	CPUTask *cpuTask;
+
+	cpuTimeline = qobject_cast<CPUTimeline *>(plottable);
+	if (cpuTimeline != nullptr) {
+		cpuTask = cpuTimeline->taskAt(dataIndex);
+		if (cpuTask == nullptr)
+			return nullptr;
+		return cpuTask->graph;
+	}
+
+	g = qobject_cast<QCPGraph *>(plottable);
+	if (g == nullptr)
+		return nullptr;
+	return fromQCPGraph(g);
 }
 
-QCPGraph *TaskGraph::getQCPGraph()
+void TaskGraph::clearMap()
 {
-	return graph;
+	graphDir.clear();
 }
@@ -52,19 +52,36 @@
 #ifndef TASKGRAPH_H
 #define TASKGRAPH_H
 
+#include <QPen>
 #include <QString>
 #include <QVector>
 #include <QMap>
 
-class LegendGraph;
+class AffineGraph;
+class CPUTimeline;
+class LodBucket;
+template<class Bucket> class LodPyramid;
 class Task;
 class QCustomPlot;
+class QCPAbstractPlottable;
 class QCPGraph;
+template<class T> class ArenaVector;
 
+namespace vtl {
+	class BitVector;
+}
+
+/*
+ * A TaskGraph is either a unified graph of a task, which has an AffineGraph
+ * of its own, or a per CPU graph, which is drawn by the CPUTimeline of the
+ * CPU. In both cases the QCPGraph that is used for the legend is only
+ * created when the task is added to the legend.
+ */
 class TaskGraph
 {
 public:
 	TaskGraph(QCustomPlot *parent);
+	TaskGraph(QCustomPlot *parent, CPUTimeline *cpuTimeline, int index);
 	virtual ~TaskGraph();
 	void destroy();
 	void setTask(Task *newTask);
@@ -74,18 +91,27 @@ public:
 	void setPen(const QPen &pen);
 	bool addToLegend();
 	bool removeFromLegend() const;
-	void setData(const QVector<double > &keys,
-		     const QVector<double> &values,
-		     bool alreadySorted = false);
+	void setData(const ArenaVector<double> &keys,
+		     const vtl::BitVector &bits);
+	void setTransform(const double *offset, const double *scale);
+	void setLod(const LodPyramid<LodBucket> *lod);
+	bool isSelected() const;
+	void select();
+	QCustomPlot *getPlot();
 	static TaskGraph *fromQCPGraph(QCPGraph *g);
+	static TaskGraph *fromPlottable(QCPAbstractPlottable *plottable,
+					int dataIndex);
 	static void clearMap();
-	QCPGraph *getQCPGraph();
 private:
 	QCustomPlot *plot;
 	Task *task;
 	TaskGraph *taskGraph;
-	QCPGraph *graph;
+	AffineGraph *graph;
+	CPUTimeline *timeline;
+	int timelineIndex;
 	QCPGraph *legendGraph;
+	QPen legendPen;
+	QString name;
 	static QMap<QCPGraph *, TaskGraph *> graphDir;
 };
 
@@ -140,7 +140,6 @@ void TaskToolBar::addCurrentTaskToLegend()
 
 void TaskToolBar::addTaskGraphToLegend(TaskGraph *graph)
 {
-	QObject *obj;
 	QCustomPlot *plot;
 	Task *task;
 
@@ -161,8 +160,7 @@ void TaskToolBar::addTaskGraphToLegend(TaskGraph *graph)
 
 	legendPidMap[task->pid] = graph;
 	graph->addToLegend();
-	obj = graph->getQCPGraph()->parent();
-	plot = qobject_cast<QCustomPlot *>(obj);
+	plot = graph->getPlot();
 	if (plot != nullptr)
 		plot->replot();
 }
@@ -171,15 +169,12 @@ void TaskToolBar::addTaskGraphToLegend(TaskGraph *graph)
 void TaskToolBar::clearLegend()
 {
 	QCustomPlot *plot = nullptr;
-	QObject *obj;
 	DEFINE_PIDMAP_ITERATOR(iter) = legendPidMap.begin();
 	while(iter != legendPidMap.end()) {
 		TaskGraph *&graph = iter.value();
 		graph->removeFromLegend();
-		if (plot == nullptr) {
-			obj = graph->getQCPGraph()->parent();
-			plot = qobject_cast<QCustomPlot *>(obj);
-		}
+		if (plot == nullptr)
+			plot = graph->getPlot();
 		iter++;
 	}
 	if (plot != nullptr)
@@ -191,7 +186,7 @@ bool TaskToolBar::checkGraphSelection()
 {
 	if (taskGraph == nullptr)
 		return false;
-	if (taskGraph->getQCPGraph()->selected())
+	if (taskGraph->isSelected())
 		return false;
 	removeTaskGraph();
 	return true;
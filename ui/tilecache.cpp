@@ -0,0 +1,241 @@
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2018  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "qcustomplot/qcustomplot.h"
+#include "analyzer/abstracttask.h"
+#include "analyzer/traceanalyzer.h"
+#include "ui/tilecache.h"
+#include "ui/timelinepainter.h"
+
+TileJob::TileJob(TileCache *c, const TileKey &k, const TileSource &s):
+	cache(c), key(k), source(s), item(this, &TileJob::render)
+{}
+
+bool TileJob::render()
+{
+	double kpp = key.keysPerPixel();
+	double start = key.start();
+	double ppv = key.height / (FULL_HEIGHT - FLOOR_HEIGHT);
+
+	/* The cache may have been cleared while we were queued */
+	if (cache->cancelled.loadAcquire() == 0) {
+		image = QImage(TILE_WIDTH, key.height + 2 * TILE_MARGIN,
+			       QImage::Format_ARGB32_Premultiplied);
+		image.fill(Qt::transparent);
+		QCPPainter painter(&image);
+		TimelinePainter tp(&painter);
+		tp.setKeyMapping(start - TILE_OVERLAP * kpp,
+				 start + (TILE_WIDTH + TILE_OVERLAP) * kpp,
+				 -TILE_OVERLAP, 1 / kpp);
+		tp.setValueMapping(TILE_MARGIN + FULL_HEIGHT * ppv, ppv);
+		tp.setAntialiasing(source.antialiasedLines,
+				   source.antialiasedScatters);
+		tp.drawTasks(source.tasks, source.colors, source.maxWakeDelay,
+			     source.wakeupFlags);
+		painter.end();
+	}
+	/* This must be the last use of this object */
+	cache->jobDone(this);
+	return false; /* No error */
+}
+
+TileCache::TileCache(QObject *parent):
+	QObject(parent), stamp(0), bytes(0), collectQueued(false),
+	cancelled(0)
+{}
+
+TileCache::~TileCache()
+{
+	clear();
+}
+
+/* Returns the level whose pixels are at most keysPerPixel wide */
+int TileCache::findLevel(double keysPerPixel)
+{
+	int exp;
+
+	frexp(keysPerPixel, &exp);
+	return exp - 1;
+}
+
+const QImage *TileCache::find(const TileKey &key)
+{
+	QHash<TileKey, Entry>::iterator iter = tiles.find(key);
+
+	if (iter == tiles.end())
+		return nullptr;
+
+	Entry &entry = iter.value();
+	lru.remove(entry.stamp);
+	entry.stamp = stamp++;
+	lru.insert(entry.stamp, key);
+	return &entry.image;
+}
+
+void TileCache::request(const TileKey &key, const TileSource &source)
+{
+	TileJob *job;
+
+	if (pending.contains(key) || tiles.contains(key))
+		return;
+	/*
+	 * When zooming quickly, most requested tiles will be out of view
+	 * before they are ready, so there is no point in queuing many of them.
+	 * The ones that are still needed will be requested again at the next
+	 * replot.
+	 */
+	if (pending.size() >= TILE_MAX_PENDING)
+		return;
+
+	pending.insert(key);
+	job = new TileJob(this, key, source);
+	group.run(&job->item);
+}
+
+void TileCache::insert(const TileKey &key, const QImage &image)
+{
+	Entry entry;
+	QMap<qint64, TileKey>::iterator oldest;
+
+	entry.image = image;
+	entry.stamp = stamp++;
+	tiles.insert(key, entry);
+	lru.insert(entry.stamp, key);
+	bytes += image.byteCount();
+
+	while (bytes > TILE_CACHE_BYTES && lru.size() > 1) {
+		oldest = lru.begin();
+		QHash<TileKey, Entry>::iterator iter =
+			tiles.find(oldest.value());
+		bytes -= iter.value().image.byteCount();
+		tiles.erase(iter);
+		lru.erase(oldest);
+	}
+}
+
+/* Called by the pool threads */
+void TileCache::jobDone(TileJob *job)
+{
+	bool queue;
+
+	doneMutex.lock();
+	doneJobs.append(job);
+	queue = !collectQueued;
+	collectQueued = true;
+	doneMutex.unlock();
+
+	if (queue)
+		QMetaObject::invokeMethod(this, "collectTiles",
+					  Qt::QueuedConnection);
+}
+
+void TileCache::collectTiles()
+{
+	QList<TileJob*> jobs;
+	int i;
+
+	doneMutex.lock();
+	jobs.swap(doneJobs);
+	collectQueued = false;
+	doneMutex.unlock();
+
+	if (jobs.isEmpty())
+		return;
+
+	for (i = 0; i < jobs.size(); i++) {
+		TileJob *job = jobs[i];
+		pending.remove(job->key);
+		if (!job->image.isNull())
+			insert(job->key, job->image);
+		delete job;
+	}
+	emit tilesReady();
+}
+
+void TileCache::deleteDoneJobs()
+{
+	QList<TileJob*> jobs;
+	int i;
+
+	doneMutex.lock();
+	jobs.swap(doneJobs);
+	doneMutex.unlock();
+
+	for (i = 0; i < jobs.size(); i++)
+		delete jobs[i];
+}
+
+void TileCache::clear()
+{
+	cancelled.storeRelease(1);
+	group.wait();
+	cancelled.storeRelease(0);
+
+	deleteDoneJobs();
+	tiles.clear();
+	lru.clear();
+	pending.clear();
+	bytes = 0;
+}
+
+/*
+ * The images of the tiles and the entries of the tiles and the LRU map,
+ * without the overhead of the containers. The images of the tiles that are
+ * being rendered are not included.
+ */
+vtl::MemUsage TileCache::memUsage() const
+{
+	quint64 used = bytes;
+
+	used += (quint64) tiles.size() * (sizeof(TileKey) + sizeof(Entry));
+	used += (quint64) lru.size() * (sizeof(qint64) + sizeof(TileKey));
+	return vtl::MemUsage(used, used);
+}
@@ -0,0 +1,194 @@
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2018  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TILECACHE_H
+#define TILECACHE_H
+
+#include <cmath>
+#include <QAtomicInt>
+#include <QColor>
+#include <QHash>
+#include <QImage>
+#include <QList>
+#include <QMap>
+#include <QMutex>
+#include <QObject>
+#include <QSet>
+#include <QVector>
+
+#include "threads/threadpool.h"
+#include "threads/workitem.h"
+#include "misc/traceshark.h"
+#include "vtl/memusage.h"
+
+class CPUTask;
+class TileCache;
+
+/* The width of a tile in pixels */
+#define TILE_WIDTH (256)
+/* Pixels above and below the row, for the markers that stick out of it */
+#define TILE_MARGIN (4)
+/* Pixels outside of a tile that are drawn, so that edge markers are whole */
+#define TILE_OVERLAP (8)
+#define TILE_CACHE_BYTES (128 * 1024 * 1024)
+#define TILE_MAX_PENDING (512)
+/* The number of coarser levels that are searched for a placeholder tile */
+#define TILE_FALLBACK_LEVELS (6)
+
+/*
+ * Identifies a tile. At level l a pixel is 2^l seconds wide, so the tiles of
+ * a level do not depend on the position of the plot and panning only needs
+ * the tiles at the new edge to be rendered.
+ */
+class TileKey {
+public:
+	TileKey(): row(0), level(0), height(0), index(0) {}
+	TileKey(int r, int l, int h, qint64 i):
+		row(r), level(l), height(h), index(i) {}
+	__always_inline bool operator==(const TileKey &other) const;
+	__always_inline double keysPerPixel() const;
+	__always_inline double start() const;
+	int row;
+	int level;
+	int height;    /* Pixels from the floor to the top of the row */
+	qint64 index;  /* The tile starts at index * TILE_WIDTH pixels */
+};
+
+/* What the tiles of a row are rendered from */
+class TileSource {
+public:
+	TileSource(): wakeupFlags(0), antialiasedLines(true),
+		antialiasedScatters(true) {}
+	QVector<CPUTask*> tasks;
+	QVector<QColor> colors;
+	QVector<double> maxWakeDelay;
+	int wakeupFlags;
+	bool antialiasedLines;
+	bool antialiasedScatters;
+};
+
+class TileJob {
+public:
+	TileJob(TileCache *c, const TileKey &k, const TileSource &s);
+	bool render();
+	TileCache *cache;
+	TileKey key;
+	TileSource source;
+	QImage image;
+	WorkItem<TileJob> item;
+};
+
+/*
+ * An LRU cache of rendered tiles. Missing tiles are rendered by the pool
+ * threads and tilesReady() is emitted in the GUI thread when some of them
+ * have been added to the cache. The tiles refer to the CPUTasks, so clear()
+ * must be called before the tasks are destroyed.
+ */
+class TileCache : public QObject {
+	Q_OBJECT
+	friend class TileJob;
+public:
+	TileCache(QObject *parent = nullptr);
+	~TileCache();
+	const QImage *find(const TileKey &key);
+	void request(const TileKey &key, const TileSource &source);
+	void clear();
+	vtl::MemUsage memUsage() const;
+	static int findLevel(double keysPerPixel);
+signals:
+	void tilesReady();
+private slots:
+	void collectTiles();
+private:
+	class Entry {
+	public:
+		QImage image;
+		qint64 stamp;
+	};
+	void jobDone(TileJob *job);
+	void insert(const TileKey &key, const QImage &image);
+	void deleteDoneJobs();
+	QHash<TileKey, Entry> tiles;
+	/* The keys by the time they were last used, the oldest first */
+	QMap<qint64, TileKey> lru;
+	QSet<TileKey> pending;
+	qint64 stamp;
+	qint64 bytes;
+	QMutex doneMutex;
+	QList<TileJob*> doneJobs;
+	bool collectQueued;
+	QAtomicInt cancelled;
+	WorkGroup group;
+};
+
+__always_inline bool TileKey::operator==(const TileKey &other) const
+{
+	return row == other.row && level == other.level &&
+		height == other.height && index == other.index;
+}
+
+__always_inline double TileKey::keysPerPixel() const
+{
+	return ldexp(1.0, level);
+}
+
+__always_inline double TileKey::start() const
+{
+	return index * TILE_WIDTH * keysPerPixel();
+}
+
+__always_inline uint qHash(const TileKey &key, uint seed = 0)
+{
+	return qHash(key.index, seed) ^ qHash(key.row * 65599 + key.level,
+					      seed) ^ qHash(key.height, seed);
+}
+
+#endif /* TILECACHE_H */
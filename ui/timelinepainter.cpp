@@ -0,0 +1,273 @@
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2018  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+#include <limits>
+
+#include "qcustomplot/qcustomplot.h"
+#include "analyzer/cputask.h"
+#include "analyzer/lodpyramid.h"
+#include "analyzer/traceanalyzer.h"
+#include "ui/timelinepainter.h"
+
+/* These match the error bars that were used for the wakeup markers */
+#define WAKEUP_WHISKER ((double) 2)
+#define WAKEUP_GAP ((double) 5)
+#define DOT_SIZE ((double) 5)
+
+TimelinePainter::TimelinePainter(QCPPainter *p):
+	painter(p), keyLower(0), keyUpper(0), xOrigin(0), keyPixels(1),
+	yOrigin(0), valuePixels(1), antialiasedLines(true),
+	antialiasedScatters(true), colX(0), colMin(0), colMax(0), colLast(0)
+{}
+
+/*
+ * The keys in [lower, upper] are drawn and lower is mapped to the pixel x0.
+ */
+void TimelinePainter::setKeyMapping(double lower, double upper, double x0,
+				    double pixelsPerKey)
+{
+	keyLower = lower;
+	keyUpper = upper;
+	xOrigin = x0;
+	keyPixels = pixelsPerKey;
+}
+
+/*
+ * The value zero is mapped to the pixel y0. The pixels grow downwards.
+ */
+void TimelinePainter::setValueMapping(double y0, double pixelsPerValue)
+{
+	yOrigin = y0;
+	valuePixels = pixelsPerValue;
+}
+
+void TimelinePainter::setAntialiasing(bool lines, bool scatters)
+{
+	antialiasedLines = lines;
+	antialiasedScatters = scatters;
+}
+
+/*
+ * All scheduling graphs are drawn first, then the markers, so that the
+ * markers of one task are never hidden by the graph of another. The task with
+ * the index skip is not drawn.
+ */
+void TimelinePainter::drawTasks(const QVector<CPUTask*> &tasks,
+				const QVector<QColor> &colors,
+				const QVector<double> &maxWakeDelay,
+				int wakeupFlags, int skip)
+{
+	QCPScatterStyle preempted(QCPScatterStyle::ssCircle, Qt::red,
+				  DOT_SIZE);
+	QCPScatterStyle running(QCPScatterStyle::ssCircle, Qt::blue,
+				DOT_SIZE);
+	int s = tasks.size();
+	int i;
+
+	painter->setAntialiasing(antialiasedLines);
+	for (i = 0; i < s; i++) {
+		if (i != skip)
+			drawSched(tasks[i], QPen(colors[i]));
+	}
+
+	if (wakeupFlags != TIMELINE_WAKEUP_NONE) {
+		painter->setAntialiasing(false);
+		for (i = 0; i < s; i++)
+			drawWakeups(tasks[i], QPen(colors[i]), wakeupFlags,
+				    maxWakeDelay[i]);
+	}
+
+	painter->setAntialiasing(antialiasedScatters);
+	preempted.applyTo(painter, QPen(Qt::red));
+	for (i = 0; i < s; i++)
+		drawDots(tasks[i]->preemptedTimev, preempted);
+	running.applyTo(painter, QPen(Qt::blue));
+	for (i = 0; i < s; i++)
+		drawDots(tasks[i]->runningTimev, running);
+}
+
+void TimelinePainter::drawSched(const CPUTask *task, const QPen &pen)
+{
+	const ArenaVector<double> &timev = task->schedTimev;
+	const double *t = timev.constData();
+	double yFloor, ySched;
+	int n, i, first, last, level, s;
+
+	if (!overlaps(timev, 0))
+		return;
+
+	yFloor = valueToPixel(FLOOR_HEIGHT);
+	ySched = valueToPixel(SCHED_HEIGHT);
+	points.resize(0);
+
+	level = task->lod.findLevel(1, keyPixels);
+	if (level >= 0) {
+		const QVector<LodBucket> &buckets = task->lod.level(level);
+		s = buckets.size();
+		for (i = task->lod.findBucket(level, keyLower); i < s; i++) {
+			const LodBucket &b = buckets[i];
+			double x = keyToPixel(b.key);
+			addStep(x, b.min > FLOOR_HEIGHT ? ySched : yFloor);
+			addStep(x, b.max > FLOOR_HEIGHT ? ySched : yFloor);
+			addStep(x, b.last > FLOOR_HEIGHT ? ySched : yFloor);
+			/* Include the first bucket to the right */
+			if (b.key > keyUpper)
+				break;
+		}
+	} else {
+		n = TSMIN(timev.size(), (int) task->schedData.size());
+		/* From the last sample to the left of the range... */
+		first = std::upper_bound(t, t + n, keyLower) - t - 1;
+		first = TSMAX(first, 0);
+		/* ...to the first sample to the right of it */
+		last = std::lower_bound(t, t + n, keyUpper) - t;
+		last = TSMIN(last, n - 1);
+		for (i = first; i <= last; i++)
+			addStep(keyToPixel(t[i]),
+				task->schedData.readbool(i) ? ySched : yFloor);
+	}
+
+	if (points.isEmpty())
+		return;
+	flushColumn();
+	painter->setPen(pen);
+	painter->setBrush(Qt::NoBrush);
+	painter->drawPolyline(points.constData(), points.size());
+}
+
+/*
+ * The horizontal markers extend to the left of the wakeup by the wakeup delay.
+ * The vertical markers are proportional to the delay, with WAKEUP_MAX
+ * corresponding to WAKEUP_SIZE.
+ */
+void TimelinePainter::drawWakeups(const CPUTask *task, const QPen &pen,
+				  int flags, double maxDelay)
+{
+	const ArenaVector<double> &timev = task->wakeTimev;
+	const ArenaVector<double> &delayv = task->wakeDelay;
+	const double *t = timev.constData();
+	bool horizontal = (flags & TIMELINE_WAKEUP_HORIZONTAL) != 0;
+	bool vertical = (flags & TIMELINE_WAKEUP_VERTICAL) != 0;
+	double margin = horizontal ? maxDelay : 0;
+	double x, y, x0, y1, delay, colDelay = 0;
+	int n, i, column, prevColumn = std::numeric_limits<int>::min();
+
+	if (!overlaps(timev, margin))
+		return;
+
+	n = TSMIN(timev.size(), delayv.size());
+	y = valueToPixel(WAKEUP_HEIGHT);
+	painter->setPen(pen);
+
+	/*
+	 * A horizontal marker ends at the wakeup time, so the markers to the
+	 * right of the range may reach into it by at most the largest delay
+	 */
+	i = std::lower_bound(t, t + n, keyLower) - t;
+	for (; i < n && t[i] <= keyUpper + margin; i++) {
+		delay = delayv[i];
+		x = keyToPixel(t[i]);
+		column = (int) x;
+		/* Only draw the longest marker of each pixel column */
+		if (column == prevColumn && delay <= colDelay)
+			continue;
+		prevColumn = column;
+		colDelay = delay;
+
+		painter->drawPoint(QPointF(x, y));
+		if (horizontal) {
+			x0 = keyToPixel(t[i] - delay);
+			if (x - WAKEUP_GAP > x0)
+				painter->drawLine(QLineF(x - WAKEUP_GAP, y,
+							 x0, y));
+			painter->drawLine(QLineF(x0, y - WAKEUP_WHISKER,
+						 x0, y + WAKEUP_WHISKER));
+			painter->drawLine(QLineF(x, y - WAKEUP_WHISKER,
+						 x, y + WAKEUP_WHISKER));
+		}
+		if (vertical) {
+			y1 = valueToPixel(WAKEUP_HEIGHT +
+					  TSMIN(WAKEUP_SIZE * delay /
+						WAKEUP_MAX, WAKEUP_SIZE));
+			if (y - WAKEUP_GAP > y1)
+				painter->drawLine(QLineF(x, y - WAKEUP_GAP,
+							 x, y1));
+			painter->drawLine(QLineF(x - WAKEUP_WHISKER, y1,
+						 x + WAKEUP_WHISKER, y1));
+			painter->drawLine(QLineF(x - WAKEUP_WHISKER, y,
+						 x + WAKEUP_WHISKER, y));
+		}
+	}
+}
+
+void TimelinePainter::drawDots(const ArenaVector<double> &timev,
+			       const QCPScatterStyle &style)
+{
+	const double *t = timev.constData();
+	double x, y;
+	int n = timev.size();
+	int i, column, prevColumn = std::numeric_limits<int>::min();
+
+	if (!overlaps(timev, 0))
+		return;
+
+	y = valueToPixel(FLOOR_HEIGHT);
+	i = std::lower_bound(t, t + n, keyLower) - t;
+	for (; i < n && t[i] <= keyUpper; i++) {
+		x = keyToPixel(t[i]);
+		column = (int) x;
+		if (column == prevColumn)
+			continue;
+		prevColumn = column;
+		style.drawShape(painter, x, y);
+	}
+}
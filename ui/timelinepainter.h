@@ -0,0 +1,171 @@
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2018  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TIMELINEPAINTER_H
+#define TIMELINEPAINTER_H
+
+#include <QColor>
+#include <QPointF>
+#include <QVector>
+#include "misc/traceshark.h"
+#include "mm/arenavector.h"
+
+class CPUTask;
+class QCPPainter;
+class QCPScatterStyle;
+class QPen;
+
+/* Flags that select the wakeup markers to draw */
+#define TIMELINE_WAKEUP_NONE (0)
+#define TIMELINE_WAKEUP_HORIZONTAL (1)
+#define TIMELINE_WAKEUP_VERTICAL (2)
+
+/*
+ * Draws the tasks of a CPU with a linear mapping from keys and from values,
+ * before the offset and scale of the tasks, to pixels. It does not use the
+ * axes, so that it can be used both for drawing onto the plot and for
+ * rendering tiles in the pool threads.
+ */
+class TimelinePainter {
+public:
+	TimelinePainter(QCPPainter *p);
+	void setKeyMapping(double lower, double upper, double x0,
+			   double pixelsPerKey);
+	void setValueMapping(double y0, double pixelsPerValue);
+	void setAntialiasing(bool lines, bool scatters);
+	void drawTasks(const QVector<CPUTask*> &tasks,
+		       const QVector<QColor> &colors,
+		       const QVector<double> &maxWakeDelay, int wakeupFlags,
+		       int skip = -1);
+	void drawSched(const CPUTask *task, const QPen &pen);
+	void drawWakeups(const CPUTask *task, const QPen &pen, int flags,
+			 double maxDelay);
+	void drawDots(const ArenaVector<double> &timev,
+		      const QCPScatterStyle &style);
+	__always_inline double keyToPixel(double key) const;
+	__always_inline double valueToPixel(double value) const;
+private:
+	__always_inline bool overlaps(const ArenaVector<double> &timev,
+				      double margin) const;
+	__always_inline void addStep(double x, double y);
+	__always_inline void flushColumn();
+	QCPPainter *painter;
+	double keyLower;
+	double keyUpper;
+	double xOrigin;
+	double keyPixels;
+	double yOrigin;
+	double valuePixels;
+	bool antialiasedLines;
+	bool antialiasedScatters;
+	/* Scratch state for building the step line of a task */
+	QVector<QPointF> points;
+	double colX;
+	double colMin;
+	double colMax;
+	double colLast;
+};
+
+__always_inline double TimelinePainter::keyToPixel(double key) const
+{
+	return xOrigin + (key - keyLower) * keyPixels;
+}
+
+__always_inline double TimelinePainter::valueToPixel(double value) const
+{
+	return yOrigin - value * valuePixels;
+}
+
+__always_inline bool TimelinePainter::overlaps(
+	const ArenaVector<double> &timev, double margin) const
+{
+	return !timev.isEmpty() && timev.first() <= keyUpper + margin &&
+		timev.last() >= keyLower;
+}
+
+/*
+ * Adds a sample to the step line in pixel coordinates. The samples that fall
+ * on the same pixel column are merged into one vertical segment, so that the
+ * number of points depends on the width of the plot rather than on the
+ * number of samples.
+ */
+__always_inline void TimelinePainter::addStep(double x, double y)
+{
+	if (points.isEmpty()) {
+		points.append(QPointF(x, y));
+	} else if ((int) x == (int) colX) {
+		colMin = TSMIN(colMin, y);
+		colMax = TSMAX(colMax, y);
+		colLast = y;
+		return;
+	} else {
+		flushColumn();
+		points.append(QPointF(x, colLast));
+		if (y != colLast)
+			points.append(QPointF(x, y));
+	}
+	colX = x;
+	colMin = y;
+	colMax = y;
+	colLast = y;
+}
+
+__always_inline void TimelinePainter::flushColumn()
+{
+	if (colMin != colMax) {
+		points.append(QPointF(colX, colMin));
+		points.append(QPointF(colX, colMax));
+	}
+	if (points.last().y() != colLast)
+		points.append(QPointF(colX, colLast));
+}
+
+#endif /* TIMELINEPAINTER_H */
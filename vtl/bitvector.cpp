@@ -75,4 +75,48 @@ void BitVector::softclear()
 	nrElements = 0;
 }
 
+/*
+ * Writes the first n elements to dst as doubles, with 0 becoming zero and 1
+ * becoming one. Consecutive elements are written stride doubles apart, so
+ * that they can be written straight into the value fields of an array of
+ * points. A whole word is handled at a time, four bits at a time are looked
+ * up in a table that holds all 16 possible four element sequences. This avoids
+ * both per bit shifts and data dependent branches.
+ */
+void BitVector::expand(double *dst, unsigned int n, unsigned int stride,
+		       double zero, double one) const
+{
+	double table[16][4];
+	const double *t;
+	unsigned int e, b, w, i;
+	unsigned int nfull;
+	word_t word;
+
+	if (n > nrElements)
+		n = nrElements;
+	nfull = n / BITVECTOR_BITS_PER_WORD;
+	for (e = 0; e < 16; e++) {
+		for (b = 0; b < 4; b++)
+			table[e][b] = ((e >> b) & 0x1) ? one : zero;
+	}
+
+	for (w = 0; w < nfull; w++) {
+		word = array[w];
+		for (b = 0; b < BITVECTOR_BITS_PER_WORD; b += 4) {
+			t = table[word & 0xf];
+			dst[0] = t[0];
+			dst[stride] = t[1];
+			dst[2 * stride] = t[2];
+			dst[3 * stride] = t[3];
+			word >>= 4;
+			dst += 4 * stride;
+		}
+	}
+
+	for (i = nfull * BITVECTOR_BITS_PER_WORD; i < n; i++) {
+		*dst = read(i) ? one : zero;
+		dst += stride;
+	}
+}
+
 }
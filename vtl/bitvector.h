@@ -59,6 +59,7 @@ namespace vtl {
 class BitVector
 {
 public:
+	typedef unsigned int word_t;
 	BitVector();
 	__always_inline bool readbool(unsigned int index) const;
 	__always_inline void appendbool(bool value);
@@ -67,9 +68,10 @@ public:
 	__always_inline unsigned int size() const;
 	void clear();
 	void softclear();
+	void expand(double *dst, unsigned int n, unsigned int stride,
+		    double zero, double one) const;
 private:
 	static const unsigned int INCREASE_NR = 1024;
-	typedef unsigned int word_t;
 	static const unsigned int BITVECTOR_BITS_PER_WORD = sizeof(word_t)
 		* 8;
 	unsigned int nrElements;
@@ -1,6 +1,6 @@
 /*
  * Traceshark - a visualizer for visualizing ftrace and perf traces
- * Copyright (C) 2014, 2015, 2016  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ * Copyright (C) 2018  Viktor Rosendahl <viktor.rosendahl@gmail.com>
  *
  * This file is dual licensed: you can use it either under the terms of
  * the GPL, or the BSD license, at your option.
@@ -49,14 +49,20 @@
  *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
-#include "analyzer/cpuidle.h"
+#ifndef _VTL_INDEX_H
+#define _VTL_INDEX_H
+
+#include <cstdint>
+
+namespace vtl {
+
+/*
+ * The index of an element in a TList or of a bit in a RankBitmap. It is 64
+ * bits wide, so that a trace may have more than 2^31 events, see
+ * TLIST_INDEX_MAX.
+ */
+typedef int64_t index_t;
 
-bool CpuIdle::doScale()
-{
-	int i;
-	int s = data.size();
-	scaledData.resize(s);
-	for (i = 0; i < s; i++)
-		scaledData[i] = data[i] * scale + offset;
-	return false; /* No error */	
 }
+
+#endif /* _VTL_INDEX_H */
@@ -0,0 +1,181 @@
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2018  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <iterator>
+
+#include "vtl/indexlist.h"
+
+namespace vtl {
+
+/*
+ * A random access iterator over the low bits of an IndexList, so that
+ * std::sort() can sort a run of indices that spans several chunks
+ */
+class LowIterator
+{
+public:
+	typedef std::random_access_iterator_tag iterator_category;
+	typedef quint32 value_type;
+	typedef index_t difference_type;
+	typedef quint32 *pointer;
+	typedef quint32 &reference;
+	LowIterator(quint32 * const *d, index_t p): data(d), pos(p) {}
+	reference operator*() const {
+		return data[pos >> INDEXLIST_CHUNK_SHIFT]
+			[pos & INDEXLIST_CHUNK_MASK];
+	}
+	reference operator[](index_t n) const { return *(*this + n); }
+	LowIterator &operator++() { pos++; return *this; }
+	LowIterator &operator--() { pos--; return *this; }
+	LowIterator operator++(int) { return LowIterator(data, pos++); }
+	LowIterator operator--(int) { return LowIterator(data, pos--); }
+	LowIterator &operator+=(index_t n) { pos += n; return *this; }
+	LowIterator &operator-=(index_t n) { pos -= n; return *this; }
+	LowIterator operator+(index_t n) const {
+		return LowIterator(data, pos + n);
+	}
+	LowIterator operator-(index_t n) const {
+		return LowIterator(data, pos - n);
+	}
+	index_t operator-(const LowIterator &o) const { return pos - o.pos; }
+	bool operator==(const LowIterator &o) const { return pos == o.pos; }
+	bool operator!=(const LowIterator &o) const { return pos != o.pos; }
+	bool operator<(const LowIterator &o) const { return pos < o.pos; }
+	bool operator>(const LowIterator &o) const { return pos > o.pos; }
+	bool operator<=(const LowIterator &o) const { return pos <= o.pos; }
+	bool operator>=(const LowIterator &o) const { return pos >= o.pos; }
+private:
+	quint32 * const *data;
+	index_t pos;
+};
+
+static __always_inline LowIterator operator+(index_t n, const LowIterator &i)
+{
+	return i + n;
+}
+
+IndexList::IndexList():
+	nrIndices(0), reserved(0)
+{}
+
+/*
+ * Adds an empty chunk with room for the reserved indices that remain, or for a
+ * full chunk if that is less.
+ */
+void IndexList::addChunk()
+{
+	index_t n = reserved - nrIndices;
+
+	chunks.append(QVector<quint32>());
+	if (n > 0)
+		chunks.last().reserve(qMin(n, INDEXLIST_CHUNK_SIZE));
+}
+
+/* Drops all but the first n indices, together with the chunks that empties */
+void IndexList::truncate(index_t n)
+{
+	int nrChunks = (n + INDEXLIST_CHUNK_MASK) >> INDEXLIST_CHUNK_SHIFT;
+
+	chunks.resize(nrChunks);
+	if (nrChunks > 0)
+		chunks.last().resize(n - ((index_t) (nrChunks - 1) <<
+					  INDEXLIST_CHUNK_SHIFT));
+	nrIndices = n;
+}
+
+/*
+ * Sorts the indices that have the same high bits and removes the duplicates,
+ * after which the bounds are moved to where their runs now begin.
+ */
+void IndexList::sortUnique()
+{
+	QVector<quint32 *> data(chunks.size());
+	index_t start = 0;
+	index_t w = 0;
+	index_t end, r, runStart;
+	int k;
+
+	for (k = 0; k < chunks.size(); k++)
+		data[k] = chunks[k].data();
+	LowIterator low(data.constData(), 0);
+
+	for (k = 0; k <= bounds.size(); k++) {
+		end = k < bounds.size() ? bounds[k] : nrIndices;
+		std::sort(low + start, low + end);
+		runStart = w;
+		for (r = start; r < end; r++) {
+			if (w == runStart || low[w - 1] != low[r])
+				low[w++] = low[r];
+		}
+		if (k < bounds.size())
+			bounds[k] = w;
+		start = end;
+	}
+	truncate(w);
+}
+
+MemUsage IndexList::memUsage() const
+{
+	quint64 allocated = (quint64) chunks.capacity() *
+		sizeof(QVector<quint32>) +
+		(quint64) bounds.capacity() * sizeof(index_t);
+	quint64 used = (quint64) chunks.size() * sizeof(QVector<quint32>) +
+		(quint64) bounds.size() * sizeof(index_t);
+	int k;
+
+	for (k = 0; k < chunks.size(); k++) {
+		allocated += (quint64) chunks[k].capacity() * sizeof(quint32);
+		used += (quint64) chunks[k].size() * sizeof(quint32);
+	}
+	return MemUsage(allocated, used);
+}
+
+}
@@ -0,0 +1,150 @@
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2018  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _VTL_INDEXLIST_H
+#define _VTL_INDEXLIST_H
+
+#include <algorithm>
+#include <QVector>
+#include <QtGlobal>
+
+#include "vtl/compiler.h"
+#include "vtl/index.h"
+#include "vtl/memusage.h"
+
+namespace vtl {
+
+/*
+ * The number of indices in each chunk of an IndexList. The chunks keep the
+ * QVectors well below their limit of 2^31 bytes.
+ */
+#define INDEXLIST_CHUNK_SHIFT (24)
+#define INDEXLIST_CHUNK_SIZE ((index_t) 1 << INDEXLIST_CHUNK_SHIFT)
+#define INDEXLIST_CHUNK_MASK (INDEXLIST_CHUNK_SIZE - 1)
+
+/*
+ * A sorted list of indices that keeps only their low 32 bits. Since the list
+ * is sorted, the high bits only change at a few positions, which are kept in
+ * bounds, one for each time that the high bits are incremented. For a list of
+ * indices below 2^32 the bounds are empty, so the list takes half the space of
+ * a list of 64-bit indices.
+ *
+ * The low bits are kept in chunks of INDEXLIST_CHUNK_SIZE, so that a list can
+ * hold more indices than a single QVector. A short list has a single chunk,
+ * which grows as needed, so it costs no more than a QVector.
+ *
+ * The high bits of the appended indices must not decrease, but the low bits
+ * may be appended out of order and sorted with sortUnique().
+ */
+class IndexList
+{
+public:
+	IndexList();
+	__always_inline void reserve(index_t n);
+	__always_inline void append(index_t index);
+	__always_inline index_t size() const;
+	__always_inline bool isEmpty() const;
+	__always_inline index_t at(index_t i) const;
+	void sortUnique();
+	MemUsage memUsage() const;
+private:
+	void addChunk();
+	void truncate(index_t n);
+	QVector<QVector<quint32> > chunks;
+	QVector<index_t> bounds;
+	index_t nrIndices;
+	/* The number of indices that the list has been reserved for */
+	index_t reserved;
+};
+
+__always_inline void IndexList::reserve(index_t n)
+{
+	reserved = n;
+	if (chunks.isEmpty() && n > 0)
+		addChunk();
+}
+
+__always_inline void IndexList::append(index_t index)
+{
+	index_t high = index >> 32;
+
+	while (bounds.size() < high)
+		bounds.append(nrIndices);
+	if ((nrIndices & INDEXLIST_CHUNK_MASK) == 0 &&
+	    nrIndices >> INDEXLIST_CHUNK_SHIFT == chunks.size())
+		addChunk();
+	chunks.last().append((quint32) index);
+	nrIndices++;
+}
+
+__always_inline index_t IndexList::size() const
+{
+	return nrIndices;
+}
+
+__always_inline bool IndexList::isEmpty() const
+{
+	return nrIndices == 0;
+}
+
+__always_inline index_t IndexList::at(index_t i) const
+{
+	index_t high = std::upper_bound(bounds.constBegin(), bounds.constEnd(),
+					i) - bounds.constBegin();
+	const QVector<quint32> &chunk =
+		chunks.constData()[i >> INDEXLIST_CHUNK_SHIFT];
+
+	return (high << 32) | chunk.constData()[i & INDEXLIST_CHUNK_MASK];
+}
+
+}
+
+#endif /* _VTL_INDEXLIST_H */
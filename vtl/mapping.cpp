@@ -0,0 +1,406 @@
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2018  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <QMutex>
+#include <QVector>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+extern "C" {
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+}
+
+#include "vtl/compiler.h"
+#include "vtl/error.h"
+#include "vtl/mapping.h"
+
+#ifdef MAP_POPULATE
+#define MAP_POPULATE_FLAG (MAP_POPULATE)
+#else
+#define MAP_POPULATE_FLAG (0)
+#endif
+
+static vtl::hugepages_t hugepages = vtl::HUGEPAGES_THP;
+
+/*
+ * The mappings that have been given back with unmap_reusable(). Their pages
+ * are still populated, so a trace that is opened after another one has been
+ * closed doesn't need to fault them in again.
+ */
+class CachedMap {
+public:
+	void *ptr;
+	size_t size;
+};
+
+static QMutex mapCacheMutex;
+static QVector<CachedMap> mapCache;
+static size_t mapCacheSize = 0;
+static size_t mapCacheLimit = VTL_MAP_CACHE_DEFAULT;
+
+/* The directory of the files that back map_scratch(), or empty if none */
+static char scratchDir[PATH_MAX];
+
+static const char *const hugepagesNames[vtl::NR_HUGEPAGES_MODES] = {
+	"none",
+	"thp",
+	"hugetlb"
+};
+
+/*
+ * The mode must not be changed while there are mappings, since it decides the
+ * size that unmap_anonymous() unmaps.
+ */
+void vtl::set_hugepages(vtl::hugepages_t mode)
+{
+	hugepages = mode;
+}
+
+vtl::hugepages_t vtl::get_hugepages()
+{
+	return hugepages;
+}
+
+bool vtl::parse_hugepages(const char *str, vtl::hugepages_t *mode)
+{
+	int i;
+
+	for (i = 0; i < vtl::NR_HUGEPAGES_MODES; i++) {
+		if (strcmp(str, hugepagesNames[i]) == 0) {
+			*mode = (vtl::hugepages_t) i;
+			return true;
+		}
+	}
+	return false;
+}
+
+static __always_inline size_t roundup_huge(size_t size)
+{
+	return (size + VTL_HUGEPAGE_SIZE - 1) & ~(VTL_HUGEPAGE_SIZE - 1);
+}
+
+/*
+ * With MAP_HUGETLB, the size of a mapping is rounded up to whole huge pages
+ * and so is the size of the munmap(). Small mappings are never worth it.
+ */
+static __always_inline size_t mapping_size(size_t size)
+{
+	if (hugepages == vtl::HUGEPAGES_HUGETLB && size >= VTL_HUGEPAGE_SIZE)
+		return roundup_huge(size);
+	return size;
+}
+
+/* Faults in the pages of a range that was mapped without MAP_POPULATE */
+static void populate_range(void *ptr, size_t size)
+{
+	volatile char *p = (volatile char*) ptr;
+	size_t pagesize, i;
+
+#ifdef MADV_POPULATE_WRITE
+	if (madvise(ptr, size, MADV_POPULATE_WRITE) == 0)
+		return;
+#endif
+	pagesize = sysconf(_SC_PAGESIZE);
+	for (i = 0; i < size; i += pagesize)
+		p[i] = 0;
+}
+
+/*
+ * Maps size bytes with an extra huge page and unmaps the parts that are
+ * outside of the first aligned range, so that THP can back the whole range
+ */
+static void *map_aligned(size_t size, int flags)
+{
+	size_t extra = size + VTL_HUGEPAGE_SIZE;
+	uintptr_t raw, start, head, tail;
+	void *ptr;
+
+	ptr = mmap(nullptr, extra, PROT_READ | PROT_WRITE, flags, -1, 0);
+	if (unlikely(ptr == MAP_FAILED))
+		mmap_err();
+	raw = (uintptr_t) ptr;
+	start = (raw + VTL_HUGEPAGE_SIZE - 1) & ~(VTL_HUGEPAGE_SIZE - 1);
+	head = start - raw;
+	tail = extra - head - size;
+	if (head > 0 && munmap(ptr, head) != 0)
+		munmap_err();
+	if (tail > 0 && munmap((void*) (start + size), tail) != 0)
+		munmap_err();
+	return (void*) start;
+}
+
+/*
+ * Maps anonymous memory for the large arrays and pools. If populate is true,
+ * the pages are faulted in at once, which is useful for memory that will be
+ * filled soon. Depending on the mode given to set_hugepages(), large mappings
+ * are backed by huge pages, so that random accesses cause fewer TLB misses.
+ */
+void *vtl::map_anonymous(size_t size, bool populate)
+{
+	int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+	void *ptr;
+
+	if (populate)
+		flags |= MAP_POPULATE_FLAG;
+
+	if (hugepages == vtl::HUGEPAGES_NONE || size < VTL_HUGEPAGE_SIZE) {
+		ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, flags, -1, 0);
+		if (unlikely(ptr == MAP_FAILED))
+			mmap_err();
+		return ptr;
+	}
+
+	size = mapping_size(size);
+#ifdef MAP_HUGETLB
+	if (hugepages == vtl::HUGEPAGES_HUGETLB) {
+		ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+			   flags | MAP_HUGETLB, -1, 0);
+		if (ptr != MAP_FAILED)
+			return ptr;
+		/* Most likely, there are no free huge pages, try THP */
+	}
+#endif
+
+	/*
+	 * Pages that were populated before the madvise() would be normal
+	 * pages, so they are populated afterwards instead
+	 */
+	ptr = map_aligned(size, flags & ~MAP_POPULATE_FLAG);
+#ifdef MADV_HUGEPAGE
+	/* This is only a hint, so a failure is not an error */
+	madvise(ptr, size, MADV_HUGEPAGE);
+#endif
+	if (populate)
+		populate_range(ptr, size);
+	return ptr;
+}
+
+void vtl::unmap_anonymous(void *ptr, size_t size)
+{
+	if (munmap(ptr, mapping_size(size)) != 0)
+		munmap_err();
+}
+
+/*
+ * Gives back the pages of a mapping that come after the first used bytes, so
+ * that the unused tail of a partially filled map doesn't stay resident. The
+ * range is kept mapped and is faulted in again if it is written. Huge pages
+ * are not split, so the tail is only trimmed at huge page boundaries if the
+ * mapping may be backed by them.
+ */
+void vtl::trim_anonymous(void *ptr, size_t size, size_t used)
+{
+	size_t gran, start;
+
+	if (hugepages != vtl::HUGEPAGES_NONE && size >= VTL_HUGEPAGE_SIZE) {
+		gran = VTL_HUGEPAGE_SIZE;
+		size = mapping_size(size);
+	} else {
+		gran = sysconf(_SC_PAGESIZE);
+	}
+	start = (used + gran - 1) & ~(gran - 1);
+	if (start >= size)
+		return;
+	/* This is only advice, so a failure is not an error */
+	madvise((char*) ptr + start, size - start, MADV_DONTNEED);
+}
+
+/*
+ * Like map_anonymous() but a mapping of the same size that has been given back
+ * with unmap_reusable() is reused if there is one. The memory of a reused
+ * mapping is not zeroed, so this is only for the pools and lists that don't
+ * expect that.
+ */
+void *vtl::map_reusable(size_t size, bool populate)
+{
+	void *ptr = nullptr;
+	int i;
+
+	mapCacheMutex.lock();
+	for (i = mapCache.size() - 1; i >= 0; i--) {
+		if (mapCache[i].size == size) {
+			ptr = mapCache[i].ptr;
+			mapCacheSize -= size;
+			mapCache.remove(i);
+			break;
+		}
+	}
+	mapCacheMutex.unlock();
+
+	if (ptr == nullptr)
+		return map_anonymous(size, populate);
+	/* The tail may have been trimmed before the mapping was given back */
+	if (populate)
+		populate_range(ptr, mapping_size(size));
+	return ptr;
+}
+
+/* Keeps the mapping for map_reusable(), unless the cache is full */
+void vtl::unmap_reusable(void *ptr, size_t size)
+{
+	CachedMap cmap;
+
+	mapCacheMutex.lock();
+	if (mapCacheSize + size <= mapCacheLimit) {
+		cmap.ptr = ptr;
+		cmap.size = size;
+		mapCache.append(cmap);
+		mapCacheSize += size;
+		ptr = nullptr;
+	}
+	mapCacheMutex.unlock();
+
+	if (ptr != nullptr)
+		unmap_anonymous(ptr, size);
+}
+
+/* Sets the limit of the cache, a limit of zero disables it */
+void vtl::set_map_cache(size_t limit)
+{
+	mapCacheMutex.lock();
+	mapCacheLimit = limit;
+	mapCacheMutex.unlock();
+	if (get_map_cache_size() > limit)
+		flush_map_cache();
+}
+
+size_t vtl::get_map_cache_size()
+{
+	size_t size;
+
+	mapCacheMutex.lock();
+	size = mapCacheSize;
+	mapCacheMutex.unlock();
+	return size;
+}
+
+void vtl::flush_map_cache()
+{
+	QVector<CachedMap> maps;
+	int i;
+
+	mapCacheMutex.lock();
+	maps.swap(mapCache);
+	mapCacheSize = 0;
+	mapCacheMutex.unlock();
+
+	for (i = 0; i < maps.size(); i++)
+		unmap_anonymous(maps[i].ptr, maps[i].size);
+}
+
+/*
+ * Sets the directory where map_scratch() creates its files. Returns false if
+ * it's not a directory that can be written to. Like the huge page mode, this
+ * must be set before anything is mapped.
+ */
+bool vtl::set_scratch_dir(const char *dir)
+{
+	struct stat sbuf;
+
+	if (strlen(dir) + sizeof("/traceshark-XXXXXX") > sizeof(scratchDir))
+		return false;
+	if (stat(dir, &sbuf) != 0 || !S_ISDIR(sbuf.st_mode) ||
+	    access(dir, W_OK | X_OK) != 0)
+		return false;
+	strcpy(scratchDir, dir);
+	return true;
+}
+
+/* Returns the scratch directory, or nullptr if none has been set */
+const char *vtl::get_scratch_dir()
+{
+	return scratchDir[0] != '\0' ? scratchDir : nullptr;
+}
+
+/*
+ * Maps size bytes that are backed by a file in the scratch directory instead of
+ * by anonymous memory. The kernel can then write the pages back to the file and
+ * drop them when memory is short, instead of running out of memory. The file
+ * is unlinked at once, so it goes away when the mapping is unmapped, also if
+ * traceshark would crash.
+ */
+void *vtl::map_scratch(size_t size)
+{
+	char path[PATH_MAX];
+	void *ptr;
+	int fd;
+
+	snprintf(path, sizeof(path), "%s/traceshark-XXXXXX", scratchDir);
+	fd = mkstemp(path);
+	if (fd < 0)
+		vtl::err(BSD_EX_CANTCREAT, errno,
+			 "Failed to create a scratch file in %s", scratchDir);
+	if (unlink(path) != 0)
+		vtl::warn(errno, "Failed to unlink %s", path);
+	if (ftruncate(fd, (off_t) size) != 0)
+		vtl::err(BSD_EX_IOERR, errno,
+			 "Failed to size a scratch file in %s", scratchDir);
+
+	ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (unlikely(ptr == MAP_FAILED))
+		mmap_err();
+	if (close(fd) != 0)
+		close_warn();
+	return ptr;
+}
+
+void vtl::unmap_scratch(void *ptr, size_t size)
+{
+	if (munmap(ptr, size) != 0)
+		munmap_err();
+}
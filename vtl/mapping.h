@@ -0,0 +1,92 @@
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2018  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _VTL_MAPPING_H
+#define _VTL_MAPPING_H
+
+#include <cstddef>
+
+namespace vtl {
+
+/*
+ * The size of the huge pages that the mappings are aligned to. This is the
+ * size of the PMD mapped pages on x86-64 and on arm64 with 4K pages.
+ */
+#define VTL_HUGEPAGE_SIZE ((size_t) 2 * 1024 * 1024)
+
+/* The default limit of the memory that unmap_reusable() keeps for reuse */
+#define VTL_MAP_CACHE_DEFAULT ((size_t) 512 * 1024 * 1024)
+
+	typedef enum {
+		HUGEPAGES_NONE = 0,	/* Only use normal pages */
+		HUGEPAGES_THP,		/* Align and ask for THP with madvise() */
+		HUGEPAGES_HUGETLB,	/* Use MAP_HUGETLB, THP if it fails */
+		NR_HUGEPAGES_MODES
+	} hugepages_t;
+
+	void set_hugepages(hugepages_t mode);
+	hugepages_t get_hugepages();
+	bool parse_hugepages(const char *str, hugepages_t *mode);
+	void *map_anonymous(size_t size, bool populate = false);
+	void unmap_anonymous(void *ptr, size_t size);
+	void trim_anonymous(void *ptr, size_t size, size_t used);
+	void *map_reusable(size_t size, bool populate = false);
+	void unmap_reusable(void *ptr, size_t size);
+	void set_map_cache(size_t limit);
+	size_t get_map_cache_size();
+	void flush_map_cache();
+	bool set_scratch_dir(const char *dir);
+	const char *get_scratch_dir();
+	void *map_scratch(size_t size);
+	void unmap_scratch(void *ptr, size_t size);
+}
+
+#endif /* _VTL_MAPPING_H */
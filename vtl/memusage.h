@@ -1,6 +1,6 @@
 /*
  * Traceshark - a visualizer for visualizing ftrace and perf traces
- * Copyright (C) 2015, 2016  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ * Copyright (C) 2018  Viktor Rosendahl <viktor.rosendahl@gmail.com>
  *
  * This file is dual licensed: you can use it either under the terms of
  * the GPL, or the BSD license, at your option.
@@ -49,35 +49,35 @@
  *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
-#ifndef WORKQUEUE_H
-#define WORKQUEUE_H
+#ifndef _VTL_MEMUSAGE_H
+#define _VTL_MEMUSAGE_H
 
-#include <QList>
-#include <QMutex>
-#include "threads/workitem.h"
-#include "threads/workthread.h"
+#include <QtGlobal>
 
-class WorkQueue {
-	friend class WorkThread<WorkQueue>;
+#include "vtl/compiler.h"
+
+namespace vtl {
+
+/*
+ * The memory of a data structure. Reserved is what has been mapped or
+ * allocated, used is what holds data. The difference is the unused tails of
+ * pools and arrays, of which only the touched pages take up RAM.
+ */
+class MemUsage {
 public:
-	WorkQueue();
-	~WorkQueue();
-	void addWorkItem(AbstractWorkItem *item);
-	void addDefaultWorkItem(AbstractWorkItem *item);
-	void setWorkItemsDefault();
-	void start();
-	bool wait();
-protected:
-	void ThreadRun();
-private:
-	QList<AbstractWorkItem*> queue;
-	QList<AbstractWorkItem*> defaultQueue;
-	QMutex queueMutex;
-	QMutex errorMutex;
-	bool error;
-	WorkThread<WorkQueue> *threads;
-	int nrThreads;
-	int nrStarted;
+	MemUsage(quint64 r = 0, quint64 u = 0): reserved(r), used(u) {}
+	__always_inline MemUsage &operator+=(const MemUsage &other);
+	quint64 reserved;
+	quint64 used;
 };
 
-#endif /* WORKQUEUE_H */
+__always_inline MemUsage &MemUsage::operator+=(const MemUsage &other)
+{
+	reserved += other.reserved;
+	used += other.used;
+	return *this;
+}
+
+}
+
+#endif /* _VTL_MEMUSAGE_H */
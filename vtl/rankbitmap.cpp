@@ -0,0 +1,185 @@
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2018  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "vtl/rankbitmap.h"
+
+namespace vtl {
+
+RankBitmap::RankBitmap():
+	nrBits(0), nrOnes(0)
+{}
+
+void RankBitmap::clear()
+{
+	nrBits = 0;
+	nrOnes = 0;
+	words.clear();
+	blockRank.clear();
+}
+
+/* All bits are cleared, the directory needs to be built afterwards */
+void RankBitmap::resize(index_t size)
+{
+	int nrWords = (size + BITS_PER_WORD - 1) / BITS_PER_WORD;
+
+	nrBits = size;
+	nrOnes = 0;
+	words.fill(0, nrWords);
+	blockRank.fill(0, (nrWords >> RANKBITMAP_BLOCK_SHIFT) + 1);
+}
+
+MemUsage RankBitmap::memUsage() const
+{
+	return MemUsage((quint64) words.capacity() * sizeof(word_t) +
+			(quint64) blockRank.capacity() * sizeof(index_t),
+			(quint64) words.size() * sizeof(word_t) +
+			(quint64) blockRank.size() * sizeof(index_t));
+}
+
+void RankBitmap::buildRank()
+{
+	int nrWords = words.size();
+	index_t r = 0;
+	int i;
+
+	for (i = 0; i < nrWords; i++) {
+		if ((i & (RANKBITMAP_BLOCK_WORDS - 1)) == 0)
+			blockRank[i >> RANKBITMAP_BLOCK_SHIFT] = r;
+		r += __builtin_popcountll(words[i]);
+	}
+	/* The extra entry, which makes rank(size()) work */
+	if ((nrWords & (RANKBITMAP_BLOCK_WORDS - 1)) == 0)
+		blockRank[nrWords >> RANKBITMAP_BLOCK_SHIFT] = r;
+	nrOnes = r;
+}
+
+/* Returns the index of the set bit that has n set bits before it */
+index_t RankBitmap::select(index_t n) const
+{
+	const index_t *br = blockRank.constData();
+	int lo = 0;
+	int hi = (words.size() - 1) >> RANKBITMAP_BLOCK_SHIFT;
+	int mid, w, i, r;
+	word_t word;
+
+	if (n < 0 || n >= nrOnes)
+		return -1;
+
+	/* Find the last block with fewer than n + 1 bits before it */
+	while (lo < hi) {
+		mid = (lo + hi + 1) / 2;
+		if (br[mid] <= n)
+			lo = mid;
+		else
+			hi = mid - 1;
+	}
+
+	r = n - br[lo];
+	for (w = lo << RANKBITMAP_BLOCK_SHIFT; ; w++) {
+		i = __builtin_popcountll(words[w]);
+		if (r < i)
+			break;
+		r -= i;
+	}
+
+	/* Clear the r lowest set bits, the next one is the one */
+	word = words[w];
+	for (i = 0; i < r; i++)
+		word &= word - 1;
+	return ((index_t) w << 6) + __builtin_ctzll(word);
+}
+
+/* Returns the first set bit at or after index, or -1 if there is none */
+index_t RankBitmap::findNext(index_t index) const
+{
+	int nrWords = words.size();
+	int w;
+	word_t word;
+
+	if (index < 0)
+		index = 0;
+	if (index >= nrBits)
+		return -1;
+
+	w = index >> 6;
+	word = words[w] & (~(word_t) 0 << (index & 63));
+	while (word == 0) {
+		if (++w >= nrWords)
+			return -1;
+		word = words[w];
+	}
+	return ((index_t) w << 6) + __builtin_ctzll(word);
+}
+
+/* Returns the last set bit at or before index, or -1 if there is none */
+index_t RankBitmap::findPrev(index_t index) const
+{
+	int w;
+	word_t word;
+
+	if (index >= nrBits)
+		index = nrBits - 1;
+	if (index < 0)
+		return -1;
+
+	w = index >> 6;
+	word = words[w];
+	if ((index & 63) != 63)
+		word &= ((word_t) 0x1 << ((index & 63) + 1)) - 1;
+	while (word == 0) {
+		if (--w < 0)
+			return -1;
+		word = words[w];
+	}
+	return ((index_t) w << 6) + 63 - __builtin_clzll(word);
+}
+
+}
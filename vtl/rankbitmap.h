@@ -0,0 +1,156 @@
+/*
+ * Traceshark - a visualizer for visualizing ftrace and perf traces
+ * Copyright (C) 2018  Viktor Rosendahl <viktor.rosendahl@gmail.com>
+ *
+ * This file is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This program is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _VTL_RANKBITMAP_H
+#define _VTL_RANKBITMAP_H
+
+#include <cstdint>
+#include <QVector>
+
+#include "vtl/compiler.h"
+#include "vtl/index.h"
+#include "vtl/memusage.h"
+
+namespace vtl {
+
+/* The number of words that share an entry in the rank directory */
+#define RANKBITMAP_BLOCK_WORDS (8)
+#define RANKBITMAP_BLOCK_SHIFT (3)
+
+/*
+ * A bitmap with a directory that holds the number of set bits before each
+ * block of words. With it, the number of set bits before an index, the rank,
+ * can be computed in constant time and the index of the nth set bit, the
+ * select, with a binary search over the blocks.
+ *
+ * The directory must be rebuilt with buildRank() after bits have been
+ * changed. Different words can be written concurrently, as long as nothing
+ * reads the bitmap at the same time.
+ *
+ * The bit indices are 64-bit but the words are kept in a QVector, whose size in
+ * bytes must fit in an int, so a bitmap can hold up to 2^34 bits.
+ */
+class RankBitmap
+{
+public:
+	typedef uint64_t word_t;
+	RankBitmap();
+	void clear();
+	void resize(index_t nrBits);
+	void buildRank();
+	__always_inline index_t size() const;
+	__always_inline index_t count() const;
+	__always_inline bool test(index_t index) const;
+	__always_inline void set(index_t index);
+	__always_inline void reset(index_t index);
+	__always_inline word_t *data();
+	__always_inline index_t rank(index_t index) const;
+	index_t select(index_t n) const;
+	index_t findNext(index_t index) const;
+	index_t findPrev(index_t index) const;
+	MemUsage memUsage() const;
+private:
+	static const int BITS_PER_WORD = 64;
+	index_t nrBits;
+	index_t nrOnes;
+	QVector<word_t> words;
+	QVector<index_t> blockRank;
+};
+
+__always_inline index_t RankBitmap::size() const
+{
+	return nrBits;
+}
+
+__always_inline index_t RankBitmap::count() const
+{
+	return nrOnes;
+}
+
+__always_inline bool RankBitmap::test(index_t index) const
+{
+	return (words[index >> 6] >> (index & 63)) & 0x1;
+}
+
+__always_inline void RankBitmap::set(index_t index)
+{
+	words[index >> 6] |= (word_t) 0x1 << (index & 63);
+}
+
+__always_inline void RankBitmap::reset(index_t index)
+{
+	words[index >> 6] &= ~((word_t) 0x1 << (index & 63));
+}
+
+__always_inline RankBitmap::word_t *RankBitmap::data()
+{
+	return words.data();
+}
+
+/* Returns the number of set bits before index */
+__always_inline index_t RankBitmap::rank(index_t index) const
+{
+	int w = index >> 6;
+	int first = (w >> RANKBITMAP_BLOCK_SHIFT) << RANKBITMAP_BLOCK_SHIFT;
+	index_t r = blockRank[w >> RANKBITMAP_BLOCK_SHIFT];
+	int i;
+
+	for (i = first; i < w; i++)
+		r += __builtin_popcountll(words[i]);
+	if ((index & 63) != 0)
+		r += __builtin_popcountll(words[w] &
+					  (((word_t) 0x1 << (index & 63)) - 1));
+	return r;
+}
+
+}
+
+#endif /* _VTL_RANKBITMAP_H */
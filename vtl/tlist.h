@@ -53,6 +53,7 @@
 #define TLIST_H
 
 #include <climits>
+#include <cstdint>
 #include <cstdlib>
 
 extern "C" {
@@ -61,6 +62,9 @@ extern "C" {
 
 #include "vtl/compiler.h"
 #include "vtl/error.h"
+#include "vtl/index.h"
+#include "vtl/mapping.h"
+#include "vtl/memusage.h"
 
 namespace vtl {
 
@@ -68,13 +72,18 @@ namespace vtl {
 #define TLIST_MIN(A, B) ((A) < (B) ? A:B)
 
 /*
- * Here we assume that INT_MAX can be expressed as 2^N - 1
- * This is a bit theoretical, if we have for example 64-bit unsigned ints, then
- * the idea is that we want to keep the array of pointers at a size of no more
- * than one million elements, in order to avoid execessive use of address space
- * and overcommit of memory, or rather address space
+ * The indices are 64-bit but the array of pointers to the maps is allocated
+ * in full when the list is created, so the maximum is what keeps it at a size
+ * of no more than 2^17 elements, i.e. 1 MiB, in order to avoid excessive use
+ * of address space. With 64-bit pointers this allows for 2^37 elements, with
+ * 32-bit pointers the address space would run out long before 2^31 elements
+ * anyway.
  */
-#define TLIST_INDEX_MAX (TLIST_MIN(0x7fffffff, INT_MAX))
+#if UINTPTR_MAX > 0xffffffff
+#define TLIST_INDEX_MAX (((index_t) 1 << 37) - 1)
+#else
+#define TLIST_INDEX_MAX ((index_t) INT_MAX)
+#endif
 
 /*
  * This code is needed in order to take into account platforms with small
@@ -99,38 +108,49 @@ template<class T>
 class TList
 {
 public:
-	TList();
+	TList(bool onScratch = false);
 	~TList();
 	__always_inline void append(const T &element);
 	__always_inline T& increase();
 	__always_inline T& preAlloc();
 	__always_inline void commit();
-	__always_inline T value(int index) const;
-	__always_inline const T& at(int index) const;
+	__always_inline T value(index_t index) const;
+	__always_inline const T& at(index_t index) const;
 	__always_inline T& last();
-	__always_inline int size() const;
+	__always_inline index_t size() const;
 	void clear();
 	void softclear();
-	__always_inline T& operator[](int index);
-	__always_inline const T& operator[](int index) const;
-	__always_inline void swap(int a, int b);
+	void resize(index_t size);
+	void trim();
+	MemUsage memUsage() const;
+	__always_inline T& operator[](index_t index);
+	__always_inline const T& operator[](index_t index) const;
+	__always_inline void swap(index_t a, index_t b);
 private:
-	__always_inline T& subscript(int index) const;
-	__always_inline int mapFromIndex(int index) const;
-	__always_inline int mapIndexFromIndex(int index)
+	__always_inline T& subscript(index_t index) const;
+	__always_inline int mapFromIndex(index_t index) const;
+	__always_inline int mapIndexFromIndex(index_t index)
 		const;
 	void clearAll();
 	void setupMem();
 	void addMem();
 	void decMem();
+	void unmapMem(int map);
 	int nrMaps;
-	int nrElements;
+	index_t nrElements;
 	T **mapArray;
+	/* The maps are backed by files in the scratch directory */
+	bool scratch;
 };
 
+/*
+ * If onScratch is true, the maps are backed by files in the directory of
+ * set_scratch_dir(), so that a list that is larger than the RAM can be paged
+ * out by the kernel.
+ */
 template<class T>
-TList<T>::TList():
-nrMaps(0), nrElements(0)
+TList<T>::TList(bool onScratch):
+nrMaps(0), nrElements(0), scratch(onScratch)
 {
 	setupMem();
 }
@@ -142,13 +162,13 @@ TList<T>::~TList()
 }
 
 template<class T>
-__always_inline int TList<T>::mapFromIndex(int index) const
+__always_inline int TList<T>::mapFromIndex(index_t index) const
 {
 	return (index >> TLIST_MAP_SHIFT);
 }
 
 template<class T>
-__always_inline int TList<T>::mapIndexFromIndex(int index)
+__always_inline int TList<T>::mapIndexFromIndex(index_t index)
 const
 {
 	return (index & TLIST_MAP_ELEMENT_MASK);
@@ -158,34 +178,52 @@ template<class T>
 void TList<T>::setupMem()
 {
 	int maxNrMaps = mapFromIndex(TLIST_MAP_MASK) + 1;
-	mapArray = (T**) mmap(nullptr, (size_t) maxNrMaps * sizeof(T*),
-			     PROT_READ | PROT_WRITE,
-			     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
-	if (unlikely(mapArray == MAP_FAILED))
-		mmap_err();
+	mapArray = (T**) map_anonymous((size_t) maxNrMaps * sizeof(T*));
 	addMem();
 }
 
 template<class T>
 void TList<T>::addMem()
 {
-	mapArray[nrMaps] = (T*) mmap(nullptr, (size_t) TLIST_MAP_NR_ELEMENTS *
-				sizeof(T), PROT_READ | PROT_WRITE,
-				MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
-	if (unlikely(mapArray[nrMaps] == MAP_FAILED))
-		mmap_err();
+	size_t size = (size_t) TLIST_MAP_NR_ELEMENTS * sizeof(T);
+
+	/*
+	 * A list that has filled its first map is a large one, so the next map
+	 * is likely to be filled as well and is populated at once
+	 */
+	if (scratch)
+		mapArray[nrMaps] = (T*) map_scratch(size);
+	else
+		mapArray[nrMaps] = (T*) map_reusable(size, nrMaps > 0);
 	nrMaps++;
 }
 
 template<class T>
-void TList<T>::decMem()
+void TList<T>::unmapMem(int map)
 {
-	int r;
+	size_t size = (size_t) TLIST_MAP_NR_ELEMENTS * sizeof(T);
 
+	if (scratch)
+		unmap_scratch(mapArray[map], size);
+	else
+		unmap_reusable(mapArray[map], size);
+}
+
+template<class T>
+void TList<T>::decMem()
+{
 	nrMaps--;
-	r = munmap(mapArray[nrMaps], TLIST_MAP_NR_ELEMENTS * sizeof(T));
-	if (unlikely(r != 0))
-		munmap_err();
+	unmapMem(nrMaps);
+}
+
+template<class T>
+MemUsage TList<T>::memUsage() const
+{
+	int maxNrMaps = mapFromIndex(TLIST_MAP_MASK) + 1;
+	quint64 maps = (quint64) nrMaps * TLIST_MAP_NR_ELEMENTS * sizeof(T);
+
+	return MemUsage(maps + (quint64) maxNrMaps * sizeof(T*),
+			(quint64) nrElements * sizeof(T));
 }
 
 template<class T>
@@ -193,16 +231,10 @@ void TList<T>::clearAll()
 {
 	int maxNrMaps = mapFromIndex(TLIST_MAP_MASK) + 1;
 	int i;
-	int r;
 
-	for (i = 0; i < nrMaps; i++) {
-		r = munmap(mapArray[i], TLIST_MAP_NR_ELEMENTS * sizeof(T));
-		if (unlikely(r != 0))
-			munmap_err();
-	}
-	r = munmap(mapArray, maxNrMaps * sizeof(T*));
-	if (unlikely(r != 0))
-		munmap_err();
+	for (i = 0; i < nrMaps; i++)
+		unmapMem(i);
+	unmap_anonymous(mapArray, maxNrMaps * sizeof(T*));
 	nrMaps = 0;
 	nrElements = 0;
 }
@@ -246,7 +278,7 @@ __always_inline void TList<T>::append(const T &element)
 }
 
 template<class T>
-__always_inline const T& TList<T>::at(int index) const
+__always_inline const T& TList<T>::at(index_t index) const
 {
 	int map = mapFromIndex(index);
 	int mapIndex = mapIndexFromIndex(index);
@@ -254,7 +286,7 @@ __always_inline const T& TList<T>::at(int index) const
 }
 
 template<class T>
-__always_inline T TList<T>::value(int index) const
+__always_inline T TList<T>::value(index_t index) const
 {
 	if (index >= nrElements) {
 		T dvalue;
@@ -266,7 +298,7 @@ __always_inline T TList<T>::value(int index) const
 template<class T>
 __always_inline T& TList<T>::last()
 {
-	int index = nrElements - 1;
+	index_t index = nrElements - 1;
 	int map = mapFromIndex(index);
 	int mapIndex = mapIndexFromIndex(index);
 	return mapArray[map][mapIndex];
@@ -274,16 +306,22 @@ __always_inline T& TList<T>::last()
 }
 
 template<class T>
-__always_inline int TList<T>::size() const
+__always_inline index_t TList<T>::size() const
 {
 	return nrElements;
 }
 
+/*
+ * The array of maps and the first map are kept, the other maps are given to
+ * the cache of vtl/mapping, so that a list that is filled again after it has
+ * been cleared can reuse them without faulting in the pages again.
+ */
 template<class T>
 void TList<T>::clear()
 {
-	clearAll();
-	setupMem();
+	while (nrMaps > 1)
+		decMem();
+	nrElements = 0;
 }
 
 template<class T>
@@ -292,8 +330,44 @@ void TList<T>::softclear()
 	nrElements = 0;
 }
 
+/*
+ * The elements that are added by growing the list are not initialized, so
+ * they need to be assigned before they are read. Since all memory is
+ * allocated here, different elements can then be assigned concurrently by
+ * different threads.
+ */
+template<class T>
+void TList<T>::resize(index_t size)
+{
+	int maps = size > 0 ? mapFromIndex(size - 1) + 1 : 0;
+
+	while (nrMaps < maps)
+		addMem();
+	nrElements = size;
+}
+
+/*
+ * Gives back the maps and the pages of the last map that are not used. The
+ * pages are faulted in again if the list grows.
+ */
+template<class T>
+void TList<T>::trim()
+{
+	int maps = nrElements > 0 ? mapFromIndex(nrElements - 1) + 1 : 1;
+	int used;
+
+	while (nrMaps > maps)
+		decMem();
+	/* The pages of a file can be dropped by the kernel without this */
+	if (scratch)
+		return;
+	used = nrElements - (index_t) (nrMaps - 1) * TLIST_MAP_NR_ELEMENTS;
+	trim_anonymous(mapArray[nrMaps - 1], (size_t) TLIST_MAP_NR_ELEMENTS *
+		       sizeof(T), (size_t) used * sizeof(T));
+}
+
 template<class T>
-__always_inline void TList<T>::swap(int a, int b)
+__always_inline void TList<T>::swap(index_t a, index_t b)
 {
 	T foo;
 	T &ta = subscript(a);
@@ -304,7 +378,7 @@ __always_inline void TList<T>::swap(int a, int b)
 }
 
 template<class T>
-__always_inline T& TList<T>::subscript(int index) const
+__always_inline T& TList<T>::subscript(index_t index) const
 {
 	int map = mapFromIndex(index);
 	int mapIndex = mapIndexFromIndex(index);
@@ -312,13 +386,13 @@ __always_inline T& TList<T>::subscript(int index) const
 }
 
 template<class T>
-__always_inline T& TList<T>::operator[](int index)
+__always_inline T& TList<T>::operator[](index_t index)
 {
 	return subscript(index);
 }
 
 template<class T>
-__always_inline const T& TList<T>::operator[](int index) const
+__always_inline const T& TList<T>::operator[](index_t index) const
 {
 	return subscript(index);
 }